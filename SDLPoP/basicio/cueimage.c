@@ -200,6 +200,100 @@ void cueimage_fillMSF(int device, byte *got_startMSF, CUESHEET_ENTRYINFO *cue_cu
 
 extern char diskpath[256]; //Disk path!
 
+//Indexed cue sheets: the cue sheet is parsed once into a table of indexes and gaps, which is searched for every sector read!
+#define CUEIMAGE_MAXENTRIES 256
+#define CUEIMAGE_MAXGAPS 256
+#define CUEIMAGE_MAXFILES 100
+//How many bytes to prefetch from the backend file on a sector read(sequential reads, like CD-DA playback, are served from memory)!
+#define CUEIMAGE_PREFETCHSIZE (2448*16)
+
+typedef struct
+{
+	uint_32 startLBA; //First disc LBA of the index!
+	uint_32 endLBA; //Last disc LBA of the index!
+	FILEPOS datafilepos; //Data file position of the first sector!
+	CDROM_TRACK_MODE *track_mode; //Track mode!
+	byte track_number; //Track number!
+	byte index; //Index number!
+	byte filenr; //The backend file!
+	byte binary; //Supported backend file type?
+	word gaps; //Amount of gaps that have been parsed before us!
+} CUEIMAGE_INDEXENTRY;
+
+typedef struct
+{
+	uint_32 startLBA; //First disc LBA of the gap!
+	uint_32 endLBA; //Last disc LBA of the gap!
+} CUEIMAGE_GAPENTRY;
+
+typedef struct
+{
+	byte state; //0=Not parsed, 1=Parsed, 2=Unusable(use the cue sheet scan instead)
+	char filename[256]; //The cue sheet that's parsed!
+	byte sorted; //Entries are ascending and non-overlapping(binary search)?
+	word numentries;
+	CUEIMAGE_INDEXENTRY entries[CUEIMAGE_MAXENTRIES]; //All indexes in the order of the cue sheet!
+	word numgaps;
+	CUEIMAGE_GAPENTRY gaps[CUEIMAGE_MAXGAPS]; //All gaps in the order of the cue sheet!
+	byte numfiles;
+	char files[CUEIMAGE_MAXFILES][256]; //All backend files!
+	BIGFILE *source; //Currently opened backend file!
+	byte sourcefile; //What backend file is opened!
+	FILEPOS sourcesize; //The size of the opened backend file!
+	byte prefetch[CUEIMAGE_PREFETCHSIZE]; //Prefetched data of the opened backend file!
+	FILEPOS prefetchpos; //Backend file position of the prefetched data!
+	uint_32 prefetchsize; //Amount of prefetched data!
+} CUEIMAGE_TABLE;
+
+CUEIMAGE_TABLE cueimage_tables[2]; //The tables of both CD-ROM drives!
+CUEIMAGE_TABLE *cueimage_building = NULL; //The table that's being built by the cue sheet scan, if any!
+
+void cueimage_addentry(CUESHEET_ENTRYINFO *entry) //Add a index to the table being built!
+{
+	CUEIMAGE_INDEXENTRY *newentry;
+	byte filenr;
+	if (cueimage_building->state == 2) return; //Unusable already?
+	if (cueimage_building->numentries >= NUMITEMS(cueimage_building->entries)) //Too many indexes?
+	{
+		cueimage_building->state = 2; //Unusable!
+		return;
+	}
+	for (filenr = 0; filenr < cueimage_building->numfiles; ++filenr) //Check the known files!
+	{
+		if (strcmp(cueimage_building->files[filenr], entry->status.filename) == 0) goto filenrfound; //Known file!
+	}
+	if (cueimage_building->numfiles >= NUMITEMS(cueimage_building->files)) //Too many files?
+	{
+		cueimage_building->state = 2; //Unusable!
+		return;
+	}
+	safestrcpy(cueimage_building->files[filenr], sizeof(cueimage_building->files[filenr]), entry->status.filename); //New file!
+	++cueimage_building->numfiles; //Added!
+	filenrfound:
+	newentry = &cueimage_building->entries[cueimage_building->numentries++]; //The new entry!
+	newentry->startLBA = entry->status.MSFPosition; //Start of the index on the disc!
+	newentry->endLBA = entry->status.MSFPosition + (CUE_MSF2LBA(entry->endM, entry->endS, entry->endF) - CUE_MSF2LBA(entry->status.M, entry->status.S, entry->status.F)); //End of the index on the disc!
+	newentry->datafilepos = entry->status.datafilepos; //Data position!
+	newentry->track_mode = entry->status.track_mode; //Track mode!
+	newentry->track_number = entry->status.track_number; //Track number!
+	newentry->index = entry->status.index; //Index number!
+	newentry->filenr = filenr; //The backend file!
+	newentry->binary = (strcmp(entry->status.file_type, "binary") == 0); //Supported backend?
+	newentry->gaps = cueimage_building->numgaps; //The gaps that have been parsed before us!
+}
+
+void cueimage_addgap(uint_32 gap_startAddr, uint_32 gap_endAddr) //Add a gap to the table being built!
+{
+	if (cueimage_building->state == 2) return; //Unusable already?
+	if (cueimage_building->numgaps >= NUMITEMS(cueimage_building->gaps)) //Too many gaps?
+	{
+		cueimage_building->state = 2; //Unusable!
+		return;
+	}
+	cueimage_building->gaps[cueimage_building->numgaps].startLBA = gap_startAddr;
+	cueimage_building->gaps[cueimage_building->numgaps++].endLBA = gap_endAddr;
+}
+
 //Result: -1: Out of range, 0: Failed to read, 1: Read successfully
 int_64 cueimage_REAL_readsector(int device, byte *M, byte *S, byte *F, byte *startM, byte *startS, byte *startF, byte *endM, byte *endS, byte *endF, void *buffer, word size, byte specialfeatures) //Read a n-byte sector! Result=Type on success, 0 on error, -1 on not found!
 {
@@ -489,6 +583,11 @@ int_64 cueimage_REAL_readsector(int device, byte *M, byte *S, byte *F, byte *sta
 					gap_endAddr = gap_startAddr + (cue_next.status.postgap_pending_duration-1); //The end of the gap!
 					cue_status.MSFPosition += (LBA - prev_LBA); //Add the previous track size of the final entry!
 					//Handle the postgap for the previous track now!
+					if (cueimage_building) //Building the table?
+					{
+						cueimage_addgap(gap_startAddr, gap_endAddr); //Add the gap!
+						goto notthispostgap1; //Don't check the sector!
+					}
 					if (CUE_MSF2LBA(orig_M, orig_S, orig_F) < gap_startAddr) goto notthispostgap1; //Before start? Not us!
 					if (CUE_MSF2LBA(orig_M, orig_S, orig_F) > gap_endAddr) goto notthispostgap1; //After end? not us!
 					//We're this postgap!
@@ -515,6 +614,11 @@ int_64 cueimage_REAL_readsector(int device, byte *M, byte *S, byte *F, byte *sta
 					gap_startAddr = cue_status.MSFPosition; //The pregap starts after the previous track!
 					gap_endAddr = gap_startAddr + (cue_next.status.pregap_pending_duration-1); //The end of the gap!
 					//Handle the pregap now!
+					if (cueimage_building) //Building the table?
+					{
+						cueimage_addgap(gap_startAddr, gap_endAddr); //Add the gap!
+						goto notthispregap; //Don't check the sector!
+					}
 					if (CUE_MSF2LBA(orig_M, orig_S, orig_F) < gap_startAddr) goto notthispregap; //Before start? Not us!
 					if (CUE_MSF2LBA(orig_M, orig_S, orig_F) > gap_endAddr) goto notthispregap; //After end? not us!
 					//We're this pregap!
@@ -549,6 +653,14 @@ int_64 cueimage_REAL_readsector(int device, byte *M, byte *S, byte *F, byte *sta
 				if (CUE_MSF2LBA(cue_current.status.M, cue_current.status.S, cue_current.status.F) >= LBA) goto finishMSFscan; //Invalid to read(non-zero length)?
 				--LBA; //Take the end position of us!
 				CUE_LBA2MSF(LBA, &cue_current.endM, &cue_current.endS, &cue_current.endF); //Save the calculated end position of the selected index!
+				if (cueimage_building) //Building the table?
+				{
+					if (cue_current.status.got_file && cue_current.status.got_index) //Got file and index to lookup?
+					{
+						cueimage_addentry(&cue_current); //Add the index!
+					}
+					goto finishMSFscan; //Continue scanning!
+				}
 				LBA = CUE_MSF2LBA(orig_M, orig_S, orig_F); //What LBA are we going to try to read!
 				if (((disks[device].selectedtrack == cue_current.status.track_number) || (disks[device].selectedtrack==0)) &&
 					((disks[device].selectedsubtrack == cue_current.status.index) || (disks[device].selectedsubtrack==0))) //Current track number and subtrack number to lookup?
@@ -749,6 +861,11 @@ int_64 cueimage_REAL_readsector(int device, byte *M, byte *S, byte *F, byte *sta
 				gap_startAddr = cue_status.MSFPosition; //The pregap starts after the previous track!
 				gap_endAddr = gap_startAddr + (LBA - 1); //The end of the gap!
 				//Handle the pregap now!
+				if (cueimage_building) //Building the table?
+				{
+					cueimage_addgap(gap_startAddr, gap_endAddr); //Add the gap!
+					goto notthispregap2; //Don't check the sector!
+				}
 				if (CUE_MSF2LBA(orig_M, orig_S, orig_F) < gap_startAddr) goto notthispregap2; //Before start? Not us!
 				if (CUE_MSF2LBA(orig_M, orig_S, orig_F) > gap_endAddr) goto notthispregap2; //After end? not us!
 				//We're this pregap!
@@ -1060,6 +1177,11 @@ int_64 cueimage_REAL_readsector(int device, byte *M, byte *S, byte *F, byte *sta
 						gap_endAddr = gap_startAddr + (cue_next.status.postgap_pending_duration - 1); //The end of the gap!
 						cue_next.status.MSFPosition += (LBA - prev_LBA) + 1; //Add the previous track size of the final entry!
 						//Handle the postgap for the previous track now!
+						if (cueimage_building) //Building the table?
+						{
+							cueimage_addgap(gap_startAddr, gap_endAddr); //Add the gap!
+							goto notthispostgap3; //Don't check the sector!
+						}
 						if (CUE_MSF2LBA(orig_M, orig_S, orig_F) < gap_startAddr) goto notthispostgap3; //Before start? Not us!
 						if (CUE_MSF2LBA(orig_M, orig_S, orig_F) > gap_endAddr) goto notthispostgap3; //After end? not us!
 						//We're this postgap!
@@ -1085,6 +1207,14 @@ int_64 cueimage_REAL_readsector(int device, byte *M, byte *S, byte *F, byte *sta
 					*S = *endS;
 					*F = *endF;
 
+					if (cueimage_building) //Building the table?
+					{
+						if (cue_current.status.got_file && cue_current.status.got_index && cue_current.status.index) //Got file and a valid index(index 0 is a pregap) to lookup?
+						{
+							cueimage_addentry(&cue_current); //Add the index!
+						}
+						goto finishMSFscan2; //Continue scanning!
+					}
 					LBA = CUE_MSF2LBA(orig_M, orig_S, orig_F); //What LBA are we going to try to read!
 					if (cue_current.status.MSFPosition >= (LBA + 1)) goto finishMSFscan2; //Invalid to read(non-zero length)?
 					if (((disks[device].selectedtrack == cue_current.status.track_number) || (disks[device].selectedtrack == 0)) &&
@@ -1246,6 +1376,11 @@ int_64 cueimage_REAL_readsector(int device, byte *M, byte *S, byte *F, byte *sta
 			gap_endAddr = gap_startAddr + (cue_next.status.postgap_pending_duration - 1); //The end of the gap!
 			cue_next.status.MSFPosition += (LBA - prev_LBA) + 1; //Add the previous track size of the final entry!
 			//Handle the postgap for the previous track now!
+			if (cueimage_building) //Building the table?
+			{
+				cueimage_addgap(gap_startAddr, gap_endAddr); //Add the gap!
+				goto notthispostgap2; //Don't check the sector!
+			}
 			if (CUE_MSF2LBA(orig_M,orig_S,orig_F)<gap_startAddr) goto notthispostgap2; //Before start? Not us!
 			if (CUE_MSF2LBA(orig_M,orig_S,orig_F)>gap_endAddr) goto notthispostgap2; //After end? not us!
 			//We're this postgap!
@@ -1271,6 +1406,14 @@ int_64 cueimage_REAL_readsector(int device, byte *M, byte *S, byte *F, byte *sta
 		*S = *endS;
 		*F = *endF;
 
+		if (cueimage_building) //Building the table?
+		{
+			if (cue_current.status.got_file && cue_current.status.got_index && cue_current.status.index) //Got file and a valid index(index 0 is a pregap) to lookup?
+			{
+				cueimage_addentry(&cue_current); //Add the index!
+			}
+			goto finishup; //Continue scanning!
+		}
 		LBA = CUE_MSF2LBA(orig_M, orig_S, orig_F); //What LBA are we going to try to read!
 		if (cue_current.status.MSFPosition >= (LBA+1)) goto finishup; //Invalid to read(non-zero length)?
 		if (((disks[device].selectedtrack == cue_current.status.track_number) || (disks[device].selectedtrack==0)) &&
@@ -1356,10 +1499,189 @@ int_64 cueimage_REAL_readsector(int device, byte *M, byte *S, byte *F, byte *sta
 	return result; //Failed!
 }
 
+void cueimage_invalidate(int device) //Discard the parsed cue sheet of a device!
+{
+	CUEIMAGE_TABLE *table;
+	if ((device != CDROM0) && (device != CDROM1)) return; //Invalid disk!
+	table = &cueimage_tables[device - CDROM0]; //The table of the device!
+	if (table->source) //Backend file opened?
+	{
+		emufclose64(table->source); //Close it!
+		table->source = NULL; //Closed!
+	}
+	table->state = 0; //Not parsed anymore!
+	table->prefetchsize = 0; //Nothing prefetched!
+}
+
+CUEIMAGE_TABLE *cueimage_gettable(int device) //Retrieves the parsed cue sheet of a device, parsing it if needed! NULL when it can't be used!
+{
+	CUEIMAGE_TABLE *table;
+	CUEIMAGE_INDEXENTRY *entry;
+	byte M, S, F, startM, startS, startF, endM, endS, endF;
+	byte orig_selectedtrack, orig_selectedsubtrack;
+	if ((device != CDROM0) && (device != CDROM1)) return NULL; //Invalid disk!
+	if (!isext(disks[device].filename, "cue")) return NULL; //Not a cue sheet!
+	table = &cueimage_tables[device - CDROM0]; //The table of the device!
+	if (table->state && (strcmp(table->filename, disks[device].filename) != 0)) //Another cue sheet mounted?
+	{
+		cueimage_invalidate(device); //Parse the new cue sheet!
+	}
+	switch (table->state) //What state?
+	{
+	case 1: //Parsed?
+		return table; //Give the table!
+	case 2: //Unusable?
+		return NULL; //Use the cue sheet scan!
+	default: //Not parsed yet?
+		break;
+	}
+	safestrcpy(table->filename, sizeof(table->filename), disks[device].filename); //What cue sheet are we parsing?
+	table->numentries = table->numgaps = table->numfiles = 0; //Nothing parsed yet!
+	table->state = 1; //Default: usable!
+	//Scan the entire cue sheet once for all tracks and subtracks, recording everything in our table!
+	orig_selectedtrack = disks[device].selectedtrack;
+	orig_selectedsubtrack = disks[device].selectedsubtrack;
+	disks[device].selectedtrack = disks[device].selectedsubtrack = 0; //All tracks and subtracks!
+	M = 0xFF;
+	S = 59;
+	F = 74;
+	cueimage_building = table; //We're building this table!
+	if (cueimage_REAL_readsector(device, &M, &S, &F, &startM, &startS, &startF, &endM, &endS, &endF, NULL, 0, 0) == 0) //Failed to scan the cue sheet?
+	{
+		table->state = 0; //Try again next time!
+	}
+	cueimage_building = NULL; //Finished building!
+	disks[device].selectedtrack = orig_selectedtrack;
+	disks[device].selectedsubtrack = orig_selectedsubtrack;
+	if (table->state != 1) return NULL; //Unusable?
+	//Check if we can use a binary search!
+	table->sorted = 1; //Default: sorted!
+	for (entry = &table->entries[1]; entry < &table->entries[table->numentries]; ++entry) //Check all entries!
+	{
+		if ((entry->startLBA > entry->endLBA) || (entry->startLBA <= entry[-1].endLBA)) //Not ascending or overlapping?
+		{
+			table->sorted = 0; //Do a linear search instead!
+			break;
+		}
+	}
+	if (table->numentries && (table->entries[0].startLBA > table->entries[0].endLBA)) table->sorted = 0; //Invalid first entry?
+	return table; //Give the table!
+}
+
+OPTINLINE byte cueimage_matchentry(int device, CUEIMAGE_INDEXENTRY *entry) //Is the entry selected?
+{
+	return (((disks[device].selectedtrack == entry->track_number) || (disks[device].selectedtrack == 0)) &&
+		((disks[device].selectedsubtrack == entry->index) || (disks[device].selectedsubtrack == 0))); //Current track number and subtrack number to lookup?
+}
+
+CUEIMAGE_INDEXENTRY *cueimage_lookupLBA(int device, CUEIMAGE_TABLE *table, uint_32 LBA) //Find the index containing a LBA!
+{
+	CUEIMAGE_INDEXENTRY *entry;
+	word low, high, middle;
+	if (table->sorted) //Binary search?
+	{
+		low = 0;
+		high = table->numentries; //Search range!
+		for (; low < high;) //Anything left to search?
+		{
+			middle = ((low + high) >> 1); //The entry to check!
+			entry = &table->entries[middle];
+			if (LBA < entry->startLBA) high = middle; //Before it?
+			else if (LBA > entry->endLBA) low = middle + 1; //After it?
+			else return cueimage_matchentry(device, entry) ? entry : NULL; //Found! Nothing else contains it!
+		}
+		return NULL; //Not found!
+	}
+	for (entry = &table->entries[0]; entry < &table->entries[table->numentries]; ++entry) //Check all entries in the order of the cue sheet!
+	{
+		if ((entry->startLBA <= LBA) && (entry->endLBA >= LBA) && cueimage_matchentry(device, entry)) return entry; //Found!
+	}
+	return NULL; //Not found!
+}
+
+int_64 cueimage_gapresult(CUEIMAGE_TABLE *table, word numgaps, uint_32 LBA) //The result when not finding the LBA after parsing numgaps gaps!
+{
+	CUEIMAGE_GAPENTRY *gap;
+	int_64 result = -1; //Default: out of range!
+	for (gap = &table->gaps[0]; gap < &table->gaps[numgaps]; ++gap) //Check all parsed gaps!
+	{
+		if ((LBA >= gap->startLBA) && (LBA <= gap->endLBA)) //Inside the gap?
+		{
+			result = (-2LL - (int_64)((gap->endLBA - LBA) + 1)); //Give the result as the difference until the next track!
+		}
+	}
+	return result; //Give the result!
+}
+
+int_64 cueimage_readindexed(int device, CUEIMAGE_TABLE *table, uint_32 LBA, void *buffer, word size) //Read a n-byte sector using the parsed cue sheet! Result=Type on success, 0 on error, -1 on not found!
+{
+	CUEIMAGE_INDEXENTRY *entry;
+	char fullfilename[256];
+	FILEPOS datapos;
+	int_64 prefetched;
+	if (!(entry = cueimage_lookupLBA(device, table, LBA))) //Not found?
+	{
+		return cueimage_gapresult(table, table->numgaps, LBA); //Not found or in a gap!
+	}
+	if (!entry->binary) //Not supported file backend type?
+	{
+		return cueimage_gapresult(table, entry->gaps, LBA); //Finish up!
+	}
+	if ((size != entry->track_mode->sectorsize) && buffer && size) return 0; //Invalid sector size not matching specified! Only apply when specifying a sector size(non-zero size)!
+	if (buffer == NULL) return 1; //Finished reading without buffer and size! Size 0 with a buffer is allowed!
+	if ((table->source == NULL) || (table->sourcefile != entry->filenr)) //Backend file isn't opened yet?
+	{
+		if (table->source) //Another file opened?
+		{
+			emufclose64(table->source); //Close it!
+			table->source = NULL; //Closed!
+		}
+		table->prefetchsize = 0; //Nothing prefetched!
+		memset(&fullfilename, 0, sizeof(fullfilename)); //Init!
+		safestrcpy(fullfilename, sizeof(fullfilename), diskpath); //Disk path!
+		safestrcat(fullfilename, sizeof(fullfilename), "/");
+		safestrcat(fullfilename, sizeof(fullfilename), table->files[entry->filenr]); //The full filename!
+		table->source = emufopen64(fullfilename, "rb"); //Open the backend data file!
+		if (!table->source) return cueimage_gapresult(table, entry->gaps, LBA); //Couldn't open the source!
+		if (emufseek64(table->source, 0, SEEK_END) != 0) //Can't seek to the end?
+		{
+			emufclose64(table->source);
+			table->source = NULL; //Closed!
+			return 0; //Can't seek to the end!
+		}
+		table->sourcesize = emuftell64(table->source); //What is the size of the file!
+		table->sourcefile = entry->filenr; //What file is opened!
+	}
+	if (entry->datafilepos >= table->sourcesize) return 0; //Past EOF!
+	datapos = entry->datafilepos + ((LBA - entry->startLBA)*entry->track_mode->sectorsize); //Where to read!
+	if (datapos >= table->sourcesize) return 0; //Past EOF!
+	if ((datapos + entry->track_mode->sectorsize) > table->sourcesize) return 0; //Past EOF!
+	if (size) //Something to read at all?
+	{
+		if ((datapos < table->prefetchpos) || ((datapos + size) > (table->prefetchpos + table->prefetchsize))) //Not prefetched?
+		{
+			table->prefetchsize = 0; //Nothing prefetched anymore!
+			if (emufseek64(table->source, datapos, SEEK_SET) != 0) return 0; //Couldn't seek to sector!
+			prefetched = emufread64(&table->prefetch, 1, MIN(sizeof(table->prefetch), (table->sourcesize - datapos)), table->source); //Read the sector and what's following it!
+			if (prefetched < size) return 0; //Couldn't read the data!
+			table->prefetchpos = datapos; //Where have we prefetched!
+			table->prefetchsize = (uint_32)prefetched; //How much has been prefetched!
+		}
+		memcpy(buffer, &table->prefetch[datapos - table->prefetchpos], size); //Give the data!
+	}
+	//Data has been read from the backend file(or nothing)!
+	return 1 + entry->track_mode->mode; //We've found the location of our data! Give 2+mode for the read sector type!
+}
+
 int_64 cueimage_readsector(int device, byte M, byte S, byte F, void *buffer, word size) //Read a n-byte sector! Result=Type on success, 0 on error, -1 on not found!
 {
 	byte startM, startS, startF, endM, endS, endF;
 	byte M2, S2, F2; //Duplicates for handling!
+	CUEIMAGE_TABLE *table;
+	if ((table = cueimage_gettable(device)) != NULL) //Parsed cue sheet?
+	{
+		return cueimage_readindexed(device, table, CUE_MSF2LBA(M, S, F), buffer, size); //Lookup in the parsed cue sheet!
+	}
 	M2 = M; //Requested minute!
 	S2 = S; //Requested second!
 	F2 = F; //Requested frame!
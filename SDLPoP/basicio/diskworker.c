@@ -0,0 +1,403 @@
+/*
+
+Copyright (C) 2019 - 2021 Superfury
+
+This file is part of UniPCemu.
+
+UniPCemu is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+UniPCemu is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with UniPCemu.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "headers/basicio/diskworker.h" //Our own definitions!
+#include "headers/basicio/io.h" //Basic I/O support!
+#include "headers/support/zalloc.h" //Memory allocation support!
+#include "headers/support/log.h" //Logging support!
+#include "headers/support/locks.h" //Locking support!
+#include "headers/emu/threads.h" //Thread support!
+
+/*
+
+Disk I/O worker: performs read-ahead and posted writes (write-behind) on a background thread.
+
+All requests are executed in order, so a read-ahead posted after a write sees the written data.
+Any direct read or write of a device waits for its posted writes first, so all users of the disk images keep seeing the same data.
+Disk image accesses themselves are serialized using the I/O lock, so the worker and direct accesses never access the images at the same time.
+
+*/
+
+//Amount of requests that can be queued at once! Each posted write takes one entry!
+#define DISKWORKER_QUEUESIZE 16
+//Amount of devices supporting read-ahead (FLOPPY0 up to CDROM1)!
+#define DISKWORKER_DEVICES 6
+
+#define DISKWORKER_READAHEAD 1
+#define DISKWORKER_WRITE 2
+
+typedef struct
+{
+	byte type; //What kind of request?
+	int device; //The device to access!
+	uint_64 startpos; //Start position on the device!
+	uint_32 size; //Size in bytes!
+	uint_32 generation; //Read-ahead generation, to detect discarded read-aheads!
+	byte busy; //Being executed by the worker? Can't be extended anymore!
+	byte *data; //The data to write! Read-aheads read into the cache of the device instead!
+} DISKWORKER_REQUEST;
+
+typedef struct
+{
+	byte state; //0=Empty, 1=Being read, 2=Ready, 3=Failed
+	uint_64 startpos; //Start position of the data!
+	uint_32 size; //Size of the data!
+	uint_32 generation; //Current generation! Changes whenever the read-ahead is discarded!
+	byte *data; //The read-ahead data!
+} DISKWORKER_READAHEADCACHE;
+
+extern IODISK disks[0x100]; //All disks available, for finding custom disks on top of a device!
+
+//The queue and caches are protected by LOCK_DISKWORKER, the disk images by LOCK_DISKIO!
+ThreadParams_p diskworker_thread = NULL; //The worker thread!
+SDL_sem *diskworker_done = NULL; //Posted once for each waiting thread whenever a request has finished!
+SDL_sem *diskworker_work = NULL; //Posted whenever a request has been queued!
+uint_32 diskworker_waiting = 0; //Amount of threads waiting on diskworker_done!
+byte diskworker_quit = 0; //Terminate the worker?
+
+DISKWORKER_REQUEST diskworker_queue[DISKWORKER_QUEUESIZE]; //All queued requests!
+byte diskworker_queuehead = 0; //First request in the queue!
+byte diskworker_queued = 0; //Amount of requests in the queue!
+DISKWORKER_READAHEADCACHE diskworker_cache[DISKWORKER_DEVICES]; //Read-ahead data for all devices!
+uint_32 diskworker_pending[0x100]; //Posted writes pending for each device!
+byte diskworker_writeerror[0x100]; //Posted write failed for each device!
+
+OPTINLINE void diskworker_waitdone() //Wait for the worker to finish a request! LOCK_DISKWORKER must be held, and is held again afterwards!
+{
+	++diskworker_waiting; //We're waiting!
+	unlock(LOCK_DISKWORKER);
+	WaitSem(diskworker_done) //Wait for a request to finish!
+	lock(LOCK_DISKWORKER);
+}
+
+void diskworker_threadfunc()
+{
+	DISKWORKER_REQUEST request;
+	byte result;
+	for (;;) //Keep working!
+	{
+		WaitSem(diskworker_work) //Wait for work!
+		lock(LOCK_DISKWORKER);
+		if (diskworker_queued==0) //Nothing to do?
+		{
+			unlock(LOCK_DISKWORKER);
+			if (diskworker_quit) break; //Terminating?
+			continue; //Wait for more!
+		}
+		diskworker_queue[diskworker_queuehead].busy = 1; //We're executing it!
+		memcpy(&request,&diskworker_queue[diskworker_queuehead],sizeof(request)); //The request to handle! Stays in the queue until finished!
+		unlock(LOCK_DISKWORKER);
+
+		//Execute the request!
+		lock(LOCK_DISKIO);
+		if (request.type==DISKWORKER_READAHEAD) //Read-ahead?
+		{
+			result = readdata_direct(request.device,diskworker_cache[request.device].data,request.startpos,request.size); //Read the data into the cache!
+		}
+		else //Posted write?
+		{
+			result = writedata_direct(request.device,request.data,request.startpos,request.size); //Write the data!
+		}
+		unlock(LOCK_DISKIO);
+
+		//Finish the request!
+		lock(LOCK_DISKWORKER);
+		if (request.type==DISKWORKER_READAHEAD) //Read-ahead?
+		{
+			if (diskworker_cache[request.device].generation==request.generation) //Still wanted?
+			{
+				diskworker_cache[request.device].state = result?2:3; //Ready or failed!
+			}
+		}
+		else //Posted write?
+		{
+			if (!result) //Failed?
+			{
+				diskworker_writeerror[request.device] = 1; //Report at the next write or flush!
+				dolog("IO","diskworker: Posted write of %u bytes at %u to device %i failed!",request.size,(uint_32)request.startpos,request.device);
+			}
+			--diskworker_pending[request.device]; //One less pending!
+		}
+		diskworker_queue[diskworker_queuehead].busy = 0; //Finished!
+		diskworker_queuehead = ((diskworker_queuehead+1)%DISKWORKER_QUEUESIZE); //Next request!
+		--diskworker_queued; //Finished!
+		for (;diskworker_waiting;--diskworker_waiting) //Anyone waiting?
+		{
+			PostSem(diskworker_done) //We've finished a request!
+		}
+		unlock(LOCK_DISKWORKER);
+	}
+}
+
+void startDiskWorker() //Start the disk I/O worker thread, if possible!
+{
+	byte entry;
+	if (diskworker_thread) return; //Already running!
+	diskworker_done = SDL_CreateSemaphore(0); //Nobody waiting yet!
+	diskworker_work = SDL_CreateSemaphore(0); //No work yet!
+	memset(&diskworker_queue,0,sizeof(diskworker_queue)); //Init queue!
+	memset(&diskworker_cache,0,sizeof(diskworker_cache)); //Init caches!
+	memset(&diskworker_pending,0,sizeof(diskworker_pending)); //Nothing pending!
+	memset(&diskworker_writeerror,0,sizeof(diskworker_writeerror)); //No errors!
+	diskworker_queuehead = diskworker_queued = 0; //Nothing queued!
+	diskworker_waiting = 0; //Nobody waiting!
+	diskworker_quit = 0; //Not quitting!
+	if (!(diskworker_done && diskworker_work)) goto failedstart; //Failed to allocate?
+	for (entry=0;entry<DISKWORKER_QUEUESIZE;++entry) //Allocate all posted write buffers!
+	{
+		if ((diskworker_queue[entry].data = (byte *)zalloc(DISKWORKER_BLOCKSIZE,"DISKWORKER_QUEUE",NULL))==NULL) goto failedstart; //Failed?
+	}
+	for (entry=0;entry<DISKWORKER_DEVICES;++entry) //Allocate all read-ahead buffers!
+	{
+		if ((diskworker_cache[entry].data = (byte *)zalloc(DISKWORKER_BLOCKSIZE,"DISKWORKER_CACHE",NULL))==NULL) goto failedstart; //Failed?
+	}
+	diskworker_thread = startThread(&diskworker_threadfunc,"UniPCemu_DiskWorker",NULL); //Start the worker!
+	if (diskworker_thread) return; //Started!
+	dolog("IO","Unable to start disk I/O worker thread!");
+	failedstart: //Failed to start? Use direct accesses only!
+	for (entry=0;entry<DISKWORKER_QUEUESIZE;++entry) //Free all posted write buffers!
+	{
+		if (diskworker_queue[entry].data) freez((void **)&diskworker_queue[entry].data,DISKWORKER_BLOCKSIZE,"DISKWORKER_QUEUE");
+	}
+	for (entry=0;entry<DISKWORKER_DEVICES;++entry) //Free all read-ahead buffers!
+	{
+		if (diskworker_cache[entry].data) freez((void **)&diskworker_cache[entry].data,DISKWORKER_BLOCKSIZE,"DISKWORKER_CACHE");
+	}
+	if (diskworker_done) SDL_DestroySemaphore(diskworker_done);
+	if (diskworker_work) SDL_DestroySemaphore(diskworker_work);
+	diskworker_done = NULL;
+	diskworker_work = NULL;
+}
+
+void doneDiskWorker() //Flush all posted writes and stop the disk I/O worker thread!
+{
+	byte entry;
+	if (diskworker_thread==NULL) return; //Not running!
+	diskworker_flush(-1); //Write everything that's posted!
+	lock(LOCK_DISKWORKER);
+	while (diskworker_queued) //Read-aheads still running?
+	{
+		diskworker_waitdone(); //Wait for them to finish!
+	}
+	diskworker_quit = 1; //Request to quit!
+	unlock(LOCK_DISKWORKER);
+	PostSem(diskworker_work) //Wake up!
+	waitThreadEnd(diskworker_thread); //Wait for it to finish!
+	diskworker_thread = NULL; //Not running anymore!
+	for (entry=0;entry<DISKWORKER_QUEUESIZE;++entry) //Free all posted write buffers!
+	{
+		freez((void **)&diskworker_queue[entry].data,DISKWORKER_BLOCKSIZE,"DISKWORKER_QUEUE");
+	}
+	for (entry=0;entry<DISKWORKER_DEVICES;++entry) //Free all read-ahead buffers!
+	{
+		freez((void **)&diskworker_cache[entry].data,DISKWORKER_BLOCKSIZE,"DISKWORKER_CACHE");
+	}
+	SDL_DestroySemaphore(diskworker_done);
+	SDL_DestroySemaphore(diskworker_work);
+	diskworker_done = NULL;
+	diskworker_work = NULL;
+}
+
+OPTINLINE DISKWORKER_REQUEST *diskworker_allocrequest() //Allocate a new request at the end of the queue! Queue lock must be held!
+{
+	while (diskworker_queued==DISKWORKER_QUEUESIZE) //Queue full?
+	{
+		diskworker_waitdone(); //Wait for a request to finish!
+	}
+	return &diskworker_queue[(diskworker_queuehead+diskworker_queued)%DISKWORKER_QUEUESIZE]; //The new request!
+}
+
+OPTINLINE void diskworker_postrequest() //Post the allocated request! Queue lock must be held!
+{
+	++diskworker_queued; //Queued!
+	PostSem(diskworker_work) //Start working!
+}
+
+OPTINLINE void diskworker_discard(int device) //Discard read-ahead data! Queue lock must be held!
+{
+	if ((device<0) || (device>=DISKWORKER_DEVICES)) return; //No read-ahead for this device!
+	diskworker_cache[device].state = 0; //Empty!
+	++diskworker_cache[device].generation; //Discard any running read-ahead!
+}
+
+OPTINLINE void diskworker_discardwritten(int device) //Discard read-ahead data of a device that's written, including custom disks reading from it! Queue lock must be held!
+{
+	int customdevice;
+	diskworker_discard(device); //The device itself!
+	for (customdevice=0;customdevice<DISKWORKER_DEVICES;++customdevice) //Check all custom disks!
+	{
+		if (disks[customdevice].customdisk.used && (disks[customdevice].customdisk.device==device)) //Reading from the written device?
+		{
+			diskworker_discard(customdevice); //Its read-ahead data is outdated too!
+		}
+	}
+}
+
+void diskworker_readahead(int device, uint_64 startpos, uint_32 bytestoread) //Start reading data we're going to need in the background!
+{
+	DISKWORKER_REQUEST *request;
+	DISKWORKER_READAHEADCACHE *cache;
+	if (diskworker_thread==NULL) return; //Not running!
+	if ((device<0) || (device>=DISKWORKER_DEVICES)) return; //No read-ahead for this device!
+	if ((bytestoread==0) || (bytestoread>DISKWORKER_BLOCKSIZE)) return; //Invalid size!
+	lock(LOCK_DISKWORKER);
+	cache = &diskworker_cache[device]; //Our cache!
+	if ((cache->state==1) || (cache->state==2)) //Being read or ready?
+	{
+		if ((startpos>=cache->startpos) && (startpos<(cache->startpos+cache->size))) //Still reading ahead of this? Don't restart until it's used up!
+		{
+			unlock(LOCK_DISKWORKER);
+			return; //Nothing to do!
+		}
+	}
+	if (diskworker_queued==DISKWORKER_QUEUESIZE) //Queue full? Don't wait for a read-ahead!
+	{
+		unlock(LOCK_DISKWORKER);
+		return; //Skip the read-ahead!
+	}
+	diskworker_discard(device); //Discard the old read-ahead!
+	cache->state = 1; //Being read!
+	cache->startpos = startpos; //Start!
+	cache->size = bytestoread; //Size!
+	request = diskworker_allocrequest(); //New request!
+	request->type = DISKWORKER_READAHEAD; //Read-ahead!
+	request->device = device; //The device!
+	request->startpos = startpos; //Start!
+	request->size = bytestoread; //Size!
+	request->generation = cache->generation; //The generation we're reading!
+	diskworker_postrequest(); //Start it!
+	unlock(LOCK_DISKWORKER);
+}
+
+byte diskworker_read(int device, void *buffer, uint_64 startpos, uint_32 bytestoread) //Read data, using read-ahead data when available. Stalls when it's still being read!
+{
+	DISKWORKER_READAHEADCACHE *cache;
+	if ((diskworker_thread==NULL) || (device<0) || (device>=DISKWORKER_DEVICES)) //No read-ahead?
+	{
+		return readdata(device,buffer,startpos,bytestoread); //Read directly!
+	}
+	lock(LOCK_DISKWORKER);
+	cache = &diskworker_cache[device]; //Our cache!
+	if (((cache->state==1) || (cache->state==2)) && (startpos>=cache->startpos) && ((startpos+bytestoread)<=(cache->startpos+cache->size))) //Read ahead?
+	{
+		while (cache->state==1) //Still being read?
+		{
+			diskworker_waitdone(); //Stall until it's ready!
+		}
+		if (cache->state==2) //Ready?
+		{
+			memcpy(buffer,&cache->data[startpos-cache->startpos],bytestoread); //Give the data!
+			unlock(LOCK_DISKWORKER);
+			return 1; //Success!
+		}
+	}
+	unlock(LOCK_DISKWORKER);
+	return readdata(device,buffer,startpos,bytestoread); //Read directly, reporting any errors!
+}
+
+byte diskworker_write(int device, void *buffer, uint_64 startpos, uint_32 bytestowrite) //Post a write to be written in the background (write-behind)!
+{
+	DISKWORKER_REQUEST *request;
+	if ((diskworker_thread==NULL) || ((device&0xFF)!=device) || (bytestowrite>DISKWORKER_BLOCKSIZE) || drivereadonly(device)) //Not posting this write? Read-only drives report their errors directly!
+	{
+		return writedata(device,buffer,startpos,bytestowrite); //Write directly!
+	}
+	lock(LOCK_DISKWORKER);
+	if (diskworker_writeerror[device]) //A posted write has failed?
+	{
+		diskworker_writeerror[device] = 0; //Reported!
+		unlock(LOCK_DISKWORKER);
+		return 0; //Report the error!
+	}
+	diskworker_discardwritten(device); //The read-ahead data is outdated!
+	if (diskworker_queued) //Something queued?
+	{
+		request = &diskworker_queue[(diskworker_queuehead+diskworker_queued-1)%DISKWORKER_QUEUESIZE]; //The last request!
+		if ((request->type==DISKWORKER_WRITE) && (request->busy==0) && (request->device==device) && ((request->startpos+request->size)==startpos) && ((request->size+bytestowrite)<=DISKWORKER_BLOCKSIZE)) //Continuing a posted write that's still waiting?
+		{
+			memcpy(&request->data[request->size],buffer,bytestowrite); //Add the data to write!
+			request->size += bytestowrite; //Extend the request!
+			unlock(LOCK_DISKWORKER);
+			return 1; //Posted!
+		}
+	}
+	request = diskworker_allocrequest(); //New request!
+	request->type = DISKWORKER_WRITE; //Posted write!
+	request->device = device; //The device!
+	request->startpos = startpos; //Start!
+	request->size = bytestowrite; //Size!
+	memcpy(request->data,buffer,bytestowrite); //Copy the data to write into the buffer of the request!
+	++diskworker_pending[device]; //One more pending!
+	diskworker_postrequest(); //Start it!
+	unlock(LOCK_DISKWORKER);
+	return 1; //Posted!
+}
+
+OPTINLINE byte diskworker_waitwrites(int device, byte consumeerrors) //Wait for all posted writes of a device (-1 for all devices) to be written!
+{
+	byte result;
+	int currentdevice;
+	if (diskworker_thread==NULL) return 1; //Nothing to flush!
+	if ((device>=0) && ((device&0xFF)!=device)) return 1; //Invalid device!
+	result = 1; //Default: OK!
+	lock(LOCK_DISKWORKER);
+	for (currentdevice=((device<0)?0:device);currentdevice<=((device<0)?0xFF:device);++currentdevice) //Check all requested devices!
+	{
+		while (diskworker_pending[currentdevice]) //Still pending?
+		{
+			diskworker_waitdone(); //Wait for it to be written!
+		}
+		if (diskworker_writeerror[currentdevice] && consumeerrors) //Failed and reporting it?
+		{
+			diskworker_writeerror[currentdevice] = 0; //Reported!
+			result = 0; //Error!
+		}
+	}
+	unlock(LOCK_DISKWORKER);
+	return result; //Give the result!
+}
+
+byte diskworker_flush(int device) //Wait for all posted writes of a device (-1 for all devices) to be written! Result: 0 when a posted write has failed!
+{
+	return diskworker_waitwrites(device,1); //Flush, reporting errors!
+}
+
+void diskworker_sync(int device) //Wait for all posted writes of a device to be written, keeping errors for the next flush!
+{
+	diskworker_waitwrites(device,0); //Wait for them! Checks the pending writes while holding the lock!
+}
+
+void diskworker_invalidate(int device) //Discard any read-ahead data of a device, including custom disks reading from it!
+{
+	if (diskworker_thread==NULL) return; //Not running!
+	lock(LOCK_DISKWORKER);
+	diskworker_discardwritten(device); //Discard it, including custom disks reading from it!
+	unlock(LOCK_DISKWORKER);
+}
+
+void diskworker_lockIO() //Lock the disk images for I/O!
+{
+	lock(LOCK_DISKIO); //Lock!
+}
+
+void diskworker_unlockIO() //Unlock the disk images for I/O!
+{
+	unlock(LOCK_DISKIO); //Unlock!
+}
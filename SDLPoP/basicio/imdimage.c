@@ -106,6 +106,147 @@ Each data record starts with a ID, followed by one byte for compressed records(e
 
 */
 
+//Track index: the location of each track in the images that are accessed, so the tracks before it don't need to be walked for every access.
+#define IMDIMAGE_MAXINDEXES 4
+
+typedef struct
+{
+	char filename[256]; //The indexed image!
+	FILEPOS filesize; //The size of the image that's indexed! Any other size means the index is outdated!
+	FILEPOS trackpos[0x100][2]; //The position of the track information block of each cylinder and head. 0 when not indexed!
+} IMDIMAGE_TRACKINDEX;
+
+IMDIMAGE_TRACKINDEX IMDimage_trackindex[IMDIMAGE_MAXINDEXES]; //All track indexes!
+byte IMDimage_nexttrackindex = 0; //The next track index to replace!
+
+void IMDimage_invalidatetrackindex(char* filename) //The image is changed in a way that the index can't follow!
+{
+	byte i;
+	for (i = 0; i < NUMITEMS(IMDimage_trackindex); ++i) //Check all indexes!
+	{
+		if (strcmp(IMDimage_trackindex[i].filename, filename) == 0) //Found?
+		{
+			memset(&IMDimage_trackindex[i], 0, sizeof(IMDimage_trackindex[i])); //Clear the index!
+		}
+	}
+}
+
+void IMDimage_buildtrackindex(IMDIMAGE_TRACKINDEX* index, BIGFILE* f, FILEPOS filepos, FILEPOS filesize) //Index all tracks starting at the current position!
+{
+	TRACKINFORMATIONBLOCK trackinfo;
+	FILEPOS trackpos;
+	word sectorsizemap[0x100]; //Sector size map!
+	word sectornumber;
+	byte data;
+	for (; (filepos + sizeof(trackinfo)) <= filesize;) //Tracks left to index?
+	{
+		trackpos = filepos; //The start of the track!
+		if (emufread64(&trackinfo, 1, sizeof(trackinfo), f) != sizeof(trackinfo)) return; //Failed to read track info?
+		filepos += sizeof(trackinfo); //Read!
+		if (index->trackpos[trackinfo.cylinder][trackinfo.head_extrabits & IMD_HEAD_HEADNUMBER] == 0) //First one found is the one that's used!
+		{
+			index->trackpos[trackinfo.cylinder][trackinfo.head_extrabits & IMD_HEAD_HEADNUMBER] = trackpos; //Where is the track located!
+		}
+		//Skip the sector number, cylinder and head maps!
+		filepos += trackinfo.sectorspertrack; //Sector number map!
+		if ((trackinfo.SectorSize > 6) && (trackinfo.SectorSize != IMD_SECTORSIZE_SECTORSIZEMAPPRESENT)) return; //Unsupported sector size!
+		if (trackinfo.head_extrabits & IMD_HEAD_CYLINDERMAPPRESENT) filepos += trackinfo.sectorspertrack; //Cylinder map!
+		if (trackinfo.head_extrabits & IMD_HEAD_HEADMAPPRESENT) filepos += trackinfo.sectorspertrack; //Head map!
+		if (filepos > filesize) return; //Invalid track!
+		if (emufseek64(f, filepos, SEEK_SET) < 0) return; //Failed to skip the maps?
+		if (trackinfo.SectorSize == IMD_SECTORSIZE_SECTORSIZEMAPPRESENT) //Sector size map following?
+		{
+			if ((filepos + (trackinfo.sectorspertrack << 1)) > filesize) return; //Invalid track!
+			if (emufread64(&sectorsizemap, 1, (trackinfo.sectorspertrack << 1), f) != (trackinfo.sectorspertrack << 1)) return; //Failed to read the sector size map?
+			filepos += (trackinfo.sectorspertrack << 1); //Read!
+			for (sectornumber = 0; sectornumber < trackinfo.sectorspertrack; ++sectornumber) //Patch as needed!
+			{
+				sectorsizemap[sectornumber] = SDL_SwapLE16(sectorsizemap[sectornumber]); //Swap all byte ordering to be readable!
+			}
+		}
+		for (sectornumber = 0; sectornumber < trackinfo.sectorspertrack; ++sectornumber) //Process all sectors on the track!
+		{
+			if (filepos >= filesize) return; //No identifier left?
+			if (emufread64(&data, 1, sizeof(data), f) != sizeof(data)) return; //Read the identifier!
+			++filepos; //Read!
+			if (data > 8) return; //Undefined value?
+			if (data) //Not one that's unavailable?
+			{
+				if (data & 1) //Normal sector with or without mark, data error or deleted?
+				{
+					filepos += (trackinfo.SectorSize == IMD_SECTORSIZE_SECTORSIZEMAPPRESENT) ? sectorsizemap[sectornumber] : SECTORSIZE_BYTES(trackinfo.SectorSize); //Skip the sector's data!
+				}
+				else //Compressed?
+				{
+					++filepos; //Skip the compressed data!
+				}
+				if (filepos > filesize) return; //Invalid track!
+				if (emufseek64(f, filepos, SEEK_SET) < 0) return; //Skip the data!
+			}
+		}
+	}
+}
+
+byte IMDimage_seektrack(char* filename, BIGFILE* f, byte track, byte head) //Seek to the track information block of a track using the track index! 0=Not indexed(f is unchanged), 1=Found
+{
+	IMDIMAGE_TRACKINDEX* index;
+	FILEPOS filepos, filesize;
+	byte i;
+	if (head > 1) return 0; //Invalid head!
+	filepos = emuftell64(f); //Where are we(the first track)?
+	if (emufseek64(f, 0, SEEK_END) < 0) return 0; //Couldn't goto EOF?
+	filesize = emuftell64(f); //The size of the file!
+	for (i = 0; i < NUMITEMS(IMDimage_trackindex); ++i) //Check all indexes!
+	{
+		index = &IMDimage_trackindex[i]; //The index to check!
+		if (strcmp(index->filename, filename) == 0) //Found?
+		{
+			if (index->filesize == filesize) goto indexready; //Valid index?
+			goto rebuildindex; //Rebuild the outdated index!
+		}
+	}
+	index = &IMDimage_trackindex[IMDimage_nexttrackindex]; //The index to replace!
+	IMDimage_nexttrackindex = ((IMDimage_nexttrackindex + 1) % NUMITEMS(IMDimage_trackindex)); //The next one to replace!
+	rebuildindex:
+	memset(index, 0, sizeof(*index)); //Clear the index!
+	if (emufseek64(f, filepos, SEEK_SET) < 0) return 0; //Couldn't return to the first track?
+	IMDimage_buildtrackindex(index, f, filepos, filesize); //Index all tracks!
+	safestrcpy(index->filename, sizeof(index->filename), filename); //What are we indexing?
+	index->filesize = filesize; //The indexed size!
+	indexready:
+	if (index->trackpos[track][head] == 0) //Not indexed?
+	{
+		emufseek64(f, filepos, SEEK_SET); //Return to the first track for a normal search!
+		return 0; //Not indexed!
+	}
+	if (emufseek64(f, index->trackpos[track][head], SEEK_SET) < 0) //Couldn't goto the track?
+	{
+		emufseek64(f, filepos, SEEK_SET); //Return to the first track for a normal search!
+		return 0; //Not indexed!
+	}
+	return 1; //Found!
+}
+
+void IMDimage_resizedtrackindex(char* filename, FILEPOS position, FILEPOS oldfilesize, FILEPOS newfilesize) //The image has grown or shrunk at position!
+{
+	IMDIMAGE_TRACKINDEX* index;
+	byte i;
+	word track;
+	for (i = 0; i < NUMITEMS(IMDimage_trackindex); ++i) //Check all indexes!
+	{
+		index = &IMDimage_trackindex[i]; //The index to check!
+		if ((strcmp(index->filename, filename) == 0) && (index->filesize == oldfilesize)) //Found and up-to-date?
+		{
+			for (track = 0; track < NUMITEMS(index->trackpos); ++track) //Move all tracks after the position!
+			{
+				if (index->trackpos[track][0] > position) index->trackpos[track][0] += (newfilesize - oldfilesize);
+				if (index->trackpos[track][1] > position) index->trackpos[track][1] += (newfilesize - oldfilesize);
+			}
+			index->filesize = newfilesize; //The new size!
+		}
+	}
+}
+
 byte is_IMDimage(char* filename) //Are we a IMD image?
 {
 	byte identifier[3];
@@ -535,6 +676,7 @@ byte readIMDSectorInfo(char* filename, byte track, byte head, byte sector, IMDIM
 	return 0; //Invalid IMD file!
 
 validIMDheaderInfo:
+	if (IMDimage_seektrack(filename, f, track, head)) goto trackfoundInfo; //Indexed track?
 	if (emuftell64(f) < 0) //Can't tell the location?
 	{
 		emufclose64(f); //Close the image!
@@ -811,6 +953,7 @@ validIMDheaderInfo:
 	}
 	#endif
 
+	trackfoundInfo:
 	//Now, we're at the specified track!
 	if (emufread64(&trackinfo, 1, sizeof(trackinfo), f) != sizeof(trackinfo)) //Failed to read track info?
 	{
@@ -1129,6 +1272,7 @@ byte readIMDSector(char* filename, byte track, byte head, byte sector, word sect
 	return 0; //Invalid IMD file!
 
 validIMDheaderRead:
+	if (IMDimage_seektrack(filename, f, track, head)) goto trackfoundRead; //Indexed track?
 	//Now, skip tracks until we reach the selected track!
 	for (;;) //Skipping left?
 	{
@@ -1247,6 +1391,7 @@ validIMDheaderRead:
 		freez((void**)&sectorsizemap, (trackinfo.sectorspertrack << 1), "IMDIMAGE_SECTORSIZEMAP"); //Free the allocated sector size map!
 	}
 
+	trackfoundRead:
 	//Now, we're at the specified track!
 	if (emufread64(&trackinfo, 1, sizeof(trackinfo), f) != sizeof(trackinfo)) //Failed to read track info?
 	{
@@ -1582,6 +1727,7 @@ validIMDheaderWrite:
 		newdatamark = 0x03; //Deleted data mark!
 		newdatamarkcompressed = 0x04; //Compressed data mark!
 	}
+	if (IMDimage_seektrack(filename, f, track, head)) goto trackfoundWrite; //Indexed track?
 	//Now, skip tracks until we reach the selected track!
 	for (;;) //Skipping left?
 	{
@@ -1700,6 +1846,7 @@ validIMDheaderWrite:
 		freez((void**)&sectorsizemap, (trackinfo.sectorspertrack << 1), "IMDIMAGE_SECTORSIZEMAP"); //Free the allocated sector size map!
 	}
 
+	trackfoundWrite:
 	//Now, we're at the specified track!
 	if (emufread64(&trackinfo, 1, sizeof(trackinfo), f) != sizeof(trackinfo)) //Failed to read track info?
 	{
@@ -2230,6 +2377,7 @@ validIMDheaderWrite:
 					successWriteTailBufferWrite:
 					#endif
 					//We've successfully updated the file with a new sector!
+					IMDimage_resizedtrackindex(filename, compressedsectorpos, eofpos, (eofpos + physicalsectorsize - 1)); //The tracks following us have moved!
 					//The compressed sector data has been updated!
 					#ifdef MEMORYCONSERVATION
 					COMMON_MEMORYCONSERVATION_ENDBUFFER(tailbuffer)
@@ -2312,6 +2460,7 @@ byte formatIMDTrack(char* filename, byte track, byte head, byte MFM, byte speed,
 	{
 		return 0; //Not a IMD image!
 	}
+	IMDimage_invalidatetrackindex(filename); //The track layout is going to change!
 	f = emufopen64(filename, "rb+"); //Open the image!
 	if (!f) return 0; //Not opened!
 	if (emufread64(&identifier, 1, sizeof(identifier), f) != sizeof(identifier)) //Try to read the header?
@@ -3026,6 +3175,7 @@ byte generateIMDImage(char* filename, byte tracks, byte heads, byte MFM, byte sp
 	{
 		return 0; //Not a IMD image!
 	}
+	IMDimage_invalidatetrackindex(fullfilename); //A new image!
 	f = emufopen64(fullfilename, "wb"); //Open the image!
 	if (!f) return 0; //Not opened!
 
@@ -26,6 +26,7 @@ along with UniPCemu.  If not, see <https://www.gnu.org/licenses/>.
 #include "headers/support/log.h" //Logging support!
 #include "headers/bios/bios.h" //BIOS support for requesting ejecting a disk!
 #include "headers/basicio/cueimage.h" //CUE image support!
+#include "headers/basicio/diskworker.h" //Disk I/O worker support!
 //Basic low level i/o functions!
 
 char diskpath[256] = "disks"; //The full disk path of the directory containing the disk images!
@@ -35,7 +36,10 @@ DISKCHANGEDHANDLER diskchangedhandlers[0x100]; //Disk changed handler!
 
 void ioInit() //Resets/unmounts all disks!
 {
+	diskworker_flush(-1); //Write all posted writes to the old disks first!
+	diskworker_lockIO(); //Keep the disk worker out while unmounting!
 	memset(&disks,0,sizeof(disks)); //Initialise disks!
+	diskworker_unlockIO(); //Unmounted!
 	memset(&diskchangedhandlers,0,sizeof(diskchangedhandlers)); //Initialise disks changed handlers!
 }
 
@@ -129,6 +133,10 @@ OPTINLINE void loadDisk(int device, char *filename, uint_64 startpos, byte reado
 	}
 
 	safestrcpy(oldfilename,sizeof(oldfilename),disks[device].filename); //Save the old filename!
+	diskworker_flush(device); //Write all posted writes to the old disk first!
+	diskworker_invalidate(device); //Discard all read-ahead data of the old disk!
+	cueimage_invalidate(device); //Discard the parsed cue sheet of the old disk!
+	diskworker_lockIO(); //Wait for any running read-ahead of the old disk to finish, and keep the disk worker out until the disk is swapped!
 
 	byte dynamicimage = is_dynamicimage(fullfilename); //Dynamic image detection!
 	byte staticimage = 0;
@@ -174,6 +182,7 @@ OPTINLINE void loadDisk(int device, char *filename, uint_64 startpos, byte reado
 	}
 
 	registerdiskchange: //Register any disk changes!
+	diskworker_unlockIO(); //The disk is swapped! Unlock before the handlers, since they can access the new disk!
 	if (diskchangedhandlers[device])
 	{
 		if (strcmp(oldfilename, fullfilename) != 0) //Different disk?
@@ -289,7 +298,7 @@ void CDROM_selectsubtrack(int device, uint_32 subtrack)
 }
 
 //Startpos=sector number (start/512 bytes)!
-byte readdata(int device, void *buffer, uint_64 startpos, uint_32 bytestoread)
+byte readdata_direct(int device, void *buffer, uint_64 startpos, uint_32 bytestoread) //Read without the disk worker! The I/O lock must be held!
 {
 	byte *resultbuffer = (byte *)buffer; //The result buffer!
 	byte sectorbuffer[512]; //Full buffered sector!
@@ -309,7 +318,7 @@ byte readdata(int device, void *buffer, uint_64 startpos, uint_32 bytestoread)
 	{
 		if (startpos+bytestoread<=disks[device].customdisk.imagesize) //Within bounds?
 		{
-			return readdata(disks[device].customdisk.device,buffer,disks[device].customdisk.startpos,bytestoread); //Read from custom disk!
+			return readdata_direct(disks[device].customdisk.device,buffer,disks[device].customdisk.startpos,bytestoread); //Read from custom disk!
 		}
 		else
 		{
@@ -392,7 +401,7 @@ byte is_mounted(int drive) //Device inserted?
 	return TRUE; //Have drive!
 }
 
-byte writedata(int device, void *buffer, uint_64 startpos, uint_32 bytestowrite)
+byte writedata_direct(int device, void *buffer, uint_64 startpos, uint_32 bytestowrite) //Write without the disk worker! The I/O lock must be held!
 {
 	byte *readbuffer = (byte *)buffer; //Data buffer!
 	byte sectorbuffer[512]; //A full sector buffered for editing!
@@ -493,4 +502,32 @@ byte writedata(int device, void *buffer, uint_64 startpos, uint_32 bytestowrite)
 	}
 
 	return TRUE; //OK!
-}
\ No newline at end of file
+}
+
+byte readdata(int device, void *buffer, uint_64 startpos, uint_32 bytestoread)
+{
+	byte result;
+	if ((device&0xFF)==device) //Valid device?
+	{
+		if (disks[device].customdisk.used) diskworker_sync(disks[device].customdisk.device); //Wait for posted writes to the custom disk!
+		diskworker_sync(device); //Wait for any posted writes to be written first!
+	}
+	diskworker_lockIO(); //Lock the disk images!
+	result = readdata_direct(device,buffer,startpos,bytestoread); //Read!
+	diskworker_unlockIO(); //Unlock the disk images!
+	return result; //Give the result!
+}
+
+byte writedata(int device, void *buffer, uint_64 startpos, uint_32 bytestowrite)
+{
+	byte result;
+	if ((device&0xFF)==device) //Valid device?
+	{
+		diskworker_sync(device); //Wait for any posted writes to be written first, in order!
+		diskworker_invalidate(device); //The read-ahead data is outdated!
+	}
+	diskworker_lockIO(); //Lock the disk images!
+	result = writedata_direct(device,buffer,startpos,bytestowrite); //Write!
+	diskworker_unlockIO(); //Unlock the disk images!
+	return result; //Give the result!
+}
@@ -1265,6 +1265,7 @@ OPTINLINE void CPU_initRegisters(word isInit) //Init the registers!
 	//GDTR
 	CPU[activeCPU].registers->GDTR.base = 0;
 	CPU[activeCPU].registers->GDTR.limit = 0xFFFF; //From bochs!
+	CPU_flushDescriptorCache(); //Nothing is cached anymore!
 
 	//LDTR (invalid)
 	REG_LDTR = 0; //No LDTR (also invalid)!
@@ -761,5 +761,6 @@ void MMU_setA20(byte where, byte enabled) //To enable A20?
 	if (unlikely(MMU.A20LineEnabled != A20lineold)) //A20 line changed?
 	{
 		MMU_RAMlayoutupdated(); //Memory layout has been updated!
+		CPU_flushAllDescriptorCaches(); //Descriptors might be mapped differently now!
 	}
 }
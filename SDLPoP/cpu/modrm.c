@@ -42,6 +42,60 @@ along with UniPCemu.  If not, see <https://www.gnu.org/licenses/>.
 
 char modrm_sizes[4][256] = {"byte","word","dword","byte"}; //What size is used for the parameter?
 
+//Precalculated 16-bit memory addressing, indexed by mod and r/m! Used when no text is to be generated!
+#define MODRM16_NONE 0
+#define MODRM16_BX 1
+#define MODRM16_BP 2
+#define MODRM16_SI 3
+#define MODRM16_DI 4
+
+#define MODRM16_NODISP 0
+#define MODRM16_DISP8 1
+#define MODRM16_DISP16 2
+
+typedef struct
+{
+	byte base; //Base register used!
+	byte index; //Index register used!
+	byte displacement; //Displacement used!
+	byte segment; //Default segment register!
+	byte EA_cycles; //EA cycles used!
+	byte havethreevariables; //Three variables used?
+} MODRM16_RECIPE;
+
+MODRM16_RECIPE modrm16_recipes[3][8] = {
+	{ //MOD_MEM
+		{MODRM16_BX,MODRM16_SI,MODRM16_NODISP,CPU_SEGMENT_DS,7,0}, //[BX+SI]
+		{MODRM16_BX,MODRM16_DI,MODRM16_NODISP,CPU_SEGMENT_DS,8,0}, //[BX+DI]
+		{MODRM16_BP,MODRM16_SI,MODRM16_NODISP,CPU_SEGMENT_SS,8,0}, //[BP+SI]
+		{MODRM16_BP,MODRM16_DI,MODRM16_NODISP,CPU_SEGMENT_SS,7,0}, //[BP+DI]
+		{MODRM16_SI,MODRM16_NONE,MODRM16_NODISP,CPU_SEGMENT_DS,5,0}, //[SI]
+		{MODRM16_DI,MODRM16_NONE,MODRM16_NODISP,CPU_SEGMENT_DS,5,0}, //[DI]
+		{MODRM16_NONE,MODRM16_NONE,MODRM16_DISP16,CPU_SEGMENT_DS,6,0}, //[disp16]
+		{MODRM16_BX,MODRM16_NONE,MODRM16_NODISP,CPU_SEGMENT_DS,5,0} //[BX]
+	},
+	{ //MOD_MEM_DISP8
+		{MODRM16_BX,MODRM16_SI,MODRM16_DISP8,CPU_SEGMENT_DS,11,1}, //[BX+SI+disp8]
+		{MODRM16_BX,MODRM16_DI,MODRM16_DISP8,CPU_SEGMENT_DS,12,1}, //[BX+DI+disp8]
+		{MODRM16_BP,MODRM16_SI,MODRM16_DISP8,CPU_SEGMENT_SS,12,1}, //[BP+SI+disp8]
+		{MODRM16_BP,MODRM16_DI,MODRM16_DISP8,CPU_SEGMENT_SS,11,1}, //[BP+DI+disp8]
+		{MODRM16_SI,MODRM16_NONE,MODRM16_DISP8,CPU_SEGMENT_DS,9,0}, //[SI+disp8]
+		{MODRM16_DI,MODRM16_NONE,MODRM16_DISP8,CPU_SEGMENT_DS,9,0}, //[DI+disp8]
+		{MODRM16_BP,MODRM16_NONE,MODRM16_DISP8,CPU_SEGMENT_SS,9,0}, //[BP+disp8]
+		{MODRM16_BX,MODRM16_NONE,MODRM16_DISP8,CPU_SEGMENT_DS,9,0} //[BX+disp8]
+	},
+	{ //MOD_MEM_DISP16
+		{MODRM16_BX,MODRM16_SI,MODRM16_DISP16,CPU_SEGMENT_DS,11,1}, //[BX+SI+disp16]
+		{MODRM16_BX,MODRM16_DI,MODRM16_DISP16,CPU_SEGMENT_DS,12,1}, //[BX+DI+disp16]
+		{MODRM16_BP,MODRM16_SI,MODRM16_DISP16,CPU_SEGMENT_SS,12,1}, //[BP+SI+disp16]
+		{MODRM16_BP,MODRM16_DI,MODRM16_DISP16,CPU_SEGMENT_SS,11,1}, //[BP+DI+disp16]
+		{MODRM16_SI,MODRM16_NONE,MODRM16_DISP16,CPU_SEGMENT_DS,9,0}, //[SI+disp16]
+		{MODRM16_DI,MODRM16_NONE,MODRM16_DISP16,CPU_SEGMENT_DS,9,0}, //[DI+disp16]
+		{MODRM16_BP,MODRM16_NONE,MODRM16_DISP16,CPU_SEGMENT_SS,9,0}, //[BP+disp16]
+		{MODRM16_BX,MODRM16_NONE,MODRM16_DISP16,CPU_SEGMENT_DS,9,0} //[BX+disp16]
+	}
+};
+
 extern byte advancedlog; //Advanced log setting
 
 //whichregister: 1=R/M, other=register!
@@ -1736,7 +1790,43 @@ void modrm_decode16(MODRM_PARAMS *params, MODRM_PTR *result, byte whichregister)
 
 	INLINEREGISTER uint_32 offset=0; //The offset calculated!
 	INLINEREGISTER byte segmentoverridden=0; //Segment is overridden?
-	switch (MODRM_MOD(params->modrm)) //Which mod?
+	if (likely(CPU[activeCPU].cpudebugger==0)) //No text to generate? Use the precalculated recipe!
+	{
+		MODRM16_RECIPE *recipe;
+		word registers[5]; //The registers that can be used!
+		int displacement;
+		recipe = &modrm16_recipes[MODRM_MOD(params->modrm)][reg]; //The recipe to use!
+		registers[MODRM16_NONE] = 0; //No register!
+		registers[MODRM16_BX] = REG_BX;
+		registers[MODRM16_BP] = REG_BP;
+		registers[MODRM16_SI] = REG_SI;
+		registers[MODRM16_DI] = REG_DI;
+		switch (recipe->displacement) //What displacement?
+		{
+		case MODRM16_DISP8: //Signed 8-bit?
+			displacement = unsigned2signed8(params->displacement.low16_low); //Sign extended!
+			break;
+		case MODRM16_DISP16: //16-bit?
+			displacement = params->displacement.low16; //Unsigned 16-bit!
+			break;
+		default: //None?
+			displacement = 0; //None!
+			break;
+		}
+		result->mem_segment = CPU_segment(recipe->segment);
+		offset = registers[recipe->base]+registers[recipe->index]+displacement; //Give addr!
+		result->segmentregister = CPU_segment_ptr(recipe->segment);
+		result->segmentregister_index = CPU_segment_index(recipe->segment);
+		segmentoverridden = (CPU[activeCPU].segment_register!=CPU_SEGMENT_DEFAULT); //Is the segment overridden?
+		params->EA_cycles = recipe->EA_cycles; //EA cycles!
+		if (recipe->havethreevariables) //3 params added?
+		{
+			params->havethreevariables = 1; //3 params added!
+		}
+		result->memorymask = 0xFFFF; //Only 16-bit offsets are used, full 32-bit otherwise for both checks and memory?
+		result->is16bit = 1; //16-bit offset!
+	}
+	else switch (MODRM_MOD(params->modrm)) //Which mod? Generating text for the debugger!
 	{
 	case MOD_MEM: //[register]
 		switch (reg) //Which register?
@@ -29,6 +29,7 @@ along with UniPCemu.  If not, see <https://www.gnu.org/licenses/>.
 #include "headers/cpu/biu.h" //BIU support!
 #include "headers/cpu/cpu_execution.h" //Execution flow support!
 #include "headers/cpu/cpu_stack.h" //Stack support!
+#include "headers/cpu/paging.h" //Paging support for the fast TSS path!
 #include "headers/cpu/easyregs.h" //Easy register support!
 
 //Force 16-bit TSS on 80286?
@@ -41,11 +42,80 @@ along with UniPCemu.  If not, see <https://www.gnu.org/licenses/>.
 //Everything concerning TSS.
 
 extern byte debugger_forceimmediatelogging; //Force immediate logging?
+extern byte MMU_logging; //Are we logging from the MMU?
+
+//Fast TSS path: read/write the TSS image in one pass on physical memory, when the TSS is within a single page!
+#define TSS_IMAGE16(image,offset) ((word)((image)[(offset)]|((image)[(offset)+1]<<8)))
+#define TSS_IMAGE32(image,offset) ((uint_32)TSS_IMAGE16(image,offset)|((uint_32)TSS_IMAGE16(image,(offset)+2)<<16))
+
+OPTINLINE void TSS_setimage16(byte *image, word value)
+{
+	image[0] = (value&0xFF); //Low byte!
+	image[1] = ((value>>8)&0xFF); //High byte!
+}
+
+OPTINLINE void TSS_setimage32(byte *image, uint_32 value)
+{
+	TSS_setimage16(image,(value&0xFFFF)); //Low word!
+	TSS_setimage16(image+2,((value>>16)&0xFFFF)); //High word!
+}
+
+//Result: 1=Fast path usable with physicaladdress translated, 0=Use the normal per-field path!
+OPTINLINE byte TSS_fastpath_translate(word offset, word size, byte iswrite, uint_64 *physicaladdress)
+{
+	uint_32 linearaddress;
+	if (unlikely(MMU_logging==1)) return 0; //Logging all accesses? Use the normal path!
+	linearaddress = (uint_32)(CPU[activeCPU].SEG_DESCRIPTOR[CPU_SEGMENT_TR].PRECALCS.base+offset); //The linear address of the TSS data!
+	if (unlikely(((linearaddress&0xFFF)+size)>0x1000)) return 0; //Crossing a page boundary? Use the normal path!
+	if (is_paging()) //Paging?
+	{
+		*physicaladdress = mappage(linearaddress,iswrite,getCPL()); //Translate using the TLB, which is loaded by the TSS checks!
+		if (unlikely(CPU[activeCPU].successfullpagemapping==0)) return 0; //Not in the TLB? Use the normal path!
+	}
+	else //Not paging?
+	{
+		*physicaladdress = (uint_64)linearaddress; //Direct address!
+	}
+	return 1; //Fast path can be used!
+}
+
+OPTINLINE byte TSS_readimage(byte *image, word offset, word size) //Read the TSS image in one go! Result: 1=Read, 0=Use the normal path!
+{
+	uint_64 physicaladdress;
+	word n;
+	if (TSS_fastpath_translate(offset,size,0,&physicaladdress)==0) return 0; //Unusable?
+	for (n=0;n<size;++n) //Read the entire image!
+	{
+		image[n] = BIU_directrb_external(physicaladdress+n,0x100); //Read the byte from physical memory!
+	}
+	return 1; //Read!
+}
+
+OPTINLINE byte TSS_writeimage(byte *image, word offset, word size) //Write the TSS image in one go! Result: 1=Written, 0=Use the normal path!
+{
+	uint_64 physicaladdress;
+	word n;
+	if (TSS_fastpath_translate(offset,size,1,&physicaladdress)==0) return 0; //Unusable?
+	for (n=0;n<size;++n) //Write the entire image!
+	{
+		BIU_directwb_external(physicaladdress+n,image[n],0x100); //Write the byte to physical memory!
+	}
+	return 1; //Written!
+}
 
 void loadTSS16(TSS286 *TSS)
 {
 	word n;
 	byte i;
+	byte image[0x2C];
+	if (TSS_readimage(&image[0],0,sizeof(image))) //Fast path?
+	{
+		for (i=0;i<NUMITEMS(TSS->dataw);++i) //Decode our TSS!
+		{
+			TSS->dataw[i] = TSS_IMAGE16(image,(i<<1)); //Load the field!
+		}
+		return; //Loaded!
+	}
 	i = 0;
 	n = 0;
 	for (i = 0;i < NUMITEMS(TSS->dataw);) //Load our TSS!
@@ -80,6 +150,27 @@ void loadTSS32(TSS386 *TSS)
 	byte ssspreg;
 	word n;
 	byte i;
+	byte image[0x68];
+	if (TSS_readimage(&image[0],0,sizeof(image))) //Fast path?
+	{
+		TSS->BackLink = TSS_IMAGE16(image,0); //Back link!
+		for (ssspreg=0;ssspreg<3;++ssspreg) //All stack registers!
+		{
+			TSS->ESPs[ssspreg] = TSS_IMAGE32(image,4+(ssspreg<<3)); //ESPn!
+			TSS->SSs[ssspreg] = TSS_IMAGE16(image,8+(ssspreg<<3)); //SSn!
+		}
+		for (i=0;i<NUMITEMS(TSS->generalpurposeregisters);++i) //32-bit data!
+		{
+			TSS->generalpurposeregisters[i] = TSS_IMAGE32(image,(7*4)+(i<<2)); //Load the field!
+		}
+		for (i=0;i<NUMITEMS(TSS->segmentregisters);++i) //16-bit data!
+		{
+			TSS->segmentregisters[i] = TSS_IMAGE16(image,((7+11)*4)+(i<<2)); //Load the field!
+		}
+		TSS->T = TSS_IMAGE16(image,(25*4)); //T-bit!
+		TSS->IOMapBase = TSS_IMAGE16(image,(25*4)+2); //I/O map base!
+		return; //Loaded!
+	}
 	debugger_forceimmediatelogging = 1; //Log!
 	TSS->BackLink = MMU_rw(CPU_SEGMENT_TR, REG_TR, 0, 0,0); //Read the TSS! Don't be afraid of errors, since we're always accessable!
 	//SP0/ESP0 initializing!
@@ -196,6 +287,12 @@ void saveTSS16(TSS286 *TSS)
 {
 	word n;
 	byte i;
+	byte image[0x2C-2-(7*2)];
+	for (i=7;i<(NUMITEMS(TSS->dataw)-1);++i) //Encode our TSS 16-bit data!
+	{
+		TSS_setimage16(&image[(i-7)<<1],TSS->dataw[i]); //Store the field!
+	}
+	if (TSS_writeimage(&image[0],(7*2),sizeof(image))) return; //Fast path?
 	i = 7;
 	for (n=((7*2));n<(sizeof(*TSS)-2);n+=2) //Write our TSS 16-bit data! Don't store the LDT and Stacks for different privilege levels!
 	{
@@ -234,6 +331,16 @@ void saveTSS32(TSS386 *TSS)
 {
 	word n;
 	byte i;
+	byte image[(10+6)*4];
+	for (i=1;i<11;++i) //Encode our TSS 32-bit data!
+	{
+		TSS_setimage32(&image[(i-1)<<2],TSS->generalpurposeregisters[i]); //Store the field!
+	}
+	for (i=0;i<6;++i) //Encode our TSS 16-bit data!
+	{
+		TSS_setimage32(&image[(10+i)<<2],TSS->segmentregisters[i]); //Store the field!
+	}
+	if (TSS_writeimage(&image[0],(8*4),sizeof(image))) return; //Fast path?
 	i = 1;
 	for (n =(8*4);n<((8+10)*4);n+=4) //Write our TSS 32-bit data! Ignore the Stack data for different privilege levels and CR3(PDBR)!
 	{
@@ -307,8 +414,6 @@ extern byte enableMMUbuffer; //To buffer the MMU writes?
 
 extern byte advancedlog; //Advanced log setting
 
-extern byte MMU_logging; //Are we logging from the MMU?
-
 byte CPU_switchtask(int whatsegment, SEGMENT_DESCRIPTOR *LOADEDDESCRIPTOR, word *segment, word destinationtask, byte isJMPorCALL, byte gated, int_64 errorcode) //Switching to a certain task?
 {
 	//Both structures to use for the TSS!
@@ -319,6 +424,7 @@ byte CPU_switchtask(int whatsegment, SEGMENT_DESCRIPTOR *LOADEDDESCRIPTOR, word
 
 	if ((CPU[activeCPU].taskswitch_stepping&1)==0) //Step 1?
 	{
+	CPU_flushDescriptorCache(); //A new task might use different descriptors!
 	CPU[activeCPU].taskswitchdata.TSS_dirty = 0; //Is the new TSS dirty?
 	CPU[activeCPU].taskswitchdata.TSSSizeSrc = CPU[activeCPU].taskswitchdata.TSSSize = 0; //The (source) TSS size!
 	if (errorcode>=0) //Error code to be pushed on the stack(not an interrupt without error code or errorless task switch)?
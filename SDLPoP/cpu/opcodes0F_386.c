@@ -250,6 +250,7 @@ void CPU386_OP0F01() //Various extended 286+ instruction GRP opcode.
 			CPUPROT1
 				CPU[activeCPU].registers->GDTR.base = CPU[activeCPU].oper1d; //Load the base!
 				CPU[activeCPU].registers->GDTR.limit = CPU[activeCPU].oper1; //Load the limit!
+				CPU_flushDescriptorCache(); //New GDT loaded!
 				CPU_apply286cycles(); //Apply the 80286+ cycles!
 			CPUPROT2
 		CPUPROT2
@@ -638,6 +639,7 @@ void CPU386_OP0F07() //Undocumented LOADALL instruction
 	//GDTR/IDTR registers!
 	CPU[activeCPU].registers->GDTR.base = CPU[activeCPU].LOADALL386DATA.fields.GDTR.BASE; //Base!
 	CPU[activeCPU].registers->GDTR.limit = CPU[activeCPU].LOADALL386DATA.fields.GDTR.LIMIT; //Limit
+	CPU_flushDescriptorCache(); //New GDT loaded!
 	CPU[activeCPU].registers->IDTR.base = CPU[activeCPU].LOADALL386DATA.fields.IDTR.BASE; //Base!
 	CPU[activeCPU].registers->IDTR.limit = CPU[activeCPU].LOADALL386DATA.fields.IDTR.LIMIT; //Limit
 
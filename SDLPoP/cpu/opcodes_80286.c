@@ -468,6 +468,7 @@ void CPU286_OP0F01() //Various extended 286+ instruction GRP opcode.
 				CPUPROT1
 					CPU[activeCPU].registers->GDTR.base = CPU[activeCPU].oper1d; //Load the base!
 					CPU[activeCPU].registers->GDTR.limit = CPU[activeCPU].oper1; //Load the limit!
+					CPU_flushDescriptorCache(); //New GDT loaded!
 					CPU_apply286cycles(); //Apply the 80286+ cycles!
 				CPUPROT2
 			CPUPROT2
@@ -809,6 +810,7 @@ void CPU286_OP0F05() //Undocumented LOADALL instruction
 	//GDTR/IDTR registers!
 	CPU[activeCPU].registers->GDTR.base = ((CPU[activeCPU].LOADALL286DATA.fields.GDTR.basehigh&0xFF)<<16)| CPU[activeCPU].LOADALL286DATA.fields.GDTR.baselow; //Base!
 	CPU[activeCPU].registers->GDTR.limit = CPU[activeCPU].LOADALL286DATA.fields.GDTR.limit; //Limit
+	CPU_flushDescriptorCache(); //New GDT loaded!
 	CPU[activeCPU].registers->IDTR.base = ((CPU[activeCPU].LOADALL286DATA.fields.IDTR.basehigh&0xFF)<<16)| CPU[activeCPU].LOADALL286DATA.fields.IDTR.baselow; //Base!
 	CPU[activeCPU].registers->IDTR.limit = CPU[activeCPU].LOADALL286DATA.fields.IDTR.limit; //Limit
 
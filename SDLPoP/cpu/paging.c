@@ -1087,6 +1087,7 @@ void Paging_Invalidate(uint_32 logicaladdress) //Invalidate a single address!
 			curentry = nextentry; //Next entry!
 		}
 	}
+	CPU_flushDescriptorCache(); //Descriptors might be mapped differently now!
 }
 
 void Paging_clearTLB()
@@ -1108,6 +1109,7 @@ void Paging_clearTLB()
 		}
 	}
 	//Finish up!
+	CPU_flushDescriptorCache(); //Descriptors might be mapped differently now!
 	BIU_recheckmemory(); //Recheck anything that's fetching from now on!
 }
 
@@ -1135,6 +1137,7 @@ void Paging_initTLB()
 	PagingTLB_initlists(); //Initialize the TLB lists to become empty!
 	PagingTLB_clearlists(); //Initialize the TLB lists to become empty!
 	effectivemappageHandler = (EMULATED_CPU >= CPU_PENTIUM) ? &mappagePSE : &mappagenonPSE; //Use either a PSE or non-PSE paging handler!
+	CPU_flushDescriptorCache(); //Descriptors might be mapped differently now!
 	BIU_recheckmemory(); //Recheck anything that's fetching from now on!
 }
 
@@ -589,6 +589,132 @@ void CPU_calcSegmentPrecalcs(byte is_CS, SEGMENT_DESCRIPTOR *descriptor)
 	}
 }
 
+//Descriptor cache: shadows the raw GDT/LDT entries that are loaded, to prevent re-reading them through the paging unit and memory each time!
+#define DESCRIPTORCACHE_SIZE 64
+//Hash of the selector: index bits together with the table indicator!
+#define DESCRIPTORCACHE_HASH(segmentval) (((segmentval)>>2)&(DESCRIPTORCACHE_SIZE-1))
+
+typedef struct
+{
+	uint_32 generation; //Generation this entry is loaded in! Valid when matching the current generation!
+	uint_32 linearaddress; //Linear address of the descriptor(table base+index)!
+	word segmentval; //Selector that's loaded(without RPL)!
+	byte bytes[8]; //The raw descriptor data!
+} DESCRIPTORCACHEENTRY;
+
+DESCRIPTORCACHEENTRY CPU_descriptorcache[MAXCPUS][DESCRIPTORCACHE_SIZE]; //The descriptor cache for each CPU!
+uint_32 CPU_descriptorcache_generation[MAXCPUS] = {1,1}; //Current generation of the descriptor caches! 0 is reserved for invalid entries!
+//Physical memory ranges that are shadowed by each CPU's descriptor cache, for the GDT(0) and LDT(1) each. Empty when low>high!
+uint_64 CPU_descriptorcache_tablelow[MAXCPUS][2] = {{~0ULL,~0ULL},{~0ULL,~0ULL}};
+uint_64 CPU_descriptorcache_tablehigh[MAXCPUS][2] = {{0,0},{0,0}};
+//Combined range of all tables above, for the quick check on memory writes. Empty when low>high!
+uint_64 CPU_descriptorcache_watchlow = ~0ULL;
+uint_64 CPU_descriptorcache_watchhigh = 0;
+
+OPTINLINE void CPU_updateDescriptorCacheWatch() //Recalculate the combined range from the table ranges!
+{
+	byte whichCPU, whichtable;
+	CPU_descriptorcache_watchlow = ~0ULL; //Start empty!
+	CPU_descriptorcache_watchhigh = 0; //Start empty!
+	for (whichCPU=0;whichCPU<MAXCPUS;++whichCPU) //Process all CPUs!
+	{
+		for (whichtable=0;whichtable<2;++whichtable) //Process the GDT and LDT!
+		{
+			if (CPU_descriptorcache_tablelow[whichCPU][whichtable]>CPU_descriptorcache_tablehigh[whichCPU][whichtable]) continue; //Empty range?
+			if (CPU_descriptorcache_tablelow[whichCPU][whichtable]<CPU_descriptorcache_watchlow) CPU_descriptorcache_watchlow = CPU_descriptorcache_tablelow[whichCPU][whichtable]; //Extend the range down!
+			if (CPU_descriptorcache_tablehigh[whichCPU][whichtable]>CPU_descriptorcache_watchhigh) CPU_descriptorcache_watchhigh = CPU_descriptorcache_tablehigh[whichCPU][whichtable]; //Extend the range up!
+		}
+	}
+}
+
+void CPU_flushDescriptorCacheCPU(byte whichCPU) //Flush the descriptor cache of a single CPU!
+{
+	if (unlikely(++CPU_descriptorcache_generation[whichCPU]==0)) //Generation wrapped?
+	{
+		memset(&CPU_descriptorcache[whichCPU], 0, sizeof(CPU_descriptorcache[whichCPU])); //Clear all entries!
+		CPU_descriptorcache_generation[whichCPU] = 1; //Restart counting!
+	}
+	CPU_descriptorcache_tablelow[whichCPU][0] = CPU_descriptorcache_tablelow[whichCPU][1] = ~0ULL; //Nothing to watch anymore for this CPU!
+	CPU_descriptorcache_tablehigh[whichCPU][0] = CPU_descriptorcache_tablehigh[whichCPU][1] = 0; //Nothing to watch anymore for this CPU!
+	CPU_updateDescriptorCacheWatch(); //The combined range might have shrunk!
+}
+
+void CPU_flushDescriptorCache() //LGDT/LLDT/task switch/paging change: the active CPU's descriptor cache is invalid!
+{
+	CPU_flushDescriptorCacheCPU(activeCPU); //Flush the active CPU!
+}
+
+void CPU_descriptorCacheMemoryWritten(uint_64 address) //Memory written within the combined range: invalidate the descriptor caches that shadow it(up to a dword written)!
+{
+	byte whichCPU, whichtable;
+	for (whichCPU=0;whichCPU<MAXCPUS;++whichCPU) //Process all CPUs!
+	{
+		for (whichtable=0;whichtable<2;++whichtable) //Process the GDT and LDT!
+		{
+			if ((address<=CPU_descriptorcache_tablehigh[whichCPU][whichtable]) && ((address+3)>=CPU_descriptorcache_tablelow[whichCPU][whichtable])) //Written to a table that's cached?
+			{
+				CPU_flushDescriptorCacheCPU(whichCPU); //Invalidate!
+				break; //Both tables of this CPU are invalidated now!
+			}
+		}
+	}
+}
+
+void CPU_flushAllDescriptorCaches() //A20 or other physical memory layout change: invalidate everything!
+{
+	byte whichCPU;
+	for (whichCPU=0;whichCPU<MAXCPUS;++whichCPU) //Process all CPUs!
+	{
+		CPU_flushDescriptorCacheCPU(whichCPU); //Invalidate!
+	}
+}
+
+extern uint_64 effectivecpuaddresspins; //What address pins are supported?
+extern byte CompaqWrapping[0x1000]; //Compaq Wrapping precalcs!
+extern MMU_type MMU; //MMU support!
+
+OPTINLINE byte CPU_readDescriptorCache(uint_32 descriptor_address, word segmentval, byte *bytes) //Read a descriptor from the cache! Result: 1=Hit, 0=Miss.
+{
+	DESCRIPTORCACHEENTRY *entry;
+	entry = &CPU_descriptorcache[activeCPU][DESCRIPTORCACHE_HASH(segmentval)]; //The entry to check!
+	if (likely((entry->generation==CPU_descriptorcache_generation[activeCPU]) && (entry->linearaddress==descriptor_address) && (entry->segmentval==(segmentval&~3)))) //Hit?
+	{
+		memcpy(bytes,&entry->bytes,sizeof(entry->bytes)); //Give the cached descriptor!
+		return 1; //Hit!
+	}
+	return 0; //Miss!
+}
+
+OPTINLINE void CPU_writeDescriptorCache(uint_32 descriptor_address, word segmentval, byte *bytes) //Store a freshly read descriptor into the cache!
+{
+	DESCRIPTORCACHEENTRY *entry;
+	uint_64 physicaladdress;
+	byte whichtable;
+	if (unlikely((descriptor_address&0xFFF)>0xFF8)) return; //Crossing a page boundary? Don't cache!
+	if (is_paging()) //Paging?
+	{
+		physicaladdress = mappage(descriptor_address,0,0); //Where does the descriptor reside in physical memory?
+		if (unlikely(CPU[activeCPU].successfullpagemapping==0)) return; //Not in the TLB? We can't watch it, so don't cache!
+	}
+	else
+	{
+		physicaladdress = (uint_64)descriptor_address; //Direct physical memory!
+	}
+	//Apply A20 in the same way the BIU does, so that we match the address that the memory writes are done on!
+	physicaladdress &= effectivecpuaddresspins; //Address pins!
+	physicaladdress &= (MMU.wraparround | (CompaqWrapping[(physicaladdress >> 20)] << 20)); //Apply A20, including Compaq-style wrapping!
+	whichtable = (segmentval&4)?1:0; //LDT or GDT?
+	if (physicaladdress<CPU_descriptorcache_tablelow[activeCPU][whichtable]) CPU_descriptorcache_tablelow[activeCPU][whichtable] = physicaladdress; //Extend the range down!
+	if ((physicaladdress+7)>CPU_descriptorcache_tablehigh[activeCPU][whichtable]) CPU_descriptorcache_tablehigh[activeCPU][whichtable] = (physicaladdress+7); //Extend the range up!
+	if (physicaladdress<CPU_descriptorcache_watchlow) CPU_descriptorcache_watchlow = physicaladdress; //Extend the combined range down!
+	if ((physicaladdress+7)>CPU_descriptorcache_watchhigh) CPU_descriptorcache_watchhigh = (physicaladdress+7); //Extend the combined range up!
+	entry = &CPU_descriptorcache[activeCPU][DESCRIPTORCACHE_HASH(segmentval)]; //The entry to fill!
+	entry->linearaddress = descriptor_address; //The linear address!
+	entry->segmentval = (segmentval&~3); //The selector!
+	memcpy(&entry->bytes,bytes,sizeof(entry->bytes)); //The descriptor data!
+	entry->generation = CPU_descriptorcache_generation[activeCPU]; //Now valid!
+}
+
 sbyte LOADDESCRIPTOR(int segment, word segmentval, SEGMENT_DESCRIPTOR *container, word isJMPorCALL) //Result: 0=#GP, 1=container=descriptor.
 {
 	sbyte result;
@@ -632,12 +758,17 @@ sbyte LOADDESCRIPTOR(int segment, word segmentval, SEGMENT_DESCRIPTOR *container
 		{
 			return (result==2)?-2:-1; //Error out!
 		}
-		for (i=0;i<(int)sizeof(container->desc.bytes);) //Process the descriptor data!
+		if ((MMU_logging==1) || (CPU_readDescriptorCache(descriptor_address,segmentval,&container->desc.bytes[0])==0)) //Logging the reads or not cached?
 		{
-			if (memory_readlinear(descriptor_address++,&container->desc.bytes[i++])) //Read a descriptor byte directly from flat memory!
+			for (i=0;i<(int)sizeof(container->desc.bytes);) //Process the descriptor data!
 			{
-				return 0; //Failed to load the descriptor!
+				if (memory_readlinear(descriptor_address+i,&container->desc.bytes[i])) //Read a descriptor byte directly from flat memory!
+				{
+					return 0; //Failed to load the descriptor!
+				}
+				++i; //Next byte!
 			}
+			CPU_writeDescriptorCache(descriptor_address,segmentval,&container->desc.bytes[0]); //Cache the descriptor for future loads!
 		}
 
 		container->desc.limit_low = DESC_16BITS(container->desc.limit_low);
@@ -1623,6 +1754,9 @@ byte segmentWritten(int segment, word value, word isJMPorCALL) //A segment regis
 			case CPU_SEGMENT_SS: //SS? We're also updating the CPL!
 				updateCPL(); //Update the CPL according to the mode!
 				break;
+			case CPU_SEGMENT_LDTR: //LDTR? A new LDT is used!
+				CPU_flushDescriptorCache(); //Flush the descriptor cache!
+				break;
 			default: //All other segments: nothing special!
 				break;
 			}
@@ -20,6 +20,7 @@ along with UniPCemu.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "headers/cpu/cpu.h" //Basic types!
 #include "headers/cpu/cpu_pmtimings.h" //Protected-mode timings header!
+#include "headers/support/log.h" //Logging support!
 
 #define EU_CYCLES_SUBSTRACT_ACCESSREAD 2
 #define EU_CYCLES_SUBSTRACT_ACCESSWRITE 2
@@ -1121,7 +1122,16 @@ CPUPM_Timings CPUPMTimings[CPUPMTIMINGS_SIZE] = {
 	,{1,1,1,0xBA,0xFF,0x06,{{{{6,0,0},{8,0,0}}},{{{6,0,0},{8,0,0}}}}} //BTS r/m32,imm8
 };
 
-word timing286lookup[4][2][2][0x100][8][8]; //4 modes(bit0=protected mode when set, bit1=32-bit instruction when set), 2 memory modes, 2 0F possibilities, 256 instructions, 9 modr/m variants, no more than 8 possibilities for every instruction. About 73K memory consumed(unaligned).
+//Verify the compact lookup tables against the full uncompressed lookup table when loading them?
+//#define TIMING286_SELFCHECK
+
+//Compact lookup tables: every distinct list of timing candidates is stored only once, with a list number for every lookup!
+#define TIMING286_MAXLISTS 0x400
+#define TIMING286_HASHSIZE 0x800
+word timing286lists[TIMING286_MAXLISTS][8]; //All distinct lists, no more than 8 possibilities for every instruction! List 0 is the empty list!
+word timing286numlists = 1; //Amount of lists that are used!
+word timing286lookup[4][2][2][0x100][8]; //4 modes(bit0=protected mode when set, bit1=32-bit instruction when set), 2 memory modes, 2 0F possibilities, 256 instructions, 8 modr/m variants. Gives the list to use. About 32K memory consumed.
+word timing286hash[TIMING286_HASHSIZE]; //Hash of the lists for finding duplicates while loading! Contains list number+1, 0 for unused!
 
 byte CPU_apply286cycles() //Apply the 80286+ cycles method. Result: 0 when to apply normal cycles. 1 when 80286+ cycles are applied!
 {
@@ -1144,11 +1154,11 @@ byte CPU_apply286cycles() //Apply the 80286+ cycles method. Result: 0 when to ap
 	if (CPU[activeCPU].CPU_interruptraised) //Any fault is raised?
 	{
 		ismemory = modrm_threevariablesused = 0; //Not to be applied with this!
-		currentinstructiontiming = &timing286lookup[isPM() | ((CPU[activeCPU].CPU_Operand_size) << 1)][0][0][0xCD][0x00][0]; //Start by pointing to our records to process! Enforce interrupt!
+		currentinstructiontiming = &timing286lists[timing286lookup[isPM() | ((CPU[activeCPU].CPU_Operand_size) << 1)][0][0][0xCD][0x00]][0]; //Start by pointing to our records to process! Enforce interrupt!
 	}
 	else
 	{
-		currentinstructiontiming = &timing286lookup[isPM() | ((CPU[activeCPU].CPU_Operand_size) << 1)][ismemory][CPU[activeCPU].is0Fopcode][CPU[activeCPU].currentopcode][MODRM_REG(CPU[activeCPU].params.modrm)][0]; //Start by pointing to our records to process!
+		currentinstructiontiming = &timing286lists[timing286lookup[isPM() | ((CPU[activeCPU].CPU_Operand_size) << 1)][ismemory][CPU[activeCPU].is0Fopcode][CPU[activeCPU].currentopcode][MODRM_REG(CPU[activeCPU].params.modrm)]][0]; //Start by pointing to our records to process!
 	}
 	//Try to use the lookup table!
 	for (instructiontiming = 0; ((instructiontiming < 8) && *currentinstructiontiming); ++instructiontiming, ++currentinstructiontiming) //Process all timing candidates!
@@ -1268,26 +1278,134 @@ byte haslower286timingpriority(byte CPUmode, byte ismemory, word lowerindex, wor
 
 int lookupTablesCPU = -1; //What lookup table is loaded?
 
-void CPU_initLookupTables() //Initialize the CPU timing lookup tables!
+//Build the list of timings for a single lookup entry, searching the candidates given. Result: 1=Found, 0=Not found(empty list)!
+OPTINLINE byte CPU_buildTimingList(byte CPUmode, byte ismemory, byte is0Fopcode, word instruction, word modrm_register, byte currentCPU, word *candidates, word numcandidates, word *sublist)
 {
 	word index; //The index into the main table!
+	word candidate; //The candidate to check!
 	word sublistindex; //The index in the sublist!
+	word sublistsize; //Sub-list size!
+	word tempsublist; //Temporary value for swapping items!
+	byte latestCPU; //Last supported CPU for this instruction timing!
+	byte current32; //32-bit opcode?
+	byte notfound = 0; //Not found CPU timings?
+	sublistsize = 0; //Initialize our size to none!
+	latestCPU = currentCPU; //Start off with the current CPU that's supported!
+	notfound = 1; //Default to not found!
+	current32 = (CPUmode >> 1); //32-bit opcode?
+try16bit:
+	for (;;) //Find the top CPU supported!
+	{
+		//First, detect the latest supported CPU!
+		for (candidate = 0; candidate < numcandidates; ++candidate) //Process all timings available!
+		{
+			index = candidates[candidate]; //The timing to check!
+			if ((CPUPMTimings[index].CPU == latestCPU) && (CPUPMTimings[index].is0F == is0Fopcode) && (CPUPMTimings[index].is32 == current32) && (CPUPMTimings[index].OPcode == (instruction & CPUPMTimings[index].OPcodemask))) //Basic opcode matches?
+			{
+				if ((CPUPMTimings[index].modrm_reg == 0) || (CPUPMTimings[index].modrm_reg == (modrm_register + 1))) //MODR/M filter matches to full opcode?
+				{
+					notfound = 0; //We're found!
+					goto topCPUTimingsdetected; //We're detected!
+				}
+			}
+		}
+		if (latestCPU == 0) goto topCPUTimingsdetected; //Abort when finished!
+		--latestCPU; //Check the next CPU!
+	}
+topCPUTimingsdetected: //TOP CPU timings detected?
+	memset(sublist, 0, sizeof(word)*8); //Clear our sublist!
+	if (notfound) //No CPU found matching this instruction?
+	{
+		if (current32) //32-bit opcode to check?
+		{
+			current32 = 0; //Try 16-bit opcode instead!
+			latestCPU = currentCPU; //Start off with the current CPU that's supported!
+			notfound = 1; //Default to not found!
+			goto try16bit; //Try the 16-bit variant instead!
+		}
+		return 0; //Unused timings!
+	}
+
+	//Now, find all items that apply to this instruction!
+	for (candidate = 0; candidate < numcandidates; ++candidate) //Process all timings available!
+	{
+		index = candidates[candidate]; //The timing to check!
+		if ((CPUPMTimings[index].CPU == latestCPU) && (CPUPMTimings[index].is0F == is0Fopcode) && (CPUPMTimings[index].OPcode == (instruction & CPUPMTimings[index].OPcodemask))) //Basic opcode matches?
+		{
+			if ((CPUPMTimings[index].modrm_reg == 0) || (CPUPMTimings[index].modrm_reg == (modrm_register + 1))) //MODR/M filter matches to full opcode?
+			{
+				if (sublistsize < 8) //Can we even add this item?
+				{
+					sublist[sublistsize++] = (index + 1); //Add the index to the sublist, when possible!
+				}
+			}
+		}
+	}
+
+	//Now, sort the items in their apropriate order!
+	for (index = 0; index < (sublistsize - 1); ++index) //Process all items to sort!
+	{
+		for (sublistindex = 0; sublistindex < (sublistsize - index - 1); ++sublistindex) //The items to compare!
+		{
+			if (haslower286timingpriority(CPUmode, ismemory, sublist[sublistindex], sublist[sublistindex + 1])) //Do we have lower timing priority (item must be after the item specified)?
+			{
+				tempsublist = sublist[sublistindex]; //Lower priority index saved!
+				sublist[sublistindex] = sublist[sublistindex + 1]; //Higher priority index to higher priority position!
+				sublist[sublistindex + 1] = tempsublist; //Lower priority index to lower priority position!
+			}
+		}
+	}
+	return 1; //The sublist is filled with items needed for the entry!
+}
+
+//Store a list of timings, reusing an identical list when it's already stored. Result: the list number to use!
+OPTINLINE word CPU_storeTimingList(word *sublist)
+{
+	word hash;
+	byte i;
+	hash = 0; //Init!
+	for (i = 0; i < 8; ++i) //Hash the entire list!
+	{
+		hash = ((hash * 31) + sublist[i]); //Add to the hash!
+	}
+	hash &= (TIMING286_HASHSIZE - 1); //The bucket to start at!
+	for (;timing286hash[hash];) //Search all used buckets!
+	{
+		if (memcmp(&timing286lists[timing286hash[hash] - 1], sublist, sizeof(timing286lists[0])) == 0) //Duplicate list?
+		{
+			return (timing286hash[hash] - 1); //Reuse the list!
+		}
+		hash = ((hash + 1) & (TIMING286_HASHSIZE - 1)); //Next bucket!
+	}
+	if (unlikely(timing286numlists >= TIMING286_MAXLISTS)) //Too many lists?
+	{
+		dolog("CPU", "Too many different 80286+ timing lists! Ignoring timings!");
+		return 0; //Use the empty list!
+	}
+	memcpy(&timing286lists[timing286numlists], sublist, sizeof(timing286lists[0])); //Store the new list!
+	timing286hash[hash] = ++timing286numlists; //Register the list in the hash!
+	return (timing286numlists - 1); //Give the new list!
+}
+
+void CPU_initLookupTables() //Initialize the CPU timing lookup tables!
+{
+	word index; //The index into the main table!
 	byte CPUmode; //The used CPU mode!
 	byte ismemory; //Memory used in the CPU mode!
 	byte is0Fopcode; //0F opcode bit!
 	word instruction; //Instruction itself!
 	word modrm_register; //The modr/m register used, if any(modr/m specified only)!
-	word sublistsize; //Sub-list size!
 	word sublist[8]; //All instructions matching this!
-	word tempsublist; //Temporary value for swapping items!
-	byte latestCPU; //Last supported CPU for this instruction timing!
+	word candidates[CPUPMTIMINGS_SIZE]; //All timings that apply to the current opcode!
+	word numcandidates; //Amount of candidates!
 	byte currentCPU; //The CPU we're emulating, relative to the 80286!
-	byte current32; //32-bit opcode?
-	byte notfound = 0; //Not found CPU timings?
 	if (lookupTablesCPU == (int)EMULATED_CPU) return; //Already loaded? Don't reload when already ready to use!
 	lookupTablesCPU = (int)EMULATED_CPU; //We're loading the specified CPU to be active!
 
 	memset(&timing286lookup, 0, sizeof(timing286lookup)); //Clear the entire list!
+	memset(&timing286lists, 0, sizeof(timing286lists)); //Clear all lists!
+	memset(&timing286hash, 0, sizeof(timing286hash)); //Clear the hash!
+	timing286numlists = 1; //Only the empty list is used!
 
 	if (EMULATED_CPU < CPU_80286) //Not a capable CPU for these timings?
 	{
@@ -1295,7 +1413,43 @@ void CPU_initLookupTables() //Initialize the CPU timing lookup tables!
 	}
 
 	currentCPU = EMULATED_CPU - CPU_80286; //The CPU to find in the table!
-	for (CPUmode = 0; CPUmode < 4; ++CPUmode) //All CPU modes! Real vs Protected is bit 0, 16-bit vs 32-bit is bit 1!
+	for (is0Fopcode = 0; is0Fopcode < 2; ++is0Fopcode) //All 0F opcode possibilities!
+	{
+		for (instruction = 0; instruction < 0x100; ++instruction) //All instruction opcodes!
+		{
+			//Only the timings for this opcode can ever match, so only search those for all variants!
+			numcandidates = 0; //Init!
+			for (index = 0; index < NUMITEMS(CPUPMTimings); ++index) //Process all timings available!
+			{
+				if ((CPUPMTimings[index].is0F == is0Fopcode) && (CPUPMTimings[index].OPcode == (instruction & CPUPMTimings[index].OPcodemask))) //Basic opcode matches?
+				{
+					candidates[numcandidates++] = index; //Candidate!
+				}
+			}
+			if (numcandidates == 0) continue; //Nothing to apply? Leave the empty list!
+			for (CPUmode = 0; CPUmode < 4; ++CPUmode) //All CPU modes! Real vs Protected is bit 0, 16-bit vs 32-bit is bit 1!
+			{
+				for (ismemory = 0; ismemory < 2; ++ismemory) //All memory modes!
+				{
+					for (modrm_register = 0; modrm_register < 8; ++modrm_register) //All modr/m variants!
+					{
+						if (CPU_buildTimingList(CPUmode, ismemory, is0Fopcode, instruction, modrm_register, currentCPU, &candidates[0], numcandidates, &sublist[0])) //Valid CPU found for this instruction?
+						{
+							timing286lookup[CPUmode][ismemory][is0Fopcode][instruction][modrm_register] = CPU_storeTimingList(&sublist[0]); //Use the list!
+						}
+					}
+				}
+			}
+		}
+	}
+	//The list is now ready for use!
+#ifdef TIMING286_SELFCHECK
+	//Verify the compact tables against the full search of all timings for every entry!
+	for (index = 0; index < NUMITEMS(CPUPMTimings); ++index) //All timings are candidates!
+	{
+		candidates[index] = index; //Candidate!
+	}
+	for (CPUmode = 0; CPUmode < 4; ++CPUmode) //All CPU modes!
 	{
 		for (ismemory = 0; ismemory < 2; ++ismemory) //All memory modes!
 		{
@@ -1305,79 +1459,16 @@ void CPU_initLookupTables() //Initialize the CPU timing lookup tables!
 				{
 					for (modrm_register = 0; modrm_register < 8; ++modrm_register) //All modr/m variants!
 					{
-						sublistsize = 0; //Initialize our size to none!
-						latestCPU = currentCPU; //Start off with the current CPU that's supported!
-						notfound = 1; //Default to not found!
-						current32 = (CPUmode >> 1); //32-bit opcode?
-					try16bit:
-						for (;;) //Find the top CPU supported!
+						CPU_buildTimingList(CPUmode, ismemory, is0Fopcode, instruction, modrm_register, currentCPU, &candidates[0], NUMITEMS(CPUPMTimings), &sublist[0]); //Build the full list!
+						if (memcmp(&timing286lists[timing286lookup[CPUmode][ismemory][is0Fopcode][instruction][modrm_register]], &sublist, sizeof(sublist))) //Mismatch?
 						{
-							//First, detect the latest supported CPU!
-							for (index = 0; index < NUMITEMS(CPUPMTimings); ++index) //Process all timings available!
-							{
-								if ((CPUPMTimings[index].CPU == latestCPU) && (CPUPMTimings[index].is0F == is0Fopcode) && (CPUPMTimings[index].is32 == current32) && (CPUPMTimings[index].OPcode == (instruction & CPUPMTimings[index].OPcodemask))) //Basic opcode matches?
-								{
-									if ((CPUPMTimings[index].modrm_reg == 0) || (CPUPMTimings[index].modrm_reg == (modrm_register + 1))) //MODR/M filter matches to full opcode?
-									{
-										notfound = 0; //We're found!
-										goto topCPUTimingsdetected; //We're detected!
-									}
-								}
-							}
-							if (latestCPU == 0) goto topCPUTimingsdetected; //Abort when finished!
-							--latestCPU; //Check the next CPU!
-						}
-					topCPUTimingsdetected: //TOP CPU timings detected?
-						memset(&sublist, 0, sizeof(sublist)); //Clear our sublist!
-						if (notfound) //No CPU found matching this instruction?
-						{
-							if (current32) //32-bit opcode to check?
-							{
-								current32 = 0; //Try 16-bit opcode instead!
-								latestCPU = currentCPU; //Start off with the current CPU that's supported!
-								notfound = 1; //Default to not found!
-								goto try16bit; //Try the 16-bit variant instead!
-							}
-							memset(&timing286lookup[CPUmode][ismemory][is0Fopcode][instruction][modrm_register], 0, sizeof(timing286lookup[CPUmode][ismemory][is0Fopcode][instruction][modrm_register])); //Unused timings!
-						}
-						else //Valid CPU found for this instruction?
-						{
-							//Now, find all items that apply to this instruction!
-							for (index = 0; index < NUMITEMS(CPUPMTimings); ++index) //Process all timings available!
-							{
-								if ((CPUPMTimings[index].CPU == latestCPU) && (CPUPMTimings[index].is0F == is0Fopcode) && (CPUPMTimings[index].OPcode == (instruction & CPUPMTimings[index].OPcodemask))) //Basic opcode matches?
-								{
-									if ((CPUPMTimings[index].modrm_reg == 0) || (CPUPMTimings[index].modrm_reg == (modrm_register + 1))) //MODR/M filter matches to full opcode?
-									{
-										if (sublistsize < NUMITEMS(sublist)) //Can we even add this item?
-										{
-											sublist[sublistsize++] = (index + 1); //Add the index to the sublist, when possible!
-										}
-									}
-								}
-							}
-
-							//Now, sort the items in their apropriate order!
-							for (index = 0; index < (sublistsize - 1); ++index) //Process all items to sort!
-							{
-								for (sublistindex = 0; sublistindex < (sublistsize - index - 1); ++sublistindex) //The items to compare!
-								{
-									if (haslower286timingpriority(CPUmode, ismemory, sublist[sublistindex], sublist[sublistindex + 1])) //Do we have lower timing priority (item must be after the item specified)?
-									{
-										tempsublist = sublist[sublistindex]; //Lower priority index saved!
-										sublist[sublistindex] = sublist[sublistindex + 1]; //Higher priority index to higher priority position!
-										sublist[sublistindex + 1] = tempsublist; //Lower priority index to lower priority position!
-									}
-								}
-							}
-
-							//Now, the sublist is filled with items needed for the entry!
-							memcpy(&timing286lookup[CPUmode][ismemory][is0Fopcode][instruction][modrm_register], &sublist, MIN(sizeof(sublist), sizeof(timing286lookup[CPUmode][ismemory][is0Fopcode][instruction][modrm_register]))); //Copy the sublist to the active items!
+							dolog("CPU", "80286+ timing self-check failed: mode %u memory %u 0F %u opcode %02X reg %u", CPUmode, ismemory, is0Fopcode, instruction, modrm_register);
 						}
 					}
 				}
 			}
 		}
 	}
-	//The list is now ready for use!
+	dolog("CPU", "80286+ timing self-check finished: %u distinct timing lists used.", timing286numlists);
+#endif
 }
\ No newline at end of file
@@ -72,6 +72,7 @@
 #include "headers/cpu/biu.h" //For checking if we're able to HLT and lock!
 #include "headers/hardware/modem.h" //Modem support!
 #include "headers/hardware/i430fx.h" //i430fx support!
+#include "headers/emu/profiler.h" //Device profiler support!
 
 //Emulator single step address, when enabled.
 byte doEMUsinglestep[5] = { 0,0,0,0,0 }; //CPU mode plus 1
@@ -425,6 +426,7 @@ void initEMU(int full) //Init!
 	MMU_resetHandlers(NULL); //Reset all memory handlers before starting!
 
 	initTicksHolder(&CPU_timing); //Initialise the ticks holder!
+	PROFILER_INIT(); //Start profiling, if enabled!
 
 	debugrow("Initializing user input...");
 	psp_input_init(); //Make sure input is set up!
@@ -788,6 +790,8 @@ void doneEMU()
 		doneVideo(); //Cleanup screen buffers!
 		debugrow("doneEMU: Finishing user input...");
 		psp_input_done(); //Make sure input is set up!
+		debugrow("doneEMU: Finishing profiler...");
+		PROFILER_DONE(); //Stop profiling, if enabled!
 		debugrow("doneEMU: EMU finished!");
 		emu_started = 0; //Not started anymore!
 		EMU_RUNNING = 0; //We aren't running anymore!
@@ -1163,6 +1167,7 @@ OPTINLINE byte coreHandler()
 	if (unlikely((currentCPUtime-last_timing)>2000000000.0)) last_timing = currentCPUtime-1000.0; //Safety: 2 seconds or more(should be impossible normally) becomes 1us.
 	for (;last_timing<currentCPUtime;) //CPU cycle loop for as many cycles as needed to get up-to-date!
 	{
+		PROFILER_BEGINSTEP(); //Start of a step!
 		if (unlikely(debugger_thread))
 		{
 			if (threadRunning(debugger_thread)) //Are we running the debugger?
@@ -1409,6 +1414,7 @@ OPTINLINE byte coreHandler()
 
 		effectiveinstructiontime = MAX(effectiveinstructiontime,instructiontime); //Maximum CPU time passed!
 		} while (++activeCPU<numemulatedcpus); //More CPUs left to handle?
+		PROFILER_MARK(PROFILE_CPU); //The CPUs have been executed!
 
 		//Seperate timing for the TSC and APIC to keep them in sync!
 		if (unlikely((EMULATED_CPU >= CPU_PENTIUM) && (effectiveinstructiontime>0.0))) //Pentium has a time stamp counter?
@@ -1431,6 +1437,7 @@ OPTINLINE byte coreHandler()
 				CPU[activeCPU].TSC += clocks; //Tick the clocks to keep us running!
 				updateAPIC(clocks, effectiveinstructiontime); //Clock the APIC as well!
 			} while (++activeCPU < numemulatedcpus); //More CPUs left to handle?
+			PROFILER_MARK(PROFILE_APIC); //The APIC has been ticked!
 		}
 
 		buslocksrequested = 0; //No locks requested!
@@ -1490,6 +1497,7 @@ OPTINLINE byte coreHandler()
 			}
 		}
 		finishLocked:
+		PROFILER_MARK(PROFILE_CPU); //Locked bus cycles are part of the CPU!
 
 		activeCPU = 0; //Return to the BSP!
 		//Now, ticking the hardware!
@@ -1511,44 +1519,71 @@ OPTINLINE byte coreHandler()
 
 		MMU_logging |= 2; //Are we logging hardware memory accesses(DMA etc)?
 		DOUBLE MHZ14passed_ns=0.0;
+		PROFILER_MARK(PROFILE_CORE); //Timekeeping is part of the core!
 		if (unlikely(MHZ14passed)) //14MHz to be ticked?
 		{
 			MHZ14passed_ns = MHZ14passed*MHZ14tick; //Actual ns ticked!
 			if (likely((CPU[activeCPU].halt & 0x10) == 0))
 			{
 				updateDMA(MHZ14passed, 0); //Update the DMA timer!
+				PROFILER_MARK(PROFILE_DMA);
 				tickPIT(MHZ14passed_ns, MHZ14passed); //Tick the PIT as much as we need to keep us in sync when running!
+				PROFILER_MARK(PROFILE_PIT);
 			}
 			if (useAdlib) updateAdlib(MHZ14passed); //Tick the adlib timer if needed!
+			PROFILER_MARK(PROFILE_ADLIB);
 			updateMouse(MHZ14passed_ns); //Tick the mouse timer if needed!
+			PROFILER_MARK(PROFILE_MOUSE);
 			stepDROPlayer(MHZ14passed_ns); //DRO player playback, if any!
+			PROFILER_MARK(PROFILE_DRO);
 			updateMIDIPlayer(MHZ14passed_ns); //MIDI player playback, if any!
+			PROFILER_MARK(PROFILE_MIDIPLAYER);
 			updatePS2Keyboard(MHZ14passed_ns); //Tick the PS/2 keyboard timer, if needed!
+			PROFILER_MARK(PROFILE_PS2KEYBOARD);
 			updatePS2Mouse(MHZ14passed_ns); //Tick the PS/2 mouse timer, if needed!
+			PROFILER_MARK(PROFILE_PS2MOUSE);
 			update8042(MHZ14passed_ns); //Tick the PS/2 mouse timer, if needed!
+			PROFILER_MARK(PROFILE_8042);
 			if (likely((CPU[activeCPU].halt & 0x10) == 0))
 			{
 				updateCMOS(MHZ14passed_ns); //Tick the CMOS, if needed!
+				PROFILER_MARK(PROFILE_CMOS);
 			}
 			updateFloppy(MHZ14passed_ns); //Update the floppy!
+			PROFILER_MARK(PROFILE_FLOPPY);
 			updateMPUTimer(MHZ14passed_ns); //Update the MPU timing!
+			PROFILER_MARK(PROFILE_MPU);
 			if (useGameBlaster && ((CPU[activeCPU].halt&0x10)==0)) updateGameBlaster(MHZ14passed_ns,MHZ14passed); //Tick the Game Blaster timer if needed and running!
+			PROFILER_MARK(PROFILE_GAMEBLASTER);
 			if (useSoundBlaster && ((CPU[activeCPU].halt&0x10)==0)) updateSoundBlaster(MHZ14passed_ns,MHZ14passed); //Tick the Sound Blaster timer if needed and running!
+			PROFILER_MARK(PROFILE_SOUNDBLASTER);
 			updateATA(MHZ14passed_ns); //Update the ATA timer!
+			PROFILER_MARK(PROFILE_ATA);
 			tickParallel(MHZ14passed_ns); //Update the Parallel timer!
+			PROFILER_MARK(PROFILE_PARALLEL);
 			updateUART(MHZ14passed_ns); //Update the UART timer!
+			PROFILER_MARK(PROFILE_UART);
 			if (useLPTDAC && ((CPU[activeCPU].halt&0x10)==0)) tickssourcecovox(MHZ14passed_ns); //Update the Sound Source / Covox Speech Thing if needed!
+			PROFILER_MARK(PROFILE_SSOURCE);
 			if (likely((CPU[activeCPU].halt&0x10)==0)) updateVGA(0.0,MHZ14passed); //Update the video 14MHz timer, when running!
+			PROFILER_MARK(PROFILE_VGA);
 		}
 		if (likely((CPU[activeCPU].halt&0x10)==0)) updateVGA(instructiontime,0); //Update the normal video timer, when running!
+		PROFILER_MARK(PROFILE_VGA);
 		if (likely((CPU[activeCPU].halt&0x10)==0)) updateDMA(0,CPU[activeCPU].cycles); //Update the DMA timer, when running!
+		PROFILER_MARK(PROFILE_DMA);
 		if (unlikely(MHZ14passed))
 		{
 			updateModem(MHZ14passed_ns); //Update the modem!
+			PROFILER_MARK(PROFILE_MODEM);
 			updateJoystick(MHZ14passed_ns); //Update the Joystick!
+			PROFILER_MARK(PROFILE_JOYSTICK);
 			updateAudio(MHZ14passed_ns); //Update the general audio processing!
+			PROFILER_MARK(PROFILE_AUDIO);
 			BIOSROM_updateTimers(MHZ14passed_ns); //Update any ROM(Flash ROM) timers!
+			PROFILER_MARK(PROFILE_BIOSROM);
 			PPI_checkfailsafetimer(); //Check for any failsafe timers to raise, if required!
+			PROFILER_MARK(PROFILE_PPI);
 		}
 		MMU_logging &= ~2; //Are we logging hardware memory accesses again?
 		if (unlikely(--timeout==0)) //Timed out?
@@ -1561,6 +1596,7 @@ OPTINLINE byte coreHandler()
 				break;
 			}
 		}
+		PROFILER_MARK(PROFILE_CORE); //Timekeeping is part of the core!
 	} //CPU cycle loop!
 
 	skipCPUtiming: //Audio emulation only?
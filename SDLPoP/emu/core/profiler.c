@@ -0,0 +1,230 @@
+/*
+
+Copyright (C) 2019 - 2021 Superfury
+
+This file is part of UniPCemu.
+
+UniPCemu is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+UniPCemu is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with UniPCemu.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "headers/types.h" //Basic types!
+#include "headers/emu/profiler.h" //Our own definitions!
+
+#ifdef DEVICE_PROFILER
+#include "headers/support/highrestimer.h" //High resolution timer!
+#include "headers/support/locks.h" //Locking support!
+#include "headers/fopen64.h" //64-bit fopen support!
+
+//Raw ticks to time the laps with. These are converted to ns using the wall time of every period!
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#ifdef _MSC_VER
+#include <intrin.h> //RDTSC support!
+#else
+#include <x86intrin.h> //RDTSC support!
+#endif
+#define PROFILER_TICKS() (uint_64)__rdtsc()
+#elif defined(SDL2)
+#define PROFILER_TICKS() (uint_64)SDL_GetPerformanceCounter()
+#else
+#define PROFILER_TICKS() (uint_64)SDL_GetTicks()
+#endif
+
+/*
+
+Device profiler: one out of every PROFILER_SAMPLEINTERVAL steps of the core handler is timed.
+Every device marks the end of its update, which adds the ticks since the previous mark to the device.
+The sampled ticks are scaled by the interval to estimate the host time spent on each device every second.
+A lap that takes way too long is the host preempting us: it's discarded, together with the rest of the step, because scaling it would blow it up.
+
+*/
+
+byte profiler_sampling = 0; //Are we sampling the current step?
+byte profiler_countdown = 1; //Steps left until the next sampled step!
+
+uint_64 profiler_lap = 0; //Ticks at the last mark in the sampled step!
+uint_64 profiler_periodstart = 0; //Ticks at the start of the current period!
+uint_64 profiler_overhead = 0; //Ticks taken by a mark itself!
+uint_64 profiler_maxlap = ~0ULL; //Maximum ticks of a lap!
+TicksHolder profiler_walltime; //Wall time of the current period!
+
+int_64 profiler_sampled[NUMPROFILES]; //Sampled ticks of the current period!
+DOUBLE profiler_period = 0.0; //Wall time of the current period!
+DOUBLE profiler_totaltime = 0.0; //Total wall time profiled!
+
+//The last finished period, for displaying!
+DOUBLE profiler_last[NUMPROFILES]; //Estimated time spent in the last period!
+DOUBLE profiler_lastwall = 0.0; //Wall time of the last period!
+
+BIGFILE *profiler_csv = NULL; //The CSV file to append to!
+extern char logpath[256]; //Log path!
+
+char profiler_names[NUMPROFILES][16] = {
+	"CPU","APIC","DMA","PIT","Adlib","Mouse","DRO","MIDIplayer","PS2keyboard","PS2mouse","8042","CMOS","Floppy","MPU",
+	"GameBlaster","SoundBlaster","ATA","Parallel","UART","SoundSource","VGA","Modem","Joystick","Audio","BIOSROM","PPI","Core"
+	}; //The names of the devices!
+
+void profiler_publish(uint_64 ticks) //A period has finished!
+{
+	char line[1024];
+	char *p;
+	byte device;
+	DOUBLE estimated[NUMPROFILES], other, tickrate;
+	tickrate = profiler_period/(DOUBLE)(ticks-profiler_periodstart); //ns per tick over this period!
+	profiler_periodstart = ticks; //Start of the next period!
+	profiler_maxlap = (uint_64)(PROFILER_MAXLAP/tickrate); //Maximum lap in ticks!
+	other = profiler_period; //What's left of the wall time!
+	for (device=0;device<NUMPROFILES;++device) //Scale all sampled ticks!
+	{
+		estimated[device] = (DOUBLE)MAX(profiler_sampled[device],0)*tickrate*(DOUBLE)PROFILER_SAMPLEINTERVAL; //Estimated time spent!
+		other -= estimated[device]; //Not outside the core handler!
+		profiler_sampled[device] = 0; //Restart sampling!
+	}
+	lock(LOCK_FRAMERATE); //We're updating framerate info!
+	memcpy(&profiler_last,&estimated,sizeof(profiler_last)); //Publish!
+	profiler_lastwall = profiler_period; //The period it's measured over!
+	unlock(LOCK_FRAMERATE);
+	profiler_totaltime += profiler_period; //Total time profiled!
+	if (profiler_csv) //Logging?
+	{
+		p = &line[0]; //Start of the line!
+		p += snprintf(p,sizeof(line),"%.3f,%.0f",(double)(profiler_totaltime/1000000000.0),(double)profiler_period); //Time and wall time!
+		for (device=0;device<NUMPROFILES;++device) //All devices!
+		{
+			p += snprintf(p,sizeof(line)-(p-&line[0]),",%.0f",(double)estimated[device]); //The device!
+		}
+		snprintf(p,sizeof(line)-(p-&line[0]),",%.0f\n",(double)other); //Time spent outside the core handler!
+		emufwrite64(&line,1,safe_strlen(line,sizeof(line)),profiler_csv); //Append the line!
+	}
+	profiler_period = 0.0; //Start a new period!
+}
+
+void profiler_startstep() //Start a sampled step!
+{
+	profiler_countdown = PROFILER_SAMPLEINTERVAL; //Next sample!
+	profiler_period += getnspassed(&profiler_walltime); //Time passed!
+	profiler_lap = PROFILER_TICKS(); //Start timing the step!
+	if (unlikely(profiler_period>=1000000000.0)) //A second has passed?
+	{
+		profiler_publish(profiler_lap); //Publish the last second!
+		profiler_lap = PROFILER_TICKS(); //Start timing the step after publishing!
+	}
+	profiler_sampling = 1; //We're sampling!
+}
+
+void profiler_mark(byte device) //The device has finished in the sampled step!
+{
+	uint_64 ticks;
+	ticks = PROFILER_TICKS(); //Current ticks!
+	if (unlikely((ticks-profiler_lap)>profiler_maxlap)) //Preempted?
+	{
+		profiler_sampling = 0; //Discard the rest of the step!
+		return;
+	}
+	profiler_sampled[device] += (int_64)(ticks-profiler_lap-profiler_overhead); //Add the ticks the device took! Can be negative for short laps, but averages out!
+	profiler_lap = ticks; //Start of the next lap!
+}
+
+void profiler_render(GPU_TEXTSURFACE *surface, int row) //Show the top entries of the last second!
+{
+	DOUBLE entries[NUMPROFILES], wall;
+	byte device, top, shown;
+	lock(LOCK_FRAMERATE); //We're using framerate info!
+	memcpy(&entries,&profiler_last,sizeof(entries));
+	wall = profiler_lastwall;
+	unlock(LOCK_FRAMERATE);
+	GPU_textgotoxy(surface,0,row); //For output!
+	if (wall<=0.0) //Nothing measured yet?
+	{
+		GPU_textclearrow(surface,row); //Clear the row!
+		return;
+	}
+	for (shown=0;shown<PROFILER_SHOWENTRIES;++shown) //Show the top entries!
+	{
+		top = 0; //Find the most expensive device left!
+		for (device=1;device<NUMPROFILES;++device)
+		{
+			if (entries[device]>entries[top]) top = device; //More expensive?
+		}
+		if (entries[top]<=0.0) break; //Nothing left to show!
+		GPU_textprintf(surface,RGB(0xFF,0xFF,0xFF),RGB(0x22,0x22,0x22),"%s%s: %02.1f%%",shown?", ":"",profiler_names[top],(float)((entries[top]/wall)*100.0)); //Show the device!
+		entries[top] = 0.0; //Shown!
+	}
+	GPU_textclearcurrentrownext(surface); //Clear the rest of the current row!
+}
+
+void initProfiler() //Start profiling!
+{
+	char filename[256];
+	word i;
+	byte batch;
+	uint_64 overhead;
+	memset(&profiler_sampled,0,sizeof(profiler_sampled)); //Nothing sampled yet!
+	memset(&profiler_last,0,sizeof(profiler_last)); //Nothing to show yet!
+	profiler_lastwall = profiler_period = profiler_totaltime = 0.0; //Nothing profiled yet!
+	profiler_sampling = 0; //Not sampling!
+	profiler_countdown = PROFILER_SAMPLEINTERVAL; //Start sampling!
+	//Calibrate the ticks taken by a mark itself, using the fastest batch of empty laps to ignore interruptions!
+	overhead = ~0ULL; //Nothing measured yet!
+	for (batch=0;batch<16;++batch) //Time some batches!
+	{
+		profiler_overhead = 0; //No overhead while calibrating!
+		profiler_sampled[PROFILE_CORE] = 0; //Nothing measured yet!
+		profiler_lap = PROFILER_TICKS(); //Start of the first lap!
+		for (i=0;i<256;++i) //Time some empty laps!
+		{
+			profiler_mark(PROFILE_CORE); //An empty lap!
+		}
+		overhead = MIN(overhead,(uint_64)(MAX(profiler_sampled[PROFILE_CORE],0)>>8)); //Average empty lap of the batch!
+	}
+	profiler_overhead = overhead; //The overhead to use!
+	profiler_sampled[PROFILE_CORE] = 0; //Not sampled!
+	initTicksHolder(&profiler_walltime); //Start of the period!
+	profiler_periodstart = PROFILER_TICKS(); //Start of the period!
+	//Estimate the maximum lap until the first period has finished!
+	profiler_maxlap = ~0ULL; //Don't discard anything yet!
+	for (;getnspassed_k(&profiler_walltime)<PROFILER_MAXLAP;) {} //Wait for a maximum lap to pass!
+	profiler_maxlap = PROFILER_TICKS()-profiler_periodstart; //Ticks of a maximum lap!
+	initTicksHolder(&profiler_walltime); //Start of the period!
+	profiler_periodstart = PROFILER_TICKS(); //Start of the period!
+	if (profiler_csv==NULL) //Not logging yet?
+	{
+		domkdir(logpath); //Make sure the log directory exists!
+		snprintf(filename,sizeof(filename),"%s/profiler.csv",logpath); //The CSV file!
+		if ((profiler_csv = emufopen64(filename,"rb"))) //Existing?
+		{
+			emufclose64(profiler_csv); //Close it!
+			profiler_csv = emufopen64(filename,"ab"); //Reopen for appending!
+		}
+		else if ((profiler_csv = emufopen64(filename,"wb"))) //New file? Write the header!
+		{
+			emufwrite64("time,wall",1,9,profiler_csv);
+			for (i=0;i<NUMPROFILES;++i) //All devices!
+			{
+				snprintf(filename,sizeof(filename),",%s",profiler_names[i]); //The device!
+				emufwrite64(&filename,1,safe_strlen(filename,sizeof(filename)),profiler_csv);
+			}
+			emufwrite64(",other\n",1,7,profiler_csv);
+		}
+	}
+}
+
+void doneProfiler() //Stop profiling!
+{
+	if (profiler_csv) //Logging?
+	{
+		emufclose64(profiler_csv); //Close the CSV file!
+		profiler_csv = NULL; //Closed!
+	}
+}
+#endif
@@ -29,6 +29,7 @@ along with UniPCemu.  If not, see <https://www.gnu.org/licenses/>.
 #include "headers/support/wave.h" //WAV file logging support!
 #include "headers/support/filters.h" //Filter support!
 #include "headers/support/signedness.h" //Sign conversion support!
+#include "../pop/opl3.h" //Fixed-point OPL synthesis core!
 
 #define uint8_t byte
 #define uint16_t word
@@ -58,6 +59,10 @@ along with UniPCemu.  If not, see <https://www.gnu.org/licenses/>.
 
 //How large is our sample buffer? 1=Real time, 0=Automatically determine by hardware
 #define __ADLIB_SAMPLEBUFFERSIZE 4971
+//Use the table-driven fixed-point synthesis core(log-sin/exp ROM tables, integer phase accumulators) instead of the floating point synthesizer? Uncomment to enable!
+//#define ADLIB_FIXEDPOINT
+//How many samples are pending at most before the fixed-point core renders them as a block? Register writes always render the pending samples first!
+#define ADLIB_BLOCKSIZE 256
 
 #define PI2 ((float)(2.0f * PI))
 
@@ -121,6 +126,12 @@ byte CSMMode; //CSM mode enabled?
 
 SOUNDDOUBLEBUFFER adlib_soundbuffer; //Our sound buffer for rendering!
 
+#ifdef ADLIB_FIXEDPOINT
+opl3_chip adlib_opl2chip; //The fixed-point chip, running in OPL2 mode!
+uint_32 adlib_pendingsamples = 0; //How many samples are still to be rendered by the fixed-point core?
+void adlib_renderFixedPoint(); //Prototype!
+#endif
+
 #ifdef WAV_ADLIB
 WAVEFILE *adlibout = NULL;
 #endif
@@ -348,12 +359,49 @@ void writeadlibaddr(byte value)
 	adlibaddr = value; //Set the address!
 }
 
+#ifdef ADLIB_FIXEDPOINT
+void adlib_writeFixedPoint(byte portnum, byte value)
+{
+	byte i;
+	adlib_renderFixedPoint(); //Render all samples up to the current point in time first!
+	switch (portnum) //Special handling?
+	{
+	case 0x01: //Waveform select enable?
+		if ((value^adlibregmem[1])&0x20) //Changed? Reapply all waveform selects!
+		{
+			for (i=0;i<0x16;++i) //Process all operators!
+			{
+				OPL3_WriteReg(&adlib_opl2chip, 0xE0|i, (value & 0x20) ? adlibregmem[0xE0|i] : 0); //Apply the waveform, masked by the enable bit!
+			}
+		}
+		break;
+	case 0x02: //Timers are handled by us!
+	case 0x03:
+	case 0x04:
+		break;
+	default:
+		if ((portnum>=0xE0) && (portnum<=0xF5)) //Waveform select?
+		{
+			OPL3_WriteReg(&adlib_opl2chip, portnum, (adlibregmem[1] & 0x20) ? value : 0); //Apply the waveform, masked by the enable bit!
+		}
+		else //Normal register?
+		{
+			OPL3_WriteReg(&adlib_opl2chip, portnum, value); //Apply the value!
+		}
+		break;
+	}
+}
+#endif
+
 void writeadlibdata(byte value)
 {
 	word portnum;
 	byte oldval;
 	portnum = adlibaddr;
 	oldval = adlibregmem[portnum]; //Save the old value for reference!
+	#ifdef ADLIB_FIXEDPOINT
+	adlib_writeFixedPoint((byte)portnum, value); //Apply the write to the fixed-point core!
+	#endif
 	if (portnum != 4) adlibregmem[portnum] = value; //Timer control applies it itself, depending on the value!
 	switch (portnum & 0xF0) //What block to handle?
 	{
@@ -953,9 +1001,17 @@ OPTINLINE void tick_adlibtimer()
 	{
 		//Process CSM tick!
 		byte channel=0;
+		#ifdef ADLIB_FIXEDPOINT
+		adlib_renderFixedPoint(); //Render all samples up to the current point in time first!
+		#endif
 		for (;;)
 		{
+			#ifdef ADLIB_FIXEDPOINT
+			OPL3_WriteReg(&adlib_opl2chip, 0xB0|channel, adlibregmem[0xB0|channel]|0x20); //Force the key to turn on!
+			OPL3_WriteReg(&adlib_opl2chip, 0xB0|channel, adlibregmem[0xB0|channel]); //Restore the programmed key status!
+			#else
 			writeadlibKeyON(channel,3); //Force the key to turn on!
+			#endif
 			if (++channel==9) break; //Finished!
 		}
 	}
@@ -1240,6 +1296,31 @@ void cleanAdlib()
 HIGHLOWPASSFILTER adlibfilter; //Output filter of the OPL2 output!
 float opl2_currentsample; //Current sample!
 
+#ifdef ADLIB_FIXEDPOINT
+void adlib_renderFixedPoint() //Render all pending samples using the fixed-point core!
+{
+	Bit16s buf[2]; //Stereo output of the core(both channels are the same in OPL2 mode)!
+	float sample;
+	if (!adlib_pendingsamples) return; //Nothing to render?
+	do
+	{
+		OPL3_Generate(&adlib_opl2chip, &buf[0]); //Generate a sample at the native chip rate!
+		sample = (float)buf[0]; //Mono output!
+		#ifdef ADLIB_LOWPASS
+			opl2_currentsample = sample;
+			//We're applying the low pass filter for the speaker!
+			applySoundFilter(&adlibfilter, &opl2_currentsample);
+			sample = opl2_currentsample; //Convert us back to our range!
+		#endif
+		sample = LIMITRANGE(sample, (float)SHRT_MIN, (float)SHRT_MAX); //Clip our data to prevent overflow!
+		#ifdef WAV_ADLIB
+		writeWAVMonoSample(adlibout,(word)(sword)sample); //Log the samples!
+		#endif
+		writeDoubleBufferedSound16(&adlib_soundbuffer,(word)(sword)sample); //Output the sample to the renderer!
+	} while (--adlib_pendingsamples); //Render all pending samples!
+}
+#endif
+
 byte adlib_ticktiming80 = 0; //80us divider!
 uint_32 adlib_ticktiming=0; //Sound timing!
 void updateAdlib(uint_32 MHZ14passed)
@@ -1258,6 +1339,9 @@ void updateAdlib(uint_32 MHZ14passed)
 				adlib_timer80(); //Tick 80us timer!
 			}
 			//Now, process the samples required!
+			#ifdef ADLIB_FIXEDPOINT
+			++adlib_pendingsamples; //Render this sample in the next block!
+			#else
 			OPL2_stepRNG(); //Tick the RNG!
 			OPL2_stepTremoloVibrato(); //Step tremolo/vibrato!
 			byte filled;
@@ -1288,8 +1372,15 @@ void updateAdlib(uint_32 MHZ14passed)
 			#endif
 			writeDoubleBufferedSound16(&adlib_soundbuffer,(word)sample); //Output the sample to the renderer!
 			tickadlib(); //Tick us to the next timing if needed!
+			#endif
 			adlib_ticktiming -= MHZ14_TICK; //Decrease timer to get time left!
 		} while (adlib_ticktiming>=MHZ14_TICK);
+		#ifdef ADLIB_FIXEDPOINT
+		if (adlib_pendingsamples>=ADLIB_BLOCKSIZE) //Enough samples for a block?
+		{
+			adlib_renderFixedPoint(); //Render the pending block!
+		}
+		#endif
 	}
 }
 
@@ -1422,6 +1513,11 @@ void initAdlib()
 	adlib_ticktiming = 0; //Reset our output timing!
 	adlib_ticktiming80 = 0; //80us tick timing!
 
+	#ifdef ADLIB_FIXEDPOINT
+	OPL3_Reset(&adlib_opl2chip, (Bit32u)usesamplerate); //Reset the fixed-point core! It's running at the native chip rate, so no resampling is used!
+	adlib_pendingsamples = 0; //Nothing pending yet!
+	#endif
+
 	if (__SOUND_ADLIB)
 	{
 		if (allocDoubleBufferedSound16(__ADLIB_SAMPLEBUFFERSIZE,&adlib_soundbuffer,0,usesamplerate)) //Valid buffer?
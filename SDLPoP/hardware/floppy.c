@@ -30,6 +30,7 @@ along with UniPCemu.  If not, see <https://www.gnu.org/licenses/>.
 #include "headers/bios/biosrom.h" //ROM support for Turbo XT BIOS detection!
 #include "headers/emu/debugger/debugger.h" //For logging extra information when debugging!
 #include "headers/hardware/cmos.h" //CMOS setting support!
+#include "headers/basicio/diskworker.h" //Disk I/O worker support!
 
 //Configuration of the FDC...
 
@@ -47,6 +48,9 @@ along with UniPCemu.  If not, see <https://www.gnu.org/licenses/>.
 //What DMA channel is expected of floppy disk I/O
 #define FLOPPY_DMA 2
 
+//How much data to read ahead after reading a sector, in bytes! One 1.44MB track!
+#define FLOPPY_READAHEAD 0x2400
+
 //Floppy DMA transfer pulse time, in nanoseconds! How long to take to transfer one byte! Use the sector byte speed for now!
 #define FLOPPY_DMA_TIMEOUT FLOPPY.DMArate
 
@@ -1321,8 +1325,9 @@ void floppy_readsector() //Request a read sector command!
 
 	FLOPPY.ST1 = 0x04; //Couldn't find any sector!
 	FLOPPY.ST2 = 0x01; //Data address mark not found!
-	if (readdata(FLOPPY_DOR_DRIVENUMBERR ? FLOPPY1 : FLOPPY0, &FLOPPY.databuffer, FLOPPY.disk_startpos, FLOPPY.databuffersize)) //Read the data into memory?
+	if (diskworker_read(FLOPPY_DOR_DRIVENUMBERR ? FLOPPY1 : FLOPPY0, &FLOPPY.databuffer, FLOPPY.disk_startpos, FLOPPY.databuffersize)) //Read the data into memory?
 	{
+		diskworker_readahead(FLOPPY_DOR_DRIVENUMBERR ? FLOPPY1 : FLOPPY0, FLOPPY.disk_startpos+FLOPPY.databuffersize, FLOPPY_READAHEAD); //Read the following sectors ahead!
 		if (FLOPPY.ejectingpending[FLOPPY_DOR_DRIVENUMBERR]) //Disk changed?
 		{
 			FLOPPY.ST1 = 0x04; //Couldn't find any sector!
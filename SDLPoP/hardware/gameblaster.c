@@ -69,6 +69,8 @@ along with UniPCemu.  If not, see <https://www.gnu.org/licenses/>.
 #define __GAMEBLASTER_SAMPLERATE (MHZ14/MHZ14_RENDERTICK)
 #define __GAMEBLASTER_SAMPLEBUFFERSIZE 4096
 #define __GAMEBLASTER_VOLUME 100.0f
+//Maximum amount of samples to render in one run!
+#define __GAMEBLASTER_BLOCKSIZE 256
 
 //We're two times 6 channels mixed on left and right, so not 6 channels but 12 channels each!
 #ifdef IS_LONGDOUBLE
@@ -742,12 +744,6 @@ OPTINLINE void generateSAA1099channelsample(SAA1099 *chip, byte channel, int_32
 	channel &= 7;
 	chip->channels[channel].level = getSAA1099SquareWave(chip,channel); //Current flipflop output of the square wave generator!
 
-	//Tick the envelopes when needed(after taking the last sample from the set of channels that use it)!
-	if (unlikely((channel==1) && (chip->env_clock[0]==0)))
-		tickSAAEnvelope(chip,0);
-	if (unlikely((channel==4) && (chip->env_clock[1]==0)))
-		tickSAAEnvelope(chip,1);
-
 	output = chip->noise[chip->channels[channel].noisechannel].level; //Noise output?
 	output |= chip->channels[channel].level; //Level is always 1-bit!
 	//Retrieve the PWM sample to render!
@@ -788,25 +784,142 @@ OPTINLINE void tickSAA1099noise(SAA1099 *chip, byte channel)
 	chip->noise[channel].laststatus = noise_flipflop; //Save the last status!
 }
 
-OPTINLINE void generateSAA1099sample(SAA1099 *chip, int_32 *leftsample, int_32 *rightsample) //Generate a sample on the requested chip!
+/* Run-based rendering: skipping generators that don't contribute to the output at once! */
+
+OPTINLINE uint_32 skipSAA1099SquareWave(SAA1099 *chip, byte channel, uint_32 samples) //Advance a square wave by a number of samples! Result: the amount of flip-flops that have happened!
 {
+	INLINEREGISTER uint_32 timepoint, timeout, flips;
+	timepoint = chip->squarewave[channel].timepoint; //Current timepoint!
+	timeout = chip->squarewave[channel].timeout; //Half-wave timeout!
+	if (unlikely(timeout==0)) timeout = 1; //Flip-flop every sample!
+	flips = (timepoint<timeout)?(timeout-timepoint):1; //Samples until the first flip-flop!
+	if (likely(samples<flips)) //No flip-flop within the run?
+	{
+		chip->squarewave[channel].timepoint = timepoint+samples; //Just advance!
+		return 0; //No flip-flops!
+	}
+	samples -= flips; //Samples left after the first flip-flop!
+	flips = 1+(samples/timeout); //The first flip-flop and every full half-wave after it!
+	chip->squarewave[channel].timepoint = (samples%timeout); //What's left of the current half-wave!
+	if (flips&1) chip->squarewave[channel].output ^= AMPENV_INPUT_SQUAREWAVEOUTPUT; //Odd amount of flip-flops toggle the output!
+	return flips; //Give the amount of flip-flops!
+}
+
+OPTINLINE void skipSAA1099noise(SAA1099 *chip, byte channel, uint_32 samples) //Advance a noise generator by a number of samples!
+{
+	INLINEREGISTER uint_32 shifts;
+	channel &= 1; //Only two channels!
+	shifts = skipSAA1099SquareWave(chip,channel|8,samples); //Flip-flops of the noise timer!
+	shifts = ((shifts+(chip->noise[channel].laststatus?1:0))>>1); //Only the high-to-low transitions shift the LFSR!
+	for (;shifts;--shifts) //Shift the LFSR as much as required!
+	{
+		if (unlikely(chip->noise[channel].lfsr&1))
+		{
+			chip->noise[channel].lfsr = (chip->noise[channel].lfsr>>1)^0x20400;
+			chip->noise[channel].level = AMPENV_INPUT_NOISEOUTPUT; //Level 1!
+		}
+		else
+		{
+			chip->noise[channel].lfsr = (chip->noise[channel].lfsr>>1);
+			chip->noise[channel].level = 0; //Level 0!
+		}
+	}
+	chip->noise[channel].laststatus = chip->squarewave[channel|8].output; //Save the last status!
+}
+
+OPTINLINE void skipSAAEnvelope(SAA1099 *chip, byte channel, uint_32 ticks) //Tick an envelope a number of times at once!
+{
+	channel &= 1; //Only two channels available!
+	if (likely(chip->env_enable[channel])) //Envelope enabled and running?
+	{
+		chip->env_step[channel] = ((chip->env_step[channel]+(ticks-1))&0x3F); //Step up to the final tick directly!
+	}
+	tickSAAEnvelope(chip,channel); //Apply the final tick and it's envelope!
+}
+
+OPTINLINE byte SAA1099channelsilent(SAA1099_CHANNEL *channel) //Is a channel outputting silence until it's settings are changed?
+{
+	if (likely(channel->activeampenv && (channel->amplitude[0]|channel->amplitude[1]))) return 0; //Audible settings!
+	//The currently running PWM periods need to be silent as well!
+	return (((channel->PWMOutput[0].waveforminput==0) || (channel->PWMOutput[0].Amplitude==0)) && ((channel->PWMOutput[1].waveforminput==0) || (channel->PWMOutput[1].Amplitude==0)));
+}
+
+OPTINLINE void skipSAA1099channel(SAA1099 *chip, byte channel, uint_32 samples) //Advance a silent channel by a number of samples!
+{
+	INLINEREGISTER uint_32 counter;
+	skipSAA1099SquareWave(chip,channel,samples); //Advance the square wave!
+	chip->channels[channel].level = chip->squarewave[channel].output; //Current flipflop output of the square wave generator!
+	counter = (chip->channels[channel].PWMOutput[1].PWMCounter&0xF)+samples; //Where the PWM counters end up!
+	if ((counter>>4)&1) chip->channels[channel].toneonnoiseonflipflop ^= AMPENV_INPUT_PWMPERIOD; //Odd amount of finished PWM periods toggle the flipflop!
+	counter &= 0xF; //The new PWM counter!
+	//The PWM outputs stay silent, so only the counters need to advance!
+	chip->channels[channel].PWMOutput[0].PWMCounter = chip->channels[channel].PWMOutput[1].PWMCounter = (byte)counter; //Advance the counters!
+	chip->channels[channel].PWMOutput[0].waveform = &WAVEFORM_OUTPUT[chip->channels[channel].PWMOutput[0].Amplitude][counter]; //Waveform position!
+	chip->channels[channel].PWMOutput[1].waveform = &WAVEFORM_OUTPUT[chip->channels[channel].PWMOutput[1].Amplitude][counter]; //Waveform position!
+}
+
+OPTINLINE void generateSAA1099block(SAA1099 *chip, uint_32 samples, int_32 *leftsamples, int_32 *rightsamples) //Generate a run of samples on the requested chip!
+{
+	INLINEREGISTER byte channel, livechannels, noisechannels, envelopes;
 	int_32 output_l, output_r;
+	uint_32 i;
+
+	//Determine the channels that are audible during this run! Registers can't change during the run!
+	livechannels = noisechannels = 0; //Default: nothing to render!
+	for (channel=0;channel<6;++channel) //Check all channels!
+	{
+		if (unlikely(SAA1099channelsilent(&chip->channels[channel])==0)) //Audible?
+		{
+			livechannels |= (1<<channel); //Render this channel!
+			if (chip->channels[channel].noise_enable) noisechannels |= (1<<chip->channels[channel].noisechannel); //We're using this noise generator!
+		}
+	}
+	//Envelopes ticking every sample, which are used by audible channels!
+	envelopes = ((chip->env_clock[0]==0)&&(livechannels&0x07))?1:0; //First envelope!
+	envelopes |= ((chip->env_clock[1]==0)&&(livechannels&0x38))?2:0; //Second envelope!
 
-	output_l = output_r = 0; //Reset the output!
-	generateSAA1099channelsample(chip,0,&output_l,&output_r); //Channel 0 sample!
-	generateSAA1099channelsample(chip,1,&output_l,&output_r); //Channel 1 sample!
-	generateSAA1099channelsample(chip,2,&output_l,&output_r); //Channel 2 sample!
-	generateSAA1099channelsample(chip,3,&output_l,&output_r); //Channel 3 sample!
-	generateSAA1099channelsample(chip,4,&output_l,&output_r); //Channel 4 sample!
-	generateSAA1099channelsample(chip,5,&output_l,&output_r); //Channel 5 sample!
-
-	//Give the result, before doing other things!
-	*leftsample = output_l; //Left sample result!
-	*rightsample = output_r; //Right sample result!
-
-	//Finally, write the resultant samples to the result!
-	tickSAA1099noise(chip,0); //Tick first noise channel!
-	tickSAA1099noise(chip,1); //Tick second noise channel!
+	if (likely(livechannels)) //Anything to render?
+	{
+		for (i=0;i<samples;++i) //Render all samples!
+		{
+			output_l = output_r = 0; //Reset the output!
+			//Tick the envelopes when needed(after taking the last sample from the set of channels that use it)!
+			if (livechannels&0x01) generateSAA1099channelsample(chip,0,&output_l,&output_r); //Channel 0 sample!
+			if (envelopes&1) tickSAAEnvelope(chip,0); //Tick the first envelope!
+			if (livechannels&0x02) generateSAA1099channelsample(chip,1,&output_l,&output_r); //Channel 1 sample!
+			if (livechannels&0x04) generateSAA1099channelsample(chip,2,&output_l,&output_r); //Channel 2 sample!
+			if (livechannels&0x08) generateSAA1099channelsample(chip,3,&output_l,&output_r); //Channel 3 sample!
+			if (envelopes&2) tickSAAEnvelope(chip,1); //Tick the second envelope!
+			if (livechannels&0x10) generateSAA1099channelsample(chip,4,&output_l,&output_r); //Channel 4 sample!
+			if (livechannels&0x20) generateSAA1099channelsample(chip,5,&output_l,&output_r); //Channel 5 sample!
+
+			//Give the result, before doing other things!
+			leftsamples[i] = output_l; //Left sample result!
+			rightsamples[i] = output_r; //Right sample result!
+
+			//Finally, tick the noise generators that are used!
+			if (noisechannels&1) tickSAA1099noise(chip,0); //Tick first noise channel!
+			if (noisechannels&2) tickSAA1099noise(chip,1); //Tick second noise channel!
+		}
+	}
+	else //Fully silent?
+	{
+		memset(leftsamples,0,samples*sizeof(leftsamples[0])); //Silence!
+		memset(rightsamples,0,samples*sizeof(rightsamples[0])); //Silence!
+	}
+
+	//Advance everything that wasn't rendered at once!
+	for (channel=0;channel<6;++channel) //Check all channels!
+	{
+		if (unlikely((livechannels&(1<<channel))==0)) //Silent channel?
+		{
+			skipSAA1099channel(chip,channel,samples); //Skip the channel!
+		}
+	}
+	if (((envelopes&1)==0) && (chip->env_clock[0]==0)) skipSAAEnvelope(chip,0,samples); //Skip the first envelope!
+	if (((envelopes&2)==0) && (chip->env_clock[1]==0)) skipSAAEnvelope(chip,1,samples); //Skip the second envelope!
+	if ((noisechannels&1)==0) skipSAA1099noise(chip,0,samples); //Skip the first noise channel!
+	if ((noisechannels&2)==0) skipSAA1099noise(chip,1,samples); //Skip the second noise channel!
 }
 
 uint_32 gameblaster_soundtiming=0;
@@ -817,7 +930,7 @@ DOUBLE gameblaster_output_tick = 0.0; //Time of a tick in the PC speaker sample!
 
 DOUBLE gameblaster_ticklength = 0.0; //Length of PIT samples to process every output sample!
 
-int_32 gb_leftsample[2], gb_rightsample[2]; //Two stereo samples!
+int_32 gb_leftsample[2][__GAMEBLASTER_BLOCKSIZE], gb_rightsample[2][__GAMEBLASTER_BLOCKSIZE]; //Two stereo runs of samples!
 
 void updateGameBlaster(DOUBLE timepassed, uint_32 MHZ14passed)
 {
@@ -825,6 +938,7 @@ void updateGameBlaster(DOUBLE timepassed, uint_32 MHZ14passed)
 	INLINEREGISTER uint_32 length; //Amount of samples to generate!
 	INLINEREGISTER uint_32 i;
 	uint_32 dutycyclei; //Input samples to process!
+	uint_32 samples, blocksize; //Samples to render in runs!
 	DOUBLE tempf;
 	uint_32 render_ticks; //A one shot tick!
 	int_32 currentsamplel,currentsampler; //Saved sample in the 1.19MHz samples!
@@ -835,39 +949,50 @@ void updateGameBlaster(DOUBLE timepassed, uint_32 MHZ14passed)
 	gameblaster_soundtiming += MHZ14passed; //Get the amount of time passed!
 	if (unlikely(gameblaster_soundtiming>=MHZ14_BASETICK))
 	{
-		for (;gameblaster_soundtiming>=MHZ14_BASETICK;)
+		samples = (gameblaster_soundtiming/MHZ14_BASETICK); //How many samples to render? Registers can't be written during this run!
+		gameblaster_soundtiming -= (samples*MHZ14_BASETICK); //Decrease timer to get time left!
+		for (;samples;samples -= blocksize) //Render all samples in blocks!
 		{
-			//Generate the sample!
-
-			gb_leftsample[0] = gb_rightsample[0] = 0; //No sample by default!
+			blocksize = MIN(samples,__GAMEBLASTER_BLOCKSIZE); //How much to render at once!
+			//Generate the samples!
 			if (likely(GAMEBLASTER.chips[0].all_ch_enable)) //Sound generation of first chip?
 			{
-				generateSAA1099sample(&GAMEBLASTER.chips[0],&gb_leftsample[0],&gb_rightsample[0]); //Generate a stereo sample on this chip!
+				generateSAA1099block(&GAMEBLASTER.chips[0],blocksize,&gb_leftsample[0][0],&gb_rightsample[0][0]); //Generate a stereo run on this chip!
 			}
-
-			gb_leftsample[1] = gb_rightsample[1] = 0; //No sample by default!
-			if (likely(GAMEBLASTER.chips[1].all_ch_enable)) //Sound generation of first chip?
+			else //No sample by default!
 			{
-				generateSAA1099sample(&GAMEBLASTER.chips[1], &gb_leftsample[1], &gb_rightsample[1]); //Generate a stereo sample on this chip!
+				memset(&gb_leftsample[0][0],0,blocksize*sizeof(gb_leftsample[0][0])); //Silence!
+				memset(&gb_rightsample[0][0],0,blocksize*sizeof(gb_rightsample[0][0])); //Silence!
 			}
 
-			gameblaster_soundtiming -= MHZ14_BASETICK; //Decrease timer to get time left!
-
-			#ifdef LOG_GAMEBLASTER
-			if (GAMEBLASTER_LOG) //Logging output?
+			if (likely(GAMEBLASTER.chips[1].all_ch_enable)) //Sound generation of second chip?
 			{
-				writeWAVStereoSample(GAMEBLASTER_LOG,signed2unsigned16((sword)(gb_leftsample[0]*AMPLIFIER)),signed2unsigned16((sword)(gb_rightsample[0]*AMPLIFIER)));
-				writeWAVStereoSample(GAMEBLASTER_LOG,signed2unsigned16((sword)(gb_leftsample[1]*AMPLIFIER)),signed2unsigned16((sword)(gb_rightsample[1]*AMPLIFIER)));
+				generateSAA1099block(&GAMEBLASTER.chips[1],blocksize,&gb_leftsample[1][0],&gb_rightsample[1][0]); //Generate a stereo run on this chip!
 			}
-			#endif
+			else //No sample by default!
+			{
+				memset(&gb_leftsample[1][0],0,blocksize*sizeof(gb_leftsample[1][0])); //Silence!
+				memset(&gb_rightsample[1][0],0,blocksize*sizeof(gb_rightsample[1][0])); //Silence!
+			}
+
+			for (dutycyclei=0;dutycyclei<blocksize;++dutycyclei) //Mix all samples!
+			{
+				#ifdef LOG_GAMEBLASTER
+				if (GAMEBLASTER_LOG) //Logging output?
+				{
+					writeWAVStereoSample(GAMEBLASTER_LOG,signed2unsigned16((sword)(gb_leftsample[0][dutycyclei]*AMPLIFIER)),signed2unsigned16((sword)(gb_rightsample[0][dutycyclei]*AMPLIFIER)));
+					writeWAVStereoSample(GAMEBLASTER_LOG,signed2unsigned16((sword)(gb_leftsample[1][dutycyclei]*AMPLIFIER)),signed2unsigned16((sword)(gb_rightsample[1][dutycyclei]*AMPLIFIER)));
+				}
+				#endif
 
-			//Load and mix the sample to render!
-			i = gb_leftsample[0]; //Load left sample!
-			i += gb_leftsample[1]; //Mix left sample!
-			length = gb_rightsample[0]; //Load right sample!
-			length += gb_rightsample[1]; //Mix right sample!
+				//Load and mix the sample to render!
+				i = gb_leftsample[0][dutycyclei]; //Load left sample!
+				i += gb_leftsample[1][dutycyclei]; //Mix left sample!
+				length = gb_rightsample[0][dutycyclei]; //Load right sample!
+				length += gb_rightsample[1][dutycyclei]; //Mix right sample!
 
-			writefifobuffer32_2(GAMEBLASTER.rawsignal,i,length); //Save the raw signal for post-processing!
+				writefifobuffer32_2(GAMEBLASTER.rawsignal,i,length); //Save the raw signal for post-processing!
+			}
 		}
 	}
 
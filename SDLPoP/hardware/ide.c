@@ -27,6 +27,7 @@ along with UniPCemu.  If not, see <https://www.gnu.org/licenses/>.
 #include "headers/hardware/pic.h" //PIC support!
 #include "headers/support/log.h" //Logging support for debugging!
 #include "headers/basicio/cueimage.h" //CUE image support!
+#include "headers/basicio/diskworker.h" //Disk I/O worker support!
 //Now, for the audio player support:
 #include "headers/emu/sound.h" //Sound support!
 #include "headers/support/sounddoublebuffer.h" //Double buffered sound!
@@ -954,6 +955,19 @@ void ATAPI_renderAudioSample(byte channel, byte slave, sword left, sword right)
 	writeDoubleBufferedSound32(&ATA[channel].Drive[slave].AUDIO_PLAYER.soundbuffer, (signed2unsigned16(right) << 16) | signed2unsigned16(left)); //Output the sample to the renderer!
 }
 
+void ATAPI_renderAudioBlock(byte channel, byte slave, byte *samples, uint_32 count) //Render a block of samples from a loaded frame!
+{
+	word sampleleft, sampleright;
+	for (; count; --count) //Samples left to render?
+	{
+		sampleleft = *samples++; //Low byte!
+		sampleleft |= (*samples++ << 8); //High byte!
+		sampleright = *samples++; //Low byte!
+		sampleright |= (*samples++ << 8); //High byte!
+		ATAPI_renderAudioSample(channel, slave, unsigned2signed16(sampleleft), unsigned2signed16(sampleright)); //Render an audio sample!
+	}
+}
+
 void ATAPI_loadtrackinfo(byte channel, byte slave) //Retrieves the track number of a MSF address!
 {
 	TRACK_GEOMETRY *g;
@@ -1102,7 +1116,7 @@ sword ATAPI_gettrackinfo(byte channel, byte slave, byte M, byte S, byte F, byte
 }
 
 byte curtrack_type = 0, curtrack_nr=0;
-void ATAPI_tickAudio(byte channel, byte slave)
+void ATAPI_tickAudioSample(byte channel, byte slave) //Render a single sample, loading a new frame if needed!
 {
 	word sampleleft, sampleright, samplepos;
 	int_64 loadstatus;
@@ -1246,6 +1260,33 @@ void ATAPI_tickAudio(byte channel, byte slave)
 	}
 }
 
+void ATAPI_tickAudio(byte channel, byte slave, uint_32 samples) //Render a block of samples!
+{
+	uint_32 count;
+	for (; samples;) //Samples left to render?
+	{
+		if (likely(ATA[channel].Drive[slave].AUDIO_PLAYER.status != PLAYER_PLAYING)) //Not running?
+		{
+			for (; samples; --samples) //Render silent samples!
+			{
+				ATAPI_renderAudioSample(channel, slave, 0, 0); //Render a silent sample!
+			}
+		}
+		else if (ATA[channel].Drive[slave].AUDIO_PLAYER.samplepos < 2349) //Rendering a buffer? Render the rest of the frame at once!
+		{
+			count = MIN(samples, ((2352 - ATA[channel].Drive[slave].AUDIO_PLAYER.samplepos) >> 2)); //How many samples are left in the frame?
+			ATAPI_renderAudioBlock(channel, slave, &ATA[channel].Drive[slave].AUDIO_PLAYER.samples[ATA[channel].Drive[slave].AUDIO_PLAYER.samplepos], count); //Render them!
+			ATA[channel].Drive[slave].AUDIO_PLAYER.samplepos += (count << 2); //Rendered!
+			samples -= count; //Rendered!
+		}
+		else //Need to load a new frame?
+		{
+			ATAPI_tickAudioSample(channel, slave); //Load the new frame and render it's first sample!
+			--samples; //Rendered!
+		}
+	}
+}
+
 byte ATAPI_audioplayer_startPlayback(byte channel, byte drive, byte startM, byte startS, byte startF, byte endM, byte endS, byte endF) //Start playback in this range!
 {
 	uint_32 noCUELBA;
@@ -1360,11 +1401,8 @@ void updateATA(DOUBLE timepassed) //ATA timing!
 				{
 					samples = (uint_32)(ATA[CDROM_channel].playerTiming / ATA[CDROM_channel].playerTick); //How many samples to tick?
 					ATA[CDROM_channel].playerTiming -= (ATA[CDROM_channel].playerTick*((DOUBLE)samples)); //We're ticking them off!
-					for (; samples;--samples) //Samples left to tick?
-					{
-						ATAPI_tickAudio(CDROM_channel, 0); //Tick the Master!
-						ATAPI_tickAudio(CDROM_channel, 1); //Tick the Slave!
-					}
+					ATAPI_tickAudio(CDROM_channel, 0, samples); //Tick the Master!
+					ATAPI_tickAudio(CDROM_channel, 1, samples); //Tick the Slave!
 				}
 			}
 		}
@@ -2037,6 +2075,7 @@ OPTINLINE byte ATA_readsector(byte channel, byte command) //Read the current sec
 	byte multiple = 1; //Multiple to read!
 	word counter;
 	word partialtransfer;
+	uint_32 readahead; //How many sectors to read ahead!
 	uint_32 disk_size = ((ATA[channel].Drive[ATA_activeDrive(channel)].driveparams[61] << 16) | ATA[channel].Drive[ATA_activeDrive(channel)].driveparams[60]); //The size of the disk in sectors!
 	if (ATA[channel].Drive[ATA_activeDrive(channel)].commandstatus == 1) //We're reading already?
 	{
@@ -2105,13 +2144,21 @@ OPTINLINE byte ATA_readsector(byte channel, byte command) //Read the current sec
 	partialtransfer = counter; //How much has been transferred!
 	EMU_setDiskBusy(ATA_Drives[channel][ATA_activeDrive(channel)], 1); //We're reading!
 	memset(&ATA[channel].Drive[ATA_activeDrive(channel)].data,0, (multiple<<9)); //Clear the buffer for any errors we take!
-	if ((readdata(ATA_Drives[channel][ATA_activeDrive(channel)], &ATA[channel].Drive[ATA_activeDrive(channel)].data, ((uint_64)ATA[channel].Drive[ATA_activeDrive(channel)].current_LBA_address << 9), (partialtransfer<<9))) || ((partialtransfer==0) && multiple)) //Read the data from disk as far as we can?
+	if ((diskworker_read(ATA_Drives[channel][ATA_activeDrive(channel)], &ATA[channel].Drive[ATA_activeDrive(channel)].data, ((uint_64)ATA[channel].Drive[ATA_activeDrive(channel)].current_LBA_address << 9), (partialtransfer<<9))) || ((partialtransfer==0) && multiple)) //Read the data from disk as far as we can?
 	{
 		for (counter=0;counter<partialtransfer;++counter) //Increase sector count as much as required!
 		{
 			ATA_increasesector(channel); //Increase the current sector!
 		}
 
+		//Read ahead the following sectors of the command, while the current block is transferred!
+		readahead = (ATA[channel].Drive[ATA_activeDrive(channel)].datasize-multiple); //How many sectors are left after this block?
+		if (readahead>(DISKWORKER_BLOCKSIZE>>9)) readahead = (DISKWORKER_BLOCKSIZE>>9); //Limit to what can be read ahead!
+		if ((partialtransfer==multiple) && readahead && ((ATA[channel].Drive[ATA_activeDrive(channel)].current_LBA_address+readahead-1)<disk_size)) //Following sectors within the disk?
+		{
+			diskworker_readahead(ATA_Drives[channel][ATA_activeDrive(channel)], ((uint_64)ATA[channel].Drive[ATA_activeDrive(channel)].current_LBA_address << 9), (readahead<<9)); //Start reading ahead!
+		}
+
 		ATA[channel].Drive[ATA_activeDrive(channel)].datapos = 0; //Initialise our data position!
 		ATA[channel].Drive[ATA_activeDrive(channel)].datablock = 0x200*multiple; //We're refreshing after this many bytes!
 		ATA[channel].Drive[ATA_activeDrive(channel)].commandstatus = 1; //Transferring data IN!
@@ -2172,7 +2219,7 @@ OPTINLINE byte ATA_writesector(byte channel, byte command)
 		{
 			goto writeoutofbounds; //We're out of bounds!
 		}
-		writeresult = writedata(ATA_Drives[channel][ATA_activeDrive(channel)], p, ((uint_64)ATA[channel].Drive[ATA_activeDrive(channel)].current_LBA_address << 9), 0x200); //Try to write the sector!
+		writeresult = diskworker_write(ATA_Drives[channel][ATA_activeDrive(channel)], p, ((uint_64)ATA[channel].Drive[ATA_activeDrive(channel)].current_LBA_address << 9), 0x200); //Try to write the sector! It's written behind in the background!
 		p += 0x200; //How much have we written!
 		if (writeresult) //Written without error?
 		{
@@ -4717,6 +4764,10 @@ void ATA_reset(byte channel, byte slave)
 	byte fullslaveinfo;
 	fullslaveinfo = slave; //Complete slave info!
 	slave &= 0x7F; //Are we a master or slave!
+	if (ATA_Drives[channel][slave]) //Drive present?
+	{
+		diskworker_flush(ATA_Drives[channel][slave]); //Write all posted writes to the disk!
+	}
 	if ((ATA_Drives[channel][slave]==0) || (ATA_Drives[channel][slave] >= CDROM0)) //CD-ROM style reset?
 	{
 		if (ATA_Drives[channel][slave] == 0) //Drive not present? NOP!
@@ -5197,6 +5248,16 @@ OPTINLINE void ATA_executeCommand(byte channel, byte command) //Execute a comman
 		break;
 	case 0x00: //NOP (ATAPI Mandatory)?
 		break;
+	case 0xE7: //Flush cache?
+#ifdef ATA_LOG
+		dolog("ATA", "FLUSHCACHE:%u,%u=%02X", channel, ATA_activeDrive(channel), command);
+#endif
+		if ((ATA_Drives[channel][ATA_activeDrive(channel)] >= CDROM0)) goto invalidcommand; //Special action for CD-ROM drives?
+		if (!diskworker_flush(ATA_Drives[channel][ATA_activeDrive(channel)])) goto invalidatedcommand; //Write all posted writes to the disk! Abort when they failed!
+		ATA[channel].Drive[ATA_activeDrive(channel)].commandstatus = 0; //Reset command status!
+		ATA[channel].Drive[ATA_activeDrive(channel)].STATUSREGISTER &= 0x10; //Reset data register, except DSC!
+		ATA_IRQ(channel, ATA_activeDrive(channel), ATA_FINISHREADYTIMING(1.0), 1); //Raise IRQ!
+		break;
 	case 0x08: //DEVICE RESET(ATAPI Mandatory)?
 		if (!(ATA_Drives[channel][ATA_activeDrive(channel)] >= CDROM0)) //ATA device? Unsupported!
 		{
@@ -6217,6 +6278,7 @@ void initATA()
 {
 	byte slave;
 	memset(&ATA, 0, sizeof(ATA)); //Initialise our data!
+	startDiskWorker(); //Start the disk I/O worker, if possible!
 
 	//We don't register a disk change handler, because ATA doesn't change disks when running!
 	//8-bits ports!
@@ -6375,6 +6437,7 @@ void initATA()
 void doneATA()
 {
 	byte slave;
+	doneDiskWorker(); //Write all posted writes and stop the disk I/O worker!
 	if (CDROM_channel != 0xFF) //Valid?
 	{
 		for (slave = 0; slave < 2; ++slave) //Process all CD-ROM channels!
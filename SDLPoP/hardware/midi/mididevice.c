@@ -334,7 +334,7 @@ void MIDIDEVICE_getsample(int_64 play_counter, uint_32 totaldelay, float sampler
 	float lchannel, rchannel; //Both channels to use!
 	byte loopflags[2]; //Flags used during looping!
 	byte totalloopflags;
-	static sword readsample[2]= {0,0}; //The sample retrieved!
+	sword *readsample = &voice->readsample[0]; //The sample retrieved! Kept per voice, so voices can be rendered in parallel!
 	int_32 modulationratiocents;
 	uint_32 tempbuffer,tempbuffer2;
 	float tempbufferf, tempbufferf2;
@@ -596,13 +596,6 @@ byte MIDIDEVICE_renderer(void* buf, uint_32 length, byte stereo, void *userdata)
 		#endif
 		return SOUNDHANDLER_RESULT_NOTFILLED; //Empty buffer: we're unused!
 	}
-	if (memprotect(soundfont,sizeof(*soundfont),"RIFF_FILE")!=soundfont)
-	{
-		#ifdef MIDI_LOCKSTART
-		//unlock(voice->locknumber); //Lock us!
-		#endif
-		return SOUNDHANDLER_RESULT_NOTFILLED; //Empty buffer: we're unable to render anything!
-	}
 	if (!soundfont)
 	{
 		#ifdef MIDI_LOCKSTART
@@ -1622,7 +1615,6 @@ OPTINLINE sbyte MIDIDEVICE_newvoice(MIDIDEVICE_VOICE *voice, byte request_channe
 	int_32 previousPBag, previousIBag;
 	static uint_64 starttime = 0; //Increasing start time counter (1 each note on)!
 
-	if (memprotect(soundfont,sizeof(*soundfont),"RIFF_FILE")!=soundfont) return 0; //We're unable to render anything!
 	if (!soundfont) return 0; //We're unable to render anything!
 	lockMPURenderer(); //Lock the audio: we're starting to modify!
 	#ifdef MIDI_LOCKSTART
@@ -3118,6 +3110,7 @@ byte init_MIDIDEVICE(char *filename, byte use_direct_MIDI) //Initialise MIDI dev
 			#endif
 			activevoices[i].allocated = addchannel(&MIDIDEVICE_renderer,&activevoices[i],"MIDI Voice",44100.0f,__MIDI_SAMPLES,1,SMPL16S,0); //Add the channel! Delay at 0.96ms for response speed! 44100/(1000000/960)=42.336 samples/response!
 			setVolume(&MIDIDEVICE_renderer,&activevoices[i],MIDI_VOLUME); //We're at 40% volume!
+			setParallel(&MIDIDEVICE_renderer,&activevoices[i],1); //Voices only touch their own state, so they can be rendered on the mixer workers!
 		}
 	}
 	MIDIDEVICE_ActiveSenseInit(); //Initialise Active Sense!
@@ -565,6 +565,8 @@ typedef struct PACKED
 #define MODEM_DATATRANSFERFREQUENCY 57600
 //Data transfer frequency of tranferring data, in the numeric result code of the connection numeric result code! Must match the MODEM_DATATRANSFERFREQUENCY
 #define MODEM_DATATRANSFERFREQUENCY_NR 18
+//Interval to send the data buffered for the network, in nanoseconds!
+#define MODEM_NETWORKFLUSHINTERVAL 1000000.0
 //Command completion timeout after receiving a carriage return during a command!
 #define MODEM_COMMANDCOMPLETIONTIMEOUT (DOUBLE)((1000000000.0/57600.0)*5760.0)
 
@@ -587,6 +589,7 @@ struct
 	DOUBLE ringtimer; //Ringing timer!
 	DOUBLE serverpolltimer; //Network connection request timer!
 	DOUBLE networkdatatimer; //Network connection request timer!
+	DOUBLE networkflushtimer; //Timer for sending the data buffered for the network!
 
 	DOUBLE serverpolltick; //How long it takes!
 	DOUBLE networkpolltick;
@@ -12001,7 +12004,7 @@ void updateModem(DOUBLE timepassed) //Sound tick. Executes every instruction.
 					}
 					if (peekfifobuffer(modem.outputbuffer[0], &datatotransmit)) //Byte available to send?
 					{
-						switch (TCP_SendData(modem.connectionid, datatotransmit)) //Send the data?
+						switch (TCP_SendBuffer(modem.connectionid, &datatotransmit, 1)) //Send the data?
 						{
 						case 0: //Failed to send?
 							break; //Simply keep retrying until we can send it!
@@ -12040,7 +12043,7 @@ void updateModem(DOUBLE timepassed) //Sound tick. Executes every instruction.
 					{
 						if (likely(modem.breakPending == 0)) //Not a pending break? If pending, don't receive new data until processed!
 						{
-							switch (TCP_ReceiveData(modem.connectionid, &datatotransmit))
+							switch (TCP_ReceiveBuffer(modem.connectionid, &datatotransmit, 1))
 							{
 							case 0: //Nothing received?
 								break;
@@ -12133,7 +12136,7 @@ void updateModem(DOUBLE timepassed) //Sound tick. Executes every instruction.
 						}
 						if (peekfifobuffer(modem.outputbuffer[connectedclient->connectionnumber], &datatotransmit)) //Byte available to send?
 						{
-							switch (TCP_SendData(connectedclient->connectionid, datatotransmit)) //Send the data?
+							switch (TCP_SendBuffer(connectedclient->connectionid, &datatotransmit, 1)) //Send the data?
 							{
 							case 0: //Failed to send?
 								break; //Simply keep retrying until we can send it!
@@ -12197,7 +12200,7 @@ void updateModem(DOUBLE timepassed) //Sound tick. Executes every instruction.
 						}
 						if (fifobuffer_freesize(modem.inputdatabuffer[connectedclient->connectionnumber])) //Free to receive?
 						{
-							switch (TCP_ReceiveData(connectedclient->connectionid, &datatotransmit))
+							switch (TCP_ReceiveBuffer(connectedclient->connectionid, &datatotransmit, 1))
 							{
 							case 0: //Nothing received?
 								break;
@@ -12266,4 +12269,21 @@ void updateModem(DOUBLE timepassed) //Sound tick. Executes every instruction.
 			continue; //Continue onwards!
 		} //While polling?
 	} //To poll?
+
+	modem.networkflushtimer += timepassed;
+	if (modem.networkflushtimer >= MODEM_NETWORKFLUSHINTERVAL) //To send the buffered data?
+	{
+		modem.networkflushtimer = 0.0; //Restart timing!
+		if ((modem.connected == 1) && (modem.connectionid >= 0)) //Normal connection?
+		{
+			TCP_FlushBuffer(modem.connectionid); //Send the buffered data!
+		}
+		else if (modem.connected == 2) //SLIP server connection is active?
+		{
+			for (connectedclient = Packetserver_allocatedclients; connectedclient; connectedclient = connectedclient->next) //Check all connected clients!
+			{
+				TCP_FlushBuffer(connectedclient->connectionid); //Send the buffered data!
+			}
+		}
+	}
 }
@@ -69,10 +69,16 @@ PC SPEAKER
 //#define SPEAKER_RATE (1000000.0f/60.0f)
 //Speaker buffer size!
 #define SPEAKER_BUFFER 4096
-//Speaker low pass filter values (if defined, it's used)! We're 96dB dynamic range, with 6dB per octave, so 16 times filtering is needed to filter it fully at the nyquist frequency.
-#define SPEAKER_LOWPASS ((((float)SPEAKER_RATE)/2.0f)/16.0f)
+//Speaker low pass filter values (if defined, it's used on the rendered samples)! Not needed for anti-aliasing anymore, since the band-limited steps take care of that!
+//#define SPEAKER_LOWPASS ((((float)SPEAKER_RATE)/2.0f)/16.0f)
 //Speaker volume during filtering! Take half to prevent overflow!
 #define SPEAKER_LOWPASSVOLUME 0.5f
+//Amount of output level changes to buffer between rendering!
+#define SPEAKER_EDGES 0x2000
+//Band-limited step(BLEP) settings: length of a step in samples(power of 2), amount of phases within a sample and cutoff frequency relative to the speaker rate!
+#define SPEAKER_BLEPTAPS 32
+#define SPEAKER_BLEPPHASES 256
+#define SPEAKER_BLEPCUTOFF 0.45
 
 //Precise timing rate!
 //The clock speed of the PIT (14.31818MHz divided by 12)!
@@ -83,11 +89,8 @@ PC SPEAKER
 #define TIME_RATE (MHZ14/12.0)
 #endif
 
-//Run the low pass at the 72 raw samples rate instead (16571Hz)!
-//#undef SPEAKER_LOWPASS
 //Formula for 4.7uF and 8 Ohm results in: 1/(2*PI*RC)=1/(2*PI*8*0.0000047) Hz(~4.4kHz) instead of ~16kHz using 72 samples.
 //#define SPEAKER_LOWPASS (1/(2.0f*PI*8*0.0000047))
-//#define SPEAKER_LOWPASS (TIME_RATE/72.0)
 
 //Log the speaker to this .wav file when defined (raw and duty cycles log)!
 //#define SPEAKER_LOGRAW "captures/speakerraw.wav"
@@ -137,7 +140,8 @@ typedef struct
 	DOUBLE samplesleft; //Samples left to process!
 	byte lastchannel_status; //Last recorded channel status
 	byte risetoggle; //Toggled bit 0 when we rise.
-	FIFOBUFFER *rawsignal; //The raw signal buffer for the oneshot mode!
+	byte speakerlevel; //Last recorded speaker output level!
+	FIFOBUFFER *rawsignal; //The raw signal buffer for the oneshot mode! Contains the output level changes and their PIT tick for the speaker!
 } PITCHANNEL; // speaker!
 
 PITCHANNEL PITchannels[6]; //All possible PIT channels, whether used or not!
@@ -206,16 +210,78 @@ DOUBLE ticklength = 0.0; //Length of PIT samples to process every output sample!
 HIGHLOWPASSFILTER PCSpeakerFilter; //Our filter to use!
 float speaker_currentsample;
 
+uint_32 speaker_pittime = 0; //Current PIT tick of the speaker output!
+uint_32 speaker_synthtime = 0; //PIT tick the speaker rendering has reached!
+
+float speaker_blepkernel[SPEAKER_BLEPPHASES][SPEAKER_BLEPTAPS]; //Band-limited impulses for all phases within a sample!
+float speaker_blepbuffer[SPEAKER_BLEPTAPS]; //Pending impulses to integrate into the output!
+byte speaker_blepposition = 0; //Current position within the pending impulses!
+byte speaker_bleppending = 0; //Samples left until all impulses have been integrated!
+float speaker_blepoutput = 0.0f; //Current band-limited output level!
+float speaker_bleptarget = 0.0f; //Output level after all pending impulses!
+
+void speaker_initBLEP() //Precalculate the band-limited impulses!
+{
+	word phase, tap;
+	DOUBLE x, sum, windowed;
+	for (phase=0;phase<SPEAKER_BLEPPHASES;++phase) //Process all phases!
+	{
+		sum = 0.0; //Initialize the sum!
+		for (tap=0;tap<SPEAKER_BLEPTAPS;++tap) //Process all taps!
+		{
+			x = (((DOUBLE)tap-(DOUBLE)(SPEAKER_BLEPTAPS/2))+(((DOUBLE)phase+0.5)/(DOUBLE)SPEAKER_BLEPPHASES)); //Distance from the step in samples!
+			windowed = 0.42+(0.5*cos((PI*x)/(DOUBLE)(SPEAKER_BLEPTAPS/2)))+(0.08*cos((2.0*PI*x)/(DOUBLE)(SPEAKER_BLEPTAPS/2))); //Blackman window!
+			x *= (PI*2.0*SPEAKER_BLEPCUTOFF); //Sinc input!
+			if (x!=0.0) windowed *= (sin(x)/x); //Windowed sinc!
+			speaker_blepkernel[phase][tap] = (float)windowed; //Store the impulse!
+			sum += windowed; //Total!
+		}
+		for (tap=0;tap<SPEAKER_BLEPTAPS;++tap) //Normalize every phase to a full step!
+		{
+			speaker_blepkernel[phase][tap] = (float)(speaker_blepkernel[phase][tap]/sum); //Normalize!
+		}
+	}
+}
+
+OPTINLINE void speaker_insertedge(DOUBLE distance, byte level) //Insert a band-limited step happening distance samples before the end of the current sample!
+{
+	INLINEREGISTER uint_32 phase;
+	INLINEREGISTER byte tap;
+	float delta;
+	float *kernel;
+	phase = (uint_32)(distance*(DOUBLE)SPEAKER_BLEPPHASES); //What phase is the step at?
+	if (unlikely(phase>=SPEAKER_BLEPPHASES)) phase = SPEAKER_BLEPPHASES-1; //Late steps are applied at the start of the sample!
+	delta = (level?(SHRT_MAX*SPEAKER_LOWPASSVOLUME):(SHRT_MIN*SPEAKER_LOWPASSVOLUME))-speaker_bleptarget; //How much to step!
+	speaker_bleptarget += delta; //The new output level!
+	kernel = &speaker_blepkernel[phase][0]; //The impulse to use!
+	for (tap=0;tap<SPEAKER_BLEPTAPS;++tap) //Add the impulse to the pending impulses!
+	{
+		speaker_blepbuffer[(speaker_blepposition+tap)&(SPEAKER_BLEPTAPS-1)] += delta*kernel[tap]; //Add the impulse!
+	}
+	speaker_bleppending = SPEAKER_BLEPTAPS; //Pending until fully integrated!
+}
+
+OPTINLINE float speaker_rendersample() //Render a band-limited sample!
+{
+	speaker_blepoutput += speaker_blepbuffer[speaker_blepposition]; //Integrate the impulses!
+	speaker_blepbuffer[speaker_blepposition] = 0.0f; //Consumed!
+	speaker_blepposition = ((speaker_blepposition+1)&(SPEAKER_BLEPTAPS-1)); //Next position!
+	if (speaker_bleppending && (--speaker_bleppending==0)) //Fully integrated?
+	{
+		speaker_blepoutput = speaker_bleptarget; //Settle exactly to prevent rounding errors from building up!
+	}
+	return speaker_blepoutput; //Give the output level!
+}
+
 void tickPIT(DOUBLE timepassed, uint_32 MHZ14passed) //Ticks all PIT timers available!
 {
 	if (__HW_DISABLED) return;
 	INLINEREGISTER uint_32 length; //Amount of samples to generate!
 	INLINEREGISTER uint_32 i;
-	uint_32 dutycyclei; //Input samples to process!
 	INLINEREGISTER uint_32 tickcounter;
 	word oldvalue; //Old value before decrement!
 	DOUBLE tempf;
-	uint_32 render_ticks; //A one shot tick!
+	uint_32 edgetime, edgelevel; //Speaker output level change!
 	byte currentsample; //Saved sample in the 1.19MHz samples!
 	byte channel; //Current channel?
 	byte mode; //The mode of the currently processing channel!
@@ -456,8 +522,14 @@ void tickPIT(DOUBLE timepassed, uint_32 MHZ14passed) //Ticks all PIT timers avai
 					//Now, write the (changed) output to the channel to use!
 					if (channel==2) //PIT2 needs a sound buffer?
 					{
-						//We're ready for the current result!
-						writefifobuffer(PITchannels[channel].rawsignal, currentsample&((PCSpeakerPort & 2) >> 1)); //Add the data to the raw signal! Apply the output mask too!
+						//We're ready for the current result! Apply the output mask too!
+						if (unlikely((currentsample&((PCSpeakerPort & 2) >> 1))!=PITchannels[channel].speakerlevel)) //Speaker output level changed?
+						{
+							if (likely(writefifobuffer32_2u(PITchannels[channel].rawsignal,speaker_pittime+(length-tickcounter),(currentsample&((PCSpeakerPort & 2) >> 1))))) //Record the change with the tick it happened on!
+							{
+								PITchannels[channel].speakerlevel = (currentsample&((PCSpeakerPort & 2) >> 1)); //Recorded!
+							}
+						}
 					}
 					else if (channel==1) //PIT1 is connected to an external ticker!
 					{
@@ -495,6 +567,7 @@ void tickPIT(DOUBLE timepassed, uint_32 MHZ14passed) //Ticks all PIT timers avai
 				PITchannels[channel].lastchannel_status = currentsample; //Save the new status!
 			}
 		}
+		speaker_pittime += length; //The speaker output has advanced!
 	}
 
 	//PC speaker output!
@@ -505,40 +578,35 @@ void tickPIT(DOUBLE timepassed, uint_32 MHZ14passed) //Ticks all PIT timers avai
 		speaker_ticktiming -= (length*speaker_tick); //Rest the amount of ticks!
 
 		//Ticks the speaker when needed!
-		i = 0; //Init counter!
-		//Generate the samples from the output signal!
-		for (;;) //Generate samples!
+		//Generate the samples from the output level changes!
+		for (i=0;i<length;++i) //Generate samples!
 		{
-			//Average our input ticks!
-			PITchannels[2].samplesleft += ticklength; //Add our time to the sample time processed!
-			tempf = floor(PITchannels[2].samplesleft); //Take the rounded number of samples to process!
-			PITchannels[2].samplesleft -= tempf; //Take off the samples we've processed!
-			render_ticks = (uint_32)tempf; //The ticks to render!
-
-			//render_ticks contains the output samples to process! Calculate the duty cycle by low pass filter and use it to generate a sample!
-			for (dutycyclei = render_ticks;dutycyclei;--dutycyclei)
+			PITchannels[2].samplesleft += ticklength; //Add our time to the sample time processed! This is the end of the sample in PIT ticks!
+			for (;peekfifobuffer32_2u(PITchannels[2].rawsignal,&edgetime,&edgelevel);) //Output level changes to process?
 			{
-				if (!readfifobuffer(PITchannels[2].rawsignal, &currentsample)) break; //Failed to read the sample? Stop counting!
-				speaker_currentsample = currentsample?(SHRT_MAX*SPEAKER_LOWPASSVOLUME):(SHRT_MIN*SPEAKER_LOWPASSVOLUME); //Convert the current result to the 16-bit data, signed instead of unsigned!
-				#ifdef SPEAKER_LOGRAW
-					writeWAVMonoSample(speakerlograw,(short)speaker_currentsample); //Log the mono sample to the WAV file, converted as needed!
-				#endif
-				#ifdef SPEAKER_LOWPASS
-					//We're applying the low pass filter for the speaker!
-					applySoundFilter(&PCSpeakerFilter, &speaker_currentsample);
-				#endif
-				#ifdef SPEAKER_LOGDUTY
-					writeWAVMonoSample(speakerlogduty,(short)speaker_currentsample); //Log the mono sample to the WAV file, converted as needed!
-				#endif
+				tempf = (DOUBLE)(int_32)(edgetime-speaker_synthtime); //When did it happen?
+				if (tempf>=PITchannels[2].samplesleft) break; //Not within this sample yet?
+				readfifobuffer32_2u(PITchannels[2].rawsignal,&edgetime,&edgelevel); //Discard it!
+				speaker_insertedge(SAFEDIV(PITchannels[2].samplesleft-tempf,ticklength),(byte)edgelevel); //Insert a band-limited step at the position within the sample!
 			}
+			tempf = floor(PITchannels[2].samplesleft); //Take the rounded number of ticks processed!
+			PITchannels[2].samplesleft -= tempf; //Take off the ticks we've processed!
+			speaker_synthtime += (uint_32)tempf; //The ticks we've rendered!
+
+			speaker_currentsample = speaker_rendersample(); //Render the band-limited sample!
+			#ifdef SPEAKER_LOGRAW
+				writeWAVMonoSample(speakerlograw,(short)speaker_bleptarget); //Log the mono sample to the WAV file, converted as needed!
+			#endif
+			#ifdef SPEAKER_LOWPASS
+				//We're applying the low pass filter for the speaker!
+				applySoundFilter(&PCSpeakerFilter, &speaker_currentsample);
+			#endif
+			#ifdef SPEAKER_LOGDUTY
+				writeWAVMonoSample(speakerlogduty,(short)speaker_currentsample); //Log the mono sample to the WAV file, converted as needed!
+			#endif
 
 			//Add the result to our buffer!
-			writeDoubleBufferedSound16(&pcspeaker_soundbuffer, (short)speaker_currentsample); //Write the sample to the buffer (mono buffer)!
-			++i; //Add time!
-			if (i == length) //Fully rendered?
-			{
-				return; //Next item!
-			}
+			writeDoubleBufferedSound16(&pcspeaker_soundbuffer, (short)LIMITRANGE(speaker_currentsample,SHRT_MIN,SHRT_MAX)); //Write the sample to the buffer (mono buffer)! Clip the overshoot of close steps!
 		}
 	}
 }
@@ -552,13 +620,18 @@ void initSpeakers(byte soundspeaker)
 	byte i;
 	for (i=0;i<numPITchannels;i++)
 	{
-		PITchannels[i].rawsignal = allocfifobuffer(((uint_64)((2048.0f / SPEAKER_RATE)*TIME_RATE)) + 1, 0); //Nonlockable FIFO with 2048 word-sized samples with lock (TICK_RATE)!
+		PITchannels[i].rawsignal = allocfifobuffer(SPEAKER_EDGES<<3, 0); //Nonlockable FIFO with output level changes and their time!
 		if (i==2 && enablespeaker) //Speaker?
 		{
 			allocDoubleBufferedSound16(SPEAKER_BUFFER,&pcspeaker_soundbuffer,0,SPEAKER_RATE); //(non-)Lockable FIFO with X word-sized samples without lock!
 		}
 	}
 	speaker_ticktiming = time_ticktiming = 0; //Initialise our timing!
+	speaker_pittime = speaker_synthtime = 0; //Initialise our output timing!
+	memset(&speaker_blepbuffer,0,sizeof(speaker_blepbuffer)); //Nothing pending!
+	speaker_blepposition = speaker_bleppending = 0; //Nothing pending!
+	speaker_blepoutput = speaker_bleptarget = (SHRT_MIN*SPEAKER_LOWPASSVOLUME); //Start at the low output level!
+	speaker_initBLEP(); //Initialize the band-limited steps!
 	if (enablespeaker)
 	{
 		addchannel(&speakerCallback, &PITchannels[2], "PC Speaker", SPEAKER_RATE, SPEAKER_BUFFER, 0, SMPL16S,1); //Add the speaker at the hardware rate, mono! Make sure our buffer responds every 2ms at least!
@@ -566,14 +639,16 @@ void initSpeakers(byte soundspeaker)
 
 #ifdef SPEAKER_LOGRAW
 		domkdir("captures"); //Captures directory!
-		speakerlograw = createWAV(SPEAKER_LOGRAW,1,(uint_32)TIME_RATE); //Start raw wave file logging!
+		speakerlograw = createWAV(SPEAKER_LOGRAW,1,(uint_32)SPEAKER_RATE); //Start raw wave file logging!
 #endif
 #ifdef SPEAKER_LOGDUTY
 		domkdir("captures"); //Captures directory!
-		speakerlogduty = createWAV(SPEAKER_LOGDUTY,1,(uint_32)TIME_RATE); //Start duty wave file logging!
+		speakerlogduty = createWAV(SPEAKER_LOGDUTY,1,(uint_32)SPEAKER_RATE); //Start duty wave file logging!
 #endif
 	}
-	initSoundFilter(&PCSpeakerFilter,0,(float)SPEAKER_LOWPASS, (float)TIME_RATE); //Initialize our low-pass filter to use!
+	#ifdef SPEAKER_LOWPASS
+	initSoundFilter(&PCSpeakerFilter,0,(float)SPEAKER_LOWPASS, (float)SPEAKER_RATE); //Initialize our low-pass filter to use!
+	#endif
 }
 
 void doneSpeakers()
@@ -186,6 +186,7 @@ void updateSoundBlaster(DOUBLE timepassed, uint_32 MHZ14passed)
 	DOUBLE dummy;
 	#endif
 	DOUBLE temp;
+	uint_32 ticks;
 	byte activeleft, activeright;
 	if (SOUNDBLASTER.baseaddr == 0) return; //No game blaster?
 
@@ -250,6 +251,22 @@ void updateSoundBlaster(DOUBLE timepassed, uint_32 MHZ14passed)
 			{
 				for (;soundblaster_sampletiming>=soundblaster_sampletick;) //A sample to play?
 				{
+					if (unlikely(soundblaster_sampletiming >= (soundblaster_sampletick + soundblaster_sampletick))) //Multiple ticks left? Skip all ticks that don't expire the timer at once!
+					{
+						ticks = (uint_32)(soundblaster_sampletiming / soundblaster_sampletick); //How many ticks are left?
+						if (unlikely(((DOUBLE)ticks * soundblaster_sampletick) > soundblaster_sampletiming)) --ticks; //Rounded up?
+						if ((SOUNDBLASTER.timer == 0) || (SOUNDBLASTER.timer > ticks)) //Not timing or not expiring in the ticks left?
+						{
+							if (SOUNDBLASTER.timer) SOUNDBLASTER.timer -= ticks; //Tick the timer!
+							soundblaster_sampletiming -= ((DOUBLE)ticks * soundblaster_sampletick); //The samples have been ticked!
+							continue; //Skip: we're not expiring!
+						}
+						if (SOUNDBLASTER.timer > 1) //Expiring after some ticks?
+						{
+							soundblaster_sampletiming -= ((DOUBLE)(SOUNDBLASTER.timer - 1) * soundblaster_sampletick); //Tick until the last tick!
+							SOUNDBLASTER.timer = 1; //Expiring on the next tick!
+						}
+					}
 					if (likely(SOUNDBLASTER.timer==0)) //Not timing?
 					{
 						soundblaster_sampletiming -= soundblaster_sampletick; //A sample has been ticked!
@@ -718,16 +735,43 @@ OPTINLINE void DSP_writeCommand(byte command)
 	}
 }
 
-//ADPCM decoder from Dosbox
-OPTINLINE byte decode_ADPCM_4_sample(byte sample, byte *reference, int_32 *scale)
+//ADPCM decoder from Dosbox, precalculated into tables for all step sizes and samples!
+typedef struct
+{
+	sbyte delta; //Adjustment of the reference!
+	byte stepsize; //The new step size!
+} ADPCM_STEP;
+
+ADPCM_STEP ADPCM_steps2[0x100 << 2]; //2-bit ADPCM steps, indexed by (stepsize<<2)|sample!
+ADPCM_STEP ADPCM_steps3[0x100 << 3]; //2.6-bit ADPCM steps, indexed by (stepsize<<3)|sample!
+ADPCM_STEP ADPCM_steps4[0x100 << 4]; //4-bit ADPCM steps, indexed by (stepsize<<4)|sample!
+
+void SoundBlaster_initADPCMsteps(ADPCM_STEP *steps, byte samplebits, const sbyte *scaleMap, const byte *adjustMap, int_32 maxsamp)
+{
+	int_32 scale, sample, samp;
+	for (scale = 0; scale < 0x100; ++scale) //All step sizes!
+	{
+		for (sample = 0; sample < (1 << samplebits); ++sample) //All samples!
+		{
+			samp = sample + scale;
+			if (samp < 0) samp = 0;
+			if (samp > maxsamp) samp = maxsamp; //Bad ADPCM sample!
+			steps->delta = scaleMap[samp]; //The adjustment of the reference!
+			steps->stepsize = (byte)((scale + adjustMap[samp]) & 0xff); //The new step size!
+			++steps; //Next step!
+		}
+	}
+}
+
+void SoundBlaster_initADPCM()
 {
-	static const sbyte scaleMap[64] = {
+	static const sbyte scaleMap4[64] = {
 		0,  1,  2,  3,  4,  5,  6,  7,  0,  -1,  -2,  -3,  -4,  -5,  -6,  -7,
 		1,  3,  5,  7,  9, 11, 13, 15, -1,  -3,  -5,  -7,  -9, -11, -13, -15,
 		2,  6, 10, 14, 18, 22, 26, 30, -2,  -6, -10, -14, -18, -22, -26, -30,
 		4, 12, 20, 28, 36, 44, 52, 60, -4, -12, -20, -28, -36, -44, -52, -60
 	};
-	static const byte adjustMap[64] = {
+	static const byte adjustMap4[64] = {
 		0, 0, 0, 0, 0, 16, 16, 16,
 		0, 0, 0, 0, 0, 16, 16, 16,
 		240, 0, 0, 0, 0, 16, 16, 16,
@@ -737,85 +781,83 @@ OPTINLINE byte decode_ADPCM_4_sample(byte sample, byte *reference, int_32 *scale
 		240, 0, 0, 0, 0,  0,  0,  0,
 		240, 0, 0, 0, 0,  0,  0,  0
 	};
-
-	int_32 samp = sample + *scale;
-
-	if ((samp < 0) || (samp > 63)) {
-		//LOG(LOG_SB, LOG_ERROR)("Bad ADPCM-4 sample");
-		if (samp < 0) samp = 0;
-		if (samp > 63) samp = 63;
-	}
-
-	int_32 ref = *reference + scaleMap[samp];
-	if (ref > 0xff) *reference = 0xff;
-	else if (ref < 0x00) *reference = 0x00;
-	else *reference = (byte)(ref & 0xff);
-	*scale = (*scale + adjustMap[samp]) & 0xff;
-
-	return (byte)*reference;
-}
-
-OPTINLINE byte decode_ADPCM_2_sample(byte sample, byte *reference, int_32 *scale)
-{
-	static const sbyte scaleMap[24] = {
+	static const sbyte scaleMap2[24] = {
 		0,  1,  0,  -1, 1,  3,  -1,  -3,
 		2,  6, -2,  -6, 4, 12,  -4, -12,
 		8, 24, -8, -24, 6, 48, -16, -48
 	};
-	static const byte adjustMap[24] = {
+	static const byte adjustMap2[24] = {
 		0, 4,   0, 4,
 		252, 4, 252, 4, 252, 4, 252, 4,
 		252, 4, 252, 4, 252, 4, 252, 4,
 		252, 0, 252, 0
 	};
-
-	int_32 samp = sample + *scale;
-	if ((samp < 0) || (samp > 23)) {
-		//LOG(LOG_SB, LOG_ERROR)("Bad ADPCM-2 sample");
-		if (samp < 0) samp = 0;
-		if (samp > 23) samp = 23;
-	}
-
-	int_32 ref = *reference + scaleMap[samp];
-	if (ref > 0xff) *reference = 0xff;
-	else if (ref < 0x00) *reference = 0x00;
-	else *reference = (byte)(ref & 0xff);
-	*scale = (*scale + adjustMap[samp]) & 0xff;
-
-	return (byte)*reference;
-}
-
-OPTINLINE byte decode_ADPCM_3_sample(byte sample, byte *reference,int_32 *scale)
-{
-	static const sbyte scaleMap[40] = {
+	static const sbyte scaleMap3[40] = {
 		0,  1,  2,  3,  0,  -1,  -2,  -3,
 		1,  3,  5,  7, -1,  -3,  -5,  -7,
 		2,  6, 10, 14, -2,  -6, -10, -14,
 		4, 12, 20, 28, -4, -12, -20, -28,
 		5, 15, 25, 35, -5, -15, -25, -35
 	};
-	static const byte adjustMap[40] = {
+	static const byte adjustMap3[40] = {
 		0, 0, 0, 8,   0, 0, 0, 8,
 		248, 0, 0, 8, 248, 0, 0, 8,
 		248, 0, 0, 8, 248, 0, 0, 8,
 		248, 0, 0, 8, 248, 0, 0, 8,
 		248, 0, 0, 0, 248, 0, 0, 0
 	};
+	SoundBlaster_initADPCMsteps(&ADPCM_steps2[0], 2, &scaleMap2[0], &adjustMap2[0], 23); //2-bit ADPCM!
+	SoundBlaster_initADPCMsteps(&ADPCM_steps3[0], 3, &scaleMap3[0], &adjustMap3[0], 39); //2.6-bit ADPCM!
+	SoundBlaster_initADPCMsteps(&ADPCM_steps4[0], 4, &scaleMap4[0], &adjustMap4[0], 63); //4-bit ADPCM!
+}
 
-	int_32 samp = sample + *scale;
-	if ((samp < 0) || (samp > 39)) {
-		//LOG(LOG_SB, LOG_ERROR)("Bad ADPCM-3 sample");
-		if (samp < 0) samp = 0;
-		if (samp > 39) samp = 39;
+//Decode all samples of an ADPCM data byte in one pass and send them for rendering!
+OPTINLINE void SoundBlaster_decodeADPCM(byte data)
+{
+	byte samples[4]; //The samples in the data byte!
+	byte numsamples, sample, stepshift;
+	ADPCM_STEP *steps, *step;
+	int_32 reference;
+	switch (SOUNDBLASTER.ADPCM_format) //What format?
+	{
+	case ADPCM_FORMAT_2BIT: //Dosbox DSP_DMA_2
+		samples[0] = ((data >> 6) & 0x3);
+		samples[1] = ((data >> 4) & 0x3);
+		samples[2] = ((data >> 2) & 0x3);
+		samples[3] = (data & 0x3);
+		numsamples = 4;
+		steps = &ADPCM_steps2[0];
+		stepshift = 2; //Shift of the step size!
+		break;
+	case ADPCM_FORMAT_26BIT: //Dosbox DSP_DMA_3
+		samples[0] = ((data >> 5) & 0x7);
+		samples[1] = ((data >> 2) & 0x7);
+		samples[2] = ((data & 3) << 0x1);
+		numsamples = 3;
+		steps = &ADPCM_steps3[0];
+		stepshift = 3; //Shift of the step size!
+		break;
+	case ADPCM_FORMAT_4BIT: //Dosbox DSP_DMA_4
+		samples[0] = ((data >> 4) & 0xF);
+		samples[1] = (data & 0xF);
+		numsamples = 2;
+		steps = &ADPCM_steps4[0];
+		stepshift = 4; //Shift of the step size!
+		break;
+	default: //Unknown format?
+		//Ignore output!
+		writefifobuffer(SOUNDBLASTER.DSPoutdata, 0x80); //Send the empty sample for rendering!
+		return;
 	}
-
-	int_32 ref = *reference + scaleMap[samp];
-	if (ref > 0xff) *reference = 0xff;
-	else if (ref < 0x00) *reference = 0x00;
-	else *reference = (byte)(ref & 0xff);
-	*scale = (*scale + adjustMap[samp]) & 0xff;
-
-	return (byte)*reference;
+	reference = (int_32)SOUNDBLASTER.ADPCM_currentreference; //The current reference!
+	for (sample = 0; sample < numsamples; ++sample) //Decode all samples!
+	{
+		step = &steps[((SOUNDBLASTER.ADPCM_stepsize & 0xFF) << stepshift) | samples[sample]]; //The step to apply!
+		reference = LIMITRANGE(reference + step->delta, 0x00, 0xFF); //Apply the adjustment!
+		SOUNDBLASTER.ADPCM_stepsize = step->stepsize; //The new step size!
+		writefifobuffer(SOUNDBLASTER.DSPoutdata, (byte)reference); //Send the partial sample for rendering!
+	}
+	SOUNDBLASTER.ADPCM_currentreference = (byte)reference; //The new reference!
 }
 
 OPTINLINE void DSP_writeData(byte data, byte isDMA)
@@ -873,28 +915,7 @@ OPTINLINE void DSP_writeData(byte data, byte isDMA)
 					}
 					else //Data based on the reference?
 					{
-						switch (SOUNDBLASTER.ADPCM_format) //What format?
-						{
-						case ADPCM_FORMAT_2BIT: //Dosbox DSP_DMA_2
-							writefifobuffer(SOUNDBLASTER.DSPoutdata, decode_ADPCM_2_sample((data >> 6) & 0x3, &SOUNDBLASTER.ADPCM_currentreference, &SOUNDBLASTER.ADPCM_stepsize)); //Send the partial sample for rendering!
-							writefifobuffer(SOUNDBLASTER.DSPoutdata, decode_ADPCM_2_sample((data >> 4) & 0x3, &SOUNDBLASTER.ADPCM_currentreference, &SOUNDBLASTER.ADPCM_stepsize)); //Send the partial sample for rendering!
-							writefifobuffer(SOUNDBLASTER.DSPoutdata, decode_ADPCM_2_sample((data >> 2) & 0x3, &SOUNDBLASTER.ADPCM_currentreference, &SOUNDBLASTER.ADPCM_stepsize)); //Send the partial sample for rendering!
-							writefifobuffer(SOUNDBLASTER.DSPoutdata, decode_ADPCM_2_sample((data >> 0) & 0x3, &SOUNDBLASTER.ADPCM_currentreference, &SOUNDBLASTER.ADPCM_stepsize)); //Send the partial sample for rendering!
-							break;
-						case ADPCM_FORMAT_26BIT: //Dosbox DSP_DMA_3
-							writefifobuffer(SOUNDBLASTER.DSPoutdata, decode_ADPCM_3_sample((data >> 5)  &  0x7, &SOUNDBLASTER.ADPCM_currentreference, &SOUNDBLASTER.ADPCM_stepsize)); //Send the partial sample for rendering!
-							writefifobuffer(SOUNDBLASTER.DSPoutdata, decode_ADPCM_3_sample((data >> 2)  &  0x7, &SOUNDBLASTER.ADPCM_currentreference, &SOUNDBLASTER.ADPCM_stepsize)); //Send the partial sample for rendering!
-							writefifobuffer(SOUNDBLASTER.DSPoutdata, decode_ADPCM_3_sample((data &  3)  << 0x1, &SOUNDBLASTER.ADPCM_currentreference, &SOUNDBLASTER.ADPCM_stepsize)); //Send the partial sample for rendering!
-							break;
-						case ADPCM_FORMAT_4BIT: //Dosbox DSP_DMA_4
-							writefifobuffer(SOUNDBLASTER.DSPoutdata, decode_ADPCM_4_sample((data >> 4) & 0xF, &SOUNDBLASTER.ADPCM_currentreference, &SOUNDBLASTER.ADPCM_stepsize)); //Send the partial sample for rendering!
-							writefifobuffer(SOUNDBLASTER.DSPoutdata, decode_ADPCM_4_sample(data        & 0xF, &SOUNDBLASTER.ADPCM_currentreference, &SOUNDBLASTER.ADPCM_stepsize)); //Send the partial sample for rendering!
-							break;
-						default: //Unknown format?
-							//Ignore output!
-							writefifobuffer(SOUNDBLASTER.DSPoutdata, 0x80); //Send the empty sample for rendering!
-							break;
-						}
+						SoundBlaster_decodeADPCM(data); //Decode the samples!
 					}
 				}
 				else //Normal 8-bit sample?
@@ -1372,6 +1393,8 @@ void initSoundBlaster(word baseaddr, byte version)
 	registerDMA8(__SOUNDBLASTER_DMA8,&SoundBlaster_readDMA8,&SoundBlaster_writeDMA8); //DMA access of the Sound Blaster!
 	registerDMATick(__SOUNDBLASTER_DMA8,&SoundBlaster_DREQ,&SoundBlaster_DACK,&SoundBlaster_TC,&SoundBlaster_EOP);
 
+	SoundBlaster_initADPCM(); //Initialize the ADPCM decoder!
+
 	DSP_HWreset(); //Hardware reset!
 
 	//Our tick timings!
@@ -477,6 +477,11 @@ void VGA_VBlankHandler(VGA_Type *VGA)
 		VGA->wait_for_vblank = 0; //Reset!
 		VGA->VGA_vblank = 1; //VBlank occurred!
 	}
+
+	//Latch the DAC cache statistics of the finished frame!
+	VGA->DACcache_lastentryupdates = VGA->DACcache_entryupdates; //Entries updated during the last frame!
+	VGA->DACcache_lastrebuilds = VGA->DACcache_rebuilds; //High color cache rebuilds during the last frame!
+	VGA->DACcache_entryupdates = VGA->DACcache_rebuilds = 0; //Start counting the new frame!
 	
 	renderHWFrame(); //Render the GPU a frame!
 }
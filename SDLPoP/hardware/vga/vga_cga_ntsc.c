@@ -23,6 +23,22 @@ along with UniPCemu.  If not, see <https://www.gnu.org/licenses/>.
 #include "headers/header_dosbox.h" //Dosbox support!
 #include "headers/hardware/vga/vga_cga_ntsc.h" //Our own definitions!
 #include "headers/fopen64.h"
+#include "headers/support/highrestimer.h" //High resolution timer support for the decoding statistics!
+
+//Use SIMD instructions for decoding the composite signal when available? Comment out to always use the portable decoder!
+#define CGA_NTSC_SIMD
+//Measure the time spent decoding scanlines?
+//#define CGA_NTSC_TIMING
+
+#ifdef CGA_NTSC_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP>=2))
+#include <emmintrin.h> //SSE2 support!
+#define CGA_NTSC_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h> //NEON support!
+#define CGA_NTSC_NEON
+#endif
+#endif
 
 //Main functions for rendering NTSC and RGBI by superfury:
 
@@ -97,6 +113,8 @@ DOUBLE max_v;
 
 DOUBLE video_ri, video_rq, video_gi, video_gq, video_bi, video_bq;
 int video_sharpness;
+int video_phasecoefficients[6][4]; //Multipliers of the a and b chroma signals for every phase of the color carrier, for the R, G and B outputs!
+uint_32 video_generation = 0; //Increased every time the conversion tables change!
 //int tandy_mode_control = 0; //Uses VGA directly by superfury
 
 bool new_cga = 0;
@@ -109,6 +127,18 @@ bool new_cga = 0;
 
 BIGFILE *df;
 
+OPTINLINE void set_phasecoefficients(byte channel, int ci, int cq) //Precalculate the chroma multipliers of an output for every phase of the carrier!
+{
+	int *ka, *kb;
+	ka = &video_phasecoefficients[channel<<1][0]; //Multipliers of a!
+	kb = &video_phasecoefficients[(channel<<1)|1][0]; //Multipliers of b!
+	//The I/Q signals rotate through (a,b), (-b,a), (-a,-b) and (b,-a) for the 4 phases!
+	ka[0] = ci; kb[0] = cq;
+	ka[1] = cq; kb[1] = -ci;
+	ka[2] = -ci; kb[2] = -cq;
+	ka[3] = -cq; kb[3] = ci;
+}
+
 OPTINLINE void update_cga16_color() { //Superfury: Removed the parameter: we access the emulation directly!
 	int x;
 
@@ -195,6 +225,11 @@ OPTINLINE void update_cga16_color() { //Superfury: Removed the parameter: we acc
         video_bq = (int) (-bi*iq_adjust_q + bq*iq_adjust_i);
         video_sharpness = (int) (sharpness*256/100);
 
+		set_phasecoefficients(0,(int)video_ri,(int)video_rq); //R!
+		set_phasecoefficients(1,(int)video_gi,(int)video_gq); //G!
+		set_phasecoefficients(2,(int)video_bi,(int)video_bq); //B!
+		++video_generation; //The conversion has changed, so any decoded scanlines are invalid now!
+
 #if 0
 	df = emufopen64("CGA_Composite_Table.dmp", "wb");
 	emufwrite64(CGA_Composite_Table, 1024, sizeof(int), df);
@@ -224,10 +259,169 @@ int temp[SCALER_MAXWIDTH + 10]={0};
 int atemp[SCALER_MAXWIDTH + 2]={0};
 int btemp[SCALER_MAXWIDTH + 2]={0};
 
+//Decoders of the composite signal into RGB pixels. i is the signal with the chroma removed, ap and bp are the chroma signals. All are indexed by pixel.
+OPTINLINE void Composite_DecodeColor_portable(int *i, int *ap, int *bp, Bit32u *srgb, int w)
+{
+	INLINEREGISTER int x, phase, y, a, b, c, d;
+	for (x = 0; x < w; ++x) {
+		phase = (x&3); //The phase of the color carrier!
+		a = ap[x];
+		b = bp[x];
+		c = i[x]+i[x];
+		d = i[x-1]+i[x+1];
+		y = ((c+d)<<8) + video_sharpness*(c-d);
+		srgb[x] = RGB(byte_clamp(y + video_phasecoefficients[0][phase]*a + video_phasecoefficients[1][phase]*b),
+			byte_clamp(y + video_phasecoefficients[2][phase]*a + video_phasecoefficients[3][phase]*b),
+			byte_clamp(y + video_phasecoefficients[4][phase]*a + video_phasecoefficients[5][phase]*b));
+	}
+}
+
+OPTINLINE void Composite_DecodeMono_portable(int *i, Bit32u *srgb, int w)
+{
+	INLINEREGISTER int x, y, c, d;
+	for (x = 0; x < w; ++x) {
+		c = (i[x]+i[x])<<3;
+		d = (i[x-1]+i[x+1])<<3;
+		y = ((c+d)<<8) + video_sharpness*(c-d);
+		srgb[x] = byte_clamp(y)*0x10101;
+	}
+}
+
+#ifdef CGA_NTSC_SSE2
+OPTINLINE __m128i Composite_mullo32(__m128i a, __m128i b) //32-bit multiply, which SSE2 doesn't have!
+{
+	__m128i even, odd;
+	even = _mm_mul_epu32(a,b); //Lanes 0 and 2!
+	odd = _mm_mul_epu32(_mm_srli_si128(a,4),_mm_srli_si128(b,4)); //Lanes 1 and 3!
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even,_MM_SHUFFLE(0,0,2,0)),_mm_shuffle_epi32(odd,_MM_SHUFFLE(0,0,2,0))); //Combine the low halves of the products!
+}
+
+OPTINLINE __m128i Composite_clamp(__m128i v) //byte_clamp for 4 values!
+{
+	v = _mm_srai_epi32(v,13);
+	v = _mm_packs_epi32(v,v); //Saturate to 16-bit!
+	v = _mm_max_epi16(v,_mm_setzero_si128());
+	v = _mm_min_epi16(v,_mm_set1_epi16(255)); //Clamp!
+	return _mm_unpacklo_epi16(v,_mm_setzero_si128()); //Back to 32-bit!
+}
+
+OPTINLINE __m128i Composite_luma(int *i, __m128i sharpness) //The luma of 4 pixels!
+{
+	__m128i c, d, y;
+	c = _mm_loadu_si128((__m128i *)i);
+	c = _mm_add_epi32(c,c);
+	d = _mm_add_epi32(_mm_loadu_si128((__m128i *)(i-1)),_mm_loadu_si128((__m128i *)(i+1)));
+	y = _mm_slli_epi32(_mm_add_epi32(c,d),8);
+	if (unlikely(video_sharpness)) y = _mm_add_epi32(y,Composite_mullo32(sharpness,_mm_sub_epi32(c,d))); //Apply sharpness!
+	return y;
+}
+
+OPTINLINE void Composite_DecodeColor(int *i, int *ap, int *bp, Bit32u *srgb, int w)
+{
+	int x;
+	__m128i y, a, b, r, g, bb, out, sharpness, alpha, rs, gs, bs;
+	__m128i kar, kbr, kag, kbg, kab, kbb;
+	sharpness = _mm_set1_epi32(video_sharpness);
+	alpha = _mm_set1_epi32((int)RGBA(0,0,0,SDL_ALPHA_OPAQUE));
+	rs = _mm_cvtsi32_si128(rshift);
+	gs = _mm_cvtsi32_si128(gshift);
+	bs = _mm_cvtsi32_si128(bshift);
+	kar = _mm_loadu_si128((__m128i *)&video_phasecoefficients[0][0]);
+	kbr = _mm_loadu_si128((__m128i *)&video_phasecoefficients[1][0]);
+	kag = _mm_loadu_si128((__m128i *)&video_phasecoefficients[2][0]);
+	kbg = _mm_loadu_si128((__m128i *)&video_phasecoefficients[3][0]);
+	kab = _mm_loadu_si128((__m128i *)&video_phasecoefficients[4][0]);
+	kbb = _mm_loadu_si128((__m128i *)&video_phasecoefficients[5][0]);
+	for (x = 0; x < w; x += 4) { //4 pixels at a time, which is one period of the color carrier!
+		y = Composite_luma(&i[x],sharpness);
+		a = _mm_loadu_si128((__m128i *)&ap[x]);
+		b = _mm_loadu_si128((__m128i *)&bp[x]);
+		r = _mm_add_epi32(y,_mm_add_epi32(Composite_mullo32(kar,a),Composite_mullo32(kbr,b)));
+		g = _mm_add_epi32(y,_mm_add_epi32(Composite_mullo32(kag,a),Composite_mullo32(kbg,b)));
+		bb = _mm_add_epi32(y,_mm_add_epi32(Composite_mullo32(kab,a),Composite_mullo32(kbb,b)));
+		out = _mm_or_si128(alpha,_mm_sll_epi32(Composite_clamp(r),rs));
+		out = _mm_or_si128(out,_mm_sll_epi32(Composite_clamp(g),gs));
+		out = _mm_or_si128(out,_mm_sll_epi32(Composite_clamp(bb),bs));
+		_mm_storeu_si128((__m128i *)&srgb[x],out);
+	}
+}
+
+OPTINLINE void Composite_DecodeMono(int *i, Bit32u *srgb, int w)
+{
+	int x;
+	__m128i y, sharpness;
+	sharpness = _mm_set1_epi32(video_sharpness);
+	for (x = 0; x < w; x += 4) {
+		y = Composite_clamp(_mm_slli_epi32(Composite_luma(&i[x],sharpness),3)); //The signal isn't scaled for mono!
+		y = _mm_or_si128(y,_mm_or_si128(_mm_slli_epi32(y,8),_mm_slli_epi32(y,16))); //Grayscale!
+		_mm_storeu_si128((__m128i *)&srgb[x],y);
+	}
+}
+#else
+#ifdef CGA_NTSC_NEON
+OPTINLINE int32x4_t Composite_clamp(int32x4_t v) //byte_clamp for 4 values!
+{
+	return vminq_s32(vmaxq_s32(vshrq_n_s32(v,13),vdupq_n_s32(0)),vdupq_n_s32(255));
+}
+
+OPTINLINE int32x4_t Composite_luma(int *i, int32x4_t sharpness) //The luma of 4 pixels!
+{
+	int32x4_t c, d;
+	c = vld1q_s32(i);
+	c = vaddq_s32(c,c);
+	d = vaddq_s32(vld1q_s32(i-1),vld1q_s32(i+1));
+	return vmlaq_s32(vshlq_n_s32(vaddq_s32(c,d),8),sharpness,vsubq_s32(c,d));
+}
+
+OPTINLINE void Composite_DecodeColor(int *i, int *ap, int *bp, Bit32u *srgb, int w)
+{
+	int x;
+	int32x4_t y, a, b, sharpness, rs, gs, bs;
+	int32x4_t kar, kbr, kag, kbg, kab, kbb;
+	uint32x4_t out;
+	sharpness = vdupq_n_s32(video_sharpness);
+	rs = vdupq_n_s32(rshift);
+	gs = vdupq_n_s32(gshift);
+	bs = vdupq_n_s32(bshift);
+	kar = vld1q_s32(&video_phasecoefficients[0][0]);
+	kbr = vld1q_s32(&video_phasecoefficients[1][0]);
+	kag = vld1q_s32(&video_phasecoefficients[2][0]);
+	kbg = vld1q_s32(&video_phasecoefficients[3][0]);
+	kab = vld1q_s32(&video_phasecoefficients[4][0]);
+	kbb = vld1q_s32(&video_phasecoefficients[5][0]);
+	for (x = 0; x < w; x += 4) { //4 pixels at a time, which is one period of the color carrier!
+		y = Composite_luma(&i[x],sharpness);
+		a = vld1q_s32(&ap[x]);
+		b = vld1q_s32(&bp[x]);
+		out = vdupq_n_u32(RGBA(0,0,0,SDL_ALPHA_OPAQUE));
+		out = vorrq_u32(out,vshlq_u32(vreinterpretq_u32_s32(Composite_clamp(vmlaq_s32(vmlaq_s32(y,kar,a),kbr,b))),rs));
+		out = vorrq_u32(out,vshlq_u32(vreinterpretq_u32_s32(Composite_clamp(vmlaq_s32(vmlaq_s32(y,kag,a),kbg,b))),gs));
+		out = vorrq_u32(out,vshlq_u32(vreinterpretq_u32_s32(Composite_clamp(vmlaq_s32(vmlaq_s32(y,kab,a),kbb,b))),bs));
+		vst1q_u32((uint32_t *)&srgb[x],out);
+	}
+}
+
+OPTINLINE void Composite_DecodeMono(int *i, Bit32u *srgb, int w)
+{
+	int x;
+	int32x4_t y, sharpness;
+	sharpness = vdupq_n_s32(video_sharpness);
+	for (x = 0; x < w; x += 4) {
+		y = Composite_clamp(vshlq_n_s32(Composite_luma(&i[x],sharpness),3)); //The signal isn't scaled for mono!
+		y = vorrq_s32(y,vorrq_s32(vshlq_n_s32(y,8),vshlq_n_s32(y,16))); //Grayscale!
+		vst1q_u32((uint32_t *)&srgb[x],vreinterpretq_u32_s32(y));
+	}
+}
+#else
+//No SIMD available, so use the portable decoders!
+#define Composite_DecodeColor Composite_DecodeColor_portable
+#define Composite_DecodeMono Composite_DecodeMono_portable
+#endif
+#endif
+
 OPTINLINE void Composite_Process(Bit8u border, Bit32u blocks/*, bool doublewidth*/, Bit8u *TempLine) //Superfury: Used to return a pointer(not used?). Replaced with void.
 {
 	int x;
-	Bit32u x2;
 
         int w = blocks*4;
 
@@ -247,23 +441,6 @@ OPTINLINE void Composite_Process(Bit8u border, Bit32u blocks/*, bool doublewidth
         }
 #endif
 
-#define COMPOSITE_CONVERT(I, Q) { \
-        i[1] = (i[1]<<3) - ap[1]; \
-        a = ap[0]; \
-        b = bp[0]; \
-        c = i[0]+i[0]; \
-        d = i[-1]+i[1]; \
-        y = ((c+d)<<8) + (int)(video_sharpness*(DOUBLE)(c-d)); \
-        rr = y + (int)(video_ri*(I)) + (int)(video_rq*(Q)); \
-        gg = y + (int)(video_gi*(I)) + (int)(video_gq*(Q)); \
-        bb = y + (int)(video_bi*(I)) + (int)(video_bq*(Q)); \
-        ++i; \
-        ++ap; \
-        ++bp; \
-        *srgb = RGB(byte_clamp(rr),byte_clamp(gg),byte_clamp(bb)); \
-        ++srgb; \
-}
-
 #define OUT(v) { *o = (v); ++o; }
 
         // Simulate CGA composite output
@@ -283,16 +460,7 @@ OPTINLINE void Composite_Process(Bit8u border, Bit32u blocks/*, bool doublewidth
 
         if ((CGA_MODECONTROL & 4) != 0 || !cga_color_burst) {
                 // Decode
-                int* i = temp + 5;
-                Bit32u* srgb = (Bit32u *)TempLine;
-                for (x2 = 0; x2 < blocks*4; ++x2) {
-                        INLINEREGISTER int c = (i[0]+i[0])<<3;
-						INLINEREGISTER int d = (i[-1]+i[1])<<3;
-						INLINEREGISTER int y = ((c+d)<<8) + video_sharpness*(c-d);
-                        ++i;
-                        *srgb = byte_clamp(y)*0x10101;
-                        ++srgb;
-                }
+                Composite_DecodeMono(temp + 5, (Bit32u *)TempLine, w);
         }
         else {
                 // Store chroma
@@ -305,20 +473,15 @@ OPTINLINE void Composite_Process(Bit8u border, Bit32u blocks/*, bool doublewidth
                         ++i;
                 }
 
-                // Decode
+                // Remove the chroma from the signal
                 i = temp + 5;
-                i[-1] = (i[-1]<<3) - ap[-1];
-                i[0] = (i[0]<<3) - ap[0];
-                Bit32u* srgb = (Bit32u *)TempLine;
-                for (x2 = 0; x2 < blocks; ++x2) {
-					INLINEREGISTER int y,a,b,c,d,rr,gg,bb;
-                        COMPOSITE_CONVERT(a, b);
-                        COMPOSITE_CONVERT(-b, a);
-                        COMPOSITE_CONVERT(-a, -b);
-                        COMPOSITE_CONVERT(b, -a);
+                for (x = -1; x < w + 1; ++x) {
+                        i[x] = (i[x]<<3) - ap[x];
                 }
+
+                // Decode
+                Composite_DecodeColor(i, ap, bp, (Bit32u *)TempLine, w);
         }
-#undef COMPOSITE_CONVERT
 #undef OUT
 
 } //Don't return the result: it's already known!
@@ -385,14 +548,75 @@ OPTINLINE void RENDER_convertRGBI(byte *pixels, uint_32 *renderdestination, uint
 }
 
 //NTSC conversion
-OPTINLINE void RENDER_convertNTSC(byte *pixels, uint_32 *renderdestination, uint_32 size) //Convert a row of data to NTSC output!
+
+//Scanlines that are unchanged since the previous frame reuse their decoded output! Wider scanlines than a CGA scanline(912 pixels) including overscan aren't cached!
+#define NTSC_SCANLINEWIDTH 1024
+
+typedef struct
 {
+	uint_32 size; //Amount of pixels decoded, 0 for none!
+	uint_32 generation; //The generation of the conversion tables used!
+	byte mono; //Decoded without color?
+	byte pixels[NTSC_SCANLINEWIDTH]; //The source pixels!
+	uint_32 output[NTSC_SCANLINEWIDTH]; //The decoded output!
+} NTSC_SCANLINE;
+
+NTSC_SCANLINE NTSC_scanlines[0x140]; //All scanlines of a NTSC(262) or PAL(312) frame!
+
+//Statistics of the conversion!
+uint_32 NTSC_scanlines_decoded = 0; //Amount of scanlines decoded!
+uint_32 NTSC_scanlines_reused = 0; //Amount of scanlines reused from the previous frame!
+#ifdef CGA_NTSC_TIMING
+DOUBLE NTSC_scanlines_time = 0.0; //Time spent decoding scanlines, in ns!
+TicksHolder NTSC_ticks; //The timer for decoding scanlines!
+byte NTSC_ticksinit = 1; //Timer needs to be initialised?
+#endif
+
+OPTINLINE void RENDER_convertNTSC(byte *pixels, uint_32 *renderdestination, uint_32 size, word scanline) //Convert a row of data to NTSC output!
+{
+	NTSC_SCANLINE *cachedscanline;
+	byte mono;
+	mono = ((CGA_MODECONTROL & 4) != 0) || (!cga_color_burst); //Decoded without color?
+	cachedscanline = NULL; //Default: not cached!
+	if (likely((scanline<NUMITEMS(NTSC_scanlines)) && (size<=NTSC_SCANLINEWIDTH))) //Cachable scanline?
+	{
+		cachedscanline = &NTSC_scanlines[scanline]; //The cached scanline!
+		if ((cachedscanline->size==size) && (cachedscanline->generation==video_generation) && (cachedscanline->mono==mono)) //Decoded the same way?
+		{
+			if (memcmp(&cachedscanline->pixels[0],pixels,size)==0) //Unchanged pixels?
+			{
+				memcpy(renderdestination,&cachedscanline->output[0],(size<<2)); //Reuse the decoded output!
+				++NTSC_scanlines_reused; //Reused!
+				return; //Finished!
+			}
+		}
+	}
+	#ifdef CGA_NTSC_TIMING
+	if (unlikely(NTSC_ticksinit)) //Timer not ready yet?
+	{
+		initTicksHolder(&NTSC_ticks); //Initialise the timer!
+		NTSC_ticksinit = 0; //Initialised!
+	}
+	getnspassed(&NTSC_ticks); //Start timing!
+	#endif
 	memcpy(renderdestination,pixels,size); //Copy the pixels to the display to convert!
 	Composite_Process(0,size>>2,(uint8_t *)renderdestination); //Convert to NTSC composite!
+	#ifdef CGA_NTSC_TIMING
+	NTSC_scanlines_time += getnspassed(&NTSC_ticks); //Time spent decoding!
+	#endif
+	++NTSC_scanlines_decoded; //Decoded!
+	if (likely(cachedscanline)) //To cache?
+	{
+		memcpy(&cachedscanline->pixels[0],pixels,size); //The source pixels!
+		memcpy(&cachedscanline->output[0],renderdestination,(size<<2)); //The decoded output!
+		cachedscanline->size = size; //Valid now!
+		cachedscanline->generation = video_generation; //The tables used!
+		cachedscanline->mono = mono; //How we're decoded!
+	}
 }
 
 //Functions to call to update our data and render it according to our settings!
-void RENDER_convertCGAOutput(byte *pixels, uint_32 *renderdestination, uint_32 size) //Convert a row of data to NTSC output!
+void RENDER_convertCGAOutput(byte *pixels, uint_32 *renderdestination, uint_32 size, word scanline) //Convert a row of data to NTSC output!
 {
 	if (CGA_RGB) //RGB monitor?
 	{
@@ -400,6 +624,6 @@ void RENDER_convertCGAOutput(byte *pixels, uint_32 *renderdestination, uint_32 s
 	}
 	else //NTSC monitor?
 	{
-		RENDER_convertNTSC(pixels, renderdestination, size); //Convert the pixels as NTSC!
+		RENDER_convertNTSC(pixels, renderdestination, size, scanline); //Convert the pixels as NTSC!
 	}
 }
\ No newline at end of file
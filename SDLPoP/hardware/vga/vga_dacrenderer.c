@@ -271,9 +271,20 @@ byte DAC_Use_BWluminance(byte use)
 	return DAC_luminancemethod; //Give the data!
 }
 
+OPTINLINE uint_32 DAC_applyBrightness(VGA_Type *VGA, uint_32 color) //Apply the active display brightness levels to a color!
+{
+	return RGBA(VGA->DACbrightness[GETR(color)], VGA->DACbrightness[GETG(color)], VGA->DACbrightness[GETB(color)], GETA(color)); //Make sure we're active display levels of brightness!
+}
+
 void DAC_updateEntry(VGA_Type *VGA, byte entry) //Update a DAC entry for rendering!
 {
 	VGA->precalcs.effectiveDAC[entry] = GA_color2bw(VGA->precalcs.DAC[entry],0); //Set the B/W or color entry!
+	VGA->precalcs.finalDAC[entry] = DAC_applyBrightness(VGA,VGA->precalcs.effectiveDAC[entry]); //The final color to output!
+	if (VGA->highcolorDACkey&(0x40<<16)) //High color cache is using the DAC as a LUT?
+	{
+		VGA->highcolorDACvalid = 0; //Rebuild the high color cache when it's used again!
+	}
+	++VGA->DACcache_entryupdates; //Count the updated entry!
 }
 
 void DAC_updateEntries(VGA_Type *VGA)
@@ -283,7 +294,9 @@ void DAC_updateEntries(VGA_Type *VGA)
 	{
 		DAC_updateEntry(VGA,i); //Update this entry with current values!
 		VGA->precalcs.effectiveMDADAC[i] = GA_color2bw(RGB(i,i,i),0); //Update the MDA DAC!
+		VGA->precalcs.finalMDADAC[i] = DAC_applyBrightness(VGA,VGA->precalcs.effectiveMDADAC[i]); //The final MDA color to output!
 	}
+	VGA->highcolorDACvalid = 0; //The color conversion might have changed, so rebuild the high color cache!
 }
 
 void VGA_initColorLevels(VGA_Type* VGA, byte enablePedestal)
@@ -306,4 +319,10 @@ void VGA_initColorLevels(VGA_Type* VGA, byte enablePedestal)
 		}
 		currange += rangestep; //Next entry level!
 	}
+	for (i = 0; i < 0x100; ++i) //Update the final colors for the new levels!
+	{
+		VGA->precalcs.finalDAC[i] = DAC_applyBrightness(VGA,VGA->precalcs.effectiveDAC[i]); //The final color to output!
+		VGA->precalcs.finalMDADAC[i] = DAC_applyBrightness(VGA,VGA->precalcs.effectiveMDADAC[i]); //The final MDA color to output!
+	}
+	VGA->highcolorDACvalid = 0; //Rebuild the high color cache with the new levels!
 }
\ No newline at end of file
@@ -54,6 +54,10 @@ along with UniPCemu.  If not, see <https://www.gnu.org/licenses/>.
 
 //Do color mode or B/W mode DAC according to our settings!
 #define VGA_DAC(VGA,DACValue) (VGA->precalcs.effectiveDAC[(DACValue)])
+//Same, but with the active display brightness levels applied, ready for output!
+#define VGA_finalDAC(VGA,DACValue) (VGA->precalcs.finalDAC[(DACValue)])
+//The DAC mode bits the 15/16-bit color cache depends on!
+#define VGA_HIGHCOLORKEY(VGA) ((((uint_32)VGA->precalcs.DACmode)<<16)|VGA->precalcs.effectiveDACmode)
 
 extern GPU_type GPU; //GPU!
 
@@ -179,6 +183,7 @@ OPTINLINE void drawPixel_real(uint_32 pixel, uint_32 x, uint_32 y) //Manual vers
 	{
 		*screenpixel = pixel; //Update whether it's needed or not!
 		GPU.emu_buffer_dirty = 1; //Update, set changed bits when changed!
+		GPU.emu_buffer_capturedirty = 1; //Changed for frame capturing as well!
 	}
 }
 
@@ -209,8 +214,7 @@ OPTINLINE void drawCGALine(VGA_Type *VGA) //Draw the current CGA line to display
 			data = *bufferpos; //Load the current pixel!
 			data &= 3; //Only 2 bits are used for the MDA!
 			data = MDAcolors[data]; //Translate the pixel to proper DAC indexes!
-			color = VGA->precalcs.effectiveMDADAC[data]; //Look up the MDA DAC color to use(translate to RGB)!
-			color = RGB(VGA->DACbrightness[GETR(color)], VGA->DACbrightness[GETG(color)], VGA->DACbrightness[GETB(color)]); //Make sure we're active display levels of brightness!
+			color = VGA->precalcs.finalMDADAC[data]; //Look up the MDA DAC color to use(translate to RGB at active display levels of brightness)!
 			drawPixel_real(color,drawx,VGA->CRTC.y); //Render the pixel as MDA colors through the B/W DAC!
 			++bufferpos; //Next pixel!
 			if (unlikely(bufferpos == finalpos)) break; //Stop processing when finished!
@@ -223,7 +227,7 @@ OPTINLINE void drawCGALine(VGA_Type *VGA) //Draw the current CGA line to display
 		if (unlikely(CGALineSize==0)) return; //Abort if nothing to render!
 		finalpos = &CGAOutputBuffer[CGALineSize]; //End of the output buffer to process!
 		bufferpos = &CGAOutputBuffer[0]; //First pixel to render!
-		RENDER_convertCGAOutput(&CGALineBuffer[0], &CGAOutputBuffer[0], CGALineSize); //Convert the CGA line to RGB output!
+		RENDER_convertCGAOutput(&CGALineBuffer[0], &CGAOutputBuffer[0], CGALineSize, VGA->CRTC.y); //Convert the CGA line to RGB output!
 		drawx = 0; //Start index to draw at!
 		for (;;) //Render all pixels!
 		{
@@ -1246,6 +1250,75 @@ uint_32 getrawVGADACentry(VGA_Type *VGA, byte index)
 	return VGA_DAC(VGA,index); //Give the entry!
 }
 
+OPTINLINE uint_32 VGA_calchighcolorDAC(VGA_Type *VGA, uint_32 lastDACcolor) //Translate a (masked) 15/16-bit pixel to the on-screen color in the current DAC mode!
+{
+	uint_32 DACcolor;
+	if (VGA->precalcs.effectiveDACmode&1) //16-bit color?
+	{
+		DACcolor = CLUT16bit[(lastDACcolor&0xFFFF)]; //Draw the 16-bit color pixel!
+		if (VGA->precalcs.DACmode & 0x40) //LUT enabled?
+		{
+			DACcolor = RGB(
+				((GETR(DACcolor) >> 2) | ((VGA->precalcs.effectiveDACmode >> 1) & 0xC0)), //Red channel!
+				((GETG(DACcolor) >> 2) | ((VGA->precalcs.effectiveDACmode >> 1) & 0xC0)), //Green channel!
+				((GETB(DACcolor) >> 2) | ((VGA->precalcs.effectiveDACmode >> 1) & 0xC0)) //Blue channel!
+				);
+		}
+	}
+	else //15-bit color?
+	{
+		DACcolor = CLUT15bit[(lastDACcolor&0xFFFF)]; //Draw the 15-bit color pixel!
+		if (VGA->precalcs.DACmode & 0x40) //LUT enabled?
+		{
+			DACcolor = RGB(
+				((GETR(DACcolor) >> 2) | ((VGA->precalcs.effectiveDACmode >> 1) & 0xC0)), //Red channel!
+				((GETG(DACcolor) >> 2) | ((VGA->precalcs.effectiveDACmode >> 1) & 0xC0)), //Green channel!
+				((GETB(DACcolor) >> 2) | ((VGA->precalcs.effectiveDACmode >> 1) & 0xC0)) //Blue channel!
+			);
+			if (VGA->precalcs.effectiveDACmode & 0x20) //Extended mode instead of RGB mode?
+			{
+				DACcolor = RGB(
+					(GETR(DACcolor) | ((lastDACcolor >> 15) & 0x01)), //Red channel!
+					(GETG(DACcolor) | ((lastDACcolor >> 15) & 0x01)), //Green channel!
+					(GETB(DACcolor) | ((lastDACcolor >> 15) & 0x01)) //Blue channel!
+				);
+			}
+		}
+		else if (VGA->precalcs.effectiveDACmode & 0x20) //Extended mode instead of RGB mode?
+		{
+			//LUT is disabled!
+			DACcolor = RGB(
+				(GETR(DACcolor) | ((lastDACcolor >> 13) & 0x04)), //Red channel!
+				(GETG(DACcolor) | ((lastDACcolor >> 13) & 0x04)), //Green channel!
+				(GETB(DACcolor) | ((lastDACcolor >> 13) & 0x04)) //Blue channel!
+				);
+		}
+	}
+	//Final step in the translation to the on-screen color: LUT itself and final color conversion if required!
+	if (VGA->precalcs.DACmode & 0x40) //LUT enabled?
+	{
+		DACcolor = RGB(
+			GETR(getrawVGADACentry(VGA,GETR(DACcolor))), //Red channel!
+			GETG(getrawVGADACentry(VGA,GETG(DACcolor))), //Green channel!
+			GETB(getrawVGADACentry(VGA,GETB(DACcolor))) //Blue channel!
+		); //Translate through DAC!
+	}
+	DACcolor = GA_color2bw(DACcolor, ((VGA->precalcs.DACmode & 0x1000)>>12)); //Apply the finished color! Use RGBA instead of RGB when specified!
+	return RGBA(VGA->DACbrightness[GETR(DACcolor)], VGA->DACbrightness[GETG(DACcolor)], VGA->DACbrightness[GETB(DACcolor)],GETA(DACcolor)); //Make sure we're active display levels of brightness!
+}
+
+void VGA_updatehighcolorDAC(VGA_Type *VGA) //Rebuild the 15/16-bit color cache for the current DAC mode, DAC entries and color settings!
+{
+	INLINEREGISTER uint_32 color;
+	for (color=0;color<0x10000;++color) //Process all pixel values!
+	{
+		VGA->highcolorDAC[color] = VGA_calchighcolorDAC(VGA,color); //Translate this pixel value!
+	}
+	VGA->highcolorDACkey = VGA_HIGHCOLORKEY(VGA); //What mode we're built for!
+	VGA->highcolorDACvalid = 1; //We're valid now!
+	++VGA->DACcache_rebuilds; //Count the rebuild!
+}
+
 byte EGA_SyncPolarityConversion[2][0x40] = {
 		{ //Positive VSync (cleared)
 		0x00,0x01,0x02,0x03,0x04,0x05,0x14,0x07,0x08,0x09,0x0A,0x0B,0x0C,0x0D,0x0E,0x0F, //Direct map 00-0F
@@ -1387,48 +1460,15 @@ void VGA_ActiveDisplay_noblanking_VGA(VGA_Type *VGA, SEQ_DATA *Sequencer, VGA_At
 			}
 			DACcolor = RGB(((Sequencer->lastDACcolor>>16)&0xFF),((Sequencer->lastDACcolor>>8)&0xFF),(Sequencer->lastDACcolor&0xFF)); //Draw the 24BPP color pixel!
 		}
-		else if (VGA->precalcs.effectiveDACmode&1) //16-bit color?
+		else //15/16-bit color?
 		{
 			Sequencer->lastDACcolor &= getActiveVGA()->precalcs.SC15025_pixelmaskregister; //Apply the pixel mask!
-			DACcolor = CLUT16bit[(Sequencer->lastDACcolor&0xFFFF)]; //Draw the 16-bit color pixel!
-			if (VGA->precalcs.DACmode & 0x40) //LUT enabled?
+			if (unlikely((VGA->highcolorDACvalid==0) || (VGA->highcolorDACkey!=VGA_HIGHCOLORKEY(VGA)))) //High color cache outdated?
 			{
-				DACcolor = RGB(
-					((GETR(DACcolor) >> 2) | ((VGA->precalcs.effectiveDACmode >> 1) & 0xC0)), //Red channel!
-					((GETG(DACcolor) >> 2) | ((VGA->precalcs.effectiveDACmode >> 1) & 0xC0)), //Green channel!
-					((GETB(DACcolor) >> 2) | ((VGA->precalcs.effectiveDACmode >> 1) & 0xC0)) //Blue channel!
-					);
-			}
-		}
-		else //15-bit color?
-		{
-			Sequencer->lastDACcolor &= getActiveVGA()->precalcs.SC15025_pixelmaskregister; //Apply the pixel mask!
-			DACcolor = CLUT15bit[(Sequencer->lastDACcolor&0xFFFF)]; //Draw the 15-bit color pixel!
-			if (VGA->precalcs.DACmode & 0x40) //LUT enabled?
-			{
-				DACcolor = RGB(
-					((GETR(DACcolor) >> 2) | ((VGA->precalcs.effectiveDACmode >> 1) & 0xC0)), //Red channel!
-					((GETG(DACcolor) >> 2) | ((VGA->precalcs.effectiveDACmode >> 1) & 0xC0)), //Green channel!
-					((GETB(DACcolor) >> 2) | ((VGA->precalcs.effectiveDACmode >> 1) & 0xC0)) //Blue channel!
-				);
-				if (VGA->precalcs.effectiveDACmode & 0x20) //Extended mode instead of RGB mode?
-				{
-					DACcolor = RGB(
-						(GETR(DACcolor) | ((Sequencer->lastDACcolor >> 15) & 0x01)), //Red channel!
-						(GETG(DACcolor) | ((Sequencer->lastDACcolor >> 15) & 0x01)), //Green channel!
-						(GETB(DACcolor) | ((Sequencer->lastDACcolor >> 15) & 0x01)) //Blue channel!
-					);
-				}
-			}
-			else if (VGA->precalcs.effectiveDACmode & 0x20) //Extended mode instead of RGB mode?
-			{
-				//LUT is disabled!
-				DACcolor = RGB(
-					(GETR(DACcolor) | ((Sequencer->lastDACcolor >> 13) & 0x04)), //Red channel!
-					(GETG(DACcolor) | ((Sequencer->lastDACcolor >> 13) & 0x04)), //Green channel!
-					(GETB(DACcolor) | ((Sequencer->lastDACcolor >> 13) & 0x04)) //Blue channel!
-					);
+				VGA_updatehighcolorDAC(VGA); //Rebuild the high color cache!
 			}
+			DACcolor = VGA->highcolorDAC[(Sequencer->lastDACcolor&0xFFFF)]; //Draw the 15/16-bit color pixel, translated through the LUT and at active display levels of brightness!
+			goto finishedcolor; //The color is finished!
 		}
 		//Final step in the translation to the on-screen color: LUT itself and final color conversion if required!
 		if (VGA->precalcs.DACmode & 0x40) //LUT enabled?
@@ -1440,12 +1480,13 @@ void VGA_ActiveDisplay_noblanking_VGA(VGA_Type *VGA, SEQ_DATA *Sequencer, VGA_At
 			); //Translate through DAC!
 		}
 		DACcolor = GA_color2bw(DACcolor, ((VGA->precalcs.DACmode & 0x1000)>>12)); //Apply the finished color! Use RGBA instead of RGB when specified!
+		DACcolor = RGBA(VGA->DACbrightness[GETR(DACcolor)], VGA->DACbrightness[GETG(DACcolor)], VGA->DACbrightness[GETB(DACcolor)],GETA(DACcolor)); //Make sure we're active display levels of brightness!
 	}
 	else //VGA compatibility mode? 8-bit color!
 	{
 		if (VGA->precalcs.EGA_DisableInternalVideoDrivers) //Special case: internal video drivers disabled?
 		{
-			DACcolor = VGA_DAC(VGA,VGA->CRTC.DACOutput = (VGA->registers->ExternalRegisters.FEATURECONTROLREGISTER&3)); //The FEAT0 and FEAT1 outputs become the new output!
+			DACcolor = VGA_finalDAC(VGA,VGA->CRTC.DACOutput = (VGA->registers->ExternalRegisters.FEATURECONTROLREGISTER&3)); //The FEAT0 and FEAT1 outputs become the new output!
 		}
 		else
 		{
@@ -1455,12 +1496,11 @@ void VGA_ActiveDisplay_noblanking_VGA(VGA_Type *VGA, SEQ_DATA *Sequencer, VGA_At
 			{
 				DACcolor = EGA_SyncPolarityConversion[GETBITS(getActiveVGA()->registers->ExternalRegisters.MISCOUTPUTREGISTER, 7, 1)][(DACcolor & 0x3F)]; //Process EGA VSync polarity required for correct colors to be createn by the display!
 			}
-			DACcolor = VGA_DAC(VGA,(byte)DACcolor); //Render through the 8-bit DAC!
+			DACcolor = VGA_finalDAC(VGA,(byte)DACcolor); //Render through the 8-bit DAC at active display levels of brightness!
 		}
 	}
 
-	DACcolor = RGBA(VGA->DACbrightness[GETR(DACcolor)], VGA->DACbrightness[GETG(DACcolor)], VGA->DACbrightness[GETB(DACcolor)],GETA(DACcolor)); //Make sure we're active display levels of brightness!
-
+	finishedcolor: //The color is finished!
 	if (VGA->precalcs.turnDACoff) //Turning the DAC off?
 	{
 		DACcolor = RGB(0x00, 0x00, 0x00); //No output on the DAC!
@@ -1523,8 +1563,7 @@ void VGA_Overscan_noblanking_VGA(VGA_Type *VGA, SEQ_DATA *Sequencer, VGA_Attribu
 			{
 				DACcolor = EGA_SyncPolarityConversion[GETBITS(getActiveVGA()->registers->ExternalRegisters.MISCOUTPUTREGISTER, 7, 1)][(DACcolor & 0x3F)]; //Process EGA VSync polarity required for correct colors to be createn by the display!
 			}
-			DACcolor = VGA_DAC(VGA, (byte)DACcolor); //What color to render?
-			DACcolor = RGB(VGA->DACbrightness[GETR(DACcolor)], VGA->DACbrightness[GETG(DACcolor)], VGA->DACbrightness[GETB(DACcolor)]); //Make sure we're active display levels of brightness!
+			DACcolor = VGA_finalDAC(VGA, (byte)DACcolor); //What color to render at active display levels of brightness?
 			drawPixel(VGA, DACcolor); //Draw overscan in the specified color instead!
 		}
 	}
@@ -1542,8 +1581,7 @@ void VGA_Overscan_noblanking_VGA(VGA_Type *VGA, SEQ_DATA *Sequencer, VGA_Attribu
 			{
 				DACcolor = EGA_SyncPolarityConversion[GETBITS(getActiveVGA()->registers->ExternalRegisters.MISCOUTPUTREGISTER, 7, 1)][(DACcolor & 0x3F)]; //Process EGA VSync polarity required for correct colors to be createn by the display!
 			}
-			DACcolor = VGA_DAC(VGA, (byte)DACcolor); //Draw overscan!
-			DACcolor = RGB(VGA->DACbrightness[GETR(DACcolor)], VGA->DACbrightness[GETG(DACcolor)], VGA->DACbrightness[GETB(DACcolor)]); //Make sure we're active display levels of brightness!
+			DACcolor = VGA_finalDAC(VGA, (byte)DACcolor); //Draw overscan at active display levels of brightness!
 			drawPixel(VGA, DACcolor); //Draw overscan in the specified color instead!
 		}
 	}
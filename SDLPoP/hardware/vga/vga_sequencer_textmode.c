@@ -83,31 +83,10 @@ extern LOADEDPLANESCONTAINER loadedplaneshigh; //All read planes for the current
 
 byte charxbuffer[256]; //Full character inner x location!
 
-OPTINLINE word getcharrow(VGA_Type *VGA, byte attribute3, byte character, byte y) //Retrieve a characters y row on/off from table!
-{
-	static word lastrow; //Last retrieved character row data!
-	static word lastcharinfo = 0; //attribute|character|row|1, bit0=Set?
-	INLINEREGISTER word lastlookup;
-	INLINEREGISTER word charloc;
-	lastlookup = (((((character << 1) | attribute3) << 5) | y) ^ 0x8000); //The last lookup!
-	if (unlikely(lastcharinfo != lastlookup)) //Row not yet loaded?
-	{
-		charloc = character; //Character position!
-		charloc <<= 5;
-		charloc |= y;
-		charloc <<= 1;
-		charloc |= attribute3;
-		lastrow = VGA->getcharxy_values[charloc]; //Lookup the new row!
-		lastcharinfo = lastlookup; //Save the loaded row as the current row!
-	}
-
-	return lastrow; //Give row!
-}
-
 void VGA_TextDecoder(VGA_Type *VGA, word loadedlocation)
 {
-	INLINEREGISTER byte x, attr3;
-	INLINEREGISTER word charrow; //The row read!
+	INLINEREGISTER byte attr3;
+	INLINEREGISTER word charloc; //The glyph cache row to use!
 	//We do nothing: text mode uses multiple planes at the same time!
 	character = loadedplanes.splitplanes[0]|(loadedplaneshigh.splitplanes[0]<<8); //Character!
 	attribute = loadedplanes.splitplanes[1]<<VGA_SEQUENCER_ATTRIBUTESHIFT; //Attribute!
@@ -156,21 +135,19 @@ void VGA_TextDecoder(VGA_Type *VGA, word loadedlocation)
 		attr3 = (byte)(attribute>>VGA_SEQUENCER_ATTRIBUTESHIFT); //Load the attribute byte itself!
 		attr3 >>= 3; //...
 		attr3 &= 1; //... Take bit 3 to get the actual attribute we need!
-		x = 0; //Start with the first pixel!
 		if (likely((character & 0xFF00) == 0)) //Compatible VGA-character(English character as the ET4000 manual states it, always true for VGA)? Fetch from DRAM!
 		{
-			charrow = getcharrow(VGA, attr3, (byte)character, ((SEQ_DATA*)VGA->Sequencer)->charinner_y); //Read the current row to use!
+			charloc = (byte)character; //Character position!
+			charloc <<= 5;
+			charloc |= ((SEQ_DATA*)VGA->Sequencer)->charinner_y; //The current row to use!
+			charloc <<= 1;
+			charloc |= attr3;
+			memcpy(&characterpixels[0],&VGA->getcharxy_pixels[charloc][0],sizeof(characterpixels)); //Copy the already expanded row from the glyph cache!
 		}
 		else //Non-English character as the ET4000 manual states it(appendix 6.1) are fetched through some external EPROMs. English characters(index<=0xFF?) are handled normally through the DRAM font(normal VGA lookup)
 		{
-			charrow = 0; //We don't have an external ROM, so simply give no character data!
+			memset(&characterpixels[0],0,sizeof(characterpixels)); //We don't have an external ROM, so simply give no character data!
 		}
-		attr3 = 16; //How far to go?
-		do //Process all coordinates of our row!
-		{
-			characterpixels[x++] = (charrow&1); //Read current coordinate!
-			charrow >>= 1; //Shift to the next pixel!
-		} while (likely(--attr3)); //Loop while anything left!
 
 		if (VGA->precalcs.textcharacterwidth == 9) //What width? 9 wide?
 		{
@@ -41,6 +41,21 @@ OPTINLINE byte reverse8_VGA(byte b) { //Reverses byte value bits!
 	return temp; //Give the result!
 }
 
+OPTINLINE void expandgetcharxy_pixels(VGA_Type *VGA, word precalcposition) //Expand a font row into the glyph cache used by the text renderer!
+{
+	INLINEREGISTER word charrow; //The row to expand!
+	INLINEREGISTER byte x;
+	byte *pixels;
+	charrow = VGA->getcharxy_values[precalcposition]; //The row to expand!
+	pixels = &VGA->getcharxy_pixels[precalcposition][0]; //Where to expand to!
+	x = 16; //How far to go?
+	do //Process all coordinates of our row!
+	{
+		*pixels++ = (charrow&1); //Font/back pixel!
+		charrow >>= 1; //Shift to the next pixel!
+	} while (likely(--x)); //Loop while anything left!
+}
+
 OPTINLINE void fillgetcharxy_values(VGA_Type *VGA, int_32 address)
 {
 	byte attribute = 0; //0 or 1 (bit value 0x4 of the attribute, 1 bit)!
@@ -104,6 +119,7 @@ OPTINLINE void fillgetcharxy_values(VGA_Type *VGA, int_32 address)
 				{
 					getcharxy_values[precalcposition] |= ((reverse8_VGA(readVRAMplane(VGA, 3, characterset_offset, 0,0)))<<8); //Read the row from the character generator! Don't do anything special, just because we're from the renderer! Also reverse the data in the byte for a little speedup! Store the row for the character generator!
 				}
+				expandgetcharxy_pixels(VGA,precalcposition); //Update the glyph cache with the new row!
 				if (likely(singlerow!=-1)) goto nextattr; //Don't change the row if a single line is updated!
 				++y; //Next row!
 			}
@@ -36,5 +36,6 @@ FILEPOS cueimage_getsize(char *filename);
 //Results of the below functions: -1: Sector not found, 0: Error, 1: Aborted(no buffer), 2+CDROM_MODES: Read a sector of said mode + 2.
 int_64 cueimage_readsector(int device, byte M, byte S, byte F, void *buffer, word size); //Read a n-byte sector! Result=Type on success, 0 on error, -1 on not found!
 int_64 cueimage_getgeometry(int device, byte *M, byte *S, byte *F, byte *startM, byte *startS, byte *startF, byte *endM, byte *endS, byte *endF, byte specialfeatures); //Result=Type on success, 0 on error, -1 on not found!
+void cueimage_invalidate(int device); //Discard the parsed cue sheet of a device, when (re)mounting it!
 
 #endif
@@ -0,0 +1,43 @@
+/*
+
+Copyright (C) 2019 - 2021 Superfury
+
+This file is part of UniPCemu.
+
+UniPCemu is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+UniPCemu is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with UniPCemu.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DISKWORKER_H
+#define DISKWORKER_H
+
+#include "headers/types.h" //Type definitions!
+
+//Maximum size of a single read-ahead or posted write!
+#define DISKWORKER_BLOCKSIZE 0x20000
+
+void startDiskWorker(); //Start the disk I/O worker thread, if possible!
+void doneDiskWorker(); //Flush all posted writes and stop the disk I/O worker thread!
+
+void diskworker_readahead(int device, uint_64 startpos, uint_32 bytestoread); //Start reading data we're going to need in the background!
+byte diskworker_read(int device, void *buffer, uint_64 startpos, uint_32 bytestoread); //Read data, using read-ahead data when available. Stalls when it's still being read!
+byte diskworker_write(int device, void *buffer, uint_64 startpos, uint_32 bytestowrite); //Post a write to be written in the background (write-behind)!
+byte diskworker_flush(int device); //Wait for all posted writes of a device (-1 for all devices) to be written! Result: 0 when a posted write has failed!
+void diskworker_invalidate(int device); //Discard any read-ahead data of a device, including custom disks reading from it!
+
+//Support for basic I/O! Direct accesses sync before taking the I/O lock!
+void diskworker_sync(int device); //Wait for all posted writes of a device to be written, keeping errors for the next flush!
+void diskworker_lockIO(); //Lock the disk images for I/O!
+void diskworker_unlockIO(); //Unlock the disk images for I/O!
+
+#endif
@@ -64,6 +64,8 @@ void iocdrom0(char *filename, uint_64 startpos, byte readonly, uint_32 customsiz
 void iocdrom1(char *filename, uint_64 startpos, byte readonly, uint_32 customsize);
 byte readdata(int device, void *buffer, uint_64 startpos, uint_32 bytestoread);
 byte writedata(int device, void *buffer, uint_64 startpos, uint_32 bytestowrite);
+byte readdata_direct(int device, void *buffer, uint_64 startpos, uint_32 bytestoread); //Read without the disk worker!
+byte writedata_direct(int device, void *buffer, uint_64 startpos, uint_32 bytestowrite); //Write without the disk worker!
 byte is_mounted(int drive); //Have drive?
 byte drivereadonly(int drive); //Drive is read-only?
 byte drivewritereadonly(int drive); //After a write, were we read-only?
@@ -70,4 +70,11 @@ void updateCPL(); //Update the CPL to be the currently loaded CPL depending on t
 void CPU_calcSegmentPrecalcsPrecalcs(); //Calculatet the segment precalcs precalcs!
 void CPU_calcSegmentPrecalcs(byte is_CS, SEGMENT_DESCRIPTOR *descriptor);
 int getLoadedTYPE(SEGMENT_DESCRIPTOR *loadeddescriptor);
+
+//Descriptor cache support!
+void CPU_flushDescriptorCache(); //Flush the descriptor cache of the active CPU(LGDT/LLDT/task switch/paging changes)!
+void CPU_flushAllDescriptorCaches(); //Flush the descriptor caches of all CPUs(physical memory layout changes)!
+void CPU_descriptorCacheMemoryWritten(uint_64 address); //Memory within the watched range has been written!
+extern uint_64 CPU_descriptorcache_watchlow; //Lowest physical address shadowed by the descriptor caches!
+extern uint_64 CPU_descriptorcache_watchhigh; //Highest physical address shadowed by the descriptor caches!
 #endif
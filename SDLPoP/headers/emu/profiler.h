@@ -0,0 +1,94 @@
+/*
+
+Copyright (C) 2019 - 2021 Superfury
+
+This file is part of UniPCemu.
+
+UniPCemu is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+UniPCemu is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with UniPCemu.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "headers/types.h" //Basic types!
+
+//Enable the device profiler? When disabled, it's compiled out of the core handler entirely!
+//#define DEVICE_PROFILER
+
+//Sample one out of this many core handler steps!
+#define PROFILER_SAMPLEINTERVAL 64
+//Laps taking longer than this many ns are discarded, since they're the host preempting us!
+#define PROFILER_MAXLAP 1000000.0
+//Amount of entries to show in the framerate display!
+#define PROFILER_SHOWENTRIES 4
+//Row of the framerate display to show the entries on!
+#define PROFILER_ROW 3
+
+//All profiled devices! The CPU step contains everything up to the first device!
+#define PROFILE_CPU 0
+#define PROFILE_APIC 1
+#define PROFILE_DMA 2
+#define PROFILE_PIT 3
+#define PROFILE_ADLIB 4
+#define PROFILE_MOUSE 5
+#define PROFILE_DRO 6
+#define PROFILE_MIDIPLAYER 7
+#define PROFILE_PS2KEYBOARD 8
+#define PROFILE_PS2MOUSE 9
+#define PROFILE_8042 10
+#define PROFILE_CMOS 11
+#define PROFILE_FLOPPY 12
+#define PROFILE_MPU 13
+#define PROFILE_GAMEBLASTER 14
+#define PROFILE_SOUNDBLASTER 15
+#define PROFILE_ATA 16
+#define PROFILE_PARALLEL 17
+#define PROFILE_UART 18
+#define PROFILE_SSOURCE 19
+#define PROFILE_VGA 20
+#define PROFILE_MODEM 21
+#define PROFILE_JOYSTICK 22
+#define PROFILE_AUDIO 23
+#define PROFILE_BIOSROM 24
+#define PROFILE_PPI 25
+#define PROFILE_CORE 26
+#define NUMPROFILES 27
+
+#ifdef DEVICE_PROFILER
+#include "headers/emu/gpu/gpu_text.h" //Text surface support!
+
+extern byte profiler_sampling; //Are we sampling the current step?
+extern byte profiler_countdown; //Steps left until the next sampled step!
+
+void initProfiler(); //Start profiling!
+void doneProfiler(); //Stop profiling!
+void profiler_startstep(); //Start a sampled step!
+void profiler_mark(byte device); //The device has finished in the sampled step!
+void profiler_render(GPU_TEXTSURFACE *surface, int row); //Show the top entries of the last second!
+
+//Start of a core handler step!
+#define PROFILER_BEGINSTEP() do { if (unlikely(--profiler_countdown==0)) profiler_startstep(); else profiler_sampling = 0; } while (0)
+//The device has just finished running!
+#define PROFILER_MARK(device) do { if (unlikely(profiler_sampling)) profiler_mark(device); } while (0)
+#define PROFILER_INIT() initProfiler()
+#define PROFILER_DONE() doneProfiler()
+#else
+//Compiled out!
+#define PROFILER_BEGINSTEP()
+#define PROFILER_MARK(device)
+#define PROFILER_INIT()
+#define PROFILER_DONE()
+#endif
+
+#endif
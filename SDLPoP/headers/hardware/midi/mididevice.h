@@ -133,6 +133,7 @@ typedef struct
 typedef struct
 {
 	int_64 play_counter; //Current play position within the soundfont!
+	sword readsample[2]; //The last samples retrieved from the soundfont!
 	int_64 monotonecounter[CHORUSSIZE]; //Monotonic counter for positive only for each chorus channel!
 	float monotonecounter_diff[CHORUSSIZE]; //Diff counter for each chorus channel!
 	uint_32 loopsize[2]; //The size of a loop!
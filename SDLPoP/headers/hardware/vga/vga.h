@@ -374,6 +374,7 @@ typedef struct
 	uint_32 ExpandTable[256]; //Expand Table (originally 32-bit) for VRAM read and write by CPU!
 	uint_32 FillTable[16]; //Fill table for memory writes!
 	word getcharxy_values[0x4000]; //All getcharxy values!
+	byte getcharxy_pixels[0x4000][16]; //All getcharxy values, expanded into a font/back pixel per column for the text renderer!
 	byte blink8; //Blink rate 8 frames?
 	byte blink16; //Blink rate 16 frames?
 	byte blink32; //Blink rate 32 frames?
@@ -406,6 +407,14 @@ typedef struct
 	uint_32 SVGAExtension_size; //The size of the SVGA extension data, if any!
 	byte enable_SVGA; //Enable SVGA? If >0, a SVGA extension is enabled. Then initialize it as needed!
 	byte DACbrightness[0x100]; //All 256 levels of brightness for active display DAC!
+	//Final color cache of the 15/16-bit DAC modes!
+	uint_32 highcolorDAC[0x10000]; //Final output color of every 15/16-bit pixel value in the current DAC mode!
+	uint_32 highcolorDACkey; //The DAC mode the high color cache has been built for!
+	byte highcolorDACvalid; //Is the high color cache valid? Cleared when any input it's built from changes!
+	uint_32 DACcache_entryupdates; //Number of single DAC entries updated this frame!
+	uint_32 DACcache_rebuilds; //Number of high color cache rebuilds this frame!
+	uint_32 DACcache_lastentryupdates; //Number of single DAC entries updated during the last frame!
+	uint_32 DACcache_lastrebuilds; //Number of high color cache rebuilds during the last frame!
 } VGA_Type; //VGA dataset!
 
 typedef DOUBLE (*VGA_clockrateextensionhandler)(VGA_Type *VGA); //The clock rate extension handler!
@@ -23,7 +23,7 @@ along with UniPCemu.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "headers/types.h" //Basic types!
 
-void RENDER_convertCGAOutput(byte *pixels, uint_32 *renderdestination, uint_32 size); //Convert a row of data to NTSC output!
+void RENDER_convertCGAOutput(byte *pixels, uint_32 *renderdestination, uint_32 size, word scanline); //Convert a row of data to NTSC output! Scanline is the row on the display!
 void RENDER_updateCGAColors(); //Update CGA rendering NTSC vs RGBI conversion!
 
 #endif
\ No newline at end of file
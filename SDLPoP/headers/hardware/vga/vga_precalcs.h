@@ -87,6 +87,8 @@ typedef struct //Contains the precalculated values!
 	uint_32 DAC[0x100]; //Full DAC saved lookup table!
 	uint_32 effectiveDAC[0x100]; //The same DAC as above, but with color conversions applied for rendering!
 	uint_32 effectiveMDADAC[0x100]; //The same DAC as above, but with b/w conversions applied for rendering, also it's index is changed to the R/G/B 256-color greyscale index!
+	uint_32 finalDAC[0x100]; //The effective DAC with the active display brightness levels applied, ready for output!
+	uint_32 finalMDADAC[0x100]; //The effective MDA DAC with the active display brightness levels applied, ready for output!
 	//Attribute controller precalcs!
 	byte attributeprecalcs[0x8000]; //All attribute precalcs!
 
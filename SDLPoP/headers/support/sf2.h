@@ -316,6 +316,24 @@ Different sample modes:
 #define GEN_SAMPLEMODES_NOLOOP2 2
 #define GEN_SAMPLEMODES_LOOPUNTILDEPRESSDONE 3
 
+//Precompiled zone flags!
+#define SF2ZONE_VALID 1
+#define SF2ZONE_GLOBAL 2
+#define SF2ZONE_MODLOOKUP 4
+
+//A precompiled preset/instrument zone(bag), built once when loading the soundfont! Don't pack this structure: it's used for fast lookups!
+typedef struct
+{
+	uint_32 owner; //The preset/instrument owning this zone! 0xFFFFFFFF=Not owned!
+	byte flags; //SF2ZONE_* flags of this zone!
+	word firstmod, endmod; //Modulator range of the zone!
+	uint_64 genfound; //Bit set for each generator found in the zone!
+	sfGenList gen[endOper]; //The generators found in the zone!
+} SF2COMPILEDZONE;
+
+//Preset lookup entry that's not found!
+#define SF2_NOPRESET 0xFFFFFFFF
+
 //Don't pack this structure: we will need to speed up this part as much as possible for rendering speedup!
 typedef struct
 {
@@ -341,6 +359,13 @@ typedef struct
 	RIFF_ENTRY shdr; //SHDR block!
 	RIFF_ENTRY pcmdata; //16-bit (SMPL) audio entry!
 	RIFF_ENTRY pcm24data; //24-bit (SMPL) audio extension of 16-bit audio entry!
+
+	//Precompiled zone lookup speedup!
+	uint_32 pbagcount; //Number of precompiled preset zones!
+	SF2COMPILEDZONE *pbags; //Precompiled preset zones!
+	uint_32 ibagcount; //Number of precompiled instrument zones!
+	SF2COMPILEDZONE *ibags; //Precompiled instrument zones!
+	uint_32 *presetlookup; //Preset by bank(0-128) and program(0-127), SF2_NOPRESET when not found!
 } RIFFHEADER; //RIFF data header!
 
 //Basic open/close functions for soundfonts!
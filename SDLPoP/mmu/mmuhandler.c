@@ -35,6 +35,7 @@ along with UniPCemu.  If not, see <https://www.gnu.org/licenses/>.
 #include "headers/hardware/pic.h" //APIC support!
 #include "headers/cpu/cpu.h" //Emulated CPU support!
 #include "headers/emu/emu_misc.h" //For 128-bit shifting support!
+#include "headers/cpu/protection.h" //Descriptor cache support!
 
 extern BIOS_Settings_TYPE BIOS_Settings; //Settings!
 
@@ -1113,6 +1114,10 @@ OPTINLINE void MMU_INTERNAL_directwb(uint_64 realaddress, byte value, word index
 	uint_64 originaladdress = realaddress; //Original address!
 	//Apply the 640K memory hole!
 	byte nonexistant = 0;
+	if (unlikely((originaladdress<=CPU_descriptorcache_watchhigh) && ((originaladdress+3)>=CPU_descriptorcache_watchlow))) //Written to a descriptor that's cached(up to a dword written)?
+	{
+		CPU_descriptorCacheMemoryWritten(originaladdress); //Invalidate the descriptor caches that shadow it!
+	}
 	if (unlikely(emulateCompaqMMURegisters && (is_i430fx==0) && (realaddress==0x80C00000))) //Compaq special register?
 	{
 		writeCompaqMMUregister((uint_32)originaladdress, value); //Update the Compaq MMU register!
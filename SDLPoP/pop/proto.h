@@ -643,6 +643,7 @@ void load_dos_exe_modifications(const char* folder_name);
 // REPLAY.C
 #ifdef USE_REPLAY
 void start_with_replay_file(const char *filename);
+void validate_replays_batch(const char* source);
 void init_record_replay();
 void replay_restore_level();
 int restore_savestate_from_buffer();
@@ -655,6 +656,7 @@ void do_replay_move();
 int save_recorded_replay_dialog();
 int save_recorded_replay(const char* full_filename);
 void replay_cycle();
+void replay_checkpoint_tick();
 int load_replay();
 void key_press_while_recording(int* key_ptr);
 void key_press_while_replaying(int* key_ptr);
@@ -61,9 +61,30 @@ dword savestate_offset = 0;
 dword savestate_size = 0;
 #define MAX_SAVESTATE_SIZE 4096
 
+// In-memory savestates taken while replaying, so seeking doesn't have to simulate every tick in between.
+// When all slots are used, every other checkpoint is dropped and the interval is doubled, so memory stays bounded.
+#define MAX_REPLAY_CHECKPOINTS 256
+#define REPLAY_CHECKPOINT_INTERVAL 240 // ticks (20 seconds)
+#define REPLAY_STEP_TICKS 60 // ticks to step back or forward with the [ and ] keys (5 seconds)
+
+typedef struct replay_checkpoint_type {
+	dword tick;
+	short level;
+	short room;
+	dword size;
+	byte data[MAX_SAVESTATE_SIZE];
+} replay_checkpoint_type;
+
+replay_checkpoint_type* replay_checkpoints = NULL;
+int num_replay_checkpoints = 0;
+dword replay_checkpoint_interval = REPLAY_CHECKPOINT_INTERVAL;
+dword replay_seek_tick = 0; // target of replay_seek_3_tick
+byte need_replay_checkpoint_seek = 0; // set by the seek keys, handled at the start of the next frame
+
 // These are defined in seg000.c:
 typedef int process_func_type(void* data, size_t data_size);
 extern int quick_process(process_func_type process_func);
+extern int quick_process_ex(process_func_type process_func, int allow_level_skip);
 extern const char quick_version[9];
 
 // header information read from the first part of a replay file
@@ -310,6 +331,184 @@ void start_with_replay_file(const char *filename) {
 	}
 }
 
+// Batch validation: each replay is validated by a child process running in 'validate' mode,
+// because the game state is global. Up to 'batch_jobs' children run concurrently.
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+typedef struct batch_replay_result_type {
+	char filename[POP_MAX_PATH];
+	int has_result; // 0 if the child did not print a result (invalid replay, crash)
+	int level;
+	int room;
+	int ticks;
+	int replay_ticks;
+	int alive;
+	double milliseconds;
+} batch_replay_result_type;
+
+typedef struct batch_validation_type {
+	batch_replay_result_type* results;
+	int num_results;
+	SDL_atomic_t next_result; // next replay to be picked up by a worker
+} batch_validation_type;
+
+static void batch_add_replay(batch_validation_type* batch, size_t* max_results, const char* filename) {
+	if (filename[0] == '\0') return;
+	if ((size_t) batch->num_results >= *max_results) {
+		batch_replay_result_type* results = realloc(batch->results, (*max_results + 128) * sizeof(batch_replay_result_type));
+		if (results == NULL) {
+			fprintf(stderr, "Out of memory, skipping %s\n", filename);
+			return;
+		}
+		batch->results = results;
+		*max_results += 128;
+	}
+	batch_replay_result_type* result = &batch->results[batch->num_results++];
+	memset(result, 0, sizeof(batch_replay_result_type));
+	snprintf_check(result->filename, sizeof(result->filename), "%s", filename);
+}
+
+// The source is either a folder containing .p1r files, or a text file listing one replay per line.
+static void batch_list_replays(batch_validation_type* batch, const char* source) {
+	size_t max_results = 0;
+	char filename[POP_MAX_PATH];
+	directory_listing_type* directory_listing = create_directory_listing_and_find_first_file(source, "p1r");
+	if (directory_listing != NULL) {
+		do {
+			snprintf_check(filename, sizeof(filename), "%s/%s", source,
+			               get_current_filename_from_directory_listing(directory_listing));
+			batch_add_replay(batch, &max_results, filename);
+		} while (find_next_file(directory_listing));
+		close_directory_listing(directory_listing);
+		return;
+	}
+	FILE* list_fp = fopen(source, "r");
+	if (list_fp == NULL) return;
+	while (fgets(filename, sizeof(filename), list_fp) != NULL) {
+		filename[strcspn(filename, "\r\n")] = '\0';
+		batch_add_replay(batch, &max_results, filename);
+	}
+	fclose(list_fp);
+}
+
+// Quotes an argument for the shell that popen() runs. Returns 0 if it doesn't fit, or can't be quoted safely.
+static int batch_quote_argument(char* buffer, size_t size, const char* argument) {
+	size_t length = 0;
+#ifdef _WIN32
+	// cmd.exe has no way to escape a quote inside a quoted argument, and expands %variables% inside quotes.
+	if (strpbrk(argument, "\"%") != NULL) return 0;
+	if (strlen(argument) + 3 > size) return 0;
+	snprintf(buffer, size, "\"%s\"", argument);
+#else
+	// Inside single quotes, nothing is special except the single quote itself, which becomes '\''.
+	if (size < 3) return 0;
+	buffer[length++] = '\'';
+	for (; *argument != '\0'; ++argument) {
+		if (*argument == '\'') {
+			if (length + 4 >= size - 1) return 0;
+			memcpy(&buffer[length], "'\\''", 4);
+			length += 4;
+		} else {
+			if (length + 1 >= size - 1) return 0;
+			buffer[length++] = *argument;
+		}
+	}
+	buffer[length++] = '\'';
+	buffer[length] = '\0';
+#endif
+	return 1;
+}
+
+static void batch_validate_replay(batch_replay_result_type* result) {
+	char command[POP_MAX_PATH * 5];
+	char program[POP_MAX_PATH * 2];
+	char filename[POP_MAX_PATH * 2];
+	char line[512];
+	Uint64 start_counter = SDL_GetPerformanceCounter();
+	if (!batch_quote_argument(program, sizeof(program), g_argv[0]) ||
+	    !batch_quote_argument(filename, sizeof(filename), result->filename)) {
+		fprintf(stderr, "Can't pass %s to a validate process, skipping it\n", result->filename);
+		return;
+	}
+	snprintf_check(command, sizeof(command), "%s validate %s", program, filename);
+	FILE* child_fp = popen(command, "r");
+	if (child_fp != NULL) {
+		while (fgets(line, sizeof(line), child_fp) != NULL) {
+			if (sscanf(line, "VALIDATE_RESULT level=%d room=%d ticks=%d replay_ticks=%d alive=%d",
+			           &result->level, &result->room, &result->ticks, &result->replay_ticks, &result->alive) == 5) {
+				result->has_result = 1;
+			}
+		}
+		pclose(child_fp);
+	}
+	result->milliseconds = (double) (SDL_GetPerformanceCounter() - start_counter) * 1000.0 / (double) SDL_GetPerformanceFrequency();
+}
+
+static int SDLCALL batch_validation_worker(void* data) {
+	batch_validation_type* batch = (batch_validation_type*) data;
+	for (;;) {
+		int index = SDL_AtomicAdd(&batch->next_result, 1);
+		if (index >= batch->num_results) break;
+		batch_validate_replay(&batch->results[index]);
+	}
+	return 0;
+}
+
+// Called in pop_main() for the 'batchvalidate' command-line parameter, before video and audio are initialized.
+// Prints one CSV line per replay, and exits with status 1 if any replay failed or did not match its length.
+void validate_replays_batch(const char* source) {
+	batch_validation_type batch = {0};
+	batch_list_replays(&batch, source);
+	if (batch.num_results == 0) {
+		fprintf(stderr, "No replays found in %s\n", source);
+		exit(1);
+	}
+
+	int num_jobs = SDL_GetCPUCount();
+	const char* jobs_param = check_param("batch_jobs=");
+	if (jobs_param != NULL) {
+		num_jobs = atoi(jobs_param + 11);
+	}
+	if (num_jobs < 1) num_jobs = 1;
+	if (num_jobs > batch.num_results) num_jobs = batch.num_results;
+
+	SDL_AtomicSet(&batch.next_result, 0);
+	// The main thread is the last worker, so only num_jobs-1 threads are needed.
+	int num_threads = num_jobs - 1;
+	SDL_Thread** workers = calloc(num_threads + 1, sizeof(SDL_Thread*));
+	for (int i = 0; i < num_threads; ++i) {
+		workers[i] = SDL_CreateThread(batch_validation_worker, "batchvalidate", &batch);
+	}
+	batch_validation_worker(&batch); // also does all the work if no threads could be created
+	for (int i = 0; i < num_threads; ++i) {
+		if (workers[i] != NULL) SDL_WaitThread(workers[i], NULL);
+	}
+	free(workers);
+
+	int num_failed = 0;
+	printf("replay,status,level,room,ticks,replay_ticks,ticks_match,kid_alive,milliseconds\n");
+	for (int i = 0; i < batch.num_results; ++i) {
+		batch_replay_result_type* result = &batch.results[i];
+		const char* status = "ok";
+		if (!result->has_result) {
+			status = "error";
+		} else if (result->ticks != result->replay_ticks) {
+			status = "mismatch";
+		}
+		if (strcmp(status, "ok") != 0) ++num_failed;
+		printf("\"%s\",%s,%d,%d,%d,%d,%d,%d,%.1f\n", result->filename, status,
+		       result->level, result->room, result->ticks, result->replay_ticks,
+		       result->has_result && result->ticks == result->replay_ticks, result->alive, result->milliseconds);
+	}
+	fprintf(stderr, "Validated %d replays with %d jobs: %d failed.\n", batch.num_results, num_jobs, num_failed);
+	free(batch.results);
+	exit(num_failed ? 1 : 0);
+}
+
 // The functions options_process_* below each process (read/write) a section of options variables (using SDL_RWops)
 // This is I/O for the *binary* representation of the relevant options - this gets saved as part of a replay.
 
@@ -569,6 +768,113 @@ int restore_savestate_from_buffer() {
 	return ok;
 }
 
+// Checkpoints use the quicksave format, plus the state that quickloading resets or doesn't need.
+replay_checkpoint_type* current_checkpoint = NULL;
+dword checkpoint_offset = 0;
+
+int process_to_checkpoint(void* data, size_t data_size) {
+	if (checkpoint_offset + data_size > MAX_SAVESTATE_SIZE) return 0;
+	memcpy(current_checkpoint->data + checkpoint_offset, data, data_size);
+	checkpoint_offset += data_size;
+	return 1;
+}
+
+int process_load_from_checkpoint(void* data, size_t data_size) {
+	if (checkpoint_offset + data_size > current_checkpoint->size) return 0;
+	memcpy(data, current_checkpoint->data + checkpoint_offset, data_size);
+	checkpoint_offset += data_size;
+	return 1;
+}
+
+int checkpoint_process_extras(process_func_type process_func) {
+	int ok = 1;
+#define process(x) ok = ok && process_func(&(x), sizeof(x))
+	process(exit_room_timer);
+	process(is_guard_notice);
+	process(text_time_total);
+	process(text_time_remaining);
+	process(keep_last_seed);
+	process(preserved_seed);
+#undef process
+	return ok;
+}
+
+void take_replay_checkpoint() {
+	if (replay_checkpoints == NULL) {
+		replay_checkpoints = malloc(MAX_REPLAY_CHECKPOINTS * sizeof(replay_checkpoint_type));
+		if (replay_checkpoints == NULL) return;
+	}
+	if (num_replay_checkpoints == MAX_REPLAY_CHECKPOINTS) {
+		// out of slots: keep every other checkpoint, and take them half as often from now on
+		for (int i = 1; i < MAX_REPLAY_CHECKPOINTS / 2; ++i) {
+			replay_checkpoints[i] = replay_checkpoints[i * 2];
+		}
+		num_replay_checkpoints = MAX_REPLAY_CHECKPOINTS / 2;
+		replay_checkpoint_interval *= 2;
+	}
+	current_checkpoint = &replay_checkpoints[num_replay_checkpoints];
+	current_checkpoint->tick = curr_tick;
+	current_checkpoint->level = current_level;
+	current_checkpoint->room = drawn_room;
+	checkpoint_offset = 0;
+	if (quick_process_ex(process_to_checkpoint, 0) && checkpoint_process_extras(process_to_checkpoint)) {
+		current_checkpoint->size = checkpoint_offset;
+		++num_replay_checkpoints;
+	}
+}
+
+void restore_replay_checkpoint(replay_checkpoint_type* checkpoint) {
+	stop_sounds();
+	current_checkpoint = checkpoint;
+	checkpoint_offset = 0;
+	quick_process_ex(process_load_from_checkpoint, 0);
+	restore_room_after_quick_load();
+	checkpoint_process_extras(process_load_from_checkpoint); // after restore_room_after_quick_load(), which resets these
+}
+
+// Finds the checkpoint to continue a seek from, or -1 if simulating forward from the current state is faster.
+int find_replay_checkpoint_for_seek() {
+	int found = -1;
+	for (int i = 0; i < num_replay_checkpoints; ++i) {
+		replay_checkpoint_type* checkpoint = &replay_checkpoints[i];
+		if (replay_seek_target == replay_seek_3_tick) {
+			if (checkpoint->tick > replay_seek_tick) break;
+			found = i; // the last checkpoint before the target
+		} else if (checkpoint->tick > curr_tick) {
+			// Seeking to the next room or level: the last known checkpoint before it changes.
+			if (checkpoint->level != current_level) break;
+			if (replay_seek_target == replay_seek_0_next_room && checkpoint->room != drawn_room) break;
+			found = i;
+		}
+	}
+	if (found < 0) return -1;
+	if (replay_seek_target == replay_seek_3_tick && replay_checkpoints[found].tick <= curr_tick && replay_seek_tick >= curr_tick) {
+		return -1; // seeking forward, and the checkpoint is behind us
+	}
+	if (replay_checkpoints[found].tick == curr_tick) return -1;
+	return found;
+}
+
+// Called at the start of every frame while replaying: handles seeks and takes checkpoints.
+void replay_checkpoint_tick() {
+	if (is_validate_mode) return;
+	if (need_replay_checkpoint_seek) {
+		need_replay_checkpoint_seek = 0;
+		int found = find_replay_checkpoint_for_seek();
+		if (found >= 0) {
+			restore_replay_checkpoint(&replay_checkpoints[found]);
+			if (replay_seek_target == replay_seek_3_tick && curr_tick >= replay_seek_tick) {
+				skipping_replay = 0; // landed exactly on the target
+			}
+		}
+	}
+	if (current_level != next_level || curr_tick >= num_replay_ticks) return;
+	dword last_tick = (num_replay_checkpoints > 0) ? replay_checkpoints[num_replay_checkpoints - 1].tick : 0;
+	if (num_replay_checkpoints == 0 || curr_tick >= last_tick + replay_checkpoint_interval) {
+		take_replay_checkpoint();
+	}
+}
+
 void start_recording() 
 {
 	curr_tick = 0;
@@ -663,8 +969,15 @@ static void print_remaining_time() {
 	printf("(rem_min=%d, rem_tick=%d)\n", rem_min, rem_tick);
 }
 
+void clear_replay_checkpoints() {
+	num_replay_checkpoints = 0;
+	replay_checkpoint_interval = REPLAY_CHECKPOINT_INTERVAL;
+	need_replay_checkpoint_seek = 0;
+}
+
 void start_replay() {
 	stop_sounds(); // Don't crash if the intro music is interrupted by Tab in PC Speaker mode.
+	clear_replay_checkpoints();
 	if (!enable_replay) return;
 	need_start_replay = 0;
 	if (!is_validate_mode) {
@@ -708,6 +1021,9 @@ void end_replay() {
 		} else {
 			printf("Play duration matches replay length. (%d ticks)\n", num_replay_ticks);
 		}
+		// machine-readable summary, parsed by validate_replays_batch()
+		printf("VALIDATE_RESULT level=%d room=%d ticks=%d replay_ticks=%d alive=%d\n",
+		       current_level, drawn_room, curr_tick, num_replay_ticks, (Kid.alive < 0) ? 1 : 0);
 		exit(0);
 	}
 }
@@ -724,6 +1040,9 @@ void do_replay_move() {
 			replay_seek_target = replay_seek_2_end;
 		}
 	}
+	if (skipping_replay && replay_seek_target == replay_seek_3_tick && curr_tick >= replay_seek_tick) {
+		skipping_replay = 0; // reached the tick we were seeking to
+	}
 	if (curr_tick == num_replay_ticks) { // replay is finished
 		end_replay();
 		return;
@@ -859,6 +1178,7 @@ void replay_cycle() {
 	need_replay_cycle = 0;
 	skipping_replay = 0;
 	stop_sounds();
+	clear_replay_checkpoints();
 	if (current_replay_number == -1 /* opened .P1R file directly, so cycling is disabled */ ||
 		!open_next_replay_file() ||
 		!load_replay()
@@ -972,10 +1292,24 @@ void key_press_while_replaying(int* key_ptr) {
 		case SDL_SCANCODE_F:                    // skip forward to next room
 			skipping_replay = 1;
 			replay_seek_target = replay_seek_0_next_room;
+			need_replay_checkpoint_seek = 1;
 			break;
 		case SDL_SCANCODE_F | WITH_SHIFT:       // skip forward to start of next level
 			skipping_replay = 1;
 			replay_seek_target = replay_seek_1_next_level;
+			need_replay_checkpoint_seek = 1;
+			break;
+		case SDL_SCANCODE_LEFTBRACKET:          // step back
+			skipping_replay = 1;
+			replay_seek_target = replay_seek_3_tick;
+			replay_seek_tick = (curr_tick > REPLAY_STEP_TICKS) ? curr_tick - REPLAY_STEP_TICKS : 0;
+			need_replay_checkpoint_seek = 1;
+			break;
+		case SDL_SCANCODE_RIGHTBRACKET:         // step forward
+			skipping_replay = 1;
+			replay_seek_target = replay_seek_3_tick;
+			replay_seek_tick = curr_tick + REPLAY_STEP_TICKS;
+			need_replay_checkpoint_seek = 1;
 			break;
 	}
 }
@@ -66,6 +66,11 @@ void far pop_main() {
 	turn_sound_on_off((is_sound_on != 0) * 15); // Turn off sound/music if those options were set.
 
 #ifdef USE_REPLAY
+	temp = check_param("batchvalidate");
+	if (temp != NULL) {
+		validate_replays_batch(temp); // runs the replays in child processes and quits
+	}
+
 	if (g_argc > 1) {
 		char *filename = g_argv[1]; // file dragged on top of executable or double clicked
 		char *e = strrchr(filename, '.');
@@ -253,13 +258,14 @@ int process_load(void* data, size_t data_size) {
 
 typedef int process_func_type(void* data, size_t data_size);
 
-int quick_process(process_func_type process_func) {
+// Replay checkpoints pass allow_level_skip = 0: they don't go through quick_fp, and must always contain the level.
+int quick_process_ex(process_func_type process_func, int allow_level_skip) {
 	int ok = 1;
 #define process(x) ok = ok && process_func(&(x), sizeof(x))
 	// level
 #ifdef USE_DEBUG_CHEATS
 	// Don't load the level if the user holds either Shift key while pressing F9.
-	if (debug_cheats_enabled && (key_states[SDL_SCANCODE_LSHIFT] || key_states[SDL_SCANCODE_RSHIFT])) {
+	if (allow_level_skip && debug_cheats_enabled && (key_states[SDL_SCANCODE_LSHIFT] || key_states[SDL_SCANCODE_RSHIFT])) {
 		fseek(quick_fp, sizeof(level), SEEK_CUR);
 	} else
 #endif
@@ -357,6 +363,10 @@ int quick_process(process_func_type process_func) {
 	return ok;
 }
 
+int quick_process(process_func_type process_func) {
+	return quick_process_ex(process_func, 1);
+}
+
 const char* quick_file = "QUICKSAVE.SAV";
 const char quick_version[] = "V1.16b4 ";
 char quick_control[] = "........";
@@ -355,6 +355,7 @@ int __pascal far play_level_2() {
 
 #ifdef USE_REPLAY
 		if (need_replay_cycle) replay_cycle();
+		if (replaying) replay_checkpoint_tick();
 #endif
 		if (Kid.sword == sword_2_drawn) {
 			// speed when fighting (smaller is faster)
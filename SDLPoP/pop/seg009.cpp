@@ -387,7 +387,7 @@ const char* __pascal far check_param(const char* param)
 
 		// List of params that expect a specifier ('sub-') arg directly after it (e.g. the mod's name, after "mod" arg)
 		// Such sub-args may conflict with the normal params (so, we should 'skip over' them)
-		static const char params_with_one_subparam[][16] = { "mod", "validate", /*...*/ };
+		static const char params_with_one_subparam[][16] = { "mod", "validate", "batchvalidate", /*...*/ };
 
 		bool curr_arg_has_one_subparam = false;
 		int i;
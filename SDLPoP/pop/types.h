@@ -1122,6 +1122,7 @@ enum replay_seek_targets {
 	replay_seek_0_next_room = 0,
 	replay_seek_1_next_level = 1,
 	replay_seek_2_end = 2,
+	replay_seek_3_tick = 3, // seek to a tick, starting from the nearest checkpoint
 };
 #endif
 
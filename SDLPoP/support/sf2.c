@@ -514,6 +514,9 @@ OPTINLINE byte validateSF(RIFFHEADER *RIFF) //Validate a soundfont file!
 	return 1; //Validated!
 }
 
+byte compileSF(RIFFHEADER *sf); //Prototype!
+void freeCompiledSF(RIFFHEADER *sf); //Prototype!
+
 RIFFHEADER *readSF(char *filename)
 {
 	
@@ -555,6 +558,10 @@ RIFFHEADER *readSF(char *filename)
 	emufclose64(f); //Close the file!
 	if (validateSF(riffheader)) //Give the allocated buffer with the file!
 	{
+		if (!compileSF(riffheader)) //Failed to precompile the zones? Lookups will walk the RIFF structure instead!
+		{
+			dolog("SF2","Warning: The soundfont %s could not be precompiled! Falling back to uncompiled lookups!",filename);
+		}
 		return riffheader; //Give the result!
 	}
 	dolog("SF2","Error: The soundfont %s is corrupt!",filename);
@@ -577,6 +584,7 @@ void closeSF(RIFFHEADER **sf)
 		*sf = NULL; //Invalidate!
 		return; //Abort!
 	}
+	freeCompiledSF(thesoundfont); //Release the precompiled zones!
 	freez((void **)sf,filesize+sizeof(RIFFHEADER),"RIFF_FILE"); //Free the data!
 }
 
@@ -838,6 +846,28 @@ byte getSFSample24(RIFFHEADER *sf, uint_32 sample, int_32 *result)
 
 /*
 
+Precompiled zone lookup
+
+*/
+
+OPTINLINE SF2COMPILEDZONE *getSFCompiledPresetZone(RIFFHEADER *sf, uint_32 preset, word PBag)
+{
+	if (unlikely(sf->pbags==NULL)) return NULL; //Not compiled!
+	if (unlikely(PBag>=sf->pbagcount)) return NULL; //Out of range!
+	if (unlikely(sf->pbags[PBag].owner!=preset)) return NULL; //Not compiled for this preset!
+	return &sf->pbags[PBag]; //Give the compiled zone!
+}
+
+OPTINLINE SF2COMPILEDZONE *getSFCompiledInstrumentZone(RIFFHEADER *sf, uint_32 instrument, word IBag)
+{
+	if (unlikely(sf->ibags==NULL)) return NULL; //Not compiled!
+	if (unlikely(IBag>=sf->ibagcount)) return NULL; //Out of range!
+	if (unlikely(sf->ibags[IBag].owner!=instrument)) return NULL; //Not compiled for this instrument!
+	return &sf->ibags[IBag]; //Give the compiled zone!
+}
+
+/*
+
 Global zone detection
 
 */
@@ -849,6 +879,11 @@ byte isGlobalPresetZone(RIFFHEADER *sf, uint_32 preset, word PBag)
 	sfPresetBag pbag2;
 	word firstPBag;
 	sfGenList finalgen;
+	SF2COMPILEDZONE *zone;
+	if ((zone = getSFCompiledPresetZone(sf,preset,PBag))!=NULL) //Precompiled?
+	{
+		return ((zone->flags&SF2ZONE_GLOBAL)?1:0); //Give the precompiled result!
+	}
 	if (getSFPreset(sf,preset,&currentpreset)) //Retrieve the header!
 	{
 		if (isValidPreset(&currentpreset)) //Valid preset?
@@ -907,6 +942,11 @@ byte isGlobalInstrumentZone(RIFFHEADER *sf, word instrument, word IBag)
 	sfInstBag ibag;
 	sfInstGenList finalgen;
 	sfInstBag ibag2;
+	SF2COMPILEDZONE *zone;
+	if ((zone = getSFCompiledInstrumentZone(sf,instrument,IBag))!=NULL) //Precompiled?
+	{
+		return ((zone->flags&SF2ZONE_GLOBAL)?1:0); //Give the precompiled result!
+	}
 	if (getSFInstrument(sf,instrument,&currentinstrument)) //Valid instrument?
 	{
 		firstIBag = LE16(currentinstrument.wInstBagNdx); //Load the first PBag!
@@ -959,6 +999,11 @@ byte isValidPresetZone(RIFFHEADER *sf, uint_32 preset, word PBag)
 {
 	sfPresetBag pbag;
 	sfGenList finalgen;
+	SF2COMPILEDZONE *zone;
+	if ((zone = getSFCompiledPresetZone(sf,preset,PBag))!=NULL) //Precompiled?
+	{
+		return ((zone->flags&SF2ZONE_VALID)?1:0); //Give the precompiled result!
+	}
 	if (isGlobalPresetZone(sf,preset,PBag)) //Valid global zone?
 	{
 		return 1; //Global zone: no instrument is allowed!
@@ -989,6 +1034,11 @@ byte isValidInstrumentZone(RIFFHEADER *sf, word instrument, word IBag)
 {
 	sfInstBag ibag;
 	sfInstGenList finalgen;
+	SF2COMPILEDZONE *zone;
+	if ((zone = getSFCompiledInstrumentZone(sf,instrument,IBag))!=NULL) //Precompiled?
+	{
+		return ((zone->flags&SF2ZONE_VALID)?1:0); //Give the precompiled result!
+	}
 	if (isGlobalInstrumentZone(sf,instrument,IBag)) //Valid global zone?
 	{
 		return 1; //Global zone: no sampleid is allowed!
@@ -1023,6 +1073,85 @@ Finally: some lookup functions for contents within the bags!
 
 /*
 
+getSFPresetModRange/getSFInstrumentModRange: Retrieves the modulator range of a zone that's valid to look up.
+parameters:
+	firstmod: The first modulator of the zone.
+	endmod: The modulator after the final modulator of the zone.
+result:
+	0: Zone isn't valid to look up modulators for
+	1: Valid zone
+
+*/
+
+OPTINLINE byte getSFPresetModRange(RIFFHEADER *sf, uint_32 preset, word PBag, word *firstmod, word *endmod)
+{
+	sfPresetHeader currentpreset;
+	sfPresetBag pbag, nextpbag;
+	SF2COMPILEDZONE *zone;
+	if ((zone = getSFCompiledPresetZone(sf,preset,PBag))!=NULL) //Precompiled?
+	{
+		*firstmod = zone->firstmod; //First modulator!
+		*endmod = zone->endmod; //End of the modulators!
+		return ((zone->flags&SF2ZONE_MODLOOKUP)?1:0); //Give the precompiled result!
+	}
+	if (getSFPreset(sf,preset,&currentpreset)) //Retrieve the header!
+	{
+		if (isValidPreset(&currentpreset)) //Valid preset?
+		{
+			if (isPresetBagNdx(sf,preset,PBag)) //Process the PBag for our preset&pbag!
+			{
+				if (getSFPresetBag(sf,PBag,&pbag)) //Load the current PBag! //Valid?
+				{
+					if (isValidPresetZone(sf,preset,PBag)) //Valid?
+					{
+						*firstmod = *endmod = LE16(pbag.wModNdx); //Load the first PMod! Default: no modulators!
+						if (getSFPresetBag(sf,PBag+1,&nextpbag)) //Next PBag to end with?
+						{
+							*endmod = LE16(nextpbag.wModNdx); //End of our modulators!
+						}
+						return 1; //Valid zone!
+					}
+				}
+			}
+		}
+	}
+	return 0; //Invalid zone!
+}
+
+OPTINLINE byte getSFInstrumentModRange(RIFFHEADER *sf, word instrument, word IBag, word *firstmod, word *endmod)
+{
+	sfInst currentinstrument;
+	sfInstBag ibag, nextibag;
+	SF2COMPILEDZONE *zone;
+	if ((zone = getSFCompiledInstrumentZone(sf,instrument,IBag))!=NULL) //Precompiled?
+	{
+		*firstmod = zone->firstmod; //First modulator!
+		*endmod = zone->endmod; //End of the modulators!
+		return ((zone->flags&SF2ZONE_MODLOOKUP)?1:0); //Give the precompiled result!
+	}
+	if (getSFInstrument(sf,instrument,&currentinstrument)) //Valid instrument?
+	{
+		if (isInstrumentBagNdx(sf,instrument,IBag)) //Process all PBags for our preset!
+		{
+			if (getSFInstrumentBag(sf,IBag,&ibag)) //Valid?
+			{
+				if (isValidInstrumentZone(sf,instrument,IBag)) //Valid?
+				{
+					*firstmod = *endmod = LE16(ibag.wInstModNdx); //Load the first IMod! Default: no modulators!
+					if (getSFInstrumentBag(sf,IBag+1,&nextibag)) //Next IBag to end with?
+					{
+						*endmod = LE16(nextibag.wInstModNdx); //End of our modulators!
+					}
+					return 1; //Valid zone!
+				}
+			}
+		}
+	}
+	return 0; //Invalid zone!
+}
+
+/*
+
 lookupSFPresetMod: Retrieves a preset from the list
 parameters:
 	sfModDestOper: What destination to filter against.
@@ -1036,9 +1165,7 @@ result:
 */
 byte lookupSFPresetMod(RIFFHEADER *sf, uint_32 preset, word PBag, SFModulator sfModDestOper, word index, sfModList *result, int_32 *originMod, int_32* foundindex, word* resultindex)
 {
-	sfPresetHeader currentpreset;
-	word CurrentMod;
-	sfPresetBag pbag;
+	word CurrentMod, EndMod;
 	sfModList mod,emptymod,originatingmod;
 	byte found;
 	word currentindex;
@@ -1049,82 +1176,69 @@ byte lookupSFPresetMod(RIFFHEADER *sf, uint_32 preset, word PBag, SFModulator sf
 	found = 0; //Default: not found!
 	gotoriginatingmod = 0; //Default: not gotten yet!
 	*resultindex = 0; //Not gotten yet!
-	if (getSFPreset(sf,preset,&currentpreset)) //Retrieve the header!
+	if (getSFPresetModRange(sf,preset,PBag,&CurrentMod,&EndMod)) //Valid zone to look up?
 	{
-		if (isValidPreset(&currentpreset)) //Valid preset?
+		memset(&emptymod,0,sizeof(emptymod)); //Final mod!
+		for (;CurrentMod<EndMod;) //Process all PMods for our bag!
 		{
-			if (isPresetBagNdx(sf,preset,PBag)) //Process the PBag for our preset&pbag!
+			if (getSFPresetMod(sf,CurrentMod,&mod)) //Valid?
 			{
-				if (getSFPresetBag(sf,PBag,&pbag)) //Load the current PBag! //Valid?
+				if (memcmp(&mod,&emptymod,sizeof(mod))==0) break; //Stop searching on final item!
+				if (LE16(mod.sfModDestOper)==sfModDestOper) //Found?
 				{
-					if (isValidPresetZone(sf,preset,PBag)) //Valid?
+					originatingfilter = 1; //Default: no originating filter!
+					if (*originMod == CurrentMod) //Current mod is originating?
+					{
+						memcpy(&originatingmod, &mod, sizeof(mod)); //Originating mod itself to keep track of!
+						gotoriginatingmod = 1; //Got originating mod!
+					}
+					if (*originMod != INT_MIN) //Originating mod specified?
+					{
+						if (gotoriginatingmod) //Got originating mod?
+						{
+							originatingfilter = ((originatingmod.sfModSrcOper == mod.sfModSrcOper) && (originatingmod.sfModDestOper == mod.sfModDestOper) && (originatingmod.sfModAmtSrcOper == mod.sfModAmtSrcOper));
+						}
+						else //Not gotten originating mod yet?
+						{
+							originatingfilter = 0; //Invalid to use!
+						}
+					}
+					if (originatingfilter) //Valid to use?
 					{
-						CurrentMod = LE16(pbag.wModNdx); //Load the first PMod!
-						memset(&emptymod,0,sizeof(emptymod)); //Final mod!
-						for (;isPresetModNdx(sf,preset,PBag,CurrentMod);) //Process all PMods for our bag!
+						if (currentindex == index) //Requested index?
 						{
-							if (getSFPresetMod(sf,CurrentMod,&mod)) //Valid?
+							if (found == 0) //Not found yet?
 							{
-								if (memcmp(&mod,&emptymod,sizeof(mod))==0) break; //Stop searching on final item!
-								if (LE16(mod.sfModDestOper)==sfModDestOper) //Found?
+								found = 1; //Found!
+								*foundindex = CurrentMod; //What index has been found!
+								memcpy(result, &mod, sizeof(*result)); //Set to last found!
+								if (CurrentMod < 0x8000) //Valid to use?
 								{
-									originatingfilter = 1; //Default: no originating filter!
-									if (*originMod == CurrentMod) //Current mod is originating?
-									{
-										memcpy(&originatingmod, &mod, sizeof(mod)); //Originating mod itself to keep track of!
-										gotoriginatingmod = 1; //Got originating mod!
-									}
-									if (*originMod != INT_MIN) //Originating mod specified?
-									{
-										if (gotoriginatingmod) //Got originating mod?
-										{
-											originatingfilter = ((originatingmod.sfModSrcOper == mod.sfModSrcOper) && (originatingmod.sfModDestOper == mod.sfModDestOper) && (originatingmod.sfModAmtSrcOper == mod.sfModAmtSrcOper));
-										}
-										else //Not gotten originating mod yet?
-										{
-											originatingfilter = 0; //Invalid to use!
-										}
-									}
-									if (originatingfilter) //Valid to use?
-									{
-										if (currentindex == index) //Requested index?
-										{
-											if (found == 0) //Not found yet?
-											{
-												found = 1; //Found!
-												*foundindex = CurrentMod; //What index has been found!
-												memcpy(result, &mod, sizeof(*result)); //Set to last found!
-												if (CurrentMod < 0x8000) //Valid to use?
-												{
-													*resultindex = CurrentMod + 0x8000; //Found index!
-												}
-												if (*originMod == INT_MIN) //Not set yet?
-												{
-													*originMod = -CurrentMod; //Copy of the original modulator!
-													memcpy(&originatingmod, &mod, sizeof(originatingmod)); //Copy of the originating mod!
-												}
-											}
-											else if (found == 1) //Already found something?
-											{
-												found = 2; //Found a second one, skip the first one!
-											}
-										}
-										else if (currentindex > index) //Later index than what's requested?
-										{
-											if (found) //Already found?
-											{
-												found = 2; //Found a second one, skip the first one!
-											}
-										}
-										++currentindex; //Next index to check against!
-									}
+									*resultindex = CurrentMod + 0x8000; //Found index!
+								}
+								if (*originMod == INT_MIN) //Not set yet?
+								{
+									*originMod = -CurrentMod; //Copy of the original modulator!
+									memcpy(&originatingmod, &mod, sizeof(originatingmod)); //Copy of the originating mod!
 								}
 							}
-							++CurrentMod;
+							else if (found == 1) //Already found something?
+							{
+								found = 2; //Found a second one, skip the first one!
+							}
+						}
+						else if (currentindex > index) //Later index than what's requested?
+						{
+							if (found) //Already found?
+							{
+								found = 2; //Found a second one, skip the first one!
+							}
 						}
+						++currentindex; //Next index to check against!
 					}
 				}
 			}
+			++CurrentMod;
 		}
 	}
 	return found; //Not found or last found!
@@ -1139,7 +1253,17 @@ byte lookupSFPresetGen(RIFFHEADER *sf, uint_32 preset, word PBag, SFGenerator sf
 	byte found;
 	found = 0; //Default: not found!
 	uint_32 firstgen, keyrange, temp; //Other generators and temporary calculation!
+	SF2COMPILEDZONE *zone;
 	keyrange = 0; //Not specified yet!
+	if ((sfGenOper<endOper) && ((zone = getSFCompiledPresetZone(sf,preset,PBag))!=NULL)) //Precompiled?
+	{
+		if (zone->genfound&(1ULL<<sfGenOper)) //Found?
+		{
+			memcpy(result,&zone->gen[sfGenOper],sizeof(*result)); //Give the precompiled generator!
+			return 1; //Found!
+		}
+		return 0; //Not found!
+	}
 	if (getSFPreset(sf,preset,&currentpreset)) //Retrieve the header!
 	{
 		if (isValidPreset(&currentpreset)) //Valid preset?
@@ -1229,9 +1353,7 @@ result:
 */
 byte lookupSFInstrumentMod(RIFFHEADER *sf, word instrument, word IBag, SFModulator sfModDestOper, word index, sfModList *result, int_32* originMod, int_32* foundindex, word* resultindex)
 {
-	sfInst currentinstrument;
-	word CurrentMod;
-	sfInstBag ibag;
+	word CurrentMod, EndMod;
 	sfModList mod,emptymod,originatingmod;
 	byte found;
 	word currentindex;
@@ -1280,79 +1402,69 @@ byte lookupSFInstrumentMod(RIFFHEADER *sf, word instrument, word IBag, SFModulat
 
 	*resultindex = 0; //No found index yet!
 
-	if (getSFInstrument(sf,instrument,&currentinstrument)) //Valid instrument?
+	if (getSFInstrumentModRange(sf,instrument,IBag,&CurrentMod,&EndMod)) //Valid zone to look up?
 	{
-		if (isInstrumentBagNdx(sf,instrument,IBag)) //Process all PBags for our preset!
+		memset(&emptymod,0,sizeof(emptymod)); //Final mod!
+		for (;CurrentMod<EndMod;) //Process all IMods for our bag!
 		{
-			if (getSFInstrumentBag(sf,IBag,&ibag)) //Valid?
+			if (getSFInstrumentMod(sf,CurrentMod,&mod)) //Valid?
 			{
-				if (isValidInstrumentZone(sf,instrument,IBag)) //Valid?
+				if (memcmp(&mod, &emptymod, sizeof(mod)) == 0) break; //Stop searching on final item!
+				if (LE16(mod.sfModDestOper) == sfModDestOper) //Found?
 				{
-					CurrentMod = LE16(ibag.wInstModNdx); //Load the first PMod!
-					memset(&emptymod,0,sizeof(emptymod)); //Final mod!
-					for (;isInstrumentModNdx(sf,instrument,IBag,CurrentMod);) //Process all PMods for our bag!
+					originatingfilter = 1; //Default: no originating filter!
+					if (*originMod == CurrentMod) //Current mod is originating?
 					{
-						if (getSFInstrumentMod(sf,CurrentMod,&mod)) //Valid?
+						memcpy(&originatingmod, &mod, sizeof(mod)); //Originating mod itself to keep track of!
+						gotoriginatingmod = 1; //Got originating mod!
+					}
+					if (*originMod != INT_MIN) //Originating mod specified?
+					{
+						if (gotoriginatingmod) //Got originating mod?
+						{
+							originatingfilter = ((originatingmod.sfModSrcOper==mod.sfModSrcOper) && (originatingmod.sfModDestOper==mod.sfModDestOper) && (originatingmod.sfModAmtSrcOper==mod.sfModAmtSrcOper));
+						}
+						else //Not gotten originating mod yet?
+						{
+							originatingfilter = 0; //Invalid to use!
+						}
+					}
+					if (originatingfilter) //Valid to use?
+					{
+						if (currentindex == index) //Requested index?
 						{
-							if (memcmp(&mod, &emptymod, sizeof(mod)) == 0) break; //Stop searching on final item!
-							if (LE16(mod.sfModDestOper) == sfModDestOper) //Found?
+							if (found == 0) //Not found yet?
 							{
-								originatingfilter = 1; //Default: no originating filter!
-								if (*originMod == CurrentMod) //Current mod is originating?
+								found = 1; //Found!
+								memcpy(result, &mod, sizeof(*result)); //Set to last found!
+								*foundindex = CurrentMod; //What index has been found!
+								if (CurrentMod < 0x8000) //Valid to use?
 								{
-									memcpy(&originatingmod, &mod, sizeof(mod)); //Originating mod itself to keep track of!
-									gotoriginatingmod = 1; //Got originating mod!
+									*resultindex = CurrentMod + 0x8000; //Found index!
 								}
-								if (*originMod != INT_MIN) //Originating mod specified?
+								if (*originMod == INT_MIN) //Not set yet?
 								{
-									if (gotoriginatingmod) //Got originating mod?
-									{
-										originatingfilter = ((originatingmod.sfModSrcOper==mod.sfModSrcOper) && (originatingmod.sfModDestOper==mod.sfModDestOper) && (originatingmod.sfModAmtSrcOper==mod.sfModAmtSrcOper));
-									}
-									else //Not gotten originating mod yet?
-									{
-										originatingfilter = 0; //Invalid to use!
-									}
-								}
-								if (originatingfilter) //Valid to use?
-								{
-									if (currentindex == index) //Requested index?
-									{
-										if (found == 0) //Not found yet?
-										{
-											found = 1; //Found!
-											memcpy(result, &mod, sizeof(*result)); //Set to last found!
-											*foundindex = CurrentMod; //What index has been found!
-											if (CurrentMod < 0x8000) //Valid to use?
-											{
-												*resultindex = CurrentMod + 0x8000; //Found index!
-											}
-											if (*originMod == INT_MIN) //Not set yet?
-											{
-												*originMod = -CurrentMod; //Copy of the original modulator!
-												memcpy(&originatingmod, &mod, sizeof(originatingmod)); //Copy of the originating mod!
-											}
-										}
-										else if (found == 1) //Already found something?
-										{
-											found = 2; //Found a second one, skip the first one!
-										}
-									}
-									else if (currentindex > index) //Later index than what's requested?
-									{
-										if (found) //Already found?
-										{
-											found = 2; //Found a second one, skip the first one!
-										}
-									}
-									++currentindex; //Next index to check against!
+									*originMod = -CurrentMod; //Copy of the original modulator!
+									memcpy(&originatingmod, &mod, sizeof(originatingmod)); //Copy of the originating mod!
 								}
 							}
+							else if (found == 1) //Already found something?
+							{
+								found = 2; //Found a second one, skip the first one!
+							}
 						}
-						++CurrentMod;
+						else if (currentindex > index) //Later index than what's requested?
+						{
+							if (found) //Already found?
+							{
+								found = 2; //Found a second one, skip the first one!
+							}
+						}
+						++currentindex; //Next index to check against!
 					}
 				}
 			}
+			++CurrentMod;
 		}
 	}
 	return found; //Not found or last found!
@@ -1368,8 +1480,18 @@ byte lookupSFInstrumentGen(RIFFHEADER *sf, word instrument, word IBag, SFGenerat
 	byte found;
 	byte dontignoregenerators;
 	byte valid;
+	SF2COMPILEDZONE *zone;
 	valid = 1; //Default: still valid!
 	found = 0;
+	if ((sfGenOper<endOper) && ((zone = getSFCompiledInstrumentZone(sf,instrument,IBag))!=NULL)) //Precompiled?
+	{
+		if (zone->genfound&(1ULL<<sfGenOper)) //Found?
+		{
+			memcpy(result,&zone->gen[sfGenOper],sizeof(*result)); //Give the precompiled generator!
+			return 1; //Found!
+		}
+		return 0; //Not found!
+	}
 	if (getSFInstrument(sf,instrument,&currentinstrument)) //Valid instrument?
 	{
 		if (isInstrumentBagNdx(sf,instrument,IBag)) //Process all PBags for our preset!
@@ -1438,6 +1560,20 @@ byte lookupPresetByInstrument(RIFFHEADER *sf, word preset, word bank, uint_32 *r
 	uint_32 currentpreset;
 	sfPresetHeader activepreset; //Current preset data!
 	byte foundpreset; //Found a preset?
+	if (sf->presetlookup) //Precompiled?
+	{
+		if ((bank<=128) && (preset<=127) && (sf->presetlookup[(bank<<7)|preset]!=SF2_NOPRESET)) //Found?
+		{
+			*result = sf->presetlookup[(bank<<7)|preset]; //Set the preset found!
+			return 1; //We've found our preset!
+		}
+		if ((bank<=128) && preset && (sf->presetlookup[bank<<7]!=SF2_NOPRESET)) //Default to preset 0 as by GM specification!
+		{
+			*result = sf->presetlookup[bank<<7]; //Set the preset found!
+			return 1; //We've found our preset!
+		}
+		return 0; //Invalid preset: disabled?
+	}
 trypreset0:
 	foundpreset = 0; //Didn't find any preset!
 	memset(&activepreset,0,sizeof(activepreset)); //init to something at least!
@@ -1710,3 +1846,147 @@ byte lookupSFInstrumentGenGlobal(RIFFHEADER *sf, word instrument, word IBag, SFG
 	}
 	return 0; //Not found at all!
 }
+
+/*
+
+Soundfont precompilation: resolves all zones once when loading, so lookups during playback don't walk the RIFF structure anymore.
+
+*/
+
+void freeCompiledSF(RIFFHEADER *sf)
+{
+	if (sf->pbags) //Preset zones compiled?
+	{
+		freez((void **)&sf->pbags,sf->pbagcount*sizeof(SF2COMPILEDZONE),"SF2_PBAGS"); //Release them!
+	}
+	if (sf->ibags) //Instrument zones compiled?
+	{
+		freez((void **)&sf->ibags,sf->ibagcount*sizeof(SF2COMPILEDZONE),"SF2_IBAGS"); //Release them!
+	}
+	if (sf->presetlookup) //Presets compiled?
+	{
+		freez((void **)&sf->presetlookup,129*128*sizeof(uint_32),"SF2_PRESETS"); //Release them!
+	}
+	sf->pbagcount = sf->ibagcount = 0; //Nothing compiled anymore!
+}
+
+byte compileSF(RIFFHEADER *sf)
+{
+	uint_32 presetcount, instrumentcount, pbagcount, ibagcount; //Amount of entries in the chunks!
+	uint_32 preset, instrument, bag, endbag;
+	word gen;
+	SF2COMPILEDZONE *pbags, *ibags, *zone;
+	uint_32 *presetlookup;
+	sfPresetHeader currentpreset, nextpreset;
+	sfInst currentinstrument, nextinstrument;
+	sfGenList pgen;
+	sfInstGenList igen;
+
+	presetcount = getRIFFChunkSize(sf->phdr)/sizeof(sfPresetHeader); //How many presets, including the terminal one?
+	instrumentcount = getRIFFChunkSize(sf->inst)/sizeof(sfInst); //How many instruments, including the terminal one?
+	pbagcount = getRIFFChunkSize(sf->pbag)/sizeof(sfPresetBag); //How many preset zones?
+	ibagcount = getRIFFChunkSize(sf->ibag)/sizeof(sfInstBag); //How many instrument zones?
+	if ((!pbagcount) || (!ibagcount)) return 0; //Nothing to compile!
+	if (((uint_64)pbagcount*sizeof(SF2COMPILEDZONE))>0xFFFFFFFFULL) return 0; //Too large!
+	if (((uint_64)ibagcount*sizeof(SF2COMPILEDZONE))>0xFFFFFFFFULL) return 0; //Too large!
+
+	pbags = (SF2COMPILEDZONE *)zalloc(pbagcount*sizeof(SF2COMPILEDZONE),"SF2_PBAGS",NULL); //Preset zones!
+	if (!pbags) return 0; //Ran out of memory!
+	ibags = (SF2COMPILEDZONE *)zalloc(ibagcount*sizeof(SF2COMPILEDZONE),"SF2_IBAGS",NULL); //Instrument zones!
+	if (!ibags) //Ran out of memory?
+	{
+		freez((void **)&pbags,pbagcount*sizeof(SF2COMPILEDZONE),"SF2_PBAGS"); //Release the preset zones!
+		return 0; //Ran out of memory!
+	}
+	presetlookup = (uint_32 *)zalloc(129*128*sizeof(uint_32),"SF2_PRESETS",NULL); //Preset lookup by bank and program!
+	if (!presetlookup) //Ran out of memory?
+	{
+		freez((void **)&pbags,pbagcount*sizeof(SF2COMPILEDZONE),"SF2_PBAGS"); //Release the preset zones!
+		freez((void **)&ibags,ibagcount*sizeof(SF2COMPILEDZONE),"SF2_IBAGS"); //Release the instrument zones!
+		return 0; //Ran out of memory!
+	}
+
+	//The lookups below run uncompiled, since nothing is assigned to the soundfont yet!
+
+	//Preset zones!
+	for (bag=0;bag<pbagcount;++bag) //Not owned by default!
+	{
+		pbags[bag].owner = SF2_NOPRESET; //Not owned!
+	}
+	for (preset=0;(preset+1)<presetcount;++preset) //Process all presets!
+	{
+		if (!(getSFPreset(sf,preset,&currentpreset) && getSFPreset(sf,preset+1,&nextpreset))) continue; //Invalid preset?
+		endbag = LE16(nextpreset.wPresetBagNdx); //End of the zones!
+		for (bag=LE16(currentpreset.wPresetBagNdx);(bag<endbag) && (bag<pbagcount);++bag) //Process all zones of the preset!
+		{
+			zone = &pbags[bag]; //The zone to compile!
+			zone->owner = preset; //We're owned by this preset!
+			zone->flags = 0; //Default: no flags!
+			zone->genfound = 0; //Default: no generators!
+			if (isValidPresetZone(sf,preset,(word)bag)) zone->flags |= SF2ZONE_VALID; //Valid zone?
+			if (isGlobalPresetZone(sf,preset,(word)bag)) zone->flags |= SF2ZONE_GLOBAL; //Global zone?
+			if (getSFPresetModRange(sf,preset,(word)bag,&zone->firstmod,&zone->endmod)) zone->flags |= SF2ZONE_MODLOOKUP; //Modulators to look up?
+			for (gen=0;gen<endOper;++gen) //Process all generators!
+			{
+				if (lookupSFPresetGen(sf,preset,(word)bag,gen,&pgen)) //Found?
+				{
+					zone->genfound |= (1ULL<<gen); //Found!
+					memcpy(&zone->gen[gen],&pgen,sizeof(zone->gen[gen])); //The generator!
+				}
+			}
+		}
+	}
+
+	//Instrument zones!
+	for (bag=0;bag<ibagcount;++bag) //Not owned by default!
+	{
+		ibags[bag].owner = SF2_NOPRESET; //Not owned!
+	}
+	for (instrument=0;((instrument+1)<instrumentcount) && (instrument<0xFFFF);++instrument) //Process all instruments!
+	{
+		if (!(getSFInstrument(sf,(word)instrument,&currentinstrument) && getSFInstrument(sf,(word)(instrument+1),&nextinstrument))) continue; //Invalid instrument?
+		endbag = LE16(nextinstrument.wInstBagNdx); //End of the zones!
+		for (bag=LE16(currentinstrument.wInstBagNdx);(bag<endbag) && (bag<ibagcount);++bag) //Process all zones of the instrument!
+		{
+			zone = &ibags[bag]; //The zone to compile!
+			zone->owner = instrument; //We're owned by this instrument!
+			zone->flags = 0; //Default: no flags!
+			zone->genfound = 0; //Default: no generators!
+			if (isValidInstrumentZone(sf,(word)instrument,(word)bag)) zone->flags |= SF2ZONE_VALID; //Valid zone?
+			if (isGlobalInstrumentZone(sf,(word)instrument,(word)bag)) zone->flags |= SF2ZONE_GLOBAL; //Global zone?
+			if (getSFInstrumentModRange(sf,(word)instrument,(word)bag,&zone->firstmod,&zone->endmod)) zone->flags |= SF2ZONE_MODLOOKUP; //Modulators to look up?
+			for (gen=0;gen<endOper;++gen) //Process all generators!
+			{
+				if (lookupSFInstrumentGen(sf,(word)instrument,(word)bag,gen,&igen)) //Found?
+				{
+					zone->genfound |= (1ULL<<gen); //Found!
+					memcpy(&zone->gen[gen],&igen,sizeof(zone->gen[gen])); //The generator!
+				}
+			}
+		}
+	}
+
+	//Presets by bank and program! The first valid preset found is used!
+	for (bag=0;bag<(129*128);++bag) //Not found by default!
+	{
+		presetlookup[bag] = SF2_NOPRESET; //Not found!
+	}
+	for (preset=0;getSFPreset(sf,preset,&currentpreset);++preset) //Process all presets, including the terminal one!
+	{
+		if (isValidPreset(&currentpreset)) //Valid?
+		{
+			if (presetlookup[(LE16(currentpreset.wBank)<<7)|LE16(currentpreset.wPreset)]==SF2_NOPRESET) //Not found yet?
+			{
+				presetlookup[(LE16(currentpreset.wBank)<<7)|LE16(currentpreset.wPreset)] = preset; //Use this preset!
+			}
+		}
+	}
+
+	//Start using the compiled zones!
+	sf->pbagcount = pbagcount;
+	sf->pbags = pbags;
+	sf->ibagcount = ibagcount;
+	sf->ibags = ibags;
+	sf->presetlookup = presetlookup;
+	return 1; //Compiled!
+}
@@ -0,0 +1,422 @@
+/*
+
+Copyright (C) 2019 - 2021 Superfury
+
+This file is part of The Common Emulator Framework.
+
+The Common Emulator Framework is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+The Common Emulator Framework is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with The Common Emulator Framework.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "headers/types.h" //Basic types!
+#include "headers/emu/gpu/gpu.h" //GPU typedefs etc.
+#include "headers/emu/gpu/gpu_capture.h" //Our own definitions!
+#include "headers/support/bmp.h" //Bitmap support!
+#include "headers/support/zalloc.h" //Zalloc support!
+#include "headers/support/log.h" //Logging support!
+#include "headers/support/locks.h" //Locking support!
+#include "headers/emu/sound.h" //Sound recording support!
+#include "headers/fopen64.h" //64-bit fopen support!
+#include "headers/emu/emu_misc.h" //File support!
+#include "headers/emu/threads.h" //Thread support!
+
+/*
+
+Frame capture: finished frames are copied into a pool of frames, which are written by the capture writer thread.
+Frames that haven't changed since the last captured frame (and have the same resolution) aren't copied: the writer writes the previous frame again instead.
+Screenshots are written by the writer thread as well.
+When the writer thread isn't available, frames are written directly instead.
+The queue is protected by LOCK_CAPTURE.
+
+*/
+
+//Amount of frames that can be queued for writing at once!
+#define CAPTURE_POOLSIZE 4
+//Size of a row to write: a row of raw pixels, which is larger than a BMP row!
+#define CAPTURE_ROWSIZE (EMU_MAX_X<<2)
+
+typedef struct
+{
+	uint_32 *pixels; //The captured pixels, width*height, packed!
+	uint_32 size; //Allocated size of the pixels in bytes!
+	word width; //Width of the frame!
+	word height; //Height of the frame!
+	byte repeat; //Unchanged frame: repeat the last written frame instead?
+	uint_32 number; //Frame number in the sequence!
+	char filename[256]; //Screenshot filename, if a single screenshot instead of a frame in the sequence!
+} CAPTUREFRAME;
+
+extern GPU_type GPU; //GPU!
+extern char capturepath[256]; //Capture path!
+
+ThreadParams_p capture_thread = NULL; //The writer thread!
+SDL_sem *capture_done = NULL; //Posted once for each waiting thread whenever a frame has been written!
+SDL_sem *capture_work = NULL; //Posted whenever a frame has been queued!
+uint_32 capture_waiting = 0; //Amount of threads waiting on capture_done!
+byte capture_quit = 0; //Terminate the writer?
+
+CAPTUREFRAME capture_pool[CAPTURE_POOLSIZE]; //All frames!
+byte capture_queuehead = 0; //First frame in the queue!
+byte capture_queued = 0; //Amount of frames in the queue!
+
+//Capture settings and state of the renderer!
+byte capture_active = 0; //Are we capturing?
+byte capture_format = CAPTURE_BMP; //The format to write!
+byte capture_withaudio = 0; //Recording the audio with it?
+uint_32 capture_interval = 1; //Capture every this many frames!
+uint_32 capture_intervalcounter = 0; //Frames counted until the next capture!
+uint_32 capture_framenumber = 0; //Next frame number to capture!
+word capture_lastwidth = 0, capture_lastheight = 0; //Resolution of the last copied frame!
+char capture_path[256]; //Directory of a BMP sequence!
+BIGFILE *capture_rawfile = NULL; //Raw sequence file!
+
+//State of the writer!
+uint_32 *capture_lastpixels = NULL; //The last written frame, for repeating unchanged frames!
+uint_32 capture_lastsize = 0; //Allocated size of the last written frame!
+word capture_writtenwidth = 0, capture_writtenheight = 0; //Resolution of the last written frame!
+byte *capture_row = NULL; //A row of raw or BMP pixels to write! Allocated before writing, since the writer thread can't use zalloc!
+
+OPTINLINE void capture_writeraw(uint_32 number) //Write the last written frame to the raw sequence!
+{
+	CAPTURE_RAWFRAME header;
+	uint_32 *pixel;
+	byte *rawpixel;
+	word x, y;
+	if ((capture_rawfile==NULL) || (capture_row==NULL)) return; //No file or row!
+	header.signature = CAPTURE_RAWSIGNATURE; //Our signature!
+	header.width = capture_writtenwidth; //Width!
+	header.height = capture_writtenheight; //Height!
+	header.number = number; //Frame number!
+	emufwrite64(&header,1,sizeof(header),capture_rawfile); //Write the frame header!
+	pixel = capture_lastpixels; //First pixel!
+	for (y=0;y<capture_writtenheight;++y) //Process all rows!
+	{
+		rawpixel = capture_row; //Start of the row!
+		for (x=0;x<capture_writtenwidth;++x) //Process all pixels!
+		{
+			rawpixel[0] = GETR(*pixel); //Red!
+			rawpixel[1] = GETG(*pixel); //Green!
+			rawpixel[2] = GETB(*pixel); //Blue!
+			rawpixel[3] = GETA(*pixel); //Alpha!
+			rawpixel += 4; //Next raw pixel!
+			++pixel; //Next pixel!
+		}
+		emufwrite64(capture_row,1,(capture_writtenwidth<<2),capture_rawfile); //Write the row!
+	}
+}
+
+void capture_writeframe(CAPTUREFRAME *frame) //Write a captured frame!
+{
+	char filename[256];
+	uint_32 *pixels;
+	uint_32 size;
+	if (frame->filename[0]) //Screenshot?
+	{
+		writeBMProw(frame->filename,frame->pixels,frame->width,frame->height,0,0,frame->width,capture_row,CAPTURE_ROWSIZE); //Write the screenshot!
+		return; //Done!
+	}
+	if (frame->repeat==0) //New frame? Becomes the last written frame!
+	{
+		pixels = capture_lastpixels; //Swap the buffers instead of copying!
+		size = capture_lastsize;
+		capture_lastpixels = frame->pixels;
+		capture_lastsize = frame->size;
+		frame->pixels = pixels;
+		frame->size = size;
+		capture_writtenwidth = frame->width; //The new resolution!
+		capture_writtenheight = frame->height;
+	}
+	if (capture_lastpixels==NULL) return; //Nothing to write yet!
+	if (capture_format==CAPTURE_RAW) //Raw sequence?
+	{
+		capture_writeraw(frame->number); //Write the frame!
+	}
+	else //BMP sequence?
+	{
+		snprintf(filename,sizeof(filename),"%s/%08" SPRINTF_u_UINT32,capture_path,frame->number); //The frame filename!
+		writeBMProw(filename,capture_lastpixels,capture_writtenwidth,capture_writtenheight,0,0,capture_writtenwidth,capture_row,CAPTURE_ROWSIZE); //Write the frame!
+	}
+}
+
+OPTINLINE void capture_waitdone() //Wait for the writer to finish a frame! LOCK_CAPTURE must be held, and is held again afterwards!
+{
+	++capture_waiting; //We're waiting!
+	unlock(LOCK_CAPTURE);
+	WaitSem(capture_done) //Wait for a frame to be written!
+	lock(LOCK_CAPTURE);
+}
+
+void capture_writerthread()
+{
+	CAPTUREFRAME *frame;
+	for (;;) //Keep writing!
+	{
+		WaitSem(capture_work) //Wait for work!
+		lock(LOCK_CAPTURE);
+		if (capture_queued==0) //Nothing to do?
+		{
+			unlock(LOCK_CAPTURE);
+			if (capture_quit) break; //Terminating?
+			continue; //Wait for more!
+		}
+		frame = &capture_pool[capture_queuehead]; //The frame to write! Stays queued until written!
+		unlock(LOCK_CAPTURE);
+
+		capture_writeframe(frame); //Write the frame!
+
+		lock(LOCK_CAPTURE);
+		capture_queuehead = ((capture_queuehead+1)%CAPTURE_POOLSIZE); //Next frame!
+		--capture_queued; //Finished!
+		for (;capture_waiting;--capture_waiting) //Anyone waiting?
+		{
+			PostSem(capture_done) //We've finished a frame!
+		}
+		unlock(LOCK_CAPTURE);
+	}
+}
+
+byte capture_startwriter() //Start the writer thread, if possible! Result: 1 when running!
+{
+	if (capture_row==NULL) //No row to write yet? Used when writing directly as well!
+	{
+		capture_row = (byte *)zalloc(CAPTURE_ROWSIZE,"CAPTURE_ROW",NULL); //The row to write!
+	}
+	if (capture_thread) return 1; //Already running!
+	capture_done = SDL_CreateSemaphore(0); //Nobody waiting yet!
+	capture_work = SDL_CreateSemaphore(0); //No work yet!
+	capture_queuehead = capture_queued = 0; //Nothing queued!
+	capture_waiting = 0; //Nobody waiting!
+	capture_quit = 0; //Not quitting!
+	if (capture_done && capture_work) //Allocated?
+	{
+		capture_thread = startThread(&capture_writerthread,"CaptureWriter",NULL); //Start the writer!
+		if (capture_thread) return 1; //Started!
+		dolog("GPU","Unable to start capture writer thread!");
+	}
+	if (capture_done) SDL_DestroySemaphore(capture_done);
+	if (capture_work) SDL_DestroySemaphore(capture_work);
+	capture_done = NULL;
+	capture_work = NULL;
+	return 0; //Write directly instead!
+}
+
+OPTINLINE CAPTUREFRAME *capture_allocframe() //Allocate a frame to fill at the end of the queue!
+{
+	CAPTUREFRAME *frame;
+	if (capture_thread==NULL) return &capture_pool[0]; //Written directly!
+	lock(LOCK_CAPTURE);
+	while (capture_queued==CAPTURE_POOLSIZE) //Queue full?
+	{
+		capture_waitdone(); //Wait for a frame to be written!
+	}
+	frame = &capture_pool[(capture_queuehead+capture_queued)%CAPTURE_POOLSIZE]; //The new frame!
+	unlock(LOCK_CAPTURE);
+	return frame; //Give the frame to fill!
+}
+
+OPTINLINE void capture_postframe(CAPTUREFRAME *frame) //Post the filled frame!
+{
+	if (capture_thread==NULL) //Writing directly?
+	{
+		capture_writeframe(frame); //Write it now!
+		return;
+	}
+	lock(LOCK_CAPTURE);
+	++capture_queued; //Queued!
+	PostSem(capture_work) //Start writing!
+	unlock(LOCK_CAPTURE);
+}
+
+OPTINLINE void capture_flush() //Wait for all queued frames to be written!
+{
+	if (capture_thread==NULL) return; //Nothing queued!
+	lock(LOCK_CAPTURE);
+	while (capture_queued) //Frames left?
+	{
+		capture_waitdone(); //Wait for them to be written!
+	}
+	unlock(LOCK_CAPTURE);
+}
+
+OPTINLINE byte capture_copyframe(CAPTUREFRAME *frame, word width, word height) //Copy the current frame! Result: 1 on success!
+{
+	uint_32 size;
+	word y;
+	size = (((uint_32)width*(uint_32)height)<<2); //The size we need!
+	if (frame->size<size) //Buffer too small?
+	{
+		if (frame->pixels) freez((void **)&frame->pixels,frame->size,"CAPTURE_FRAME"); //Release the old buffer!
+		frame->size = 0; //Nothing allocated!
+		if ((frame->pixels = (uint_32 *)zalloc(size,"CAPTURE_FRAME",NULL))==NULL) return 0; //Failed to allocate!
+		frame->size = size; //Allocated!
+	}
+	for (y=0;y<height;++y) //Copy all rows!
+	{
+		memcpy(&frame->pixels[y*width],&EMU_BUFFER(0,y),(width<<2)); //Copy the row!
+	}
+	frame->width = width; //The resolution!
+	frame->height = height;
+	return 1; //Copied!
+}
+
+OPTINLINE void capture_getresolution(word *width, word *height) //The resolution to capture!
+{
+	*width = (GPU.xres>EMU_MAX_X)?EMU_MAX_X:GPU.xres;
+	*height = (GPU.yres>EMU_MAX_Y)?EMU_MAX_Y:GPU.yres; //Apply limits!
+}
+
+void GPU_captureFrame() //Capture a finished frame, if capturing! Called by the renderer with the GPU locked!
+{
+	CAPTUREFRAME *frame;
+	word width, height;
+	if (likely(capture_active==0)) return; //Not capturing?
+	if (++capture_intervalcounter<capture_interval) return; //Not this frame?
+	capture_intervalcounter = 0; //Restart counting!
+	capture_getresolution(&width,&height); //What to capture?
+	frame = capture_allocframe(); //The frame to fill!
+	frame->filename[0] = '\0'; //Part of the sequence!
+	frame->number = capture_framenumber++; //The frame number!
+	frame->repeat = 1; //Default: repeat the last frame!
+	if ((GPU.emu_buffer_capturedirty || (width!=capture_lastwidth) || (height!=capture_lastheight)) && width && height) //Changed?
+	{
+		if (capture_copyframe(frame,width,height)) //Copied?
+		{
+			frame->repeat = 0; //New frame!
+			GPU.emu_buffer_capturedirty = 0; //Captured!
+			capture_lastwidth = width; //The last resolution copied!
+			capture_lastheight = height;
+		}
+	}
+	capture_postframe(frame); //Write the frame!
+}
+
+void GPU_captureScreenshot(char *filename) //Write the current frame to a BMP file in the background! Called by the renderer with the GPU locked!
+{
+	CAPTUREFRAME *frame;
+	word width, height;
+	capture_getresolution(&width,&height); //What to capture?
+	if (!(width && height)) return; //Nothing to dump!
+	if (capture_startwriter()==0) //No writer available?
+	{
+		writeBMP(filename,&EMU_BUFFER(0,0),width,height,0,0,EMU_BUFFERPITCH); //Dump our raw screen directly!
+		return;
+	}
+	frame = capture_allocframe(); //The frame to fill!
+	if (capture_copyframe(frame,width,height)==0) return; //Failed to copy!
+	safestrcpy(frame->filename,sizeof(frame->filename),filename); //The screenshot filename!
+	capture_postframe(frame); //Write the screenshot!
+}
+
+byte GPU_startCapture(byte format, uint_32 interval, byte withaudio) //Start capturing every interval frames in the given format, optionally recording the audio with it! 1 on success!
+{
+	char filename[256], firstframe[256];
+	uint_32 i;
+	if (capture_active) GPU_stopCapture(); //Stop capturing first!
+	capture_startwriter(); //Start the writer, if possible!
+	domkdir(capturepath); //Captures directory!
+	i = 0; //For the number!
+	do
+	{
+		snprintf(capture_path,sizeof(capture_path),"%s/capture_%" SPRINTF_u_UINT32,capturepath,++i); //Next sequence directory!
+		snprintf(filename,sizeof(filename),"%s.raw",capture_path); //Next sequence file!
+		snprintf(firstframe,sizeof(firstframe),"%s/%08u.bmp",capture_path,0); //First frame of the next sequence directory!
+	} while (FILE_EXISTS(firstframe) || FILE_EXISTS(filename)); //Still exists?
+	if (format==CAPTURE_RAW) //Raw sequence?
+	{
+		if ((capture_rawfile = emufopen64(filename,"wb"))==NULL) return 0; //Failed to create the file!
+	}
+	else //BMP sequence?
+	{
+		format = CAPTURE_BMP; //Default format!
+		domkdir(capture_path); //Sequence directory!
+	}
+	capture_format = format; //The format to write!
+	capture_interval = interval?interval:1; //The interval to use!
+	capture_intervalcounter = capture_interval-1; //Capture the first frame!
+	capture_framenumber = 0; //Start of the sequence!
+	capture_lastwidth = capture_lastheight = 0; //Force copying the first frame!
+	capture_writtenwidth = capture_writtenheight = 0; //Nothing written yet!
+	if (capture_lastpixels) freez((void **)&capture_lastpixels,capture_lastsize,"CAPTURE_FRAME"); //Nothing to repeat!
+	capture_lastsize = 0;
+	capture_withaudio = withaudio; //Recording audio?
+	if (capture_withaudio) //Record audio with it?
+	{
+		sound_startRecording(); //Start recording the sound!
+	}
+	lockGPU(); //Start at the next frame!
+	capture_active = 1; //Start capturing!
+	unlockGPU();
+	return 1; //Started!
+}
+
+void GPU_stopCapture() //Stop capturing, writing all captured frames!
+{
+	if (capture_active==0) return; //Not capturing?
+	lockGPU(); //Wait for the current frame!
+	capture_active = 0; //Stop capturing!
+	unlockGPU();
+	if (capture_withaudio) //Recording audio with it?
+	{
+		sound_stopRecording(); //Stop recording the sound!
+		capture_withaudio = 0; //Not anymore!
+	}
+	capture_flush(); //Write all captured frames!
+	if (capture_rawfile) //Raw file opened?
+	{
+		emufclose64(capture_rawfile); //Close it!
+		capture_rawfile = NULL; //Closed!
+	}
+}
+
+byte GPU_isCapturing() //Are we capturing?
+{
+	return capture_active; //Are we capturing?
+}
+
+void GPU_doneCapture() //Stop capturing and the writer thread! Rendering must have stopped already!
+{
+	byte entry;
+	if (capture_active) //Still capturing?
+	{
+		capture_active = 0; //Stop capturing!
+		if (capture_withaudio) sound_stopRecording(); //Stop recording the sound!
+		capture_withaudio = 0; //Not anymore!
+	}
+	capture_flush(); //Write everything that's queued!
+	if (capture_rawfile) //Raw file opened?
+	{
+		emufclose64(capture_rawfile); //Close it!
+		capture_rawfile = NULL; //Closed!
+	}
+	if (capture_thread) //Writer running?
+	{
+		lock(LOCK_CAPTURE);
+		capture_quit = 1; //Request to quit!
+		unlock(LOCK_CAPTURE);
+		PostSem(capture_work) //Wake up!
+		waitThreadEnd(capture_thread); //Wait for it to finish!
+		capture_thread = NULL; //Not running anymore!
+		SDL_DestroySemaphore(capture_done);
+		SDL_DestroySemaphore(capture_work);
+		capture_done = NULL;
+		capture_work = NULL;
+	}
+	for (entry=0;entry<CAPTURE_POOLSIZE;++entry) //Free all frames!
+	{
+		if (capture_pool[entry].pixels) freez((void **)&capture_pool[entry].pixels,capture_pool[entry].size,"CAPTURE_FRAME");
+		capture_pool[entry].size = 0;
+	}
+	if (capture_lastpixels) freez((void **)&capture_lastpixels,capture_lastsize,"CAPTURE_FRAME");
+	capture_lastsize = 0;
+	if (capture_row) freez((void **)&capture_row,CAPTURE_ROWSIZE,"CAPTURE_ROW");
+}
@@ -35,6 +35,7 @@ along with The Common Emulator Framework.  If not, see <https://www.gnu.org/lice
 #include "headers/bios/bios.h" //Settings support!
 #ifdef UNIPCEMU
 #include "headers/emu/debugger/debugger.h" //Debugger support!
+#include "headers/emu/profiler.h" //Device profiler support!
 #endif
 
 //Are we disabled?
@@ -224,6 +225,9 @@ void renderFramerate()
 				}
 				#endif
 			}
+			#ifdef DEVICE_PROFILER
+				profiler_render(frameratesurface, PROFILER_ROW); //Show the most expensive devices! After the CPU speed, which prints on the row after the cursor!
+			#endif
 			EMU_drawRecording(6); //Draw the recording flag!
 #ifdef UNIPCEMU
 			EMU_drawBusy(0); //Draw busy flag disk A!
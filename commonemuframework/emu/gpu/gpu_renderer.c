@@ -28,6 +28,7 @@ along with The Common Emulator Framework.  If not, see <https://www.gnu.org/lice
 #include "headers/support/zalloc.h" //Zalloc support!
 #include "headers/emu/gpu/gpu_text.h" //Text rendering support!
 #include "headers/support/locks.h" //Locking support!
+#include "headers/emu/gpu/gpu_capture.h" //Frame capture support!
 
 //Are we disabled?
 #define __HW_DISABLED 0
@@ -111,6 +112,7 @@ void done_GPURenderer() //Cleanup only!
 		freez((void **)&row_empty,row_empty_size,"GPURenderer_EmptyRow"); //Clean up!
 	}
 	GPU_finishRenderer(); //Finish the renderer!
+	GPU_doneCapture(); //Finish capturing!
 }
 
 uint_32 *get_rowempty()
@@ -511,15 +513,11 @@ void renderHWFrame() //Render a frame from hardware!
 			{
 				if (!--SCREEN_CAPTURE) //Capture this frame?
 				{
-					word tempx, tempy;
-					tempx = GPU.xres;
-					tempy = GPU.yres;
-					tempx = (tempx>EMU_MAX_X)?EMU_MAX_X:tempx;
-					tempy = (tempy>EMU_MAX_Y)?EMU_MAX_Y:tempy; //Apply limits!
-					writeBMP(get_screencapture_filename(),&EMU_BUFFER(0,0),tempx,tempy,0,0,EMU_BUFFERPITCH); //Dump our raw screen!
+					GPU_captureScreenshot(get_screencapture_filename()); //Dump our raw screen in the background!
 				}
 			}
 		}
+		GPU_captureFrame(); //Capture the frame, if capturing!
 		GPU_FrameRendered(); //A frame has been rendered, so update our stats!
 		unlockGPU();
 	}
@@ -44,6 +44,7 @@ along with The Common Emulator Framework.  If not, see <https://www.gnu.org/lice
 #include "headers/hardware/ps2_keyboard.h" //Key I/O support!
 #include "headers/support/keyboard.h" //Keyboard I/O support!
 #include "headers/emu/sound.h" //Sound support for connect/disconnect support!
+#include "headers/emu/gpu/gpu_capture.h" //Frame capture support!
 #ifdef VISUALC
 #include "sdl_joystick.h" //Joystick support!
 #include "sdl_events.h" //Event support!
@@ -3747,6 +3748,21 @@ void updateInput(SDL_Event *event) //Update all input!
 					lock(LOCK_MAINTHREAD); //Relock us!
 				}
 				break;
+			case SDLK_F7: //F7? Start/stop frame capture, recording the sound along with it!
+				if (RALT) //ALT-F7?
+				{
+					unlock(LOCK_MAINTHREAD); //We're not doing anything right now!
+					if (GPU_isCapturing()) //Capturing?
+					{
+						GPU_stopCapture(); //Stop capturing!
+					}
+					else //Not capturing?
+					{
+						GPU_startCapture(CAPTURE_DEFAULTFORMAT,CAPTURE_DEFAULTINTERVAL,1); //Start capturing with sound!
+					}
+					lock(LOCK_MAINTHREAD); //Relock us!
+				}
+				break;
 			case SDLK_F9: //F9? Used to kill Dosbox. Since we use F4 for that, do special actions for debugging errors!
 				if (RALT) //ALT-F9?
 				{
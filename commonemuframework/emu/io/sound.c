@@ -54,6 +54,13 @@
 //Define RECORD_TESTWAVE to make it record a test sine wave instead.
 //#define RECORD_TESTWAVE 1.0
 
+//Maximum amount of mixer worker threads to render parallel channels on, next to the mixing thread itself. 0 disables parallel mixing.
+#ifdef IS_PSP
+#define SOUND_MIXTHREADS 0
+#else
+#define SOUND_MIXTHREADS 3
+#endif
+
 //What frequency to filter our sound for (higher than 0Hz!) Currently the high pass filter disturbs sound too much, so it's disabled. Low pass is set to half the rendering frequency!
 //#define SOUND_HIGHPASS 18.2f
 #define SOUND_CHANNELHIGHPASS 18.2f
@@ -75,6 +82,7 @@ typedef struct
 {
 	void *samples; //All samples!
 	int_32 *filteredsamples;
+	float *floatsamples; //Samples being filtered!
 	HIGHLOWPASSFILTER samplefilter[2]; //Filter to be applied to get the filtered samples.
 	HIGHLOWPASSFILTER highpasssamplefilter[2]; //Filter to be applied to get the filtered samples.
 	uint_32 length;		/* size of sound data in bytes */
@@ -105,6 +113,7 @@ typedef struct
 	byte samplemethod; //The method used to decode samples!
 	byte highpassfilter; //High pass filter the signal?
 	byte bufferflags; //Special flags about the buffer from the soundhandler function!
+	byte parallel; //Can the channel be rendered on a mixer worker thread?
 	//Fill and processbuffer to use!
 	void *fillbuffer; //Fillbuffer function to use!
 	void *processbuffer; //Channelbuffer function to use (determined by fillbuffer function)!
@@ -255,6 +264,24 @@ byte setStereo(SOUNDHANDLER handler, void *extradata, byte stereo) //Channel&Vol
 	return 0; //Not found!
 }
 
+byte setParallel(SOUNDHANDLER handler, void *extradata, byte parallel) //Allow the channel to be rendered on a mixer worker thread?
+{
+	if (__HW_DISABLED) return 0; //Disabled?
+	uint_32 n;
+	lockaudio(); //Lock the audio!
+	for (n=0;n<soundchannels_used;n++) //Check all!
+	{
+		if (soundchannels[n].soundhandler && (soundchannels[n].soundhandler==handler) && (soundchannels[n].extradata==extradata)) //Found?
+		{
+			soundchannels[n].parallel = (parallel?1:0); //Are we rendered in parallel?
+			unlockaudio(); //Unlock the audio!
+			return 1; //Done: check no more!
+		}
+	}
+	unlockaudio(); //Unlock the audio!
+	return 0; //Not found!
+}
+
 byte setSampleRate(SOUNDHANDLER handler, void *extradata, float rate)
 {
 	if (__HW_DISABLED) return 0; //Disabled?
@@ -385,6 +412,7 @@ byte addchannel(SOUNDHANDLER handler, void *extradata, char *name, float sampler
 			soundchannels[n].soundhandler = handler; //Set handler!
 			soundchannels[n].fillbuffer = &fillbuffer_new; //Our fillbuffer call to start with!
 			soundchannels[n].extradata = extradata; //Extra data to be sent!
+			soundchannels[n].parallel = 0; //Default: rendered by the mixer itself!
 			soundchannels[n].sound.numsamples = samples; //Ammount of samples to buffer at a time!
 			memset(&soundchannels[n].name,0,sizeof(soundchannels[n].name)); //Init name!
 			safestrcpy(soundchannels[n].name,sizeof(soundchannels[0].name),name); //Set a name to use for easy viewing/debugging!
@@ -419,6 +447,13 @@ byte addchannel(SOUNDHANDLER handler, void *extradata, char *name, float sampler
 			soundchannels[n].sound.samples = zalloc(soundchannels[n].sound.length,"SW_Samples",NULL);
 			soundchannels[n].sound.filteredlength = (soundchannels[n].sound.numsamples<<1)*(uint_32)sizeof(int_32); //Ammount of samples in the buffer, stereo quality (even if mono used)!
 			soundchannels[n].sound.filteredsamples = zalloc(soundchannels[n].sound.filteredlength,"SW_Samples",NULL);
+			soundchannels[n].sound.floatsamples = zalloc((soundchannels[n].sound.numsamples<<1)*(uint_32)sizeof(float),"SW_FloatSamples",NULL);
+			if (!soundchannels[n].sound.floatsamples) //Can't filter?
+			{
+				removechannel(handler,extradata,0);
+				unlockaudio(); //Unlock audio and start playing!
+				return 0; //Abort!
+			}
 			initSoundFilter(&soundchannels[n].sound.samplefilter[0],0,(float)(SW_SAMPLERATE/2.0),samplerate); //Left filter!
 			initSoundFilter(&soundchannels[n].sound.samplefilter[1],0,(float)(SW_SAMPLERATE/2.0),samplerate); //Right filter!
 			initSoundFilter(&soundchannels[n].sound.highpasssamplefilter[0], 1, SOUND_CHANNELHIGHPASS, samplerate); //Left filter!
@@ -474,9 +509,14 @@ void removechannel(SOUNDHANDLER handler, void *extradata, byte is_hw) //Removes
 				}
 			}
 			
+			if (soundchannels[n].sound.floatsamples) //Filter buffer allocated?
+			{
+				freez((void **)&soundchannels[n].sound.floatsamples,(soundchannels[n].sound.numsamples<<1)*(uint_32)sizeof(float),"SW_FloatSamples"); //Free samples!
+			}
 			//Next remove our handler and the channel itself!
 			soundchannels[n].soundhandler = NULL; //Stop the handler from availability!
 			soundchannels[n].extradata = NULL; //No extra data anymore!
+			soundchannels[n].parallel = 0; //Not parallel anymore!
 
 			#ifdef DEBUG_SOUNDALLOC
 			dolog("soundservice","Channel %p:%p:%s released and ready to continue.",handler,extradata,soundchannels[n].name);
@@ -628,24 +668,44 @@ OPTINLINE void processbufferflags(playing_p currentchannel)
 	maxval = soundbuffer_maxval; //Fast load!
 	minval = soundbuffer_minval; //Fast load!
 	float sample;
+	float *floatsamples;
 	byte stereobit;
 	stereobit = (C_STEREO(currentchannel)&1); //Stereo bit/toggle!
 	currentchannel->processbuffer = (currentchannel->bufferflags&1)?&filledchannelbuffer:&emptychannelbuffer; //Either the filled or empty channel buffer to use!
 	numsamples = (C_BUFFERSIZE(currentchannel)<<C_STEREO(currentchannel)); //How many to process?
 	if (unlikely(currentchannel->bufferflags & 1)) //Got anything to process at all? Don't do anything with the samples if not needed!
 	{
-		for (samplepos = 0; samplepos < numsamples; ++samplepos) //Parse output!
+		floatsamples = currentchannel->sound.floatsamples; //Where to filter!
+		for (samplepos = 0; samplepos < numsamples; ++samplepos) //Load the input!
 		{
 			sample = (float)(getsample_raw(currentchannel, samplepos)); //Store raw samples for now, unfiltered!
 #ifdef SOUND_FILTER_VOLUME
 			sample *= sound_filter_volume; //Protect against overflows!
-			applySoundLowPassFilter(&currentchannel->sound.samplefilter[samplepos & stereobit], &sample); //Apply the left/right filter!
+#endif
+			floatsamples[samplepos] = sample; //Filter this sample!
+		}
+#ifdef SOUND_FILTER_VOLUME
+		//Filter the entire block at once!
+		if (stereobit) //Stereo?
+		{
+			applySoundFilterBlockStereo(&currentchannel->sound.samplefilter[0], &currentchannel->sound.samplefilter[1], floatsamples, (numsamples>>1)); //Apply the left/right filter!
 			if (currentchannel->highpassfilter) //High-pass filter enabled?
 			{
-				applySoundHighPassFilter(&currentchannel->sound.highpasssamplefilter[samplepos & stereobit], &sample); //Apply the left/right filter!
+				applySoundFilterBlockStereo(&currentchannel->sound.highpasssamplefilter[0], &currentchannel->sound.highpasssamplefilter[1], floatsamples, (numsamples>>1)); //Apply the left/right filter!
 			}
+		}
+		else //Mono?
+		{
+			applySoundFilterBlock(&currentchannel->sound.samplefilter[0], floatsamples, numsamples); //Apply the filter!
+			if (currentchannel->highpassfilter) //High-pass filter enabled?
+			{
+				applySoundFilterBlock(&currentchannel->sound.highpasssamplefilter[0], floatsamples, numsamples); //Apply the filter!
+			}
+		}
 #endif
-			sample = LIMITRANGE(sample, minval, maxval); //Limit to valid range!
+		for (samplepos = 0; samplepos < numsamples; ++samplepos) //Parse output!
+		{
+			sample = LIMITRANGE(floatsamples[samplepos], minval, maxval); //Limit to valid range!
 			currentchannel->sound.filteredsamples[samplepos] = (int_32)sample; //Save the filtered sample!
 		}
 	}
@@ -868,7 +928,127 @@ byte getRecordedSampleR8u()
 
 int_32 mixedsamples[SAMPLESIZE*2]; //All mixed samples buffer!
 
+//Channel types to mix!
+#define MIXCHANNELS_SERIAL 1
+#define MIXCHANNELS_PARALLEL 2
+
+OPTINLINE void mixchannels(uint_32 firstchannel, uint_32 endchannel, int_32 *samples, uint_32 length, byte types) //Mix a range of channels into a buffer!
+{
+	uint_32 currentsample;
+	playing_p activechannel; //Current channel!
+	int_32 *firstactivesample;
+	int_32 *activesample;
+	if (firstchannel>=endchannel) return; //Nothing to mix!
+	activechannel = &soundchannels[firstchannel]; //Lookup the first channel!
+	for (;;) //Mix the next channel!
+	{
+		if (activechannel->soundhandler && (types&(activechannel->parallel?MIXCHANNELS_PARALLEL:MIXCHANNELS_SERIAL))) //Active and to be mixed?
+		{
+			if (activechannel->samplerate && activechannel->sound.samples && activechannel->sound.filteredsamples && activechannel->sound.floatsamples /*&&
+				memprotect(activechannel->sound.samples,activechannel->sound.length,"SW_Samples")*/) //Allocated all neccesary channel data?
+			{
+				currentsample = length; //The ammount of sample to still buffer!
+				activesample = samples; //Init active sample to the first sample!
+				if (!(activechannel->bufferflags & 1)) //Empty channel buffer?
+				{
+					activechannel->fillbuffer = &fillbuffer_new; //We're not yet initialised, so call check for initialisation from now on!
+				}
+				for (;;) //Process all samples!
+				{
+					firstactivesample = activesample++; //First channel sample!
+					mixchannel(activechannel,firstactivesample,activesample++); //L&R channel!
+					if (activechannel->fillbuffer==&fillbuffer_new) break; //Stop procesing the channel if there's nothing left to process!
+					if (!--currentsample) break; //Next sample when still not done!
+				}
+			}
+		}
+		if (++firstchannel>=endchannel) break; //Stop when no channels left!
+		++activechannel; //Next channel!
+	}
+}
+
+#if SOUND_MIXTHREADS
+/*
+
+Mixer workers: each worker mixes its range of parallel channels into its own buffer.
+The mixer adds the buffers together in a fixed order, so the output doesn't depend on the amount of workers.
+
+*/
+
+typedef struct
+{
+	SDL_Thread *thread; //The worker thread!
+	SDL_sem *start; //Start mixing!
+	SDL_sem *done; //Finished mixing!
+	byte quit; //Terminate the worker?
+	uint_32 firstchannel; //First channel to mix!
+	uint_32 endchannel; //The channel after the final channel to mix!
+	uint_32 length; //Amount of samples to mix!
+	int_32 mixedsamples[SAMPLESIZE*2]; //Our mixed samples buffer!
+} MIXERWORKER;
+
+MIXERWORKER mixerworkers[SOUND_MIXTHREADS]; //All mixer workers!
+byte mixerworkers_used = 0; //How many mixer workers are running?
+
+int mixerworker_thread(void *data)
+{
+	MIXERWORKER *worker = (MIXERWORKER *)data; //Our worker!
+	for (;;) //Keep mixing!
+	{
+		SDL_SemWait(worker->start); //Wait for work!
+		if (worker->quit) break; //Terminating?
+		memset(&worker->mixedsamples,0,(worker->length<<1)*sizeof(worker->mixedsamples[0])); //Init mixed samples, stereo!
+		mixchannels(worker->firstchannel,worker->endchannel,&worker->mixedsamples[0],worker->length,MIXCHANNELS_PARALLEL); //Mix our parallel channels!
+		SDL_SemPost(worker->done); //We're finished!
+	}
+	return 0; //Finished!
+}
+
+void startMixerWorkers() //Start the mixer workers, if supported!
+{
+	int numworkers;
+	byte worker;
+	if (mixerworkers_used) return; //Already running!
+	numworkers = SDL_GetCPUCount()-1; //Leave one core for the emulation itself!
+	if (numworkers>SOUND_MIXTHREADS) numworkers = SOUND_MIXTHREADS; //Limit to what we support!
+	for (worker=0;((int)worker)<numworkers;++worker) //Start all workers!
+	{
+		memset(&mixerworkers[worker],0,sizeof(mixerworkers[worker])); //Init!
+		mixerworkers[worker].start = SDL_CreateSemaphore(0); //Not started yet!
+		mixerworkers[worker].done = SDL_CreateSemaphore(0); //Not finished yet!
+		if (mixerworkers[worker].start && mixerworkers[worker].done) //Valid?
+		{
+			mixerworkers[worker].thread = SDL_CreateThread(&mixerworker_thread,"MixerWorker",&mixerworkers[worker]); //Start the worker!
+		}
+		if (mixerworkers[worker].thread==NULL) //Failed to start?
+		{
+			if (mixerworkers[worker].start) SDL_DestroySemaphore(mixerworkers[worker].start);
+			if (mixerworkers[worker].done) SDL_DestroySemaphore(mixerworkers[worker].done);
+			dolog("soundservice","Unable to start mixer worker thread: %s",SDL_GetError());
+			break; //Stop starting workers: use what we've got!
+		}
+		++mixerworkers_used; //One more worker running!
+	}
+}
+
+void stopMixerWorkers() //Stop the mixer workers!
+{
+	byte worker;
+	for (worker=0;worker<mixerworkers_used;++worker) //Stop all workers!
+	{
+		mixerworkers[worker].quit = 1; //Request to quit!
+		SDL_SemPost(mixerworkers[worker].start); //Wake up!
+		SDL_WaitThread(mixerworkers[worker].thread,NULL); //Wait for it to finish!
+		SDL_DestroySemaphore(mixerworkers[worker].start);
+		SDL_DestroySemaphore(mixerworkers[worker].done);
+		memset(&mixerworkers[worker],0,sizeof(mixerworkers[worker])); //Cleanup!
+	}
+	mixerworkers_used = 0; //No workers anymore!
+}
+#endif
+
 WAVEFILE *recording = NULL; //We are recording when set.
+word recordedsamples[SAMPLESIZE*2]; //The block of samples to record!
 
 byte mixerready = 0; //Are we ready to give output to the buffer?
 byte inputready = 0; //Are we ready to give output to the buffer?
@@ -886,10 +1066,14 @@ OPTINLINE void mixaudio(uint_32 length) //Mix audio channels to buffer!
 #endif
 	INLINEREGISTER int_32 result_l, result_r; //Sample buffer!
 	sword temp_l, temp_r; //Filtered values!
+	word *recordedsample; //The current recorded sample!
 	//Active data
-	playing_p activechannel; //Current channel!
-	int_32 *firstactivesample;
 	int_32 *activesample;
+#if SOUND_MIXTHREADS
+	int_32 *workersample;
+	uint_32 channelsperworker, currentchannel;
+	byte worker;
+#endif
 	
 	//Stuff for Master gain
 #ifndef IS_PSP
@@ -904,31 +1088,39 @@ OPTINLINE void mixaudio(uint_32 length) //Mix audio channels to buffer!
 	if (length>SAMPLESIZE) length = SAMPLESIZE; //Limit us to what we CAN render!
 	if (channelsleft)
 	{
-		activechannel = &soundchannels[0]; //Lookup the first channel!
-		for (;;) //Mix the next channel!
+#if SOUND_MIXTHREADS
+		if (mixerworkers_used) //Mixing parallel channels on the workers?
 		{
-			if (activechannel->soundhandler) //Active?
+			//Split all channels into consecutive ranges: the first one for ourselves, the others for the workers!
+			channelsperworker = ((channelsleft+mixerworkers_used)/(mixerworkers_used+1)); //How many channels for each of us!
+			currentchannel = channelsperworker; //The workers start after our own range!
+			for (worker=0;worker<mixerworkers_used;++worker) //Start all workers!
+			{
+				mixerworkers[worker].firstchannel = MIN(currentchannel,channelsleft); //First channel!
+				currentchannel += channelsperworker; //Next range!
+				mixerworkers[worker].endchannel = MIN(currentchannel,channelsleft); //End of our channels!
+				mixerworkers[worker].length = length; //How much to mix!
+				SDL_SemPost(mixerworkers[worker].start); //Start mixing!
+			}
+			mixchannels(0,channelsleft,&mixedsamples[0],length,MIXCHANNELS_SERIAL); //Mix all channels that aren't rendered in parallel!
+			mixchannels(0,MIN(channelsperworker,channelsleft),&mixedsamples[0],length,MIXCHANNELS_PARALLEL); //Mix our own range of parallel channels!
+			for (worker=0;worker<mixerworkers_used;++worker) //Reduce all workers into the mix, always in the same order!
 			{
-				if (activechannel->samplerate && activechannel->sound.samples && activechannel->sound.filteredsamples /*&&
-					memprotect(activechannel->sound.samples,activechannel->sound.length,"SW_Samples")*/) //Allocated all neccesary channel data?
+				SDL_SemWait(mixerworkers[worker].done); //Wait for the worker to finish!
+				currentsample = (length<<1); //How many samples to add!
+				activesample = &mixedsamples[0]; //Our output!
+				workersample = &mixerworkers[worker].mixedsamples[0]; //The worker output!
+				for (;;) //Add all samples!
 				{
-					currentsample = length; //The ammount of sample to still buffer!
-					activesample = &mixedsamples[0]; //Init active sample to the first sample!
-					if (!(activechannel->bufferflags & 1)) //Empty channel buffer?
-					{
-						activechannel->fillbuffer = &fillbuffer_new; //We're not yet initialised, so call check for initialisation from now on!
-					}
-					for (;;) //Process all samples!
-					{
-						firstactivesample = activesample++; //First channel sample!
-						mixchannel(activechannel,firstactivesample,activesample++); //L&R channel!
-						if (activechannel->fillbuffer==&fillbuffer_new) break; //Stop procesing the channel if there's nothing left to process!
-						if (!--currentsample) break; //Next sample when still not done!
-					}
+					*activesample++ += *workersample++; //Add the worker's sample!
+					if (!--currentsample) break; //Finished?
 				}
 			}
-			if (!--channelsleft) break; //Stop when no channels left!
-			++activechannel; //Next channel!
+		}
+		else //Mixing all channels ourselves?
+#endif
+		{
+			mixchannels(0,channelsleft,&mixedsamples[0],length,MIXCHANNELS_SERIAL|MIXCHANNELS_PARALLEL); //Mix all channels!
 		}
 	} //Got channels?
 
@@ -964,6 +1156,7 @@ OPTINLINE void mixaudio(uint_32 length) //Mix audio channels to buffer!
 	//Final step: apply Master gain and clip to output!
 	currentsample = length; //Init samples to give!
 	activesample = &mixedsamples[0]; //Initialise the mixed samples position!
+	recordedsample = &recordedsamples[0]; //Initialise the recorded samples position!
 	for (;;)
 	{
 		result_l = *activesample++; //L channel!
@@ -987,7 +1180,9 @@ OPTINLINE void mixaudio(uint_32 length) //Mix audio channels to buffer!
 		result_r = temp_r; //Write back!
 
 		//Apply recording of sound!
-		if (recording) writeWAVStereoSample(recording,result_l,result_r); //Write the recording to the file if needed!
+		recordedsample[0] = (word)result_l; //Left sample to record!
+		recordedsample[1] = (word)result_r; //Right sample to record!
+		recordedsample += 2; //Next sample!
 
 		if (((haswindowactive&4)==0) && (backgroundpolicy<2)) //Not to sound audio?
 		{
@@ -1005,8 +1200,11 @@ OPTINLINE void mixaudio(uint_32 length) //Mix audio channels to buffer!
 			writeDoubleBufferedSound32(&mixeroutput,(signed2unsigned16((sword)result_r)<<16)|signed2unsigned16((sword)result_l)); //Give the stereo output to the mixer!
 #endif
 		}
-		if (!--currentsample) return; //Finished!
+		if (!--currentsample) break; //Finished!
 	}
+
+	//Apply recording of sound!
+	if (recording) writeWAVSamples(recording,&recordedsamples[0],length); //Write the recording to the file if needed, as a single block!
 }
 
 OPTINLINE void recordaudio(uint_32 length) //Record audio channels to state!
@@ -1696,6 +1894,10 @@ void initAudio() //Initialises audio subsystem!
 		inputleft = inputright = 0; //Clear input samples!
 		currentrecordedsample = (signed2unsigned16(0)<<8)|signed2unsigned16(0); //Clear the currently recorded sample to initialize it!
 
+		#if SOUND_MIXTHREADS
+		startMixerWorkers(); //Start rendering parallel channels on the mixer workers!
+		#endif
+
 		//Finish up to start playing!
 		calc_samplePos(); //Initialise sample position precalcs!
 		PAUSEAUDIO(0); //Start playing!
@@ -1739,6 +1941,12 @@ void doneAudio()
 		SDLAudio_Loaded = 0; //Not loaded anymore!
 	}
 
+	#if SOUND_MIXTHREADS
+	lockaudio(); //Make sure we're not mixing!
+	stopMixerWorkers(); //Stop the mixer workers!
+	unlockaudio(); //Finished!
+	#endif
+
 	if (mixerready)
 	{
 		freeDoubleBufferedSound(&mixeroutput); //Release our double buffered output!
@@ -126,6 +126,7 @@ typedef struct
 	uint_32 framenr; //Current frame number (for Frameskip, kept 0 elsewise.)
 
 	uint_32 emu_buffer_dirty; //Emu screenbuffer dirty: needs re-rendering?
+	byte emu_buffer_capturedirty; //Emu screenbuffer changed since the last captured frame?
 
 	//Text surface support!
 	Handler textrenderers[10]; //Every surface can have a handler to draw!
@@ -0,0 +1,61 @@
+/*
+
+Copyright (C) 2019 - 2021 Superfury
+
+This file is part of The Common Emulator Framework.
+
+The Common Emulator Framework is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+The Common Emulator Framework is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with The Common Emulator Framework.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef GPU_CAPTURE_H
+#define GPU_CAPTURE_H
+
+#include "headers/types.h" //Basic types!
+
+//Capture formats!
+#define CAPTURE_BMP 0
+#define CAPTURE_RAW 1
+
+//Default settings used by the capture hotkey!
+#define CAPTURE_DEFAULTFORMAT CAPTURE_BMP
+#define CAPTURE_DEFAULTINTERVAL 1
+
+/*
+
+Raw captures are written as a single file, containing for every frame:
+- a CAPTURE_RAWFRAME header
+- width*height pixels of 4 bytes each, in R,G,B,A order, top row first.
+
+*/
+
+#include "headers/packed.h" //Packed type!
+typedef struct PACKED
+{
+	uint_32 signature; //CAPTURE_RAWSIGNATURE
+	uint_32 width; //Width of the frame!
+	uint_32 height; //Height of the frame!
+	uint_32 number; //Frame number in the sequence!
+} CAPTURE_RAWFRAME;
+#include "headers/endpacked.h" //End of packed type!
+
+#define CAPTURE_RAWSIGNATURE 0x4D524655
+
+byte GPU_startCapture(byte format, uint_32 interval, byte withaudio); //Start capturing every interval frames in the given format, optionally recording the audio with it! 1 on success!
+void GPU_stopCapture(); //Stop capturing, writing all captured frames!
+byte GPU_isCapturing(); //Are we capturing?
+void GPU_captureFrame(); //Capture a finished frame, if capturing! Called by the renderer with the GPU locked!
+void GPU_captureScreenshot(char *filename); //Write the current frame to a BMP file in the background! Called by the renderer with the GPU locked!
+void GPU_doneCapture(); //Stop capturing and the writer thread!
+
+#endif
@@ -59,6 +59,7 @@ void removechannel(SOUNDHANDLER handler, void *extradata, byte is_hw); //Removes
 void resetchannels(); //Stop all channels&reset!
 byte setVolume(SOUNDHANDLER handler, void *extradata, float p_volume); //Channel&Volume(100.0f=100%)
 byte setSampleRate(SOUNDHANDLER handler, void *extradata, float rate); //Set sample rate!
+byte setParallel(SOUNDHANDLER handler, void *extradata, byte parallel); //Allow the channel to be rendered on a mixer worker thread? Only for handlers that don't share state with other channels!
 
 byte sound_isRecording(); //Are we recording?
 void sound_startRecording(); //Start sound recording?
@@ -21,6 +21,10 @@ along with The Common Emulator Framework.  If not, see <https://www.gnu.org/lice
 #ifndef BMP_H
 #define BMP_H
 
+//Size of a row of a written BMP file of w pixels wide, including padding!
+#define BMP_ROWSIZE(w) ((((uint_32)(w)*3)+3)&~3)
+
 byte writeBMP(char *thefilename, uint_32 *image, int w, int h, byte doublexres, byte doubleyres, int virtualwidth); //1 on success, 0 on failure!
+byte writeBMProw(char *thefilename, uint_32 *image, int w, int h, byte doublexres, byte doubleyres, int virtualwidth, byte *rowbuffer, uint_32 rowbuffersize); //Same as writeBMP, but using the given row buffer of at least BMP_ROWSIZE bytes instead of allocating one! 1 on success, 0 on failure!
 
 #endif
\ No newline at end of file
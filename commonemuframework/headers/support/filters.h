@@ -48,5 +48,7 @@ void updateSoundFilter(HIGHLOWPASSFILTER *filter, byte ishighpass, float cutoff_
 void applySoundHighPassFilter(HIGHLOWPASSFILTER *filter, float *currentsample); //Apply the filter to a sample stream!
 void applySoundLowPassFilter(HIGHLOWPASSFILTER *filter, float *currentsample); //Apply the filter to a sample stream!
 void applySoundFilter(HIGHLOWPASSFILTER *filter, float *currentsample); //Apply the filter to a sample stream!
+void applySoundFilterBlock(HIGHLOWPASSFILTER *filter, float *samples, uint_32 numsamples); //Apply the filter to a block of samples!
+void applySoundFilterBlockStereo(HIGHLOWPASSFILTER *filterl, HIGHLOWPASSFILTER *filterr, float *samples, uint_32 numframes); //Apply the left and right filters to a block of interleaved stereo samples!
 
 #endif
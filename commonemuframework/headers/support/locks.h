@@ -43,7 +43,11 @@ SDL_sem *getLock(byte id); //For termination of locks!
 #define LOCK_DISKINDICATOR 12
 #define LOCK_PCAP 13
 #define LOCK_PCAPFLAG 14
+#define LOCK_DISKWORKER 15
+#define LOCK_DISKIO 16
+#define LOCK_WAVE 17
+#define LOCK_CAPTURE 18
 //Finally MIDI locks, when enabled!
-//#define MIDI_LOCKSTART 15
+//#define MIDI_LOCKSTART 19
 
 #endif
@@ -24,6 +24,11 @@ along with The Common Emulator Framework.  If not, see <https://www.gnu.org/lice
 #include "headers/types.h" //Basic types!
 #include "headers/support/fifobuffer.h" //FIFO buffer for transferred data!
 
+//Size of the send and receive buffers of a connection! Must be a power of 2!
+#define TCP_BUFFERSIZE 0x4000
+//How much buffered data to send automatically, without waiting for a flush!
+#define TCP_SENDTHRESHOLD 0x1000
+
 //Based on http://stephenmeier.net/2015/12/23/sdl-2-0-tutorial-04-networking/
 
 //General support for the backend.
@@ -41,6 +46,9 @@ void stopTCPServer(); //Stop the TCP server!
 sword TCP_ConnectClient(const char *destination, word port); //Connect as a client!
 byte TCP_SendData(sword id, byte data); //Send data to the other side(both from server and client).
 sbyte TCP_ReceiveData(sword id, byte *result); //Receive data, if available. 0=No data, 1=Received data, -1=Not connected anymore!
+int_32 TCP_SendBuffer(sword id, byte *data, uint_32 size); //Buffer data to send, sending it once enough is buffered. Result: amount of data buffered, -1=Not connected or the connection has failed!
+int_32 TCP_ReceiveBuffer(sword id, byte *data, uint_32 size); //Receive buffered data, receiving a block when nothing is buffered. Result: amount of data received, 0=No data, -1=Not connected anymore!
+byte TCP_FlushBuffer(sword id); //Send all buffered data. 1=Everything has been sent, 0=Failed to send(the connection has failed and the buffered data is discarded) or not connected!
 byte TCP_DisconnectClientServer(sword id); //Disconnect either the client or server, whatever state we're currently using.
 
 #endif
\ No newline at end of file
@@ -23,6 +23,7 @@ along with The Common Emulator Framework.  If not, see <https://www.gnu.org/lice
 
 #include "headers/types.h" //Basic types!
 #include "headers/fopen64.h"
+#include "headers/emu/threads.h" //Thread support!
 
 #include "headers/packed.h" //Packed type!
 typedef struct PACKED
@@ -43,16 +44,41 @@ typedef struct PACKED
 } WAVEHEADER;
 #include "headers/endpacked.h" //End of packed type!
 
+//Size of a single chunk of recorded data written to the file at once!
+#define WAVE_CHUNKSIZE 0x10000
+//Amount of chunks in the recording ring buffer!
+#define WAVE_CHUNKS 8
+//Update the RIFF sizes in the file every this many chunks written!
+#define WAVE_HEADERINTERVAL 16
+
 typedef struct
 {
 	BIGFILE *f; //The file itself!
 	WAVEHEADER header; //Full version of the WAVE header to be written to the file when closed!
 	char filename[256]; //Full filename!
+	//Recording ring buffer: filled by the emulation, written in chunks by the writer thread!
+	byte *buffer; //All chunks of the ring buffer!
+	uint_32 chunksize[WAVE_CHUNKS]; //Filled size of each queued chunk!
+	byte *fillpos; //Current position in the chunk being filled!
+	byte *fillend; //End of the chunk being filled!
+	byte fillchunk; //The chunk being filled!
+	byte writechunk; //The first chunk queued for writing!
+	byte queued; //Amount of chunks queued for writing!
+	byte quit; //Terminate the writer thread?
+	byte writeerror; //A write to the file has failed?
+	byte fillerror; //A write error has been seen by the emulation?
+	byte chunkswritten; //Chunks written since the RIFF sizes have been updated!
+	FILEPOS datasize; //Amount of data written to the file!
+	ThreadParams_p writer; //The writer thread, if any! Written directly by the emulation otherwise!
+	SDL_sem *done; //Posted once for each waiting thread whenever a chunk has been written!
+	SDL_sem *work; //Posted whenever a chunk has been queued!
+	uint_32 waiting; //Amount of threads waiting on done!
 } WAVEFILE;
 
 WAVEFILE *createWAV(char *filename, byte channels, uint_32 samplerate);
 byte writeWAVMonoSample(WAVEFILE *f, word sample);
 byte writeWAVStereoSample(WAVEFILE *f, word lsample, word rsample);
+byte writeWAVSamples(WAVEFILE *f, void *samples, uint_32 count); //Write a block of count samples(of all channels) at once!
 void closeWAV(WAVEFILE **f);
 
 #endif
\ No newline at end of file
@@ -22,6 +22,7 @@ along with The Common Emulator Framework.  If not, see <https://www.gnu.org/lice
 #include "headers/support/zalloc.h" //Zero allocation support!
 #include "headers/support/log.h" //Logging support!
 #include "headers/fopen64.h" //64-bit fopen support!
+#include "headers/support/bmp.h" //Our own definitions!
 
 //Are we disabled?
 #define __HW_DISABLED 0
@@ -113,7 +114,7 @@ OPTINLINE void getBMP(TRGB *pixel,int x, int y, uint_32 *image, int h, int virtu
 	pixel->B = (byte)b;
 }
 
-byte writeBMP(char *thefilename, uint_32 *image, int w, int h, byte doublexres, byte doubleyres, int virtualwidth)
+byte writeBMProw(char *thefilename, uint_32 *image, int w, int h, byte doublexres, byte doubleyres, int virtualwidth, byte *rowbuffer, uint_32 rowbuffersize)
 {
 	int originalw, originalh;
 	char filename[256];
@@ -124,7 +125,8 @@ byte writeBMP(char *thefilename, uint_32 *image, int w, int h, byte doublexres,
 	TBMPInfoHeader BMPInfo; //Info about the BMP!
 	uint_32 dataStartOffset;
 	static byte bmppad[3] = {0,0,0}; //For padding!
-	TRGB pixel; //A pixel for writing to the file!
+	TRGB *row; //A row of pixels for writing to the file!
+	uint_32 rowsize; //The size of a row!
 	int y = 0;
 	int x = 0;
 
@@ -168,7 +170,15 @@ byte writeBMP(char *thefilename, uint_32 *image, int w, int h, byte doublexres,
 
 	//Now write the file!
 
+	rowsize = (sizeof(TRGB)*w)+rowpadding; //The size of a row, including padding!
+	if ((rowbuffer==NULL) || (rowbuffersize<rowsize)) return 0; //Can't write without a row!
+	row = (TRGB *)rowbuffer; //A row to write at once!
+
 	f = emufopen64(filename,"wb");
+	if (!f) //Failed to create?
+	{
+		return 0; //Failure!
+	}
 	emufwrite64(&BMPHeader,1,sizeof(BMPHeader),f); //Write the header!
 	emufwrite64(&BMPInfo,1,sizeof(BMPInfo),f); //Write the header!
 
@@ -176,12 +186,30 @@ byte writeBMP(char *thefilename, uint_32 *image, int w, int h, byte doublexres,
 	{
 		for (x=0;x<w;x++) //Process all columns!
 		{
-			getBMP(&pixel,x,y,image,h,virtualwidth,doublexres,doubleyres,originalw,originalh); //Get the pixel to be written!
-			emufwrite64(&pixel,1,sizeof(pixel),f); //Write the pixel to the file!
+			getBMP(&row[x],x,y,image,h,virtualwidth,doublexres,doubleyres,originalw,originalh); //Get the pixel to be written!
 		}
-		emufwrite64(&bmppad,1,(int_64)rowpadding,f); //Write the padding!
+		memcpy(&row[w],&bmppad,rowpadding); //Apply the padding!
+		emufwrite64(row,1,rowsize,f); //Write the row, including padding, to the file!
 	}
 
 	emufclose64(f);
 	return 1; //Success!
+}
+
+byte writeBMP(char *thefilename, uint_32 *image, int w, int h, byte doublexres, byte doubleyres, int virtualwidth)
+{
+	byte *row; //A row of pixels for writing to the file!
+	uint_32 rowsize; //The size of a row!
+	byte result;
+	if (__HW_DISABLED) return 0; //Abort!
+	if (!w || !h)
+	{
+		return 0; //Can't write: empty height/width!
+	}
+	rowsize = BMP_ROWSIZE(w<<doublexres); //The size of a row, including padding!
+	row = (byte *)zalloc(rowsize,"BMPROW",NULL); //A row to write at once!
+	if (!row) return 0; //Can't write without a row!
+	result = writeBMProw(thefilename,image,w,h,doublexres,doubleyres,virtualwidth,row,rowsize); //Write the file!
+	freez((void **)&row,rowsize,"BMPROW"); //Release the row!
+	return result; //Give the result!
 }
\ No newline at end of file
@@ -20,6 +20,22 @@ along with The Common Emulator Framework.  If not, see <https://www.gnu.org/lice
 
 #include "headers/support/filters.h" //Our filter definitions!
 
+//Use SIMD instructions to filter blocks of samples when available? Comment out to always use the portable filters!
+#define SOUND_FILTER_SIMD
+
+#ifdef SOUND_FILTER_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP>=2))
+#include <emmintrin.h> //SSE2 support!
+#define SOUND_FILTER_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h> //NEON support!
+#define SOUND_FILTER_NEON
+#endif
+#endif
+
+//Filter results closer to zero than this are flushed to zero after a block, so a silent channel doesn't decay into denormals!
+#define SOUND_FILTER_DENORMAL 1e-15f
+
 void updateSoundFilter(HIGHLOWPASSFILTER *filter, byte ishighpass, float cutoff_freq, float samplerate)
 {
 	if (filter->isInit || (filter->cutoff_freq!=cutoff_freq) || (filter->samplerate!=samplerate) || (ishighpass!=filter->isHighPass)) //We're to update?
@@ -79,3 +95,290 @@ void applySoundLowPassFilter(HIGHLOWPASSFILTER *filter, float *currentsample)
 {
 	calcSoundLowPassFilter(filter,currentsample); //Filter manually!
 }
+
+/*
+
+Block filters: both filter types are a first order recurrence y[n] = c*y[n-1] + b*u[n].
+Low-pass: c = 1-alpha, b = alpha, u[n] = x[n].
+High-pass: c = b = alpha, u[n] = x[n]-x[n-1].
+The SIMD versions unroll the recurrence over a vector of samples, so every result only depends on the last result of the previous vector:
+y[n+k] = c^(k+1)*y[n-1] + sum(i=0..k) c^(k-i)*b*u[n+i]
+
+*/
+
+#if defined(SOUND_FILTER_SSE2) || defined(SOUND_FILTER_NEON)
+typedef struct
+{
+	float P[4]; //Powers of c to apply to the last result!
+	float K[4][4]; //Weight of each input of the vector on each result!
+} SOUNDFILTERBLOCKCOEFS; //Unrolled coefficients of a mono block!
+
+OPTINLINE void soundfilter_monocoefficients(SOUNDFILTERBLOCKCOEFS *coefs, float c, float b)
+{
+	byte lane, input;
+	float power;
+	power = 1.0f; //c^0!
+	for (lane=0;lane<4;++lane) //All lanes!
+	{
+		power *= c; //Next power!
+		coefs->P[lane] = power; //c^(lane+1)!
+	}
+	for (input=0;input<4;++input) //All inputs!
+	{
+		for (lane=0;lane<4;++lane) //All results!
+		{
+			coefs->K[input][lane] = (lane<input)?0.0f:((lane==input)?b:(coefs->P[lane-input-1]*b)); //c^(lane-input)*b!
+		}
+	}
+}
+
+OPTINLINE void soundfilter_stereocoefficients(SOUNDFILTERBLOCKCOEFS *coefs, float cl, float bl, float cr, float br)
+{
+	//Lanes are L0,R0,L1,R1. Only the first two weights are used!
+	coefs->P[0] = cl; coefs->P[1] = cr; coefs->P[2] = cl*cl; coefs->P[3] = cr*cr; //c^1 and c^2!
+	coefs->K[0][0] = bl; coefs->K[0][1] = br; coefs->K[0][2] = cl*bl; coefs->K[0][3] = cr*br; //Weight of the first frame!
+	coefs->K[1][0] = 0.0f; coefs->K[1][1] = 0.0f; coefs->K[1][2] = bl; coefs->K[1][3] = br; //Weight of the second frame!
+}
+#endif
+
+//Filters numsamples samples. Returns the amount of samples handled, which is a multiple of the vector size!
+OPTINLINE uint_32 soundfilter_monoblock(float *samples, uint_32 numsamples, float c, float b, byte ishighpass, float *last_result, float *last_sample)
+{
+#ifdef SOUND_FILTER_SSE2
+	SOUNDFILTERBLOCKCOEFS coefs;
+	__m128 P, K0, K1, K2, K3, X, U, Y, lastresult, lastsample;
+	uint_32 n;
+	if (numsamples<4) return 0; //Nothing to vectorize!
+	soundfilter_monocoefficients(&coefs,c,b); //Calculate the coefficients!
+	P = _mm_loadu_ps(&coefs.P[0]);
+	K0 = _mm_loadu_ps(&coefs.K[0][0]);
+	K1 = _mm_loadu_ps(&coefs.K[1][0]);
+	K2 = _mm_loadu_ps(&coefs.K[2][0]);
+	K3 = _mm_loadu_ps(&coefs.K[3][0]);
+	lastresult = _mm_set1_ps(*last_result); //Last result in all lanes!
+	lastsample = _mm_set1_ps(*last_sample); //Last sample in all lanes!
+	for (n=0;(n+4)<=numsamples;n+=4) //All vectors!
+	{
+		X = _mm_loadu_ps(&samples[n]); //Load the samples!
+		if (ishighpass) //High-pass filter? Filter the difference with the previous sample!
+		{
+			U = _mm_sub_ps(X,_mm_move_ss(_mm_shuffle_ps(X,X,_MM_SHUFFLE(2,1,0,0)),lastsample)); //x[n]-x[n-1]!
+			lastsample = _mm_shuffle_ps(X,X,_MM_SHUFFLE(3,3,3,3)); //Last sample of the vector!
+		}
+		else //Low-pass filter?
+		{
+			U = X; //Filter the samples!
+		}
+		Y = _mm_add_ps(_mm_mul_ps(P,lastresult),_mm_mul_ps(K0,_mm_shuffle_ps(U,U,_MM_SHUFFLE(0,0,0,0))));
+		Y = _mm_add_ps(Y,_mm_mul_ps(K1,_mm_shuffle_ps(U,U,_MM_SHUFFLE(1,1,1,1))));
+		Y = _mm_add_ps(Y,_mm_add_ps(_mm_mul_ps(K2,_mm_shuffle_ps(U,U,_MM_SHUFFLE(2,2,2,2))),_mm_mul_ps(K3,_mm_shuffle_ps(U,U,_MM_SHUFFLE(3,3,3,3)))));
+		_mm_storeu_ps(&samples[n],Y); //Store the results!
+		lastresult = _mm_shuffle_ps(Y,Y,_MM_SHUFFLE(3,3,3,3)); //Last result of the vector!
+	}
+	*last_result = _mm_cvtss_f32(lastresult); //Give the last result!
+	*last_sample = _mm_cvtss_f32(lastsample); //Give the last sample!
+	return n; //How much we've handled!
+#elif defined(SOUND_FILTER_NEON)
+	SOUNDFILTERBLOCKCOEFS coefs;
+	float32x4_t P, K0, K1, K2, K3, X, U, Y, lastresult, lastsample;
+	uint_32 n;
+	if (numsamples<4) return 0; //Nothing to vectorize!
+	soundfilter_monocoefficients(&coefs,c,b); //Calculate the coefficients!
+	P = vld1q_f32(&coefs.P[0]);
+	K0 = vld1q_f32(&coefs.K[0][0]);
+	K1 = vld1q_f32(&coefs.K[1][0]);
+	K2 = vld1q_f32(&coefs.K[2][0]);
+	K3 = vld1q_f32(&coefs.K[3][0]);
+	lastresult = vdupq_n_f32(*last_result); //Last result in all lanes!
+	lastsample = vdupq_n_f32(*last_sample); //Last sample in all lanes!
+	for (n=0;(n+4)<=numsamples;n+=4) //All vectors!
+	{
+		X = vld1q_f32(&samples[n]); //Load the samples!
+		if (ishighpass) //High-pass filter? Filter the difference with the previous sample!
+		{
+			U = vsubq_f32(X,vextq_f32(lastsample,X,3)); //x[n]-x[n-1]!
+			lastsample = vdupq_n_f32(vgetq_lane_f32(X,3)); //Last sample of the vector!
+		}
+		else //Low-pass filter?
+		{
+			U = X; //Filter the samples!
+		}
+		Y = vmulq_f32(P,lastresult);
+		Y = vmlaq_f32(Y,K0,vdupq_n_f32(vgetq_lane_f32(U,0)));
+		Y = vmlaq_f32(Y,K1,vdupq_n_f32(vgetq_lane_f32(U,1)));
+		Y = vmlaq_f32(Y,K2,vdupq_n_f32(vgetq_lane_f32(U,2)));
+		Y = vmlaq_f32(Y,K3,vdupq_n_f32(vgetq_lane_f32(U,3)));
+		vst1q_f32(&samples[n],Y); //Store the results!
+		lastresult = vdupq_n_f32(vgetq_lane_f32(Y,3)); //Last result of the vector!
+	}
+	*last_result = vgetq_lane_f32(lastresult,0); //Give the last result!
+	*last_sample = vgetq_lane_f32(lastsample,0); //Give the last sample!
+	return n; //How much we've handled!
+#else
+	return 0; //Not supported!
+#endif
+}
+
+//Filters numframes interleaved stereo frames. Returns the amount of frames handled, which is a multiple of the vector size!
+OPTINLINE uint_32 soundfilter_stereoblock(float *samples, uint_32 numframes, float cl, float bl, float cr, float br, byte ishighpass, float *last_result_l, float *last_sample_l, float *last_result_r, float *last_sample_r)
+{
+#ifdef SOUND_FILTER_SSE2
+	SOUNDFILTERBLOCKCOEFS coefs;
+	__m128 P, K0, K1, X, U, Y, lastresult, lastsample;
+	uint_32 n;
+	if (numframes<2) return 0; //Nothing to vectorize!
+	soundfilter_stereocoefficients(&coefs,cl,bl,cr,br); //Calculate the coefficients!
+	P = _mm_loadu_ps(&coefs.P[0]);
+	K0 = _mm_loadu_ps(&coefs.K[0][0]);
+	K1 = _mm_loadu_ps(&coefs.K[1][0]);
+	lastresult = _mm_setr_ps(*last_result_l,*last_result_r,*last_result_l,*last_result_r); //Last results!
+	lastsample = _mm_setr_ps(*last_sample_l,*last_sample_r,*last_sample_l,*last_sample_r); //Last samples!
+	for (n=0;(n+2)<=numframes;n+=2) //All vectors!
+	{
+		X = _mm_loadu_ps(&samples[n<<1]); //Load the frames!
+		if (ishighpass) //High-pass filter? Filter the difference with the previous frame!
+		{
+			U = _mm_sub_ps(X,_mm_shuffle_ps(lastsample,X,_MM_SHUFFLE(1,0,1,0))); //x[n]-x[n-1]!
+			lastsample = _mm_shuffle_ps(X,X,_MM_SHUFFLE(3,2,3,2)); //Last frame of the vector!
+		}
+		else //Low-pass filter?
+		{
+			U = X; //Filter the frames!
+		}
+		Y = _mm_add_ps(_mm_mul_ps(P,lastresult),_mm_add_ps(_mm_mul_ps(K0,_mm_shuffle_ps(U,U,_MM_SHUFFLE(1,0,1,0))),_mm_mul_ps(K1,U)));
+		_mm_storeu_ps(&samples[n<<1],Y); //Store the results!
+		lastresult = _mm_shuffle_ps(Y,Y,_MM_SHUFFLE(3,2,3,2)); //Last frame of the vector!
+	}
+	*last_result_l = _mm_cvtss_f32(lastresult); //Give the last results!
+	*last_result_r = _mm_cvtss_f32(_mm_shuffle_ps(lastresult,lastresult,_MM_SHUFFLE(1,1,1,1)));
+	*last_sample_l = _mm_cvtss_f32(lastsample); //Give the last samples!
+	*last_sample_r = _mm_cvtss_f32(_mm_shuffle_ps(lastsample,lastsample,_MM_SHUFFLE(1,1,1,1)));
+	return n; //How much we've handled!
+#elif defined(SOUND_FILTER_NEON)
+	SOUNDFILTERBLOCKCOEFS coefs;
+	float32x4_t P, K0, K1, X, U, Y;
+	float32x2_t lastresult, lastsample;
+	uint_32 n;
+	if (numframes<2) return 0; //Nothing to vectorize!
+	soundfilter_stereocoefficients(&coefs,cl,bl,cr,br); //Calculate the coefficients!
+	P = vld1q_f32(&coefs.P[0]);
+	K0 = vld1q_f32(&coefs.K[0][0]);
+	K1 = vld1q_f32(&coefs.K[1][0]);
+	lastresult = vset_lane_f32(*last_result_r,vdup_n_f32(*last_result_l),1); //Last results!
+	lastsample = vset_lane_f32(*last_sample_r,vdup_n_f32(*last_sample_l),1); //Last samples!
+	for (n=0;(n+2)<=numframes;n+=2) //All vectors!
+	{
+		X = vld1q_f32(&samples[n<<1]); //Load the frames!
+		if (ishighpass) //High-pass filter? Filter the difference with the previous frame!
+		{
+			U = vsubq_f32(X,vcombine_f32(lastsample,vget_low_f32(X))); //x[n]-x[n-1]!
+			lastsample = vget_high_f32(X); //Last frame of the vector!
+		}
+		else //Low-pass filter?
+		{
+			U = X; //Filter the frames!
+		}
+		Y = vmulq_f32(P,vcombine_f32(lastresult,lastresult));
+		Y = vmlaq_f32(Y,K0,vcombine_f32(vget_low_f32(U),vget_low_f32(U)));
+		Y = vmlaq_f32(Y,K1,U);
+		vst1q_f32(&samples[n<<1],Y); //Store the results!
+		lastresult = vget_high_f32(Y); //Last frame of the vector!
+	}
+	*last_result_l = vget_lane_f32(lastresult,0); //Give the last results!
+	*last_result_r = vget_lane_f32(lastresult,1);
+	*last_sample_l = vget_lane_f32(lastsample,0); //Give the last samples!
+	*last_sample_r = vget_lane_f32(lastsample,1);
+	return n; //How much we've handled!
+#else
+	return 0; //Not supported!
+#endif
+}
+
+OPTINLINE void soundfilter_flushdenormals(HIGHLOWPASSFILTER *filter)
+{
+	if (unlikely(fabsf(filter->sound_last_result)<SOUND_FILTER_DENORMAL)) //Decayed to (almost) nothing?
+	{
+		filter->sound_last_result = 0.0f; //Flush to zero!
+	}
+}
+
+void applySoundFilterBlock(HIGHLOWPASSFILTER *filter, float *samples, uint_32 numsamples)
+{
+	float last_result, last_sample, alpha, current;
+	uint_32 n;
+	last_result = filter->sound_last_result; //Load the last result to process!
+	last_sample = filter->sound_last_sample; //Load the last sample to process!
+	alpha = filter->alpha; //The alpha to use!
+	if (unlikely(filter->isHighPass)) //High-pass filter? Low-pass filters are more commonly used!
+	{
+		n = soundfilter_monoblock(samples,numsamples,alpha,alpha,1,&last_result,&last_sample); //Vectorized part!
+		for (;n<numsamples;++n) //Remaining samples!
+		{
+			current = samples[n]; //The sample to process!
+			samples[n] = last_result = alpha * (last_result + current - last_sample);
+			last_sample = current; //The last sample that was processed!
+		}
+	}
+	else //Low-pass filter?
+	{
+		n = soundfilter_monoblock(samples,numsamples,1.0f-alpha,alpha,0,&last_result,&last_sample); //Vectorized part!
+		for (;n<numsamples;++n) //Remaining samples!
+		{
+			samples[n] = last_result += (alpha*(samples[n]-last_result));
+		}
+	}
+	filter->sound_last_result = last_result; //Save the last result!
+	filter->sound_last_sample = last_sample; //Save the last sample!
+	soundfilter_flushdenormals(filter); //Don't decay into denormals!
+}
+
+void applySoundFilterBlockStereo(HIGHLOWPASSFILTER *filterl, HIGHLOWPASSFILTER *filterr, float *samples, uint_32 numframes)
+{
+	float last_result_l, last_sample_l, last_result_r, last_sample_r, alpha_l, alpha_r;
+	uint_32 n;
+	if (unlikely(filterl->isHighPass!=filterr->isHighPass)) //Mixed filter types? Filter each sample on its own!
+	{
+		for (n=0;n<numframes;++n) //All frames!
+		{
+			applySoundFilter(filterl,&samples[n<<1]); //Left sample!
+			applySoundFilter(filterr,&samples[(n<<1)|1]); //Right sample!
+		}
+		soundfilter_flushdenormals(filterl); //Don't decay into denormals!
+		soundfilter_flushdenormals(filterr);
+		return;
+	}
+	last_result_l = filterl->sound_last_result; //Load the last results to process!
+	last_result_r = filterr->sound_last_result;
+	last_sample_l = filterl->sound_last_sample; //Load the last samples to process!
+	last_sample_r = filterr->sound_last_sample;
+	alpha_l = filterl->alpha; //The alphas to use!
+	alpha_r = filterr->alpha;
+	if (unlikely(filterl->isHighPass)) //High-pass filter? Low-pass filters are more commonly used!
+	{
+		n = soundfilter_stereoblock(samples,numframes,alpha_l,alpha_l,alpha_r,alpha_r,1,&last_result_l,&last_sample_l,&last_result_r,&last_sample_r); //Vectorized part!
+		for (;n<numframes;++n) //Remaining frames!
+		{
+			last_result_l = alpha_l * (last_result_l + samples[n<<1] - last_sample_l);
+			last_sample_l = samples[n<<1]; //The last sample that was processed!
+			samples[n<<1] = last_result_l;
+			last_result_r = alpha_r * (last_result_r + samples[(n<<1)|1] - last_sample_r);
+			last_sample_r = samples[(n<<1)|1]; //The last sample that was processed!
+			samples[(n<<1)|1] = last_result_r;
+		}
+	}
+	else //Low-pass filter?
+	{
+		n = soundfilter_stereoblock(samples,numframes,1.0f-alpha_l,alpha_l,1.0f-alpha_r,alpha_r,0,&last_result_l,&last_sample_l,&last_result_r,&last_sample_r); //Vectorized part!
+		for (;n<numframes;++n) //Remaining frames!
+		{
+			samples[n<<1] = last_result_l += (alpha_l*(samples[n<<1]-last_result_l));
+			samples[(n<<1)|1] = last_result_r += (alpha_r*(samples[(n<<1)|1]-last_result_r));
+		}
+	}
+	filterl->sound_last_result = last_result_l; //Save the last results!
+	filterr->sound_last_result = last_result_r;
+	filterl->sound_last_sample = last_sample_l; //Save the last samples!
+	filterr->sound_last_sample = last_sample_r;
+	soundfilter_flushdenormals(filterl); //Don't decay into denormals!
+	soundfilter_flushdenormals(filterr);
+}
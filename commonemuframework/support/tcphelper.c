@@ -20,6 +20,7 @@ along with The Common Emulator Framework.  If not, see <https://www.gnu.org/lice
 
 #include "headers/types.h" //Basic type support!
 #include "headers/support/log.h" //Logging support!
+#include "headers/support/zalloc.h" //Buffer allocation support!
 #include "headers/support/tcphelper.h" //TCP module support!
 
 #define NET_LOGFILE "net"
@@ -46,6 +47,23 @@ byte Client_READY[0x100]; //Client ready for use?
 word availableconnections = 1; //Available connections(one less than can be allocated(reserved connection), because of sending connection(#0))?
 word totalconnections = 1; //Total amount of connections!
 word SERVER_PORT = 23; //What server port to apply?
+
+//Buffered data of a connection, to transfer in blocks instead of byte by byte!
+typedef struct
+{
+	byte data[TCP_BUFFERSIZE]; //The buffered data!
+	uint_32 readpos; //Where to read the buffered data!
+	uint_32 size; //How much data is buffered!
+} TCPRING;
+
+typedef struct
+{
+	TCPRING send; //Data to be sent!
+	TCPRING receive; //Data that has been received!
+	byte disconnected; //Has the other side disconnected? Buffered received data is still given first!
+} TCPBUFFERS;
+
+TCPBUFFERS *connectionbuffers[0x100]; //The buffers of each connection!
 #endif
 
 byte NET_READY = 0; //Are we ready to be used?
@@ -145,6 +163,21 @@ byte freeTCPid(sword id) //Free a connection to use!
 	return 0; //Not found!
 }
 
+byte allocTCPbuffers(sword id) //Allocate the send and receive buffers of a connection!
+{
+	if (connectionbuffers[id]) return 1; //Already allocated!
+	connectionbuffers[id] = (TCPBUFFERS *)zalloc(sizeof(TCPBUFFERS), "TCP_buffers", NULL); //Allocate the buffers!
+	return (connectionbuffers[id]!=NULL); //Allocated?
+}
+
+void freeTCPbuffers(sword id) //Release the send and receive buffers of a connection!
+{
+	if (connectionbuffers[id]) //Allocated?
+	{
+		freez((void **)&connectionbuffers[id], sizeof(TCPBUFFERS), "TCP_buffers"); //Release the buffers!
+	}
+}
+
 sword TCP_connectClientFromServer(sword id, TCPsocket source)
 {
 	//Accept a client as a new server?
@@ -161,7 +194,7 @@ sword TCP_connectClientFromServer(sword id, TCPsocket source)
 			mysock[id] = NULL; //Deallocated!
 			return -1;
 		}
-		if (SDLNet_TCP_AddSocket(listensocketset[id], source) != -1)
+		if ((SDLNet_TCP_AddSocket(listensocketset[id], source) != -1) && allocTCPbuffers(id)) //Added and buffers allocated?
 		{
 			Client_READY[id] = 2; //Connected as a server!
 			if (availableconnections == 0) TCPServer_INTERNAL_stopserver(0); //Stop serving if no connections left!
@@ -248,7 +281,7 @@ sword TCP_ConnectClient(const char *destination, word port)
 			freeTCPid(id); //Free the used ID!
 			return -1; //Failed to connect!
 		}
-		if (SDLNet_TCP_AddSocket(listensocketset[id], mysock[id])!=-1)
+		if ((SDLNet_TCP_AddSocket(listensocketset[id], mysock[id])!=-1) && allocTCPbuffers(id)) //Added and buffers allocated?
 		{
 			Client_READY[id]=1; //Connected as a client!
 			return id; //Successfully connected!
@@ -265,40 +298,140 @@ sword TCP_ConnectClient(const char *destination, word port)
 	return -1; //Not supported!
 }
 
-byte TCP_SendData(sword id, byte data)
+#ifdef GOTNET
+TCPBUFFERS *TCP_getbuffers(sword id) //Retrieve the buffers of a connected connection!
+{
+	if (id < 0) return NULL; //Invalid ID!
+	if (id >= NUMITEMS(allocatedconnections)) return NULL; //Invalid ID!
+	if (!allocatedconnections[id]) return NULL; //Not allocated!
+	if (!Client_READY[id]) return NULL; //Not connected?
+	return connectionbuffers[id]; //Give the buffers, if any!
+}
+#endif
+
+byte TCP_FlushBuffer(sword id)
 {
 #ifdef GOTNET
-	if (id < 0) return 0; //Invalid ID!
-	if (id >= NUMITEMS(allocatedconnections)) return 0; //Invalid ID!
-	if (!allocatedconnections[id]) return 0; //Not allocated!
-	if (!Client_READY[id]) return 0; //Not connected?
-	if(SDLNet_TCP_Send(mysock[id], &data, 1)!=1) {
-		return 0;
+	TCPBUFFERS *buffers;
+	TCPRING *ring;
+	uint_32 blocksize;
+	int sent;
+	if (!(buffers = TCP_getbuffers(id))) return 0; //Not connected?
+	ring = &buffers->send; //The send buffer!
+	if (buffers->disconnected) goto sendfailed; //Can't send anymore?
+	for (;ring->size;) //Anything left to send?
+	{
+		blocksize = MIN(ring->size, TCP_BUFFERSIZE - ring->readpos); //How much can be sent at once(up to the end of the buffer)!
+		sent = SDLNet_TCP_Send(mysock[id], &ring->data[ring->readpos], (int)blocksize); //Send the block!
+		if (sent != (int)blocksize) //Failed to send all of it? The send blocks until everything is sent, so it has failed!
+		{
+			buffers->disconnected = 1; //The connection has failed!
+			goto sendfailed;
+		}
+		ring->readpos = ((ring->readpos + blocksize) & (TCP_BUFFERSIZE - 1)); //Sent!
+		ring->size -= blocksize; //Less buffered!
 	}
-	return 1;
+	return 1; //Everything has been sent!
+	sendfailed: //The connection has failed?
+	ring->readpos = ring->size = 0; //Discard the data that can't be sent anymore!
+	return 0; //Failed!
 #endif
 	return 0; //Not supported!
 }
 
-sbyte TCP_ReceiveData(sword id, byte *result)
+int_32 TCP_SendBuffer(sword id, byte *data, uint_32 size)
 {
 #ifdef GOTNET
-	if (id < 0) return -1; //Invalid ID!
-	if (id >= NUMITEMS(allocatedconnections)) return -1; //Invalid ID!
-	if (!allocatedconnections[id]) return -1; //Not allocated!
-	if (!Client_READY[id]) return -1; //Not connected?
-	if(SDLNet_CheckSockets(listensocketset[id],0))
+	TCPBUFFERS *buffers;
+	TCPRING *ring;
+	uint_32 blocksize, writepos, result;
+	if (!(buffers = TCP_getbuffers(id))) return -1; //Not connected?
+	if (buffers->disconnected) return -1; //The connection has failed?
+	ring = &buffers->send; //The send buffer!
+	result = 0; //Nothing buffered yet!
+	for (;size;) //Anything left to buffer?
 	{
-		byte retval=0;
-		if(SDLNet_TCP_Recv(mysock[id], &retval, 1)!=1) {
-			return -1; //Socket closed
-		} else
+		if (ring->size == TCP_BUFFERSIZE) //Buffer full?
 		{
-			*result = retval; //Data read!
-			return 1; //Got data!
+			if (!TCP_FlushBuffer(id)) return -1; //Make room! Failed to send?
 		}
+		writepos = ((ring->readpos + ring->size) & (TCP_BUFFERSIZE - 1)); //Where to write!
+		blocksize = MIN(MIN(size, TCP_BUFFERSIZE - ring->size), TCP_BUFFERSIZE - writepos); //How much fits at once!
+		memcpy(&ring->data[writepos], data, blocksize); //Buffer the data!
+		ring->size += blocksize; //Buffered!
+		data += blocksize; //Next data!
+		size -= blocksize; //Less left!
+		result += blocksize; //More buffered!
 	}
-	else return 0; //No data to receive!
+	if (ring->size >= TCP_SENDTHRESHOLD) //Enough to send?
+	{
+		if (!TCP_FlushBuffer(id)) return -1; //Send it! Failed to send?
+	}
+	return (int_32)result; //How much has been buffered!
+#endif
+	return -1; //Not supported!
+}
+
+int_32 TCP_ReceiveBuffer(sword id, byte *data, uint_32 size)
+{
+#ifdef GOTNET
+	TCPBUFFERS *buffers;
+	TCPRING *ring;
+	uint_32 blocksize, writepos, result;
+	int received;
+	if (!(buffers = TCP_getbuffers(id))) return -1; //Not connected?
+	ring = &buffers->receive; //The receive buffer!
+	if ((ring->size == 0) && (buffers->disconnected == 0)) //Nothing buffered? Try to receive a block!
+	{
+		if (SDLNet_CheckSockets(listensocketset[id], 0) > 0) //Data available?
+		{
+			ring->readpos = 0; //Receive at the start of the buffer, receiving as much as possible at once!
+			received = SDLNet_TCP_Recv(mysock[id], &ring->data[0], TCP_BUFFERSIZE); //Receive what's available!
+			if (received <= 0) //Socket closed?
+			{
+				buffers->disconnected = 1; //Disconnected!
+			}
+			else
+			{
+				ring->size = (uint_32)received; //Received!
+			}
+		}
+	}
+	if (ring->size == 0) //Nothing buffered?
+	{
+		return buffers->disconnected ? -1 : 0; //Disconnected or no data!
+	}
+	result = 0; //Nothing given yet!
+	for (;size && ring->size;) //Anything left to give?
+	{
+		blocksize = MIN(MIN(size, ring->size), TCP_BUFFERSIZE - ring->readpos); //How much can be given at once!
+		memcpy(data, &ring->data[ring->readpos], blocksize); //Give the data!
+		ring->readpos = ((ring->readpos + blocksize) & (TCP_BUFFERSIZE - 1)); //Given!
+		ring->size -= blocksize; //Less buffered!
+		data += blocksize; //Next data!
+		size -= blocksize; //Less left!
+		result += blocksize; //More given!
+	}
+	return (int_32)result; //How much has been received!
+#endif
+	return -1; //No socket by default!
+}
+
+byte TCP_SendData(sword id, byte data)
+{
+#ifdef GOTNET
+	if (TCP_SendBuffer(id, &data, 1) != 1) return 0; //Couldn't buffer?
+	return TCP_FlushBuffer(id); //Send it immediately, together with any buffered data before it!
+#endif
+	return 0; //Not supported!
+}
+
+sbyte TCP_ReceiveData(sword id, byte *result)
+{
+#ifdef GOTNET
+	int_32 received;
+	received = TCP_ReceiveBuffer(id, result, 1); //Receive one byte!
+	return (received < 0) ? -1 : (sbyte)received; //Give the result!
 #endif
 	return -1; //No socket by default!
 }
@@ -310,6 +443,7 @@ byte TCP_DisconnectClientServer(sword id)
 	if (id >= NUMITEMS(allocatedconnections)) return 0; //Invalid ID!
 	if (!allocatedconnections[id]) return 0; //Not allocated!
 	if (!Client_READY[id]) return 0; //Not connected?
+	TCP_FlushBuffer(id); //Send what's still buffered, if possible!
 	if (listensocketset[id])
 	{
 		if (mysock[id]) //Valid socket to remove?
@@ -324,6 +458,7 @@ byte TCP_DisconnectClientServer(sword id)
 		mysock[id] = NULL; //Not allocated anymore!
 	}
 
+	freeTCPbuffers(id); //Release the buffers! Buffered data is lost!
 	Client_READY[id] = 0; //Ready again!
 	if (freeTCPid(id)) //Freed the ID for other uses!
 	{
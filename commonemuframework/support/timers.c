@@ -28,8 +28,8 @@ along with The Common Emulator Framework.  If not, see <https://www.gnu.org/lice
 //Are we disabled?
 #define __HW_DISABLED 0
 
-//Timer step in us! Originally 100ms now 10000?
-#define TIMER_STEP 1000
+//Size of the timer name hash table! Must be a power of 2!
+#define TIMER_HASHSIZE 0x80
 
 //Log running timers (error/timing search only!)
 //#define TIMER_LOG
@@ -42,6 +42,10 @@ byte timer_ready = 0; //Ready?
 
 TicksHolder timer_lasttimer; //Last timer ticks holder!
 byte timer_init = 0;
+DOUBLE timer_now = 0.0; //Current time of the timers, in us!
+SDL_sem *timer_wakeup = NULL; //Wakes up the timer thread when the timers are changed!
+byte timer_wakeuppending = 0; //Has the timer thread been woken up, without having checked the timers yet?
+byte timer_threadrunning = 0; //Is the timer thread running? The time of the timers doesn't pass while it isn't!
 
 typedef struct
 {
@@ -50,7 +54,10 @@ typedef struct
 	DOUBLE overflowtime; //The time taken to overflow in us!
 	Handler handler; //The handler!
 	byte enabled; //Enabled?
-	DOUBLE counter; //Counter for handling the frequency calls!
+	DOUBLE counter; //Counter for handling the frequency calls, while not running!
+	DOUBLE deadline; //The time of the next overflow, while running!
+	word heappos; //Position in the deadline heap(base 1), 0 when not running!
+	word hashnext; //Next timer with the same name hash(base 1), 0 for none!
 	char name[256]; //The name of the timer!
 	uint_32 calls; //Total ammount of calls so far (for debugging only!)
 	DOUBLE total_timetaken; //Time taken by the function!
@@ -59,6 +66,9 @@ typedef struct
 } TIMER; //A timer's data!
 
 TIMER timers[100]; //We use up to 100 timers!
+word timer_heap[NUMITEMS(timers)]; //Running timers, ordered by their deadline(earliest first)!
+word timer_heapsize = 0; //Amount of running timers!
+word timer_hash[TIMER_HASHSIZE]; //First timer(base 1) of each name hash, 0 for none!
 
 ThreadParams_p timerthread = NULL; //Our thread!
 byte allow_running = 0;
@@ -67,13 +77,168 @@ extern DOUBLE clockspeed; //Default clockspeed we use, in Hz!
 
 byte EMU_Timers_Enabled = 1; //Are emulator timers enabled?
 
+//Timer lookup by name! All following functions are called with the timers locked!
+
+OPTINLINE word timer_hashname(char *name)
+{
+	uint_32 hash = 5381; //Initial hash!
+	for (;*name;) //Hash the name!
+	{
+		hash = ((hash << 5) + hash) + (byte)*name++; //Hash the character!
+	}
+	return (word)(hash & (TIMER_HASHSIZE - 1)); //Give the hash!
+}
+
+int timer_find(char *name) //Find a timer by name! Result: -1 if not found!
+{
+	word timer;
+	for (timer = timer_hash[timer_hashname(name)]; timer; timer = timers[timer - 1].hashnext) //Check all timers with the same hash!
+	{
+		if (strcmp(timers[timer - 1].name, name) == 0) //Found?
+		{
+			return (int)(timer - 1); //Give the timer!
+		}
+	}
+	return -1; //Not found!
+}
+
+void timer_unhash(int timer) //Remove a timer from the name lookup!
+{
+	word *link;
+	for (link = &timer_hash[timer_hashname(timers[timer].name)]; *link; link = &timers[*link - 1].hashnext) //Check all timers with the same hash!
+	{
+		if (*link == (word)(timer + 1)) //Found?
+		{
+			*link = timers[timer].hashnext; //Unlink!
+			timers[timer].hashnext = 0; //Not linked anymore!
+			return; //Done!
+		}
+	}
+}
+
+//Deadline heap of the running timers!
+
+OPTINLINE void timer_heapset(word pos, word timer)
+{
+	timer_heap[pos] = timer; //Set the timer!
+	timers[timer].heappos = pos + 1; //Where are we?
+}
+
+void timer_heapup(word pos) //Move a timer up in the heap while it's earlier than its parent!
+{
+	word timer, parent;
+	timer = timer_heap[pos]; //The timer to move!
+	for (;pos;) //Not at the top?
+	{
+		parent = ((pos - 1) >> 1); //The parent!
+		if (timers[timer_heap[parent]].deadline <= timers[timer].deadline) break; //Parent is earlier? We're done!
+		timer_heapset(pos, timer_heap[parent]); //Move the parent down!
+		pos = parent; //Check from the parent!
+	}
+	timer_heapset(pos, timer); //Place the timer!
+}
+
+void timer_heapdown(word pos) //Move a timer down in the heap while it's later than its children!
+{
+	word timer, child;
+	timer = timer_heap[pos]; //The timer to move!
+	for (;;)
+	{
+		child = (pos << 1) + 1; //The first child!
+		if (child >= timer_heapsize) break; //No children? We're done!
+		if (((child + 1) < timer_heapsize) && (timers[timer_heap[child + 1]].deadline < timers[timer_heap[child]].deadline)) //Second child is earlier?
+		{
+			++child; //Use the second child!
+		}
+		if (timers[timer].deadline <= timers[timer_heap[child]].deadline) break; //Earlier than the children? We're done!
+		timer_heapset(pos, timer_heap[child]); //Move the child up!
+		pos = child; //Check from the child!
+	}
+	timer_heapset(pos, timer); //Place the timer!
+}
+
+void timer_heapremove(int timer) //Remove a timer from the heap!
+{
+	word pos;
+	if (!timers[timer].heappos) return; //Not running?
+	pos = timers[timer].heappos - 1; //Where are we?
+	timers[timer].heappos = 0; //Not running anymore!
+	if (pos == --timer_heapsize) return; //Last entry? Nothing to move!
+	timer_heapset(pos, timer_heap[timer_heapsize]); //Move the last entry into our position!
+	timer_heapup(pos); //Move it up when needed!
+	timer_heapdown(timers[timer_heap[pos]].heappos - 1); //Move it down when needed!
+}
+
+void timer_updatenow() //Update the current time of the timers!
+{
+	if (!timer_init) //Not initialised yet?
+	{
+		initTicksHolder(&timer_lasttimer); //Init ticks holder for precision!
+		getuspassed(&timer_lasttimer); //Initialise the timer to current time!
+		timer_init = 1; //Ready!
+	}
+	if (!timer_threadrunning) //Not running? Time doesn't pass for the timers!
+	{
+		getuspassed(&timer_lasttimer); //Start counting from the current time!
+		return;
+	}
+	timer_now += (DOUBLE)getuspassed(&timer_lasttimer); //How many time has passed for real!
+}
+
+void timer_notify() //Wake up the timer thread, because a timer has changed!
+{
+	if (timer_threadrunning && timer_wakeup && (!timer_wakeuppending)) //Running the thread and not woken up already?
+	{
+		timer_wakeuppending = 1; //Woken up!
+		PostSem(timer_wakeup) //Wake up!
+	}
+}
+
+void timer_update(int timer) //Start or stop running a timer, depending on it's settings!
+{
+	byte running;
+	running = (timers[timer].enabled && timers[timer].handler && (timers[timer].frequency!=0.0f) && ((timers[timer].core&1) || EMU_Timers_Enabled)); //Are we to be running?
+	if (running && (!timers[timer].heappos)) //To start running?
+	{
+		timers[timer].deadline = timer_now + (timers[timer].overflowtime - timers[timer].counter); //When to overflow!
+		timer_heapset(timer_heapsize++, (word)timer); //Add to the heap!
+		timer_heapup(timer_heapsize - 1); //Move it into it's position!
+	}
+	else if ((!running) && timers[timer].heappos) //To stop running?
+	{
+		timers[timer].counter = timers[timer].overflowtime - (timers[timer].deadline - timer_now); //How far we've counted!
+		if (timers[timer].counter < 0.0) timers[timer].counter = 0.0; //Overflow is pending!
+		timer_heapremove(timer); //Stop running!
+	}
+}
+
+void timer_updateall() //Start or stop running all timers!
+{
+	int i;
+	for (i = 0; i < (int)NUMITEMS(timers); i++) //Check all timers!
+	{
+		if (timers[i].frequency != 0.0f) //Set?
+		{
+			timer_update(i); //Update the timer!
+		}
+	}
+}
+
+void timer_remove(int timer) //Remove a timer!
+{
+	timer_heapremove(timer); //Stop running!
+	timer_unhash(timer); //Stop looking it up!
+	memset(&timers[timer],0,sizeof(timers[timer])); //Disable!
+}
+
 //This handles all current used timers!
 void timer_thread() //Handler for timer!
 {
 	char name[256];
 	int curtimer;
 	uint_64 numcounters;
-	DOUBLE realpassed; //Real timer passed since last call!
+	DOUBLE timeleft; //Time left until the first timer overflows!
+	SDL_sem *timerlock; //The lock of the firing timer!
 
 
 	lock(LOCK_TIMERS); //Wait for our lock!
@@ -85,99 +250,100 @@ void timer_thread() //Handler for timer!
 	cleardata(&name[0],sizeof(name)); //Init name!
 
 	lock(LOCK_TIMERS);
-	if (!timer_init) //Not initialised yet?
+	if (!timer_wakeup) //Not allocated yet?
 	{
-		initTicksHolder(&timer_lasttimer); //Init ticks holder for precision!
-		timer_init = 1; //Ready!
+		timer_wakeup = SDL_CreateSemaphore(0); //Allocate our wakeup signal!
 	}
+	timer_updatenow(); //Start counting from the current time, without the time we weren't running!
+	timer_wakeuppending = 0; //Not woken up yet!
+	timer_threadrunning = 1; //We're running now!
 	unlock(LOCK_TIMERS);
 
-	getuspassed(&timer_lasttimer); //Initialise the timer to current time!
-
+	lock(LOCK_TIMERS); //Wait for our lock!
 	for (;;) //Keep running!
 	{
-		lock(LOCK_TIMERS); //Wait for our lock!
 		if (!allow_running)
 		{
 			unlock(LOCK_TIMERS); //We're done!
 			return; //To stop running?
 		}
 		
-		realpassed = (DOUBLE)getuspassed(&timer_lasttimer); //How many time has passed for real!
+		timer_wakeuppending = 0; //We're checking the timers, so any changes from now on need to wake us up again!
+		timer_updatenow(); //How many time has passed for real!
 
-		for (curtimer=0; curtimer<(int)NUMITEMS(timers); curtimer++) //Process timers!
+		if (timer_heapsize && (timers[timer_heap[0]].deadline <= timer_now)) //First timer is to fire?
 		{
-			if (timers[curtimer].enabled) //Timer set, valid and enabled?
+			curtimer = timer_heap[0]; //The timer to fire!
+			numcounters = (uint_64)((timer_now - timers[curtimer].deadline) / timers[curtimer].overflowtime) + 1; //Ammount of times to count!
+			timers[curtimer].deadline += (numcounters*timers[curtimer].overflowtime); //Next overflow! We skip any overflow!
+			timer_heapdown(0); //Move to it's new position!
+			if (timers[curtimer].counterlimit) //Gotten a limit?
 			{
-				if (timers[curtimer].handler) //Valid entry?
+				if (numcounters>timers[curtimer].counterlimit)
 				{
-					if (timers[curtimer].frequency) //Valid frequency?
+					numcounters = timers[curtimer].counterlimit;
+				}
+			}
+			timerlock = timers[curtimer].lock; //The lock to use!
+			if (timerlock) //To wait for using threads?
+			{
+				//Lock
+				WaitSem(timerlock)
+			}
+			if (!(timers[curtimer].core&2)) //Not counter only timer?
+			{
+				for (;;) //Overflow multi?
+				{
+#ifdef TIMER_LOG
+					safestrcpy(name,sizeof(name),timers[curtimer].name); //Set name!
+					dolog("emu","firing timer: %s",timers[curtimer].name); //Log our timer firing!
+					TicksHolder singletimer;
+					startHiresCounting(&singletimer); //Start counting!
+#endif
+					if (timers[curtimer].handler) //Gotten a handler?
 					{
-						if ((timers[curtimer].core&1) || ((!(timers[curtimer].core&1)) && EMU_Timers_Enabled)) //Allowed to run?
-						{
-							timers[curtimer].counter += realpassed; //Increase counter using high precision timer!
-							numcounters = (uint_64)(timers[curtimer].counter / timers[curtimer].overflowtime); //Ammount of times to count!
-							timers[curtimer].counter -= (numcounters*timers[curtimer].overflowtime); //Decrease counter by the executions! We skip any overflow!
-							if (timers[curtimer].counterlimit) //Gotten a limit?
-							{
-								if (numcounters>timers[curtimer].counterlimit)
-								{
-									numcounters = timers[curtimer].counterlimit;
-								}
-							}
-							if (numcounters) //Are we to fire?
-							{
-								if (timers[curtimer].lock) //To wait for using threads?
-								{
-									//Lock
-									WaitSem(timers[curtimer].lock)
-								}
-								if (!(timers[curtimer].core&2)) //Not counter only timer?
-								{
-									for (;;) //Overflow multi?
-									{
-		#ifdef TIMER_LOG
-										safestrcpy(name,sizeof(name),timers[curtimer].name); //Set name!
-										dolog("emu","firing timer: %s",timers[curtimer].name); //Log our timer firing!
-										TicksHolder singletimer;
-										startHiresCounting(&singletimer); //Start counting!
-		#endif
-										if (timers[curtimer].handler) //Gotten a handler?
-										{
-											unlock(LOCK_TIMERS); //Free timers while running handler!
-											timers[curtimer].handler(); //Run the handler!
-											lock(LOCK_TIMERS); //Lock timers while running timer thread itself!
-										}
-		#ifdef TIMER_LOG
-										++timers[curtimer].calls; //For debugging the ammount of calls!
-										timers[curtimer].total_timetaken += getuspassed(&singletimer); //Add the time that has passed for this timer!
-										dolog("emu","returning timer: %s",timers[curtimer].name); //Log our timer return!
-		#endif
-										if (!--numcounters) break; //Done? Process next counter!
-									}
-								}
-								else //We're a counter only?
-								{
-									uint_64 *counter;
-									counter = (uint_64 *)timers[curtimer].handler; //Handler is a counter!
-									if (counter && numcounters!=0.0f) //Loaded?
-									{
-										*counter += numcounters; //Add the counter!
-									}
-								}
-								if (timers[curtimer].lock) //To wait for using threads?
-								{
-									//Unlock
-									PostSem(timers[curtimer].lock)
-								}
-							}
-						}
+						unlock(LOCK_TIMERS); //Free timers while running handler!
+						timers[curtimer].handler(); //Run the handler!
+						lock(LOCK_TIMERS); //Lock timers while running timer thread itself!
 					}
+#ifdef TIMER_LOG
+					++timers[curtimer].calls; //For debugging the ammount of calls!
+					timers[curtimer].total_timetaken += getuspassed(&singletimer); //Add the time that has passed for this timer!
+					dolog("emu","returning timer: %s",timers[curtimer].name); //Log our timer return!
+#endif
+					if (!--numcounters) break; //Done? Process next counter!
+				}
+			}
+			else //We're a counter only?
+			{
+				uint_64 *counter;
+				counter = (uint_64 *)timers[curtimer].handler; //Handler is a counter!
+				if (counter && numcounters!=0.0f) //Loaded?
+				{
+					*counter += numcounters; //Add the counter!
 				}
 			}
+			if (timerlock) //To wait for using threads?
+			{
+				//Unlock
+				PostSem(timerlock)
+			}
+			continue; //Check for the next timer to fire!
 		}
-		unlock(LOCK_TIMERS); //Release our lock!
-		delay(TIMER_STEP); //Lousy, take 100ms breaks!
+
+		//Sleep until the first timer is to fire, or the timers are changed!
+		if (timer_heapsize) //Running timers?
+		{
+			timeleft = timers[timer_heap[0]].deadline - timer_now; //Time left until it fires!
+			unlock(LOCK_TIMERS); //Release our lock!
+			SDL_SemWaitTimeout(timer_wakeup, (Uint32)((timeleft + 999.0) / 1000.0)); //Wait until it's to fire, rounded up to whole ms!
+		}
+		else //Nothing running?
+		{
+			unlock(LOCK_TIMERS); //Release our lock!
+			WaitSem(timer_wakeup) //Wait for any timer to be added!
+		}
+		lock(LOCK_TIMERS); //Wait for our lock!
 	}
 }
 
@@ -203,20 +369,15 @@ void addtimer(float frequency, Handler timer, char *name, uint_32 counterlimit,
 {
 	int i;
 	int timerpos = -1; //Timer position to use!
+	word hash;
 	if (__HW_DISABLED) return; //Abort!
 	if (frequency==0.0f)
 	{
 		removetimer(name); //Remove the timer if it's there!
 		return; //Don't add without frequency: 0 times/sec is never!
 	}
-	for (i=0; i<(int)NUMITEMS(timers); i++) //Check for existing timer!
-	{
-		if (!strcmp(timers[i].name,name)) //Found?
-		{
-			timerpos = i; //Use this position!
-			break; //Quit our search!
-		}
-	}
+	lock(LOCK_TIMERS);
+	timerpos = timer_find(name); //Check for existing timer!
 
 //Now for new timers!
 	if (timerpos==-1) //New timer?
@@ -231,59 +392,68 @@ void addtimer(float frequency, Handler timer, char *name, uint_32 counterlimit,
 			}
 			++i; //Next timer!
 		}
+		if (timerpos!=-1) //Found a position to add?
+		{
+			memset(&timers[timerpos].name,0,sizeof(timers[timerpos].name)); //Init name!
+			safestrcpy(timers[timerpos].name,sizeof(timers[0].name),name); //Timer name!
+			hash = timer_hashname(timers[timerpos].name); //The hash of the name!
+			timers[timerpos].hashnext = timer_hash[hash]; //Link the timers with the same hash!
+			timer_hash[hash] = (word)(timerpos + 1); //We're the first one to look up!
+		}
 	}
 	
 	if (timerpos!=-1) //Found a position to add?
 	{
-		lock(LOCK_TIMERS);
+		timer_updatenow(); //Update the time for starting and stopping!
+		timer_heapremove(timerpos); //Restart running the timer!
 		timers[timerpos].handler = timer; //Set timer!
 		timers[timerpos].counter = 0; //Reset counter!
 		timers[timerpos].frequency = frequency; //Start timer!
 		timers[timerpos].counterlimit = counterlimit; //The counter limit!
-		memset(&timers[timerpos].name,0,sizeof(timers[timerpos].name)); //Init name!
-		safestrcpy(timers[timerpos].name,sizeof(timers[0].name),name); //Timer name!
 		timers[timerpos].core = coretimer; //Are we a core timer?
 		timers[timerpos].enabled = 1; //Set to enabled by default!
 		timers[timerpos].lock = uselock; //The sephamore to use, if any!
 		timer_calcfreq(timerpos);
+		timer_update(timerpos); //Start running!
+		timer_notify(); //Timers have changed!
 		unlock(LOCK_TIMERS); //Allow running again!
 		return; //Finished: we're added!
 	}
+	unlock(LOCK_TIMERS); //Allow running again!
 }
 
 void cleartimers() //Clear all running timers!
 {
 	int i;
 	if (__HW_DISABLED) return; //Abort!
+	lock(LOCK_TIMERS);
 	for (i=0; i<(int)NUMITEMS(timers); i++)
 	{
 		if (timers[i].frequency!=0.0) //Set?
 		{
-			if (strcmp(timers[i].name,"")!=0) //Set and has a name?
-			{
-				removetimer(timers[i].name); //Remove!
-			}
+			timer_remove(i); //Remove!
 		}
 	}
+	timer_notify(); //Timers have changed!
+	unlock(LOCK_TIMERS);
 }
 
 void useTimer(char *name, byte use)
 {
 	int i;
 	if (__HW_DISABLED) return; //Abort!
-	for (i=0; i<(int)NUMITEMS(timers); i++)
+	lock(LOCK_TIMERS);
+	if ((i = timer_find(name))!=-1) //Found?
 	{
 		if (timers[i].frequency!=0.0) //Set?
 		{
-			if (strcmp(timers[i].name,name)==0) //Found?
-			{
-				lock(LOCK_TIMERS);
-				timers[i].enabled = use; //To use it?
-				unlock(LOCK_TIMERS);
-				return; //Don't search any further: we've found our timer!
-			}
+			timer_updatenow(); //Update the time for starting and stopping!
+			timers[i].enabled = use; //To use it?
+			timer_update(i); //Start or stop running!
+			timer_notify(); //Timers have changed!
 		}
 	}
+	unlock(LOCK_TIMERS);
 	//We only get here when the timer isn't found. Do nothing in this case!
 }
 
@@ -291,19 +461,16 @@ void removetimer(char *name) //Removes a timer!
 {
 	int i;
 	if (__HW_DISABLED) return; //Abort!
-	for (i=0; i<(int)NUMITEMS(timers); i++)
+	lock(LOCK_TIMERS);
+	if ((i = timer_find(name))!=-1) //Found?
 	{
 		if (timers[i].frequency!=0.0) //Enabled?
 		{
-			if (strcmp(timers[i].name,name)==0) //Timer enabled and selected?
-			{
-				lock(LOCK_TIMERS);
-				memset(&timers[i],0,sizeof(timers[i])); //Disable!
-				unlock(LOCK_TIMERS);
-				break;
-			}
+			timer_remove(i); //Disable!
+			timer_notify(); //Timers have changed!
 		}
 	}
+	unlock(LOCK_TIMERS);
 }
 
 void startTimers(byte core)
@@ -328,6 +495,9 @@ void startTimers(byte core)
 	}
 	lock(LOCK_TIMERS);
 	EMU_Timers_Enabled = 1; //Enable timers!
+	timer_updatenow(); //Update the time for starting and stopping!
+	timer_updateall(); //Start running the emulator timers!
+	timer_notify(); //Timers have changed!
 	unlock(LOCK_TIMERS);
 }
 
@@ -344,15 +514,29 @@ void stopTimers(byte core)
 			threadparams = timerthread; //Load the thread to stop!
 			timerthread = NULL; //Finished!
 			EMU_Timers_Enabled = 0; //Disable timers!
+			timer_updatenow(); //Update the time for starting and stopping!
+			timer_updateall(); //Stop running the emulator timers!
+			timer_notify(); //Wake up the thread to terminate!
+			timer_threadrunning = 0; //Stop the time of the timers until the thread is started again!
 			unlock(LOCK_TIMERS); //We're done!
 			delay(1000000); //Wait just a bit for the thread to end!
 			waitThreadEnd(threadparams); //Wait for our thread to end!
+			lock(LOCK_TIMERS);
+			if (timer_wakeup) //Allocated?
+			{
+				SDL_DestroySemaphore(timer_wakeup); //Release our wakeup signal!
+				timer_wakeup = NULL; //Released!
+			}
+			unlock(LOCK_TIMERS);
 			return; //Finish up!
 		}
 		unlock(LOCK_TIMERS); //Finished!
 	}
 	lock(LOCK_TIMERS);
 	EMU_Timers_Enabled = 0; //Enable timers!
+	timer_updatenow(); //Update the time for starting and stopping!
+	timer_updateall(); //Stop running the emulator timers!
+	timer_notify(); //Timers have changed!
 	unlock(LOCK_TIMERS);
 }
 
@@ -361,13 +545,13 @@ void resetTimers() //Init/Reset all timers to go off and turn off all handlers!
 	if (__HW_DISABLED) return; //Abort!
 	stopTimers(0); //Stop normal timers!
 	int i;
+	lock(LOCK_TIMERS);
 	for (i = 0; i < (int)NUMITEMS(timers); i++)
 	{
-		if (!timers[i].core) //Not a core timer?
+		if ((!timers[i].core) && (timers[i].frequency!=0.0)) //Not a core timer?
 		{
-			lock(LOCK_TIMERS);
-			memset(&timers[i], 0, sizeof(timers[i])); //Delete the timer that's not a core timer!
-			unlock(LOCK_TIMERS);
+			timer_remove(i); //Delete the timer that's not a core timer!
 		}
 	}
+	unlock(LOCK_TIMERS);
 }
\ No newline at end of file
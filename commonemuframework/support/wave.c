@@ -22,60 +22,189 @@ along with The Common Emulator Framework.  If not, see <https://www.gnu.org/lice
 #include "headers/support/wave.h" //Wave file structures etc.
 #include "headers/support/zalloc.h" //Allocation support!
 #include "headers/fopen64.h" //64-bit fopen support!
+#include "headers/support/locks.h" //Locking support!
+#include "headers/emu/threads.h" //Thread support!
 
 #define RIFF_RIFF 0x46464952
 #define RIFF_WAVE 0x45564157
 #define RIFF_FMT 0x20746d66
 #define RIFF_DATA 0x61746164
 
-byte writeWord(BIGFILE *f, word w) //INTERNAL: Channels are interleaved, channel 0 left, channel 0 right, channel 1 left, channel 1 right etc.
+/*
+
+Recording is done through a ring buffer of WAVE_CHUNKS chunks.
+The emulation fills the chunks with samples, without any locking or file access.
+Full chunks are queued and written by the writer thread of the file, which also updates the RIFF sizes every WAVE_HEADERINTERVAL chunks.
+When the writer thread isn't available, full chunks are written directly instead.
+The queue, the data size and the write error of all files are protected by LOCK_WAVE while a writer thread is running.
+
+*/
+
+OPTINLINE void WAV_updateheader(WAVEFILE *f, FILEPOS datasize) //Update the RIFF sizes in the header of the file!
 {
-	return (emufwrite64(&w, 1, sizeof(w), f) == sizeof(w)); //Written?
+	f->header.Subchunk2Size = (uint_32)datasize; //Update data size!
+	f->header.ChunkSize = (uint_32)((datasize+sizeof(f->header)) - 8U); //Update WaveFmt chunk size
+	emufseek64(f->f,0,SEEK_SET); //Goto BOF to update the header!
+	emufwrite64(&f->header,1,sizeof(f->header),f->f); //Overwrite the file's header!
+	emufseek64(f->f,0,SEEK_END); //Continue writing at EOF!
 }
 
-byte writeDWord(BIGFILE *f, uint_32 d) //INTERNAL
+byte WAV_writechunk(WAVEFILE *f, byte *chunk, uint_32 size) //Write a chunk to the file! The data size is updated by the caller! 1 on success, 0 on failure!
 {
-	return (emufwrite64(&d, 1, sizeof(d), f) == sizeof(d)); //Written?
+	if (emufwrite64(chunk,1,size,f->f)!=size) //Failed to write?
+	{
+		return 0; //Abort!
+	}
+	if (++f->chunkswritten>=WAVE_HEADERINTERVAL) //Time to update the header?
+	{
+		f->chunkswritten = 0; //Restart counting!
+		WAV_updateheader(f,f->datasize+size); //Keep the file playable while recording! Only we update the data size!
+	}
+	return 1; //Written!
+}
+
+void WAV_writerthread()
+{
+	WAVEFILE *f;
+	byte *chunk;
+	uint_32 size;
+	byte result;
+	f = (WAVEFILE *)getthreadparams(); //The file we're writing!
+	if (!f) return; //Nothing to write?
+	for (;;) //Keep writing!
+	{
+		WaitSem(f->work) //Wait for work!
+		lock(LOCK_WAVE);
+		if (f->queued==0) //Nothing to do?
+		{
+			unlock(LOCK_WAVE);
+			if (f->quit) break; //Terminating?
+			continue; //Wait for more!
+		}
+		chunk = &f->buffer[f->writechunk*WAVE_CHUNKSIZE]; //The chunk to write! Stays queued until written!
+		size = f->chunksize[f->writechunk]; //How much to write!
+		unlock(LOCK_WAVE);
+
+		result = WAV_writechunk(f,chunk,size); //Write the chunk!
+
+		lock(LOCK_WAVE);
+		if (result) f->datasize += size; //Written!
+		else f->writeerror = 1; //Report the error!
+		f->writechunk = ((f->writechunk+1)%WAVE_CHUNKS); //Next chunk!
+		--f->queued; //Finished!
+		for (;f->waiting;--f->waiting) //Anyone waiting?
+		{
+			PostSem(f->done) //We've finished a chunk!
+		}
+		unlock(LOCK_WAVE);
+	}
+}
+
+byte WAV_queuechunk(WAVEFILE *f) //Queue the chunk being filled for writing and start filling the next chunk!
+{
+	byte *chunk;
+	uint_32 size;
+	chunk = &f->buffer[f->fillchunk*WAVE_CHUNKSIZE]; //The chunk being filled!
+	size = (uint_32)(f->fillpos-chunk); //How much has been filled!
+	if (size) //Anything filled?
+	{
+		if (f->writer) //Writing in the background?
+		{
+			lock(LOCK_WAVE);
+			f->chunksize[f->fillchunk] = size; //How much to write!
+			++f->queued; //Queued!
+			PostSem(f->work) //Start writing!
+			while (f->queued==WAVE_CHUNKS) //No chunk left to fill?
+			{
+				++f->waiting; //We're waiting!
+				unlock(LOCK_WAVE);
+				WaitSem(f->done) //Wait for a chunk to be written!
+				lock(LOCK_WAVE);
+			}
+			f->fillchunk = ((f->writechunk+f->queued)%WAVE_CHUNKS); //Fill the next free chunk!
+			f->fillerror |= f->writeerror; //Any errors writing in the background?
+			unlock(LOCK_WAVE);
+			chunk = &f->buffer[f->fillchunk*WAVE_CHUNKSIZE]; //The new chunk to fill!
+		}
+		else //Write directly?
+		{
+			if (WAV_writechunk(f,chunk,size)) f->datasize += size; //Write the chunk ourselves, reusing it afterwards!
+			else f->writeerror = f->fillerror = 1; //Report the error!
+		}
+	}
+	f->fillpos = chunk; //Start filling!
+	f->fillend = chunk+WAVE_CHUNKSIZE; //Where the chunk ends!
+	return (f->fillerror==0); //Give the result!
 }
 
 byte writeWAVMonoSample(WAVEFILE *f, word sample)
 {
-	if (memprotect(f,sizeof(*f),NULL))
+	if (unlikely(f==NULL)) return 0; //Error!
+	if (unlikely((f->fillend-f->fillpos)<(int)sizeof(sample))) //Chunk full?
 	{
-		return writeWord(f->f, sample); //Write the sample!
+		if (unlikely(WAV_queuechunk(f)==0)) return 0; //Error!
 	}
-	return 0; //Error!
+	memcpy(f->fillpos,&sample,sizeof(sample)); //Write the sample!
+	f->fillpos += sizeof(sample); //Filled!
+	return (f->fillerror==0); //Give the result!
 }
 
-byte writeWAVStereoSample(WAVEFILE *f, word lsample, word rsample)
+byte writeWAVStereoSample(WAVEFILE *f, word lsample, word rsample) //INTERNAL: Channels are interleaved, channel 0 left, channel 0 right, channel 1 left, channel 1 right etc.
 {
-	byte result;
-	if (memprotect(f, sizeof(*f), NULL))
+	word samples[2];
+	if (unlikely(f==NULL)) return 0; //Error!
+	if (unlikely((f->fillend-f->fillpos)<(int)sizeof(samples))) //Chunk full?
 	{
-		result = writeWord(f->f, lsample); //Write the left sample!
-		if (!result) return 0; //Error!
-		return writeWord(f->f, rsample); //Write the right sample!
+		if (unlikely(WAV_queuechunk(f)==0)) return 0; //Error!
 	}
-	return 0; //Error!
+	samples[0] = lsample; //Left sample!
+	samples[1] = rsample; //Right sample!
+	memcpy(f->fillpos,&samples,sizeof(samples)); //Write the samples!
+	f->fillpos += sizeof(samples); //Filled!
+	return (f->fillerror==0); //Give the result!
 }
 
-void WAVdealloc(void **ptr, uint_32 size, SDL_sem *lock)
+byte writeWAVSamples(WAVEFILE *f, void *samples, uint_32 count) //Write a block of count samples(of all channels) at once!
 {
-	if (lock) WaitSem(lock)
+	byte *data;
+	uint_32 size, left;
+	if (unlikely(f==NULL)) return 0; //Error!
+	data = (byte *)samples; //What to write!
+	left = count*f->header.BlockAlign; //How much to write!
+	while (left) //Anything left to write?
+	{
+		if (unlikely(f->fillpos==f->fillend)) //Chunk full?
+		{
+			if (unlikely(WAV_queuechunk(f)==0)) return 0; //Error!
+		}
+		size = MIN(left,(uint_32)(f->fillend-f->fillpos)); //How much fits in the chunk!
+		memcpy(f->fillpos,data,size); //Fill the chunk!
+		f->fillpos += size; //Filled!
+		data += size; //Processed!
+		left -= size; //Processed!
+	}
+	return (f->fillerror==0); //Give the result!
+}
+
+void WAVdealloc(void **ptr, uint_32 size, SDL_sem *locksem)
+{
+	if (locksem) WaitSem(locksem)
 	WAVEFILE **f;
 	WAVEFILE *f2;
 	FILEPOS finalposition; //Final data position!
+	byte isempty; //Nothing recorded?
 	f = (WAVEFILE **)ptr; //The wave file pointer
 	if (f) //valid?
 	{
 		f2 = *f; //Get the pointer value!
 		if (f2) //Valid pointer?
 		{
-			if (f2->f) //Valid file?
+			if (f2->f && f2->buffer) //Valid file?
 			{
-				//Update WAVE file data!
-				finalposition = emuftell64(f2->f); //Final position!
-				if (finalposition == sizeof(f2->header)) //Empty file?
+				if (f2->writer) lock(LOCK_WAVE); //The writer thread updates the queue and data size!
+				isempty = ((f2->queued==0) && (f2->datasize==0) && (f2->fillpos==&f2->buffer[f2->fillchunk*WAVE_CHUNKSIZE])); //Nothing written, queued or filled?
+				if (f2->writer) unlock(LOCK_WAVE);
+				if (isempty) //Empty file?
 				{
 					if (f2->header.NumChannels == 2) //Stereo?
 					{
@@ -85,8 +214,26 @@ void WAVdealloc(void **ptr, uint_32 size, SDL_sem *lock)
 					{
 						writeWAVMonoSample(f2, 0); //Mono empty sample!
 					}
-					finalposition = emuftell64(f2->f); //Update final position!
 				}
+				WAV_queuechunk(f2); //Write the remaining samples!
+			}
+			if (f2->writer) //Writer thread running?
+			{
+				lock(LOCK_WAVE);
+				f2->quit = 1; //Request to quit after writing everything that's queued!
+				unlock(LOCK_WAVE);
+				PostSem(f2->work) //Wake up!
+				waitThreadEnd(f2->writer); //Wait for it to finish!
+				f2->writer = NULL; //Not running anymore!
+			}
+			if (f2->done) SDL_DestroySemaphore(f2->done);
+			if (f2->work) SDL_DestroySemaphore(f2->work);
+			f2->done = NULL;
+			f2->work = NULL;
+			if (f2->f) //Valid file?
+			{
+				//Update WAVE file data!
+				finalposition = emuftell64(f2->f); //Final position!
 				f2->header.Subchunk2Size = (uint_32)(finalposition - sizeof(f2->header)); //Update data size!
 				f2->header.ChunkSize = (uint_32)(finalposition - 8U); //Update WaveFmt chunk size
 				emufseek64(f2->f,0,SEEK_SET); //Goto BOF to update the header!
@@ -99,11 +246,12 @@ void WAVdealloc(void **ptr, uint_32 size, SDL_sem *lock)
 				}
 				f2->f = NULL; //Not allocated anymore!
 			}
+			if (f2->buffer) freez((void **)&f2->buffer,WAVE_CHUNKS*WAVE_CHUNKSIZE,"WAVEBUFFER"); //Release the ring buffer!
 		}
 	}
 	DEALLOCFUNC defaultdealloc = getdefaultdealloc(); //Default deallocation function!
 	defaultdealloc(ptr,size,NULL); //Release the pointer normally by direct deallocation!
-	if (lock) PostSem(lock)
+	if (locksem) PostSem(locksem)
 }
 
 WAVEFILE *createWAV(char *filename, byte channels, uint_32 samplerate)
@@ -135,6 +283,14 @@ WAVEFILE *createWAV(char *filename, byte channels, uint_32 samplerate)
 	f->header.Subchunk2ID = RIFF_DATA; //DATA chunk start!
 	f->header.Subchunk2Size = 0; //We don't have any data recorded yet, so 0 bytes atm!
 	safestrcpy(f->filename,sizeof(f->filename),filename); //Set the filename to be removed if empty!
+	f->buffer = (byte *)zalloc(WAVE_CHUNKS*WAVE_CHUNKSIZE,"WAVEBUFFER",NULL); //Allocate the ring buffer!
+	if (!f->buffer) //Failed to allocate?
+	{
+		freez((void **)&f, sizeof(WAVEFILE), "WAVEFILE"); //Free the file!
+		return NULL; //Failed to allocate!
+	}
+	f->fillpos = &f->buffer[0]; //Start filling the first chunk!
+	f->fillend = &f->buffer[WAVE_CHUNKSIZE]; //Where the first chunk ends!
 	f->f = emufopen64(filename, "wb+"); //Open the WAV file!
 	if (emufwrite64(&f->header, 1, sizeof(f->header), f->f) != sizeof(f->header)) //Failed to write the header?
 	{
@@ -142,6 +298,14 @@ WAVEFILE *createWAV(char *filename, byte channels, uint_32 samplerate)
 		return NULL; //Failed to unregister!
 	}
 
+	//Start the writer thread, if possible! Otherwise, we write the chunks directly!
+	f->done = SDL_CreateSemaphore(0); //Nobody waiting yet!
+	f->work = SDL_CreateSemaphore(0); //No work yet!
+	if (f->done && f->work) //Allocated?
+	{
+		f->writer = startThread(&WAV_writerthread,"WAVEWriter",f); //Start the writer!
+	}
+
 	return f; //Give the started file!
 }
 
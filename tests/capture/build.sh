@@ -0,0 +1,23 @@
+#!/bin/bash
+# Builds and runs the frame capture test and benchmark, with the writer thread and writing directly.
+# Usage: build.sh [frames] [frame pace in us]
+. "$(dirname "$0")/../common/prepare.sh"
+prepare_sources commonemuframework/emu/gpu/gpu_capture.c commonemuframework/support/bmp.c
+prepare_baseline commonemuframework/support/bmp.c
+$CC $CFLAGS -c "$COMMON/stubs.c" -o "$BUILD/stubs.o"
+$CC $CFLAGS -c "$BUILD/src/commonemuframework/emu/gpu/gpu_capture.c" -o "$BUILD/gpu_capture.o"
+$CC $CFLAGS -c "$BUILD/src/commonemuframework/support/bmp.c" -o "$BUILD/bmp.o"
+$CC $CFLAGS -c "$BUILD/baseline/commonemuframework/support/bmp.c" -o "$BUILD/bmp_baseline.o"
+rename_globals "$BUILD/bmp_baseline.o" baseline_
+$CC $CFLAGS -c "$TESTDIR/main.c" -o "$BUILD/main.o"
+$CC -o "$BUILD/capture" "$BUILD/main.o" "$BUILD/gpu_capture.o" "$BUILD/bmp.o" "$BUILD/bmp_baseline.o" "$BUILD/stubs.o" $LIBS
+failed=0
+echo "writer thread:"
+"$BUILD/capture" "$BUILD/thread" "$@" || failed=1
+echo "direct:"
+TEST_NOTHREAD=1 "$BUILD/capture" "$BUILD/direct" "$@" || failed=1
+if [ $failed != 0 ]; then
+	echo "FAILED"
+	exit 1
+fi
+echo "OK"
@@ -0,0 +1,250 @@
+/*
+
+Capture harness: test and benchmark of the frame capture of emu/gpu/gpu_capture.c.
+
+Renders frames with changing contents (every third frame) and resolution (halfway) into the frame buffer, and captures them:
+- Raw sequence: every frame in the file must match the frame buffer at the time it was captured.
+- BMP sequence: every frame must be identical to the BMP the baseline writeBMP writes of the frame buffer at the time it was captured.
+- Screenshots: identical to the baseline writeBMP as well.
+Run with TEST_NOTHREAD=1 to test writing the frames directly.
+
+Benchmark: the time the renderer spends capturing a frame at a frame pace, and the time the baseline spent writing a BMP directly.
+
+Usage: capture <capture directory> [frames] [frame pace in us]
+
+*/
+
+#include "headers/types.h" //Basic types!
+#include "headers/emu/gpu/gpu.h" //GPU support!
+#include "headers/emu/gpu/gpu_capture.h" //Capture support!
+#include "headers/support/bmp.h" //Bitmap support!
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+//What the capture uses from the rest of the emulator!
+GPU_type GPU;
+uint_32 rmask = 0xFF, gmask = 0xFF00, bmask = 0xFF0000, amask = 0xFF000000; //RGBA byte order!
+byte rshift = 0, gshift = 8, bshift = 16, ashift = 24;
+char capturepath[256] = "captures"; //Capture path!
+int FILE_EXISTS(char *filename) { return (access(filename, F_OK) == 0); }
+void sound_startRecording() {}
+void sound_stopRecording() {}
+
+//The baseline BMP writer!
+byte baseline_writeBMP(char *thefilename, uint_32 *image, int w, int h, byte doublexres, byte doubleyres, int virtualwidth);
+
+#define MAXFRAMES 1024
+uint_32 expectedhash[MAXFRAMES]; //Hash of each frame!
+word expectedwidth[MAXFRAMES], expectedheight[MAXFRAMES]; //Resolution of each frame!
+char expecteddir[256]; //Where the expected BMP frames are!
+long mismatches = 0;
+
+uint_32 hashframe(word width, word height) //Hash of the frame buffer, in R,G,B,A order like the raw file!
+{
+	uint_32 hash = 2166136261u, pixel;
+	byte rgba[4];
+	word x, y;
+	int i;
+	for (y = 0; y < height; ++y)
+	{
+		for (x = 0; x < width; ++x)
+		{
+			pixel = EMU_BUFFER(x, y);
+			rgba[0] = GETR(pixel);
+			rgba[1] = GETG(pixel);
+			rgba[2] = GETB(pixel);
+			rgba[3] = GETA(pixel);
+			for (i = 0; i < 4; ++i)
+			{
+				hash ^= rgba[i];
+				hash *= 16777619u;
+			}
+		}
+	}
+	return hash;
+}
+
+int samefiles(char *a, char *b)
+{
+	FILE *fa, *fb;
+	int ca, cb;
+	fa = fopen(a, "rb");
+	fb = fopen(b, "rb");
+	if (!fa || !fb)
+	{
+		if (fa) fclose(fa);
+		if (fb) fclose(fb);
+		return 0;
+	}
+	do
+	{
+		ca = fgetc(fa);
+		cb = fgetc(fb);
+	} while ((ca == cb) && (ca != EOF));
+	fclose(fa);
+	fclose(fb);
+	return (ca == cb);
+}
+
+double seconds()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+void renderframe(int frame, int frames) //Render a frame into the frame buffer!
+{
+	word x, y;
+	GPU.xres = (frame < (frames / 2)) ? 640 : 720; //Resolution change halfway!
+	GPU.yres = (frame < (frames / 2)) ? 480 : 400;
+	if ((frame % 3) == 0) //Changed contents?
+	{
+		for (y = 0; y < GPU.yres; ++y) for (x = 0; x < GPU.xres; ++x) EMU_BUFFER(x, y) = RGB((x * 7 + frame) & 0xFF, (y * 3 + frame) & 0xFF, (x ^ y ^ frame) & 0xFF);
+		GPU.emu_buffer_capturedirty = 1; //Redrawn!
+	}
+}
+
+double capture(byte format, int frames, int pace) //Capture a sequence! Gives the time per frame, in us!
+{
+	char filename[256];
+	int frame;
+	double start, total = 0.0;
+	if (!GPU_startCapture(format, 1, 0))
+	{
+		printf("%s: can't start capturing\n", (format == CAPTURE_RAW) ? "raw" : "BMP");
+		++mismatches;
+		return 0.0;
+	}
+	for (frame = 0; frame < frames; ++frame)
+	{
+		renderframe(frame, frames);
+		expectedhash[frame] = hashframe(GPU.xres, GPU.yres);
+		expectedwidth[frame] = GPU.xres;
+		expectedheight[frame] = GPU.yres;
+		if ((format == CAPTURE_BMP) && ((frame % 7) == 0)) //Check this frame?
+		{
+			snprintf(filename, sizeof(filename), "%s/%08u", expecteddir, frame);
+			baseline_writeBMP(filename, &EMU_BUFFER(0, 0), GPU.xres, GPU.yres, 0, 0, EMU_BUFFERPITCH);
+		}
+		start = seconds();
+		GPU_captureFrame(); //Capture the finished frame!
+		total += seconds() - start;
+		if (pace) usleep(pace); //Emulate the next frame!
+	}
+	GPU_stopCapture();
+	return total * 1e6 / frames;
+}
+
+void checkraw(char *filename, int frames)
+{
+	static byte row[EMU_MAX_X << 2];
+	CAPTURE_RAWFRAME header;
+	FILE *f;
+	uint_32 hash, i;
+	word y;
+	int frame = 0;
+	if (!(f = fopen(filename, "rb")))
+	{
+		printf("raw: can't open %s\n", filename);
+		++mismatches;
+		return;
+	}
+	for (; fread(&header, sizeof(header), 1, f) == 1; ++frame)
+	{
+		hash = 2166136261u;
+		for (y = 0; (y < header.height) && (header.width <= EMU_MAX_X); ++y)
+		{
+			if (fread(row, 4, header.width, f) != header.width) break;
+			for (i = 0; i < (header.width << 2); ++i)
+			{
+				hash ^= row[i];
+				hash *= 16777619u;
+			}
+		}
+		if ((frame >= frames) || (header.signature != CAPTURE_RAWSIGNATURE) || (header.number != (uint_32)frame) || (header.width != expectedwidth[frame]) || (header.height != expectedheight[frame]) || (hash != expectedhash[frame]))
+		{
+			if (mismatches++ < 10) printf("raw: frame %d differs from the frame buffer\n", frame);
+		}
+	}
+	fclose(f);
+	if (frame != frames)
+	{
+		printf("raw: %d of %d frames written\n", frame, frames);
+		++mismatches;
+	}
+}
+
+void checkbmp(char *directory, int frames)
+{
+	char filename[256], expected[256];
+	int frame;
+	for (frame = 0; frame < frames; frame += 7)
+	{
+		snprintf(filename, sizeof(filename), "%s/%08u.bmp", directory, frame);
+		snprintf(expected, sizeof(expected), "%s/%08u.bmp", expecteddir, frame);
+		if (!samefiles(filename, expected))
+		{
+			if (mismatches++ < 10) printf("BMP: frame %d differs from the baseline writeBMP\n", frame);
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	char filename[256], expected[256];
+	int frames, pace, frame;
+	double rawtime, bmptime, basetime, start;
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s <capture directory> [frames] [frame pace in us]\n", argv[0]);
+		return 1;
+	}
+	snprintf(capturepath, sizeof(capturepath), "%s", argv[1]);
+	snprintf(expecteddir, sizeof(expecteddir), "%s/expected", argv[1]);
+	mkdir(capturepath, 0777);
+	mkdir(expecteddir, 0777);
+	frames = (argc > 2) ? atoi(argv[2]) : 120;
+	pace = (argc > 3) ? atoi(argv[3]) : 16667;
+	if (frames > MAXFRAMES) frames = MAXFRAMES;
+	GPU.emu_screenbuffer = (uint_32 *)calloc(EMU_SCREENBUFFERSIZE, sizeof(uint_32));
+	if (!GPU.emu_screenbuffer) return 1;
+
+	rawtime = capture(CAPTURE_RAW, frames, pace);
+	snprintf(filename, sizeof(filename), "%s/capture_1.raw", capturepath);
+	checkraw(filename, frames);
+	bmptime = capture(CAPTURE_BMP, frames, pace);
+	snprintf(filename, sizeof(filename), "%s/capture_2", capturepath);
+	checkbmp(filename, frames);
+
+	snprintf(filename, sizeof(filename), "%s/screenshot", capturepath);
+	snprintf(expected, sizeof(expected), "%s/screenshot", expecteddir);
+	renderframe(0, frames);
+	baseline_writeBMP(expected, &EMU_BUFFER(0, 0), GPU.xres, GPU.yres, 0, 0, EMU_BUFFERPITCH);
+	GPU_captureScreenshot(filename);
+	GPU_doneCapture(); //Write everything!
+	strcat(filename, ".bmp");
+	strcat(expected, ".bmp");
+	if (!samefiles(filename, expected))
+	{
+		printf("screenshot differs from the baseline writeBMP\n");
+		++mismatches;
+	}
+
+	basetime = 0.0;
+	for (frame = 0; frame < 20; ++frame) //The baseline: writing BMP files directly!
+	{
+		renderframe(frame * 3, 40);
+		snprintf(filename, sizeof(filename), "%s/direct", capturepath);
+		start = seconds();
+		baseline_writeBMP(filename, &EMU_BUFFER(0, 0), GPU.xres, GPU.yres, 0, 0, EMU_BUFFERPITCH);
+		basetime += seconds() - start;
+	}
+	printf("%d frames checked, %ld mismatches\n", frames, mismatches);
+	printf("time per frame: raw %.1f us, BMP %.1f us, baseline direct BMP %.1f us\n", rawtime, bmptime, basetime * 1e6 / 20);
+	return mismatches ? 1 : 0;
+}
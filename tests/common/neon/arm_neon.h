@@ -0,0 +1,50 @@
+#ifndef ARM_NEON_STANDIN_H
+#define ARM_NEON_STANDIN_H
+
+//Scalar stand-in for the NEON intrinsics used by vga_cga_ntsc.c and filters.c, to check their NEON paths without an ARM toolchain!
+
+#include <stdint.h>
+
+typedef struct { int32_t v[4]; } int32x4_t;
+typedef struct { uint32_t v[4]; } uint32x4_t;
+typedef struct { float v[4]; } float32x4_t;
+typedef struct { float v[2]; } float32x2_t;
+
+#define LANES(expr) { int k; for (k = 0; k < 4; ++k) { expr; } }
+
+static inline int32x4_t vld1q_s32(const int32_t *p) { int32x4_t r; LANES(r.v[k] = p[k]); return r; }
+static inline void vst1q_u32(uint32_t *p, uint32x4_t a) { LANES(p[k] = a.v[k]); }
+static inline int32x4_t vaddq_s32(int32x4_t a, int32x4_t b) { int32x4_t r; LANES(r.v[k] = (int32_t)((uint32_t)a.v[k] + (uint32_t)b.v[k])); return r; }
+static inline int32x4_t vsubq_s32(int32x4_t a, int32x4_t b) { int32x4_t r; LANES(r.v[k] = (int32_t)((uint32_t)a.v[k] - (uint32_t)b.v[k])); return r; }
+static inline int32x4_t vmlaq_s32(int32x4_t a, int32x4_t b, int32x4_t c) { int32x4_t r; LANES(r.v[k] = (int32_t)((uint32_t)a.v[k] + (uint32_t)b.v[k] * (uint32_t)c.v[k])); return r; }
+static inline int32x4_t vmaxq_s32(int32x4_t a, int32x4_t b) { int32x4_t r; LANES(r.v[k] = (a.v[k] > b.v[k]) ? a.v[k] : b.v[k]); return r; }
+static inline int32x4_t vminq_s32(int32x4_t a, int32x4_t b) { int32x4_t r; LANES(r.v[k] = (a.v[k] < b.v[k]) ? a.v[k] : b.v[k]); return r; }
+static inline int32x4_t vdupq_n_s32(int32_t x) { int32x4_t r; LANES(r.v[k] = x); return r; }
+static inline uint32x4_t vdupq_n_u32(uint32_t x) { uint32x4_t r; LANES(r.v[k] = x); return r; }
+static inline uint32x4_t vorrq_u32(uint32x4_t a, uint32x4_t b) { uint32x4_t r; LANES(r.v[k] = a.v[k] | b.v[k]); return r; }
+static inline int32x4_t vorrq_s32(int32x4_t a, int32x4_t b) { int32x4_t r; LANES(r.v[k] = a.v[k] | b.v[k]); return r; }
+static inline uint32x4_t vshlq_u32(uint32x4_t a, int32x4_t s) { uint32x4_t r; LANES(r.v[k] = (s.v[k] >= 0) ? (a.v[k] << s.v[k]) : (a.v[k] >> -s.v[k])); return r; }
+static inline uint32x4_t vreinterpretq_u32_s32(int32x4_t a) { uint32x4_t r; LANES(r.v[k] = (uint32_t)a.v[k]); return r; }
+static inline int32x4_t vshlq_n_s32_lanes(int32x4_t a, int n) { int32x4_t r; LANES(r.v[k] = (int32_t)((uint32_t)a.v[k] << n)); return r; }
+static inline int32x4_t vshrq_n_s32_lanes(int32x4_t a, int n) { int32x4_t r; LANES(r.v[k] = a.v[k] >> n); return r; }
+#define vshlq_n_s32(a, n) vshlq_n_s32_lanes(a, n)
+#define vshrq_n_s32(a, n) vshrq_n_s32_lanes(a, n)
+
+static inline float32x4_t vld1q_f32(const float *p) { float32x4_t r; LANES(r.v[k] = p[k]); return r; }
+static inline void vst1q_f32(float *p, float32x4_t a) { LANES(p[k] = a.v[k]); }
+static inline float32x4_t vdupq_n_f32(float x) { float32x4_t r; LANES(r.v[k] = x); return r; }
+static inline float32x2_t vdup_n_f32(float x) { float32x2_t r; r.v[0] = r.v[1] = x; return r; }
+static inline float32x4_t vsubq_f32(float32x4_t a, float32x4_t b) { float32x4_t r; LANES(r.v[k] = a.v[k] - b.v[k]); return r; }
+static inline float32x4_t vmulq_f32(float32x4_t a, float32x4_t b) { float32x4_t r; LANES(r.v[k] = a.v[k] * b.v[k]); return r; }
+static inline float32x4_t vmlaq_f32(float32x4_t a, float32x4_t b, float32x4_t c) { float32x4_t r; LANES(r.v[k] = a.v[k] + b.v[k] * c.v[k]); return r; }
+static inline float32x4_t vextq_f32_lanes(float32x4_t a, float32x4_t b, int n) { float32x4_t r; LANES(r.v[k] = ((k + n) < 4) ? a.v[k + n] : b.v[k + n - 4]); return r; }
+static inline float32x4_t vcombine_f32(float32x2_t low, float32x2_t high) { float32x4_t r; r.v[0] = low.v[0]; r.v[1] = low.v[1]; r.v[2] = high.v[0]; r.v[3] = high.v[1]; return r; }
+static inline float32x2_t vget_low_f32(float32x4_t a) { float32x2_t r; r.v[0] = a.v[0]; r.v[1] = a.v[1]; return r; }
+static inline float32x2_t vget_high_f32(float32x4_t a) { float32x2_t r; r.v[0] = a.v[2]; r.v[1] = a.v[3]; return r; }
+static inline float32x2_t vset_lane_f32_lanes(float x, float32x2_t a, int lane) { a.v[lane] = x; return a; }
+#define vextq_f32(a, b, n) vextq_f32_lanes(a, b, n)
+#define vgetq_lane_f32(a, lane) ((a).v[lane])
+#define vget_lane_f32(a, lane) ((a).v[lane])
+#define vset_lane_f32(x, a, lane) vset_lane_f32_lanes(x, a, lane)
+
+#endif
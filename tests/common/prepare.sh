@@ -0,0 +1,61 @@
+#!/bin/bash
+# Shared setup for the harnesses under tests/. Source it from a harness build.sh:
+#   . "$(dirname "$0")/../common/prepare.sh"
+#
+# The emulator sources include their headers using Windows paths relative to the Visual Studio project.
+# This copies all headers into $BUILD/inc with the include paths fixed up, so single sources can be built with gcc.
+#
+# Provides:
+#   ROOT    - the repository root
+#   BUILD   - the build directory of the harness (tests/<name>/_build), recreated on every run
+#   COMMON  - this directory, containing the shared stubs
+#   CC, CFLAGS - compiler and flags for building emulator sources against the copied headers
+#   prepare_sources <path>...  - copy repository sources into $BUILD/src, with the include paths fixed up
+#   prepare_baseline <path>... - same for the baseline version of the sources, into $BUILD/baseline
+#   rename_globals <object> <prefix> - prefix the global symbols defined in an object, to link it next to the current version
+set -e
+TESTDIR=$(cd "$(dirname "$0")" && pwd)
+ROOT=$(cd "$TESTDIR/../.." && pwd)
+COMMON="$ROOT/tests/common"
+BUILD="$TESTDIR/_build"
+BASELINE=${BASELINE:-e2e3e24} #The commit the optimized versions are compared against!
+
+fixincludes() #Fix up the include paths of the given files!
+{
+	find "$@" \( -name '*.[ch]' -o -name '*.cpp' \) -print0 | xargs -0 perl -pi -e 'if(/^\s*#\s*include\s*"/){ s{\\}{/}g; s{"\.\./commonemuframework/headers/}{"headers/}; }'
+}
+
+prepare_sources() #Copy the current sources!
+{
+	for f in "$@"; do
+		mkdir -p "$BUILD/src/$(dirname "$f")"
+		cp "$ROOT/$f" "$BUILD/src/$f"
+		fixincludes "$BUILD/src/$f"
+	done
+}
+
+prepare_baseline() #Copy the baseline sources!
+{
+	for f in "$@"; do
+		mkdir -p "$BUILD/baseline/$(dirname "$f")"
+		git -C "$ROOT" show "$BASELINE:$f" > "$BUILD/baseline/$f"
+		fixincludes "$BUILD/baseline/$f"
+	done
+}
+
+rename_globals() #Prefix the global symbols defined in an object!
+{
+	nm --defined-only -g "$1" | awk -v prefix="$2" '{ print $3 " " prefix $3 }' > "$1.syms"
+	objcopy --redefine-syms="$1.syms" "$1"
+}
+
+rm -rf "$BUILD"
+mkdir -p "$BUILD/inc/headers" "$BUILD/sdlinc" "$BUILD/src"
+cp -r "$ROOT/commonemuframework/headers/." "$BUILD/inc/headers/"
+cp -r "$ROOT/SDLPoP/headers/." "$BUILD/inc/headers/"
+fixincludes "$BUILD/inc"
+ln -s "$ROOT/SDL2/include" "$BUILD/sdlinc/SDL2" #For <SDL2/...> includes!
+
+CC=${CC:-gcc}
+CFLAGS="${OPTFLAGS:--O2} -std=gnu99 -w -DSDL2 -DUNIPCEMU -DIS_LINUX -I$BUILD/inc -I$ROOT/SDL2/include -I$BUILD/sdlinc"
+LIBS="-lpthread -lm"
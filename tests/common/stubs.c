@@ -0,0 +1,312 @@
+/*
+
+Shared stubs for the harnesses under tests/.
+
+Implements the parts of SDL and the framework that the tested sources use, on top of pthreads and stdio:
+threads, semaphores, mutexes, conditions, file RWops, 64-bit files, the framework locks and thread manager, and logging.
+All stubs are weak, so a harness can link the real implementation instead.
+
+Set TEST_LOG=1 in the environment to print the dolog() output to stderr.
+Set TEST_NOTHREAD=1 to make starting threads fail, to test the fallback paths.
+
+*/
+
+#define _GNU_SOURCE
+#include "headers/types.h" //Basic types!
+#include "headers/support/locks.h" //Lock support!
+#include "headers/emu/threads.h" //Thread support!
+#include "headers/support/zalloc.h" //Memory allocation support!
+#include "headers/fopen64.h" //64-bit fopen support!
+#include "headers/support/highrestimer.h" //Time support!
+#include "headers/emu/gpu/gpu_emu.h" //Text output support!
+#include <pthread.h>
+#include <semaphore.h>
+#include <errno.h>
+#include <time.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WEAK __attribute__((weak))
+
+//SDL threading primitives!
+struct SDL_semaphore { sem_t sem; };
+struct SDL_mutex { pthread_mutex_t mutex; };
+struct SDL_cond { pthread_cond_t cond; };
+struct SDL_Thread { pthread_t thread; SDL_ThreadFunction fn; void *data; int status; };
+
+WEAK SDL_sem *SDL_CreateSemaphore(Uint32 initial_value)
+{
+	SDL_sem *sem = (SDL_sem *)malloc(sizeof(*sem));
+	if (sem) sem_init(&sem->sem, 0, initial_value);
+	return sem;
+}
+WEAK void SDL_DestroySemaphore(SDL_sem *sem) { if (sem) { sem_destroy(&sem->sem); free(sem); } }
+WEAK int SDL_SemWait(SDL_sem *sem) { while (sem_wait(&sem->sem) && (errno == EINTR)); return 0; }
+WEAK int SDL_SemTryWait(SDL_sem *sem) { return sem_trywait(&sem->sem) ? SDL_MUTEX_TIMEDOUT : 0; }
+WEAK int SDL_SemPost(SDL_sem *sem) { return sem_post(&sem->sem); }
+WEAK Uint32 SDL_SemValue(SDL_sem *sem) { int value = 0; sem_getvalue(&sem->sem, &value); return (Uint32)((value < 0) ? 0 : value); }
+WEAK int SDL_SemWaitTimeout(SDL_sem *sem, Uint32 ms)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += ms / 1000;
+	ts.tv_nsec += (long)(ms % 1000) * 1000000L;
+	if (ts.tv_nsec >= 1000000000L) { ++ts.tv_sec; ts.tv_nsec -= 1000000000L; }
+	for (;;)
+	{
+		if (sem_timedwait(&sem->sem, &ts) == 0) return 0;
+		if (errno != EINTR) return SDL_MUTEX_TIMEDOUT;
+	}
+}
+
+WEAK SDL_mutex *SDL_CreateMutex(void)
+{
+	pthread_mutexattr_t attr;
+	SDL_mutex *mutex = (SDL_mutex *)malloc(sizeof(*mutex));
+	if (!mutex) return NULL;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE); //Like SDL's mutexes!
+	pthread_mutex_init(&mutex->mutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+	return mutex;
+}
+WEAK void SDL_DestroyMutex(SDL_mutex *mutex) { if (mutex) { pthread_mutex_destroy(&mutex->mutex); free(mutex); } }
+WEAK int SDL_LockMutex(SDL_mutex *mutex) { return pthread_mutex_lock(&mutex->mutex); }
+WEAK int SDL_UnlockMutex(SDL_mutex *mutex) { return pthread_mutex_unlock(&mutex->mutex); }
+
+WEAK SDL_cond *SDL_CreateCond(void)
+{
+	SDL_cond *cond = (SDL_cond *)malloc(sizeof(*cond));
+	if (cond) pthread_cond_init(&cond->cond, NULL);
+	return cond;
+}
+WEAK void SDL_DestroyCond(SDL_cond *cond) { if (cond) { pthread_cond_destroy(&cond->cond); free(cond); } }
+WEAK int SDL_CondWait(SDL_cond *cond, SDL_mutex *mutex) { return pthread_cond_wait(&cond->cond, &mutex->mutex); }
+WEAK int SDL_CondSignal(SDL_cond *cond) { return pthread_cond_signal(&cond->cond); }
+WEAK int SDL_CondBroadcast(SDL_cond *cond) { return pthread_cond_broadcast(&cond->cond); }
+
+static void *stub_sdlthread(void *data)
+{
+	SDL_Thread *thread = (SDL_Thread *)data;
+	thread->status = thread->fn(thread->data);
+	return NULL;
+}
+WEAK SDL_Thread *SDL_CreateThread(SDL_ThreadFunction fn, const char *name, void *data)
+{
+	SDL_Thread *thread;
+	if (getenv("TEST_NOTHREAD")) return NULL; //Fail on request!
+	thread = (SDL_Thread *)malloc(sizeof(*thread));
+	if (!thread) return NULL;
+	thread->fn = fn;
+	thread->data = data;
+	thread->status = 0;
+	if (pthread_create(&thread->thread, NULL, &stub_sdlthread, thread)) { free(thread); return NULL; }
+	return thread;
+}
+WEAK void SDL_WaitThread(SDL_Thread *thread, int *status)
+{
+	if (!thread) return;
+	pthread_join(thread->thread, NULL);
+	if (status) *status = thread->status;
+	free(thread);
+}
+WEAK void SDL_DetachThread(SDL_Thread *thread) { if (thread) pthread_detach(thread->thread); }
+WEAK SDL_threadID SDL_ThreadID(void) { return (SDL_threadID)pthread_self(); }
+
+WEAK void SDL_Delay(Uint32 ms) { struct timespec ts; ts.tv_sec = ms / 1000; ts.tv_nsec = (long)(ms % 1000) * 1000000L; nanosleep(&ts, NULL); }
+WEAK Uint32 SDL_GetTicks(void) { struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts); return (Uint32)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000); }
+WEAK Uint64 SDL_GetPerformanceCounter(void) { struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts); return (Uint64)ts.tv_sec * 1000000000ULL + (Uint64)ts.tv_nsec; }
+WEAK Uint64 SDL_GetPerformanceFrequency(void) { return 1000000000ULL; }
+WEAK const char *SDL_GetError(void) { return "stub"; }
+WEAK Uint32 SDL_WasInit(Uint32 flags) { return 0; }
+WEAK void SDL_LockAudio(void) {}
+WEAK void SDL_UnlockAudio(void) {}
+WEAK void *SDL_malloc(size_t size) { return malloc(size); }
+WEAK void SDL_free(void *mem) { free(mem); }
+
+//SDL file RWops using stdio!
+static Sint64 stub_rwsize(SDL_RWops *context)
+{
+	FILE *f = (FILE *)context->hidden.unknown.data1;
+	off_t pos = ftello(f), size;
+	fseeko(f, 0, SEEK_END);
+	size = ftello(f);
+	fseeko(f, pos, SEEK_SET);
+	return (Sint64)size;
+}
+static Sint64 stub_rwseek(SDL_RWops *context, Sint64 offset, int whence)
+{
+	FILE *f = (FILE *)context->hidden.unknown.data1;
+	if (fseeko(f, (off_t)offset, whence)) return -1;
+	return (Sint64)ftello(f);
+}
+static size_t stub_rwread(SDL_RWops *context, void *ptr, size_t size, size_t maxnum) { return fread(ptr, size, maxnum, (FILE *)context->hidden.unknown.data1); }
+static size_t stub_rwwrite(SDL_RWops *context, const void *ptr, size_t size, size_t num) { return fwrite(ptr, size, num, (FILE *)context->hidden.unknown.data1); }
+static int stub_rwclose(SDL_RWops *context) { int result = fclose((FILE *)context->hidden.unknown.data1); free(context); return result; }
+WEAK SDL_RWops *SDL_RWFromFile(const char *file, const char *mode)
+{
+	SDL_RWops *rw;
+	FILE *f = fopen(file, mode);
+	if (!f) return NULL;
+	rw = (SDL_RWops *)calloc(1, sizeof(*rw));
+	if (!rw) { fclose(f); return NULL; }
+	rw->size = &stub_rwsize;
+	rw->seek = &stub_rwseek;
+	rw->read = &stub_rwread;
+	rw->write = &stub_rwwrite;
+	rw->close = &stub_rwclose;
+	rw->hidden.unknown.data1 = f;
+	return rw;
+}
+WEAK Sint64 SDL_RWsize(SDL_RWops *context) { return context->size(context); }
+WEAK Sint64 SDL_RWseek(SDL_RWops *context, Sint64 offset, int whence) { return context->seek(context, offset, whence); }
+WEAK Sint64 SDL_RWtell(SDL_RWops *context) { return context->seek(context, 0, RW_SEEK_CUR); }
+WEAK size_t SDL_RWread(SDL_RWops *context, void *ptr, size_t size, size_t maxnum) { return context->read(context, ptr, size, maxnum); }
+WEAK size_t SDL_RWwrite(SDL_RWops *context, const void *ptr, size_t size, size_t num) { return context->write(context, ptr, size, num); }
+WEAK int SDL_RWclose(SDL_RWops *context) { return context->close(context); }
+
+//Framework locks: one binary semaphore per lock, like locks.c!
+static sem_t stub_locks[0x100];
+static byte stub_locksready[0x100];
+static pthread_mutex_t stub_locklock = PTHREAD_MUTEX_INITIALIZER;
+
+WEAK void initLocks() {}
+WEAK SDL_sem *getLock(byte id) { return NULL; }
+WEAK byte lock(byte id)
+{
+	pthread_mutex_lock(&stub_locklock);
+	if (!stub_locksready[id]) { sem_init(&stub_locks[id], 0, 1); stub_locksready[id] = 1; }
+	pthread_mutex_unlock(&stub_locklock);
+	while (sem_wait(&stub_locks[id]) && (errno == EINTR));
+	return 1;
+}
+WEAK void unlock(byte id)
+{
+	sem_post(&stub_locks[id]);
+}
+
+//Framework thread manager!
+typedef struct
+{
+	pthread_t thread;
+	ThreadParams params;
+} STUB_THREAD;
+
+static __thread void *stub_threadparams = NULL; //The params of the current thread!
+
+static void *stub_threadhandler(void *data)
+{
+	STUB_THREAD *thread = (STUB_THREAD *)data;
+	stub_threadparams = thread->params.params;
+	thread->params.callback(); //Run the thread!
+	return NULL;
+}
+WEAK void initThreads() {}
+WEAK ThreadParams_p startThread(Handler thefunc, char *name, void *params)
+{
+	STUB_THREAD *thread;
+	if (getenv("TEST_NOTHREAD")) return NULL; //Fail on request!
+	thread = (STUB_THREAD *)calloc(1, sizeof(*thread));
+	if (!thread) return NULL;
+	thread->params.callback = thefunc;
+	thread->params.params = params;
+	thread->params.status = 2; //Running!
+	snprintf(thread->params.name, sizeof(thread->params.name), "%s", name);
+	if (pthread_create(&thread->thread, NULL, &stub_threadhandler, thread)) { free(thread); return NULL; }
+	return &thread->params;
+}
+WEAK void waitThreadEnd(ThreadParams_p params)
+{
+	STUB_THREAD *thread;
+	if (!params) return;
+	thread = (STUB_THREAD *)((byte *)params - offsetof(STUB_THREAD, params));
+	pthread_join(thread->thread, NULL);
+	free(thread);
+}
+WEAK byte threadRunning(ThreadParams_p thread) { return (thread != NULL); }
+WEAK void *getthreadparams() { return stub_threadparams; }
+
+//Logging and errors!
+WEAK void dolog(char *filename, const char *format, ...)
+{
+	va_list args;
+	if (!getenv("TEST_LOG")) return; //Not logging?
+	fprintf(stderr, "[%s] ", filename);
+	va_start(args, format);
+	vfprintf(stderr, format, args);
+	va_end(args);
+	fprintf(stderr, "\n");
+}
+WEAK void raiseError(char *source, const char *text, ...)
+{
+	va_list args;
+	fprintf(stderr, "error(%s): ", source);
+	va_start(args, text);
+	vfprintf(stderr, text, args);
+	va_end(args);
+	fprintf(stderr, "\n");
+	exit(2);
+}
+WEAK void raiseNonFatalError(char *source, const char *text, ...) {}
+WEAK void lockaudio() {}
+WEAK void unlockaudio() {}
+WEAK void EMU_locktext() {}
+WEAK void EMU_unlocktext() {}
+WEAK void GPU_EMU_printscreen(sword x, sword y, char *text, ...) {}
+WEAK int getUniversalTimeOfDay(UniversalTimeOfDay *result) { return -1; } //No time available!
+WEAK byte epochtoaccuratetime(UniversalTimeOfDay *curtime, accuratetime *datetime) { return 0; }
+
+WEAK byte allcleared = 0; //Not shutting down!
+
+//Memory allocation, without the pointer registration!
+WEAK void *nzalloc(uint_32 size, char *name, SDL_sem *lock) { return malloc(size); }
+WEAK void *zalloc(uint_32 size, char *name, SDL_sem *lock) { return calloc(1, size); }
+WEAK void freez(void **ptr, uint_32 size, char *name) { if (ptr && *ptr) { free(*ptr); *ptr = NULL; } }
+WEAK void *memprotect(void *ptr, uint_32 size, char *name) { return ptr; }
+
+//Files, directly on top of stdio!
+WEAK void delete_file(char *directory, char *filename) //No wildcard support!
+{
+	char path[512];
+	if (!filename) return;
+	snprintf(path, sizeof(path), "%s%s%s", directory ? directory : "", directory ? "/" : "", filename);
+	remove(path);
+}
+WEAK BIGFILE *emufopen64(char *filename, char *mode) { return (BIGFILE *)fopen(filename, mode); }
+WEAK int emufseek64(BIGFILE *stream, int64_t pos, int direction) { return fseeko((FILE *)stream, pos, direction); }
+WEAK int emufflush64(BIGFILE *stream) { return fflush((FILE *)stream); }
+WEAK int64_t emuftell64(BIGFILE *stream) { return ftello((FILE *)stream); }
+WEAK int emufeof64(BIGFILE *stream) { return feof((FILE *)stream); }
+WEAK int64_t emufread64(void *data, int64_t size, int64_t count, BIGFILE *stream) { return fread(data, size, count, (FILE *)stream); }
+WEAK int64_t emufwrite64(void *data, int64_t size, int64_t count, BIGFILE *stream) { return fwrite(data, size, count, (FILE *)stream); }
+WEAK int emufclose64(BIGFILE *stream) { return fclose((FILE *)stream); }
+
+//String helpers!
+WEAK void safe_strcpy(char *s, size_t size, const char *s2) { if (size) { strncpy(s, s2, size - 1); s[size - 1] = '\0'; } }
+WEAK void safe_strcat(char *s, size_t size, const char *s2) { size_t len = strnlen(s, size); if (len < size) { strncpy(s + len, s2, size - 1 - len); s[size - 1] = '\0'; } }
+WEAK uint_32 safe_strlen(const char *s, size_t size) { return (uint_32)strnlen(s, size); }
+WEAK void safe_scatnprintf(char *dest, size_t size, const char *src, ...)
+{
+	va_list args;
+	size_t len = strnlen(dest, size);
+	if (len >= size) return; //No room!
+	va_start(args, src);
+	vsnprintf(dest + len, size - len, src, args);
+	va_end(args);
+}
+WEAK byte isext(char *filename, char *extension) //Extension in the |-separated list?
+{
+	char list[256], *ext, *saveptr;
+	size_t len, extlen;
+	if (!filename || !extension) return 0;
+	snprintf(list, sizeof(list), "%s", extension);
+	len = strlen(filename);
+	for (ext = strtok_r(list, "|", &saveptr); ext; ext = strtok_r(NULL, "|", &saveptr))
+	{
+		extlen = strlen(ext);
+		if ((len > extlen) && (filename[len - extlen - 1] == '.') && !strcasecmp(filename + len - extlen, ext)) return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,10 @@
+#!/bin/bash
+# Builds and runs the cue sheet table equivalence test and benchmark.
+. "$(dirname "$0")/../common/prepare.sh"
+prepare_sources SDLPoP/basicio/cueimage.c
+$CC $CFLAGS -c "$BUILD/src/SDLPoP/basicio/cueimage.c" -o "$BUILD/cueimage.o"
+$CC $CFLAGS -c "$COMMON/stubs.c" -o "$BUILD/stubs.o"
+$CC $CFLAGS -c "$TESTDIR/main.c" -o "$BUILD/main.o"
+$CC -o "$BUILD/cueimage" "$BUILD/main.o" "$BUILD/cueimage.o" "$BUILD/stubs.o" $LIBS
+mkdir -p "$BUILD/img"
+"$BUILD/cueimage" "$BUILD/img"
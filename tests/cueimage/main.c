@@ -0,0 +1,160 @@
+/*
+
+Cue sheet harness: equivalence test and benchmark of the parsed cue sheet table of basicio/cueimage.c.
+
+Generates BINARY backend files and cue sheets with multiple files, pregaps, postgaps, INDEX 00/02, mixed sector sizes,
+an unsupported WAVE file and a missing file. Then for every selected track/subtrack and LBA, reads the sector through
+the table (cueimage_readsector) and through the linear cue sheet scan (cueimage_REAL_readsector), which must give
+the same result and data.
+
+Benchmark: sequential and random sector reads through both.
+
+Usage: cueimage <image directory>
+
+*/
+
+#include "headers/types.h" //Basic types!
+#include "headers/basicio/io.h" //Basic I/O support!
+#include "headers/basicio/cueimage.h" //Cue sheet support!
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+IODISK disks[0x100]; //All disks!
+char diskpath[256]; //Where the images are!
+
+//The linear cue sheet scan!
+int_64 cueimage_REAL_readsector(int device, byte *M, byte *S, byte *F, byte *startM, byte *startS, byte *startF, byte *endM, byte *endS, byte *endF, void *buffer, word size, byte specialfeatures);
+
+#define SHEETS 5
+static char *sheets[SHEETS][2] = {
+	{ "s1.cue", "FILE \"a.bin\" BINARY\n  TRACK 01 MODE1/2352\n    INDEX 01 00:00:00\n  TRACK 02 AUDIO\n    INDEX 00 00:10:00\n    INDEX 01 00:12:00\n  TRACK 03 AUDIO\n    INDEX 01 00:20:00\n    INDEX 02 00:25:10\n  TRACK 04 AUDIO\n    INDEX 00 00:30:00\n    INDEX 01 00:32:00\n" },
+	{ "s2.cue", "FILE \"c.bin\" BINARY\r\n  TRACK 01 MODE1/2048\r\n    INDEX 01 00:00:00\r\n    POSTGAP 00:02:00\r\nFILE \"b.bin\" BINARY\r\n  TRACK 02 AUDIO\r\n    PREGAP 00:02:00\r\n    INDEX 01 00:00:00\r\n  TRACK 03 AUDIO\r\n    INDEX 00 00:05:00\r\n    INDEX 01 00:06:00\r\n    POSTGAP 00:01:00\r\nFILE \"d.bin\" BINARY\r\n  TRACK 04 AUDIO\r\n    INDEX 01 00:00:00\r\n  TRACK 05 AUDIO\r\n    PREGAP 00:01:10\r\n    INDEX 01 00:04:00\r\n" },
+	{ "s3.cue", "FILE \"c.bin\" BINARY\n  TRACK 01 MODE1/2048\n    INDEX 01 00:00:00\nFILE \"x.wav\" WAVE\n  TRACK 02 AUDIO\n    INDEX 01 00:00:00\nFILE \"b.bin\" BINARY\n  TRACK 03 AUDIO\n    INDEX 01 00:00:00\n" },
+	{ "s4.cue", "FILE \"c.bin\" BINARY\n  TRACK 01 MODE1/2048\n    INDEX 01 00:00:00\nFILE \"missing.bin\" BINARY\n  TRACK 02 AUDIO\n    INDEX 01 00:00:00\nFILE \"b.bin\" BINARY\n  TRACK 03 AUDIO\n    INDEX 01 00:00:00\n" },
+	{ "s5.cue", "CATALOG 0123456789012\nFILE \"d.bin\" BINARY\n  TRACK 01 AUDIO\n    PREGAP 00:02:00\n    INDEX 00 00:00:00\n    INDEX 01 00:01:00\n  TRACK 02 AUDIO\n    INDEX 00 00:03:00\n    INDEX 01 00:03:00\n    INDEX 02 00:05:00\n    POSTGAP 00:00:30\n" }
+};
+
+int makefile(char *name, char *contents, long sectors, int sectorsize, int seed) //Create a cue sheet or backend file!
+{
+	char path[512];
+	FILE *f;
+	long i;
+	snprintf(path, sizeof(path), "%s/%s", diskpath, name);
+	f = fopen(path, "wb");
+	if (!f) return 0;
+	if (contents) fputs(contents, f);
+	else for (i = 0; i < sectors * sectorsize; ++i) fputc((int)((i * 7 + seed + (i >> 11)) & 0xFF), f);
+	fclose(f);
+	return 1;
+}
+
+void selectsheet(int device, char *name, byte track, byte subtrack)
+{
+	snprintf(disks[device].filename, sizeof(disks[device].filename), "%s/%s", diskpath, name);
+	disks[device].selectedtrack = track;
+	disks[device].selectedsubtrack = subtrack;
+}
+
+int_64 scansector(int device, uint_32 LBA, void *buffer, word size) //Read through the linear scan!
+{
+	byte M, S, F, startM, startS, startF, endM, endS, endF;
+	M = (byte)(LBA / 4500);
+	S = (byte)((LBA / 75) % 60);
+	F = (byte)(LBA % 75);
+	return cueimage_REAL_readsector(device, &M, &S, &F, &startM, &startS, &startF, &endM, &endS, &endF, buffer, size, 0);
+}
+
+int_64 tablesector(int device, uint_32 LBA, void *buffer, word size) //Read through the parsed table!
+{
+	return cueimage_readsector(device, (byte)(LBA / 4500), (byte)((LBA / 75) % 60), (byte)(LBA % 75), buffer, size);
+}
+
+double benchmark(int device, byte random, byte table, uint_32 reads) //Time per sector, in us!
+{
+	static byte buffer[2352];
+	struct timespec start, end;
+	uint_32 i, LBA, state = 1;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < reads; ++i)
+	{
+		if (random) LBA = ((state = state * 1103515245 + 12345) >> 8) % 2900;
+		else LBA = i % 2900;
+		if (table) tablesector(device, LBA, buffer, sizeof(buffer));
+		else scansector(device, LBA, buffer, sizeof(buffer));
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return ((double)(end.tv_sec - start.tv_sec) * 1e6 + (double)(end.tv_nsec - start.tv_nsec) / 1e3) / (double)reads;
+}
+
+int main(int argc, char **argv)
+{
+	static byte scanbuffer[4000], tablebuffer[4000];
+	static const int sizes[4] = { 2352, 2048, 0, -1 }; //-1=No buffer!
+	int device = CDROM0;
+	int sheet, size, track, subtrack;
+	uint_32 LBA;
+	int_64 scanresult, tableresult;
+	long cases = 0, mismatches = 0, data = 0, gaps = 0;
+	byte random;
+	double scantime, tabletime;
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s <image directory>\n", argv[0]);
+		return 1;
+	}
+	snprintf(diskpath, sizeof(diskpath), "%s", argv[1]);
+	if (!(makefile("a.bin", NULL, 3000, 2352, 1) && makefile("b.bin", NULL, 900, 2352, 2) && makefile("c.bin", NULL, 400, 2048, 3) && makefile("d.bin", NULL, 700, 2352, 4)))
+	{
+		fprintf(stderr, "Can't create the images in %s\n", diskpath);
+		return 1;
+	}
+	for (sheet = 0; sheet < SHEETS; ++sheet) makefile(sheets[sheet][0], sheets[sheet][1], 0, 0, 0);
+
+	for (sheet = 0; sheet < SHEETS; ++sheet)
+	{
+		for (track = 0; track <= 6; ++track)
+		{
+			for (subtrack = 0; subtrack <= 3; ++subtrack)
+			{
+				selectsheet(device, sheets[sheet][0], track, subtrack);
+				for (LBA = 0; LBA < 4200; ++LBA)
+				{
+					for (size = 0; size < 4; ++size)
+					{
+						if ((sizes[size] < 0) && (LBA & 7)) continue; //Check geometry less often!
+						if ((sizes[size] == 0) && (LBA & 3)) continue;
+						memset(scanbuffer, 0xAA, sizeof(scanbuffer));
+						memset(tablebuffer, 0xAA, sizeof(tablebuffer));
+						scanresult = scansector(device, LBA, (sizes[size] < 0) ? NULL : scanbuffer, (sizes[size] < 0) ? 0 : sizes[size]);
+						tableresult = tablesector(device, LBA, (sizes[size] < 0) ? NULL : tablebuffer, (sizes[size] < 0) ? 0 : sizes[size]);
+						++cases;
+						if ((scanresult > 0) && (sizes[size] > 0)) ++data;
+						if (scanresult < -2) ++gaps;
+						if ((scanresult != tableresult) || memcmp(scanbuffer, tablebuffer, sizeof(scanbuffer)))
+						{
+							if (mismatches++ < 10) printf("%s track %d subtrack %d LBA %u size %d: scan %lld, table %lld\n", sheets[sheet][0], track, subtrack, LBA, sizes[size], (long long)scanresult, (long long)tableresult);
+						}
+					}
+				}
+			}
+		}
+	}
+	printf("%ld reads (%ld with data, %ld in gaps), %ld mismatches\n", cases, data, gaps, mismatches);
+
+	selectsheet(device, "s1.cue", 0, 0);
+	for (random = 0; random < 2; ++random)
+	{
+		scantime = benchmark(device, random, 0, 2000);
+		tabletime = benchmark(device, random, 1, 200000);
+		printf("%s reads: scan %.2f us/sector, table %.3f us/sector (%.0fx)\n", random ? "random" : "sequential", scantime, tabletime, tabletime ? (scantime / tabletime) : 0.0);
+	}
+	if (mismatches)
+	{
+		printf("FAILED: the table differs from the cue sheet scan\n");
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,10 @@
+#!/bin/bash
+# Builds and runs the disk I/O worker stress test and benchmark.
+# Usage: build.sh [stress iterations] [benchmark megabytes] [latency in us]
+. "$(dirname "$0")/../common/prepare.sh"
+prepare_sources SDLPoP/basicio/diskworker.c
+$CC $CFLAGS -c "$BUILD/src/SDLPoP/basicio/diskworker.c" -o "$BUILD/diskworker.o"
+$CC $CFLAGS -c "$COMMON/stubs.c" -o "$BUILD/stubs.o"
+$CC $CFLAGS -c "$TESTDIR/main.c" -o "$BUILD/main.o"
+$CC -o "$BUILD/diskworker" "$BUILD/main.o" "$BUILD/diskworker.o" "$BUILD/stubs.o" $LIBS
+"$BUILD/diskworker" "$@"
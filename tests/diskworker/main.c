@@ -0,0 +1,386 @@
+/*
+
+Disk I/O worker harness: stress test and benchmark of basicio/diskworker.c.
+
+The disk images are replaced by memory images with a simulated access latency. readdata/writedata follow basicio/io.c.
+
+Stress test: two emulation threads issue random read-aheads, reads, posted writes, direct reads/writes, flushes and invalidations.
+Every read is checked against a reference copy of the images, which is updated at the moment a write is issued.
+Device 5 is a custom disk (like the boot images) reading from device 2, to check that writes to the underlying device discard its read-ahead.
+Failing writes are injected on device 4, and must be reported by the next write or flush of that device.
+Accesses to the images are checked to never overlap, which is what the I/O lock guarantees.
+
+Benchmark: sequential reads with and without read-ahead, and sequential writes with and without posting.
+
+Usage: diskworker [stress iterations] [benchmark megabytes] [latency in us]
+
+*/
+
+#define _GNU_SOURCE
+#include "headers/types.h" //Basic types!
+#include "headers/basicio/io.h" //Basic I/O support!
+#include "headers/basicio/diskworker.h" //Disk I/O worker!
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define IMAGESIZE 0x400000
+#define DEVICES 8
+#define CUSTOMDEVICE 5
+#define CUSTOMBASE 0x10000
+#define CUSTOMSIZE 0x100000
+#define FAILDEVICE 4
+#define FAILSTART 0x300000
+
+IODISK disks[0x100]; //All disks!
+byte *images[DEVICES]; //The actual images!
+byte *models[DEVICES]; //What the emulated machine expects to read!
+uint_32 latency = 20; //Simulated latency of an image access, in us!
+volatile int accessing = 0; //Image accesses in progress!
+volatile int overlaps = 0; //Image accesses that overlapped!
+volatile int failwrites = 0; //Fail writes on the failing device?
+uint_32 directreads = 0, directwrites = 0; //Statistics!
+
+void simulatelatency(uint_32 size)
+{
+	struct timespec ts;
+	uint_32 us;
+	us = latency + (size >> 12); //Latency plus transfer time!
+	if (!us) return;
+	ts.tv_sec = 0;
+	ts.tv_nsec = (long)us * 1000L;
+	nanosleep(&ts, NULL);
+}
+
+void beginaccess()
+{
+	if (__sync_fetch_and_add(&accessing, 1)) __sync_fetch_and_add(&overlaps, 1); //Someone else accessing the images?
+}
+
+void endaccess()
+{
+	__sync_fetch_and_sub(&accessing, 1);
+}
+
+byte readdata_direct(int device, void *buffer, uint_64 startpos, uint_32 bytestoread)
+{
+	byte result = 0;
+	beginaccess();
+	if (disks[device].customdisk.used) //Custom disk?
+	{
+		if ((startpos + bytestoread) <= disks[device].customdisk.imagesize) //Within bounds?
+		{
+			startpos += disks[device].customdisk.startpos; //Read from the underlying device!
+			device = disks[device].customdisk.device;
+		}
+		else goto finish; //Out of bounds!
+	}
+	if ((device >= DEVICES) || ((startpos + bytestoread) > IMAGESIZE)) goto finish; //Out of bounds!
+	simulatelatency(bytestoread);
+	memcpy(buffer, &images[device][startpos], bytestoread);
+	__sync_fetch_and_add(&directreads, 1);
+	result = 1;
+	finish:
+	endaccess();
+	return result;
+}
+
+byte writedata_direct(int device, void *buffer, uint_64 startpos, uint_32 bytestowrite)
+{
+	byte result = 0;
+	beginaccess();
+	if (disks[device].customdisk.used) goto finish; //Read-only custom disk!
+	if ((device >= DEVICES) || ((startpos + bytestowrite) > IMAGESIZE)) goto finish; //Out of bounds!
+	if (failwrites && (device == FAILDEVICE) && ((startpos + bytestowrite) > FAILSTART)) goto finish; //Injected failure!
+	simulatelatency(bytestowrite);
+	memcpy(&images[device][startpos], buffer, bytestowrite);
+	__sync_fetch_and_add(&directwrites, 1);
+	result = 1;
+	finish:
+	endaccess();
+	return result;
+}
+
+//Like basicio/io.c!
+byte drivereadonly(int drive)
+{
+	return (disks[drive].readonly || disks[drive].customdisk.used);
+}
+
+byte readdata(int device, void *buffer, uint_64 startpos, uint_32 bytestoread)
+{
+	byte result;
+	if ((device & 0xFF) == device) //Valid device?
+	{
+		if (disks[device].customdisk.used) diskworker_sync(disks[device].customdisk.device); //Wait for posted writes to the custom disk!
+		diskworker_sync(device); //Wait for any posted writes to be written first!
+	}
+	diskworker_lockIO(); //Lock the disk images!
+	result = readdata_direct(device, buffer, startpos, bytestoread); //Read!
+	diskworker_unlockIO(); //Unlock the disk images!
+	return result;
+}
+
+byte writedata(int device, void *buffer, uint_64 startpos, uint_32 bytestowrite)
+{
+	byte result;
+	if ((device & 0xFF) == device) //Valid device?
+	{
+		diskworker_sync(device); //Wait for any posted writes to be written first, in order!
+		diskworker_invalidate(device); //The read-ahead data is outdated!
+	}
+	diskworker_lockIO(); //Lock the disk images!
+	result = writedata_direct(device, buffer, startpos, bytestowrite); //Write!
+	diskworker_unlockIO(); //Unlock the disk images!
+	return result;
+}
+
+uint_32 rnd(uint_32 *state) //xorshift!
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+const byte *expected(int device, uint_32 startpos)
+{
+	if (disks[device].customdisk.used) return &models[disks[device].customdisk.device][disks[device].customdisk.startpos + startpos];
+	return &models[device][startpos];
+}
+
+typedef struct
+{
+	int devices[4]; //Devices used by this thread!
+	int numdevices;
+	uint_32 iterations;
+	uint_32 seed;
+	uint_32 errors;
+	uint_32 readaheadhits;
+} STRESSTHREAD;
+
+void *stressthread(void *data)
+{
+	STRESSTHREAD *t = (STRESSTHREAD *)data;
+	static __thread byte buffer[DISKWORKER_BLOCKSIZE];
+	uint_32 i, op, pos, size, limit, streampos[DEVICES];
+	int device;
+	memset(&streampos, 0, sizeof(streampos));
+	for (i = 0; i < t->iterations; ++i)
+	{
+		device = t->devices[rnd(&t->seed) % t->numdevices];
+		limit = disks[device].customdisk.used ? CUSTOMSIZE : ((device == FAILDEVICE) ? FAILSTART : IMAGESIZE); //Valid area!
+		op = rnd(&t->seed) % 100;
+		size = ((rnd(&t->seed) % 64) + 1) << 9; //Up to 32KB in sectors!
+		if (op < 30) //Sequential read with read-ahead, like the IDE and floppy do!
+		{
+			pos = streampos[device];
+			if ((pos + size) > limit) pos = 0;
+			if (!diskworker_read(device, buffer, pos, size)) { printf("read of device %i at %u failed\n", device, pos); ++t->errors; }
+			else if (memcmp(buffer, expected(device, pos), size)) { printf("device %i: stale data at %u+%u\n", device, pos, size); ++t->errors; }
+			streampos[device] = pos + size;
+			if ((streampos[device] + DISKWORKER_BLOCKSIZE) <= limit) diskworker_readahead(device, streampos[device], DISKWORKER_BLOCKSIZE); //Read the next block!
+			continue;
+		}
+		pos = (rnd(&t->seed) % ((limit - size) >> 9)) << 9; //Random position!
+		if (op < 45) //Random read through the worker!
+		{
+			if (!diskworker_read(device, buffer, pos, size)) { printf("read of device %i at %u failed\n", device, pos); ++t->errors; }
+			else if (memcmp(buffer, expected(device, pos), size)) { printf("device %i: stale data at %u+%u\n", device, pos, size); ++t->errors; }
+		}
+		else if (op < 55) //Direct read!
+		{
+			if (!readdata(device, buffer, pos, size)) { printf("direct read of device %i at %u failed\n", device, pos); ++t->errors; }
+			else if (memcmp(buffer, expected(device, pos), size)) { printf("device %i: stale direct data at %u+%u\n", device, pos, size); ++t->errors; }
+		}
+		else if (op < 85) //Posted write!
+		{
+			if (disks[device].customdisk.used) device = disks[device].customdisk.device; //Write the underlying device instead!
+			memset(buffer, (byte)rnd(&t->seed), size);
+			buffer[0] = (byte)i;
+			if (!diskworker_write(device, buffer, pos, size)) { printf("posted write of device %i at %u failed\n", device, pos); ++t->errors; }
+			memcpy(&models[device][pos], buffer, size);
+			if (op < 60) //Continue the write, to combine it!
+			{
+				if ((pos + (size << 1)) <= limit)
+				{
+					memset(buffer, (byte)rnd(&t->seed), size);
+					if (!diskworker_write(device, buffer, pos + size, size)) { printf("posted write of device %i at %u failed\n", device, pos + size); ++t->errors; }
+					memcpy(&models[device][pos + size], buffer, size);
+				}
+			}
+		}
+		else if (op < 92) //Direct write!
+		{
+			if (disks[device].customdisk.used) device = disks[device].customdisk.device; //Write the underlying device instead!
+			memset(buffer, (byte)rnd(&t->seed), size);
+			if (!writedata(device, buffer, pos, size)) { printf("direct write of device %i at %u failed\n", device, pos); ++t->errors; }
+			memcpy(&models[device][pos], buffer, size);
+		}
+		else if (op < 96) //Flush!
+		{
+			if (!diskworker_flush(device)) { printf("flush of device %i failed\n", device); ++t->errors; }
+			if (memcmp(images[device], models[device], IMAGESIZE) && !disks[device].customdisk.used) { printf("device %i: image differs after flush\n", device); ++t->errors; }
+		}
+		else //Invalidate!
+		{
+			diskworker_invalidate(device);
+		}
+	}
+	return NULL;
+}
+
+int stresstest(uint_32 iterations)
+{
+	pthread_t threads[2];
+	STRESSTHREAD t[2];
+	uint_32 errors = 0;
+	int device;
+	memset(&t, 0, sizeof(t));
+	t[0].devices[0] = 0; t[0].devices[1] = 1; t[0].devices[2] = 2; t[0].devices[3] = CUSTOMDEVICE; t[0].numdevices = 4;
+	t[1].devices[0] = 3; t[1].devices[1] = FAILDEVICE; t[1].devices[2] = 6; t[1].numdevices = 3; //Device 6 has no read-ahead!
+	t[0].seed = 0x12345678; t[1].seed = 0x9ABCDEF1;
+	t[0].iterations = t[1].iterations = iterations;
+	pthread_create(&threads[0], NULL, &stressthread, &t[0]);
+	pthread_create(&threads[1], NULL, &stressthread, &t[1]);
+	pthread_join(threads[0], NULL);
+	pthread_join(threads[1], NULL);
+	errors = t[0].errors + t[1].errors;
+	if (!diskworker_flush(-1)) { printf("final flush failed\n"); ++errors; }
+	for (device = 0; device < DEVICES; ++device)
+	{
+		if (memcmp(images[device], models[device], IMAGESIZE)) { printf("device %i: image differs at the end\n", device); ++errors; }
+	}
+	return errors;
+}
+
+int failuretest()
+{
+	byte buffer[0x1000];
+	int errors = 0;
+	memset(buffer, 0x55, sizeof(buffer));
+	failwrites = 1;
+	if (!diskworker_write(FAILDEVICE, buffer, FAILSTART, sizeof(buffer))) { printf("failing write wasn't posted\n"); ++errors; }
+	if (diskworker_flush(FAILDEVICE)) { printf("failed posted write wasn't reported by the flush\n"); ++errors; }
+	if (!diskworker_flush(FAILDEVICE)) { printf("failed posted write was reported twice\n"); ++errors; }
+	if (!diskworker_write(FAILDEVICE, buffer, FAILSTART, sizeof(buffer))) { printf("failing write wasn't posted\n"); ++errors; }
+	readdata(FAILDEVICE, buffer, 0, sizeof(buffer)); //Syncs, keeping the error!
+	if (diskworker_write(FAILDEVICE, buffer, 0, sizeof(buffer))) { printf("failed posted write wasn't reported by the next write\n"); ++errors; }
+	failwrites = 0;
+	if (!diskworker_flush(-1)) { printf("flush failed after the error was reported\n"); ++errors; }
+	memcpy(models[FAILDEVICE], images[FAILDEVICE], IMAGESIZE); //Resync!
+	return errors;
+}
+
+int customdisktest()
+{
+	byte buffer[0x1000];
+	int errors = 0;
+	if (!diskworker_read(CUSTOMDEVICE, buffer, 0, sizeof(buffer))) ++errors;
+	diskworker_readahead(CUSTOMDEVICE, 0x1000, 0x4000); //Cache the custom disk!
+	if (!diskworker_read(CUSTOMDEVICE, buffer, 0x1000, sizeof(buffer))) ++errors; //Wait for it!
+	memset(buffer, 0xA5, sizeof(buffer));
+	diskworker_write(2, buffer, CUSTOMBASE + 0x2000, sizeof(buffer)); //Write the underlying device!
+	memcpy(&models[2][CUSTOMBASE + 0x2000], buffer, sizeof(buffer));
+	if (!diskworker_read(CUSTOMDEVICE, buffer, 0x2000, sizeof(buffer))) ++errors;
+	if (memcmp(buffer, expected(CUSTOMDEVICE, 0x2000), sizeof(buffer))) { printf("custom disk read-ahead kept stale data after a posted write\n"); ++errors; }
+	diskworker_readahead(CUSTOMDEVICE, 0x1000, 0x4000); //Cache the custom disk again!
+	if (!diskworker_read(CUSTOMDEVICE, buffer, 0x1000, sizeof(buffer))) ++errors; //Wait for it!
+	memset(buffer, 0x5A, sizeof(buffer));
+	writedata(2, buffer, CUSTOMBASE + 0x3000, sizeof(buffer)); //Write the underlying device directly!
+	memcpy(&models[2][CUSTOMBASE + 0x3000], buffer, sizeof(buffer));
+	if (!diskworker_read(CUSTOMDEVICE, buffer, 0x3000, sizeof(buffer))) ++errors;
+	if (memcmp(buffer, expected(CUSTOMDEVICE, 0x3000), sizeof(buffer))) { printf("custom disk read-ahead kept stale data after a direct write\n"); ++errors; }
+	return errors;
+}
+
+double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void emulate() //The emulated machine handles the data, taking as long as an image access!
+{
+	double until;
+	until = now() + (latency + (0x2000 >> 12)) / 1e6;
+	while (now() < until);
+}
+
+void benchmark(uint_32 megabytes)
+{
+	static byte buffer[0x10000];
+	uint_32 total, pos, chunk = 0x2000; //8KB per access, like a multiple sector transfer!
+	double start, direct, readahead, directw, posted;
+	total = megabytes << 20;
+	start = now();
+	for (pos = 0; pos < total; pos += chunk)
+	{
+		readdata(0, buffer, pos % IMAGESIZE, chunk);
+		emulate();
+	}
+	direct = now() - start;
+	start = now();
+	for (pos = 0; pos < total; pos += chunk)
+	{
+		diskworker_read(0, buffer, pos % IMAGESIZE, chunk);
+		if (((pos + chunk) % IMAGESIZE) + DISKWORKER_BLOCKSIZE <= IMAGESIZE) diskworker_readahead(0, (pos + chunk) % IMAGESIZE, DISKWORKER_BLOCKSIZE);
+		emulate();
+	}
+	readahead = now() - start;
+	start = now();
+	for (pos = 0; pos < total; pos += chunk)
+	{
+		writedata(1, buffer, pos % IMAGESIZE, chunk);
+		emulate();
+	}
+	directw = now() - start;
+	start = now();
+	for (pos = 0; pos < total; pos += chunk)
+	{
+		diskworker_write(1, buffer, pos % IMAGESIZE, chunk);
+		emulate();
+	}
+	diskworker_flush(1);
+	posted = now() - start;
+	printf("benchmark: %u MB in 8KB accesses with %u us latency, and as long of emulation after each access\n", megabytes, latency);
+	printf("  reads:  direct %.3fs, read-ahead %.3fs (%.2fx)\n", direct, readahead, direct / readahead);
+	printf("  writes: direct %.3fs, posted %.3fs (%.2fx)\n", directw, posted, directw / posted);
+}
+
+int main(int argc, char **argv)
+{
+	uint_32 iterations = 20000, megabytes = 16;
+	int device, errors;
+	uint_32 seed = 1;
+	if (argc > 1) iterations = (uint_32)atoi(argv[1]);
+	if (argc > 2) megabytes = (uint_32)atoi(argv[2]);
+	if (argc > 3) latency = (uint_32)atoi(argv[3]);
+	memset(&disks, 0, sizeof(disks));
+	for (device = 0; device < DEVICES; ++device)
+	{
+		images[device] = (byte *)malloc(IMAGESIZE);
+		models[device] = (byte *)malloc(IMAGESIZE);
+		for (uint_32 i = 0; i < IMAGESIZE; ++i) images[device][i] = (byte)rnd(&seed);
+		memcpy(models[device], images[device], IMAGESIZE);
+		snprintf(disks[device].filename, sizeof(disks[device].filename), "memory%i", device);
+	}
+	disks[CUSTOMDEVICE].customdisk.used = 1; //Custom disk on top of device 2!
+	disks[CUSTOMDEVICE].customdisk.device = 2;
+	disks[CUSTOMDEVICE].customdisk.startpos = CUSTOMBASE;
+	disks[CUSTOMDEVICE].customdisk.imagesize = CUSTOMSIZE;
+
+	startDiskWorker();
+	errors = customdisktest();
+	errors += failuretest();
+	errors += stresstest(iterations);
+	printf("stress: %u iterations on 2 threads, %u image reads, %u image writes, %i overlapping accesses, %i errors\n", iterations, directreads, directwrites, overlaps, errors);
+	if (megabytes) benchmark(megabytes);
+	doneDiskWorker();
+	errors += overlaps;
+	printf("%s\n", errors ? "FAILED" : "OK");
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,25 @@
+#!/bin/bash
+# Builds and runs the block sound filter test and benchmark, against the baseline filters.c.
+# The current filters are built with their SIMD path for this machine, their portable path and their NEON path through a scalar stand-in.
+. "$(dirname "$0")/../common/prepare.sh"
+prepare_sources commonemuframework/support/filters.c
+prepare_baseline commonemuframework/support/filters.c
+sed 's|^#define SOUND_FILTER_SIMD|//#define SOUND_FILTER_SIMD|' "$BUILD/src/commonemuframework/support/filters.c" > "$BUILD/src/commonemuframework/support/filters_portable.c"
+$CC $CFLAGS -c "$COMMON/stubs.c" -o "$BUILD/stubs.o"
+$CC $CFLAGS -c "$TESTDIR/main.c" -o "$BUILD/main.o"
+$CC $CFLAGS -c "$BUILD/baseline/commonemuframework/support/filters.c" -o "$BUILD/baseline.o"
+rename_globals "$BUILD/baseline.o" baseline_
+$CC $CFLAGS -c "$BUILD/src/commonemuframework/support/filters.c" -o "$BUILD/simd.o"
+$CC $CFLAGS -c "$BUILD/src/commonemuframework/support/filters_portable.c" -o "$BUILD/portable.o"
+$CC $CFLAGS -U__SSE2__ -D__ARM_NEON -I"$COMMON/neon" -c "$BUILD/src/commonemuframework/support/filters.c" -o "$BUILD/neon.o"
+failed=0
+for v in simd portable neon; do
+	$CC -o "$BUILD/filters_$v" "$BUILD/main.o" "$BUILD/$v.o" "$BUILD/baseline.o" "$BUILD/stubs.o" $LIBS
+	echo "$v:"
+	"$BUILD/filters_$v" || failed=1
+done
+if [ $failed != 0 ]; then
+	echo "FAILED"
+	exit 1
+fi
+echo "OK"
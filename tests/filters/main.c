@@ -0,0 +1,151 @@
+/*
+
+Filters harness: test and benchmark of the block sound filters of support/filters.c, used by the sound mixer.
+
+Filters random 16-bit samples with low-pass and high-pass filters at several cutoff frequencies, in blocks of several
+lengths split over two calls, mono and stereo with different left and right cutoffs. The block filters must give the
+same samples as filtering every sample with the baseline applySoundFilter, within a tolerance: the block filters
+calculate in a different order, so their rounding differs. After a long silence, the filter state must be flushed to zero.
+
+Benchmark: filtering blocks of 2048 samples with the baseline per sample filter and with the block filters.
+
+Usage: filters
+
+*/
+
+#include "headers/types.h" //Basic types!
+#include "headers/support/filters.h" //Filter support!
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+//The maximum difference with the baseline, in 16-bit sample units: a tenth of a step, well below what the mixer rounds away!
+#define TOLERANCE 0.1
+
+//The baseline filter!
+void baseline_initSoundFilter(HIGHLOWPASSFILTER *filter, byte ishighpass, float cutoff_freq, float samplerate);
+void baseline_applySoundFilter(HIGHLOWPASSFILTER *filter, float *currentsample);
+
+#define MAXSAMPLES 4099
+#define BENCHMARKSAMPLES 2048
+#define BENCHMARKBLOCKS 20000
+
+float input[MAXSAMPLES * 2], expected[MAXSAMPLES * 2], filtered[MAXSAMPLES * 2];
+double maxerror = 0.0;
+
+double seconds()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+void compare(uint_32 count)
+{
+	uint_32 i;
+	for (i = 0; i < count; ++i)
+	{
+		if (fabs(expected[i] - filtered[i]) > maxerror) maxerror = fabs(expected[i] - filtered[i]);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	static const float cutoffs[5] = { 20.0f, 200.0f, 4000.0f, 11025.0f, 22050.0f };
+	static const uint_32 lengths[8] = { 1, 2, 3, 5, 7, 64, 1023, MAXSAMPLES };
+	HIGHLOWPASSFILTER baseline, baselinel, baseliner, filter, filterl, filterr;
+	uint_32 i, length, half, block;
+	int highpass, cutoff, lengthnr, failed = 0;
+	double start, persample, blockmono, blockstereo;
+	srand(1);
+	for (i = 0; i < (MAXSAMPLES * 2); ++i) input[i] = (float)((rand() % 65536) - 32768);
+	for (highpass = 0; highpass < 2; ++highpass)
+	{
+		for (cutoff = 0; cutoff < 5; ++cutoff)
+		{
+			for (lengthnr = 0; lengthnr < 8; ++lengthnr)
+			{
+				length = lengths[lengthnr];
+				half = (length >> 1);
+				//Mono!
+				baseline_initSoundFilter(&baseline, highpass, cutoffs[cutoff], 44100.0f);
+				initSoundFilter(&filter, highpass, cutoffs[cutoff], 44100.0f);
+				memcpy(&expected, &input, length * sizeof(float));
+				memcpy(&filtered, &input, length * sizeof(float));
+				for (i = 0; i < length; ++i) baseline_applySoundFilter(&baseline, &expected[i]);
+				applySoundFilterBlock(&filter, &filtered[0], half);
+				applySoundFilterBlock(&filter, &filtered[half], length - half);
+				compare(length);
+				//Stereo!
+				baseline_initSoundFilter(&baselinel, highpass, cutoffs[cutoff], 44100.0f);
+				baseline_initSoundFilter(&baseliner, highpass, cutoffs[(cutoff + 2) % 5], 44100.0f);
+				initSoundFilter(&filterl, highpass, cutoffs[cutoff], 44100.0f);
+				initSoundFilter(&filterr, highpass, cutoffs[(cutoff + 2) % 5], 44100.0f);
+				memcpy(&expected, &input, length * 2 * sizeof(float));
+				memcpy(&filtered, &input, length * 2 * sizeof(float));
+				for (i = 0; i < length; ++i)
+				{
+					baseline_applySoundFilter(&baselinel, &expected[i << 1]);
+					baseline_applySoundFilter(&baseliner, &expected[(i << 1) | 1]);
+				}
+				applySoundFilterBlockStereo(&filterl, &filterr, &filtered[0], half);
+				applySoundFilterBlockStereo(&filterl, &filterr, &filtered[half << 1], length - half);
+				compare(length << 1);
+			}
+		}
+	}
+	printf("maximum difference with the baseline: %g\n", maxerror);
+	if (maxerror > TOLERANCE)
+	{
+		printf("the block filters differ more than %g from the baseline\n", TOLERANCE);
+		failed = 1;
+	}
+
+	initSoundFilter(&filter, 0, 200.0f, 44100.0f); //Silence after a pulse!
+	memset(&filtered, 0, sizeof(filtered));
+	filtered[0] = 32767.0f;
+	for (block = 0; block < 200; ++block)
+	{
+		applySoundFilterBlock(&filter, &filtered[0], 1024);
+		memset(&filtered, 0, sizeof(filtered));
+	}
+	printf("low-pass state after silence: %g\n", filter.sound_last_result);
+	if (filter.sound_last_result != 0.0f)
+	{
+		printf("the low-pass state isn't flushed to zero\n");
+		failed = 1;
+	}
+
+	for (highpass = 0; highpass < 2; ++highpass)
+	{
+		baseline_initSoundFilter(&baseline, highpass, 4000.0f, 44100.0f);
+		initSoundFilter(&filter, highpass, 4000.0f, 44100.0f);
+		initSoundFilter(&filterl, highpass, 4000.0f, 44100.0f);
+		initSoundFilter(&filterr, highpass, 4000.0f, 44100.0f);
+		start = seconds();
+		for (block = 0; block < BENCHMARKBLOCKS; ++block)
+		{
+			memcpy(&filtered, &input, BENCHMARKSAMPLES * sizeof(float));
+			for (i = 0; i < BENCHMARKSAMPLES; ++i) baseline_applySoundFilter(&baseline, &filtered[i]);
+		}
+		persample = seconds() - start;
+		start = seconds();
+		for (block = 0; block < BENCHMARKBLOCKS; ++block)
+		{
+			memcpy(&filtered, &input, BENCHMARKSAMPLES * sizeof(float));
+			applySoundFilterBlock(&filter, &filtered[0], BENCHMARKSAMPLES);
+		}
+		blockmono = seconds() - start;
+		start = seconds();
+		for (block = 0; block < BENCHMARKBLOCKS; ++block)
+		{
+			memcpy(&filtered, &input, BENCHMARKSAMPLES * sizeof(float));
+			applySoundFilterBlockStereo(&filterl, &filterr, &filtered[0], BENCHMARKSAMPLES >> 1);
+		}
+		blockstereo = seconds() - start;
+		printf("%s: baseline per sample %.2f ns, block mono %.2f ns, block stereo %.2f ns per sample\n", highpass ? "high-pass" : "low-pass", persample * 1e9 / ((double)BENCHMARKBLOCKS * BENCHMARKSAMPLES), blockmono * 1e9 / ((double)BENCHMARKBLOCKS * BENCHMARKSAMPLES), blockstereo * 1e9 / ((double)BENCHMARKBLOCKS * BENCHMARKSAMPLES));
+	}
+	return failed;
+}
@@ -0,0 +1,13 @@
+#!/bin/bash
+# Builds and runs the IMD track index equivalence test and benchmark, against the baseline imdimage.c.
+. "$(dirname "$0")/../common/prepare.sh"
+prepare_sources SDLPoP/basicio/imdimage.c
+prepare_baseline SDLPoP/basicio/imdimage.c
+$CC $CFLAGS -c "$BUILD/src/SDLPoP/basicio/imdimage.c" -o "$BUILD/imdimage.o"
+$CC $CFLAGS -c "$BUILD/baseline/SDLPoP/basicio/imdimage.c" -o "$BUILD/imdimage_baseline.o"
+rename_globals "$BUILD/imdimage_baseline.o" baseline_
+$CC $CFLAGS -c "$COMMON/stubs.c" -o "$BUILD/stubs.o"
+$CC $CFLAGS -c "$TESTDIR/main.c" -o "$BUILD/main.o"
+$CC -o "$BUILD/imdimage" "$BUILD/main.o" "$BUILD/imdimage.o" "$BUILD/imdimage_baseline.o" "$BUILD/stubs.o" $LIBS
+mkdir -p "$BUILD/img"
+"$BUILD/imdimage" "$BUILD/img"
@@ -0,0 +1,244 @@
+/*
+
+IMD image harness: equivalence test and benchmark of the track index of basicio/imdimage.c.
+
+Generates two identical IMD images, with compressed, unavailable and deleted sectors, cylinder/head maps,
+per-sector size tables and a missing track. One is accessed through the current imdimage.c and the other through
+the baseline version, which walks the file for each access: all sector information, sector reads and writes
+(which change the track layout when compressing or expanding sectors) must give the same results and images.
+
+Benchmark: sequential and random sector reads and sector information lookups through both.
+
+Usage: imdimage <image directory>
+
+*/
+
+#include "headers/types.h" //Basic types!
+#include "headers/basicio/imdimage.h" //IMD image support!
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+char diskpath[256]; //Where the images are!
+
+//The baseline implementation!
+byte baseline_readIMDSectorInfo(char *filename, byte track, byte head, byte sector, IMDIMAGE_SECTORINFO *result);
+byte baseline_readIMDSector(char *filename, byte track, byte head, byte sector, word sectorsize, void *result);
+byte baseline_writeIMDSector(char *filename, byte track, byte head, byte sector, byte deleted, word sectorsize, void *sectordata);
+
+uint_32 seed = 12345; //Generator state!
+
+uint_32 rnd()
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+void generate(char *filename, byte variant) //Generate an IMD image! variant: use all special cases!
+{
+	FILE *f;
+	int cylinder, head, sector, type, i;
+	byte trackinfo[5];
+	f = fopen(filename, "wb");
+	if (!f) return;
+	fputs("IMD 1.18: test image\r\n", f);
+	fputc(0x1A, f);
+	for (cylinder = 0; cylinder < 80; ++cylinder)
+	{
+		for (head = 0; head < 2; ++head)
+		{
+			if (variant && (cylinder == 40) && (head == 1)) continue; //Missing track!
+			trackinfo[0] = 5; //Mode!
+			trackinfo[1] = cylinder;
+			trackinfo[2] = head;
+			if (variant && ((cylinder % 7) == 3)) trackinfo[2] |= 0x80; //Cylinder map!
+			if (variant && ((cylinder % 11) == 5)) trackinfo[2] |= 0x40; //Head map!
+			trackinfo[3] = 18; //Sectors per track!
+			trackinfo[4] = (variant && ((cylinder % 13) == 2)) ? 0xFF : 2; //Sector size table or 512 bytes!
+			fwrite(trackinfo, 1, sizeof(trackinfo), f);
+			for (sector = 0; sector < 18; ++sector) fputc(((sector * 5) % 18) + 1, f); //Interleaved sector numbers!
+			if (trackinfo[2] & 0x80) for (sector = 0; sector < 18; ++sector) fputc(cylinder, f);
+			if (trackinfo[2] & 0x40) for (sector = 0; sector < 18; ++sector) fputc(head, f);
+			if (trackinfo[4] == 0xFF) for (sector = 0; sector < 18; ++sector) { fputc(0, f); fputc(2, f); } //512 bytes each!
+			for (sector = 0; sector < 18; ++sector)
+			{
+				type = rnd() % 10;
+				if (type < 4) { fputc(2, f); fputc(rnd() & 0xFF, f); } //Compressed!
+				else if ((type == 4) && variant) fputc(0, f); //Unavailable!
+				else if ((type == 5) && variant) { fputc(4, f); fputc(0xE5, f); } //Deleted compressed!
+				else
+				{
+					fputc(((type == 6) && variant) ? 3 : 1, f); //Normal or deleted!
+					for (i = 0; i < 512; ++i) fputc(rnd() & 0xFF, f);
+				}
+			}
+		}
+	}
+	fclose(f);
+}
+
+int samefiles(char *a, char *b)
+{
+	FILE *fa, *fb;
+	int ca, cb;
+	fa = fopen(a, "rb");
+	fb = fopen(b, "rb");
+	if (!fa || !fb)
+	{
+		if (fa) fclose(fa);
+		if (fb) fclose(fb);
+		return 0;
+	}
+	do
+	{
+		ca = fgetc(fa);
+		cb = fgetc(fb);
+	} while ((ca == cb) && (ca != EOF));
+	fclose(fa);
+	fclose(fb);
+	return (ca == cb);
+}
+
+double elapsedus(struct timespec *start) //Elapsed time since start, in us!
+{
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (double)(end.tv_sec - start->tv_sec) * 1e6 + (double)(end.tv_nsec - start->tv_nsec) / 1e3;
+}
+
+int main(int argc, char **argv)
+{
+	static byte current[8192], baseline[8192], writedata[512];
+	char currentimage[512], baselineimage[512];
+	IMDIMAGE_SECTORINFO currentinfo, baselineinfo;
+	byte variant, random, result, baselineresult, readresult, baselinereadresult;
+	int round, cylinder, head, sector, deleted, fill, i, k;
+	long cases = 0, mismatches = 0, n;
+	struct timespec start;
+	double readtime, baselinereadtime, infotime, baselineinfotime;
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s <image directory>\n", argv[0]);
+		return 1;
+	}
+	snprintf(diskpath, sizeof(diskpath), "%s", argv[1]);
+
+	for (variant = 0; variant < 2; ++variant)
+	{
+		snprintf(currentimage, sizeof(currentimage), "%s/current%u.imd", diskpath, variant);
+		snprintf(baselineimage, sizeof(baselineimage), "%s/baseline%u.imd", diskpath, variant);
+		seed = 777 + variant;
+		generate(currentimage, variant);
+		seed = 777 + variant;
+		generate(baselineimage, variant);
+		for (round = 0; round < 3; ++round)
+		{
+			for (cylinder = 0; cylinder < 82; ++cylinder) //All sectors, including nonexistant ones!
+			{
+				for (head = 0; head < 3; ++head)
+				{
+					for (sector = 0; sector < 20; ++sector)
+					{
+						memset(&currentinfo, 0x55, sizeof(currentinfo));
+						memset(&baselineinfo, 0x55, sizeof(baselineinfo));
+						result = readIMDSectorInfo(currentimage, cylinder, head, sector, &currentinfo);
+						baselineresult = baseline_readIMDSectorInfo(baselineimage, cylinder, head, sector, &baselineinfo);
+						memset(current, 0, sizeof(current));
+						memset(baseline, 0, sizeof(baseline));
+						readresult = readIMDSector(currentimage, cylinder, head, sector, 512, current);
+						baselinereadresult = baseline_readIMDSector(baselineimage, cylinder, head, sector, 512, baseline);
+						++cases;
+						if ((result != baselineresult) || memcmp(&currentinfo, &baselineinfo, sizeof(currentinfo)) || (readresult != baselinereadresult) || memcmp(current, baseline, sizeof(current)))
+						{
+							if (mismatches++ < 10) printf("variant %u round %d cylinder %d head %d sector %d: info %u/%u, read %u/%u\n", variant, round, cylinder, head, sector, result, baselineresult, readresult, baselinereadresult);
+						}
+					}
+				}
+			}
+			for (k = 0; k < 300; ++k) //Random writes, compressing and expanding sectors!
+			{
+				cylinder = rnd() % 81;
+				head = rnd() % 2;
+				sector = rnd() % 19;
+				deleted = rnd() % 2;
+				fill = rnd() % 3;
+				for (i = 0; i < 512; ++i) writedata[i] = fill ? 0xF6 : (rnd() & 0xFF);
+				result = writeIMDSector(currentimage, cylinder, head, sector, deleted, 512, writedata);
+				baselineresult = baseline_writeIMDSector(baselineimage, cylinder, head, sector, deleted, 512, writedata);
+				++cases;
+				if (result != baselineresult)
+				{
+					if (mismatches++ < 10) printf("variant %u write cylinder %d head %d sector %d: %u/%u\n", variant, cylinder, head, sector, result, baselineresult);
+				}
+				if ((k % 50) == 0) //Interleave reads with the writes!
+				{
+					cylinder = rnd() % 80;
+					readresult = readIMDSector(currentimage, cylinder, 1, 3, 512, current);
+					baselinereadresult = baseline_readIMDSector(baselineimage, cylinder, 1, 3, 512, baseline);
+					++cases;
+					if ((readresult != baselinereadresult) || memcmp(current, baseline, 512))
+					{
+						if (mismatches++ < 10) printf("variant %u read after write cylinder %d: %u/%u\n", variant, cylinder, readresult, baselinereadresult);
+					}
+				}
+			}
+			if (!samefiles(currentimage, baselineimage))
+			{
+				if (mismatches++ < 10) printf("variant %u round %d: the written images differ\n", variant, round);
+			}
+		}
+	}
+	printf("%ld accesses, %ld mismatches\n", cases, mismatches);
+
+	snprintf(currentimage, sizeof(currentimage), "%s/benchmark.imd", diskpath);
+	seed = 99;
+	generate(currentimage, 0);
+	for (random = 0; random < 2; ++random)
+	{
+		for (k = 0; k < 4; ++k) //Reads and information, baseline and current!
+		{
+			n = 0;
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			for (cylinder = 0; cylinder < 80; cylinder += (k < 2) ? 1 : 4)
+			{
+				for (head = 0; head < 2; ++head)
+				{
+					for (sector = 0; sector < 18; ++sector)
+					{
+						int c = cylinder, h = head, s = sector + 1;
+						if (random)
+						{
+							c = rnd() % 80;
+							h = rnd() % 2;
+							s = (rnd() % 18) + 1;
+						}
+						switch (k)
+						{
+						case 0: baseline_readIMDSector(currentimage, c, h, s, 512, baseline); break;
+						case 1: readIMDSector(currentimage, c, h, s, 512, current); break;
+						case 2: baseline_readIMDSectorInfo(currentimage, c, h, s, &baselineinfo); break;
+						case 3: readIMDSectorInfo(currentimage, c, h, s, &currentinfo); break;
+						}
+						++n;
+					}
+				}
+			}
+			switch (k)
+			{
+			case 0: baselinereadtime = elapsedus(&start) / n; break;
+			case 1: readtime = elapsedus(&start) / n; break;
+			case 2: baselineinfotime = elapsedus(&start) / n; break;
+			case 3: infotime = elapsedus(&start) / n; break;
+			}
+		}
+		printf("%s: sector read %.1f -> %.1f us, sector information %.1f -> %.1f us\n", random ? "random" : "sequential", baselinereadtime, readtime, baselineinfotime, infotime);
+	}
+	if (mismatches)
+	{
+		printf("FAILED: the indexed accesses differ from the baseline\n");
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
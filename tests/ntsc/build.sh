@@ -0,0 +1,37 @@
+#!/bin/bash
+# Builds and runs the CGA composite decoder equivalence test and benchmark, against the baseline vga_cga_ntsc.c.
+# The current decoder is built with its SIMD path for this machine, its portable path and its NEON path through a scalar stand-in.
+. "$(dirname "$0")/../common/prepare.sh"
+prepare_sources SDLPoP/hardware/vga/vga_cga_ntsc.c
+prepare_baseline SDLPoP/hardware/vga/vga_cga_ntsc.c SDLPoP/headers/hardware/vga/vga_cga_ntsc.h
+mkdir -p "$BUILD/baseinc/headers/hardware/vga"
+cp "$BUILD/baseline/SDLPoP/headers/hardware/vga/vga_cga_ntsc.h" "$BUILD/baseinc/headers/hardware/vga/vga_cga_ntsc.h"
+sed 's|^#define CGA_NTSC_SIMD|//#define CGA_NTSC_SIMD|' "$BUILD/src/SDLPoP/hardware/vga/vga_cga_ntsc.c" > "$BUILD/src/SDLPoP/hardware/vga/vga_cga_ntsc_portable.c"
+$CC $CFLAGS -c "$COMMON/stubs.c" -o "$BUILD/stubs.o"
+$CC $CFLAGS -c "$TESTDIR/main.c" -o "$BUILD/main.o"
+$CC -I"$BUILD/baseinc" $CFLAGS -DNTSC_BASELINE -c "$TESTDIR/main.c" -o "$BUILD/main_baseline.o"
+$CC $CFLAGS -c "$BUILD/src/SDLPoP/hardware/vga/vga_cga_ntsc.c" -o "$BUILD/simd.o"
+$CC $CFLAGS -c "$BUILD/src/SDLPoP/hardware/vga/vga_cga_ntsc_portable.c" -o "$BUILD/portable.o"
+$CC $CFLAGS -U__SSE2__ -D__ARM_NEON -I"$COMMON/neon" -c "$BUILD/src/SDLPoP/hardware/vga/vga_cga_ntsc.c" -o "$BUILD/neon.o"
+$CC -I"$BUILD/baseinc" $CFLAGS -c "$BUILD/baseline/SDLPoP/hardware/vga/vga_cga_ntsc.c" -o "$BUILD/baseline.o"
+$CC -o "$BUILD/ntsc_baseline" "$BUILD/main_baseline.o" "$BUILD/baseline.o" "$BUILD/stubs.o" $LIBS
+for v in simd portable neon; do
+	$CC -o "$BUILD/ntsc_$v" "$BUILD/main.o" "$BUILD/$v.o" "$BUILD/stubs.o" $LIBS
+done
+failed=0
+output=$("$BUILD/ntsc_baseline" "$BUILD/baseline.bin")
+echo "$(head -1 <<< "$output")"
+echo "baseline: $(tail -1 <<< "$output")"
+for v in simd portable neon; do
+	output=$("$BUILD/ntsc_$v" "$BUILD/$v.bin") || failed=1
+	echo "$v: $(tail -1 <<< "$output")"
+	if ! cmp -s "$BUILD/baseline.bin" "$BUILD/$v.bin"; then
+		echo "  the decoded scanlines differ from the baseline"
+		failed=1
+	fi
+done
+if [ $failed != 0 ]; then
+	echo "FAILED"
+	exit 1
+fi
+echo "OK"
@@ -0,0 +1,173 @@
+/*
+
+NTSC harness: equivalence test and benchmark of the CGA composite decoder of hardware/vga/vga_cga_ntsc.c.
+
+Decodes scanlines of a dither pattern matrix, random RGBI pixels, 1bpp pixels and colour bars, for the old and
+new CGA, 4 mode control values and the color burst on and off, with widths of 4, 322, 640, 912 and 2048 pixels.
+All decoded pixels are written to the output file, which must be identical for the baseline decoder and all
+decoder paths (SIMD, portable and NEON) of the current one.
+
+The current decoder also checks that decoding scanlines through the scanline cache gives the same pixels as
+decoding them fresh, while the pixels, the mode and the color burst change.
+
+Benchmark: a 640 pixel color scanline, decoded fresh and (current decoder only) unchanged from the previous frame.
+
+Build with NTSC_BASELINE defined for the baseline decoder.
+
+Usage: ntsc <output file>
+
+*/
+
+#include "headers/types.h" //Basic types!
+#include "headers/hardware/vga/vga.h" //VGA/CGA support!
+#include "headers/hardware/vga/vga_cga_mda.h" //CGA settings support!
+#include "headers/hardware/vga/vga_cga_ntsc.h" //NTSC decoder support!
+#include "headers/support/highrestimer.h" //Ticks holder support!
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef NTSC_BASELINE
+//The baseline decoder has no scanline cache!
+#define CONVERT(pixels,destination,size,scanline) RENDER_convertCGAOutput(pixels,destination,size)
+#else
+#define CONVERT(pixels,destination,size,scanline) RENDER_convertCGAOutput(pixels,destination,size,scanline)
+#endif
+
+//What the decoder uses from the rest of the emulator!
+VGA_Type *ActiveVGA = NULL;
+uint_32 rmask = 0xFF, gmask = 0xFF00, bmask = 0xFF0000, amask = 0xFF000000; //RGBA byte order!
+byte rshift = 0, gshift = 8, bshift = 16, ashift = 24;
+void initTicksHolder(TicksHolder *ticksholder) {}
+float getnspassed(TicksHolder *ticksholder) { return 0.0f; }
+
+extern byte cga_color_burst; //Color burst!
+
+byte source[2048]; //The scanline to decode!
+uint_32 destination[2048]; //The decoded scanline!
+
+void makeline(int pattern, int y, int size)
+{
+	int x, n;
+	for (x = 0; x < size; ++x)
+	{
+		switch (pattern)
+		{
+		case 0: //Dither pattern matrix!
+			n = (x / 40) & 15;
+			source[x] = ((n >> (x & 3)) & 1) ? ((y >> 3) & 15) : ((y >> 7) & 15);
+			break;
+		case 1: //Random RGBI!
+			source[x] = (byte)(rand() & 15);
+			break;
+		case 2: //1bpp!
+			source[x] = (rand() & 1) ? 15 : 0;
+			break;
+		default: //Colour bars!
+			source[x] = (byte)((x >> 3) & 15);
+			break;
+		}
+	}
+}
+
+void setmode(byte newcga, byte modecontrol, byte burst)
+{
+	setCGA_NewCGA(newcga);
+	cga_color_burst = burst;
+	ActiveVGA->registers->Compatibility_CGAModeControl = modecontrol;
+	RENDER_updateCGAColors();
+}
+
+double cputime()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+	return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv)
+{
+	static const byte modes[4] = { 0x1A, 0x0A, 0x09, 0x0E };
+	static byte screen[200][640];
+	FILE *f;
+	int newcga, mode, burst, pattern, y, size, frame, scanlines = 0;
+	double start;
+#ifndef NTSC_BASELINE
+	static uint_32 fresh[2048];
+	int mismatches = 0;
+#endif
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s <output file>\n", argv[0]);
+		return 1;
+	}
+	f = fopen(argv[1], "wb");
+	ActiveVGA = (VGA_Type *)calloc(1, sizeof(VGA_Type));
+	if (!(f && ActiveVGA && (ActiveVGA->registers = (VGA_REGISTERS *)calloc(1, sizeof(VGA_REGISTERS)))))
+	{
+		fprintf(stderr, "Can't create %s\n", argv[1]);
+		return 1;
+	}
+	setCGA_NTSC(1);
+	srand(42);
+	for (newcga = 0; newcga < 2; ++newcga)
+	{
+		for (mode = 0; mode < 4; ++mode)
+		{
+			for (burst = 0; burst < 2; ++burst)
+			{
+				setmode(newcga, modes[mode], burst);
+				for (pattern = 0; pattern < 4; ++pattern)
+				{
+					for (y = 0; y < 200; ++y)
+					{
+						size = (y & 1) ? 640 : 912;
+						if (y == 5) size = 2048;
+						if (y == 7) size = 4;
+						if (y == 9) size = 322;
+						makeline(pattern, y, size);
+						memset(destination, 0, sizeof(destination));
+						CONVERT(source, destination, size, 0xFFFF); //Not cached!
+						fwrite(destination, sizeof(uint_32), size & ~3, f);
+						++scanlines;
+					}
+				}
+			}
+		}
+	}
+	fclose(f);
+	printf("%d scanlines decoded\n", scanlines);
+
+	setmode(0, 0x1A, 1); //A 640x200 color screen of the dither pattern matrix!
+	for (y = 0; y < 200; ++y)
+	{
+		makeline(0, y, 640);
+		memcpy(screen[y], source, 640);
+	}
+	start = cputime();
+	for (frame = 0; frame < 600; ++frame) for (y = 0; y < 200; ++y) CONVERT(screen[y], destination, 640, 0xFFFF);
+	printf("640 pixel color scanline: %.2f us decoded", (cputime() - start) * 1e6 / (600 * 200));
+#ifndef NTSC_BASELINE
+	start = cputime();
+	for (frame = 0; frame < 600; ++frame) for (y = 0; y < 200; ++y) CONVERT(screen[y], destination, 640, y);
+	printf(", %.2f us unchanged", (cputime() - start) * 1e6 / (600 * 200));
+	for (frame = 0; frame < 20; ++frame) //Cached decoding must match fresh decoding!
+	{
+		if (frame == 10) setmode(0, 0x0A, 1); //Mode change!
+		if (frame == 15) cga_color_burst = 0; //Color burst change!
+		for (y = 0; y < 200; ++y)
+		{
+			if (((y * 7 + frame) % 13) == 0) screen[y][(frame * 31 + y) % 640] ^= 5; //Change some pixels!
+			CONVERT(screen[y], fresh, 640, 0xFFFF);
+			CONVERT(screen[y], destination, 640, y);
+			if (memcmp(fresh, destination, 640 * sizeof(uint_32))) ++mismatches;
+		}
+	}
+	printf(", %d cached scanline mismatches\n", mismatches);
+	return mismatches ? 1 : 0;
+#else
+	printf("\n");
+	return 0;
+#endif
+}
@@ -0,0 +1,24 @@
+#!/bin/bash
+# Builds and runs the device profiler test and benchmark, and the same core handler with the profiler compiled out.
+# Usage: build.sh [seconds]
+. "$(dirname "$0")/../common/prepare.sh"
+DURATION=${1:-10}
+prepare_sources SDLPoP/emu/core/profiler.c commonemuframework/support/highrestimer.c
+$CC $CFLAGS -c "$COMMON/stubs.c" -o "$BUILD/stubs.o"
+$CC $CFLAGS -c "$BUILD/src/commonemuframework/support/highrestimer.c" -o "$BUILD/highrestimer.o"
+$CC $CFLAGS -DDEVICE_PROFILER -c "$BUILD/src/SDLPoP/emu/core/profiler.c" -o "$BUILD/profiler.o"
+$CC $CFLAGS -DDEVICE_PROFILER -c "$TESTDIR/main.c" -o "$BUILD/main.o"
+$CC -o "$BUILD/profiler" "$BUILD/main.o" "$BUILD/profiler.o" "$BUILD/highrestimer.o" "$BUILD/stubs.o" $LIBS
+$CC $CFLAGS -c "$TESTDIR/main.c" -o "$BUILD/main_off.o"
+$CC -o "$BUILD/profiler_off" "$BUILD/main_off.o" "$BUILD/highrestimer.o" "$BUILD/stubs.o" $LIBS
+mkdir -p "$BUILD/logs"
+failed=0
+echo "profiler:"
+"$BUILD/profiler" "$BUILD/logs" $DURATION || failed=1
+echo "compiled out:"
+"$BUILD/profiler_off" "$BUILD/logs" $DURATION || failed=1
+if [ $failed != 0 ]; then
+	echo "FAILED"
+	exit 1
+fi
+echo "OK"
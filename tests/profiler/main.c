@@ -0,0 +1,174 @@
+/*
+
+Profiler harness: test and benchmark of the device profiler of emu/core/profiler.c.
+
+Runs a simulated core handler for some seconds: every step runs a fixed amount of work for the CPU and VGA, and
+varying amounts for the DMA, PIT and Adlib, marking every device like the core handler does. Between blocks of steps,
+the renderer runs outside the core handler. The periods logged to profiler.csv must add up to the wall time profiled,
+and the share of the wall time the devices take together must match the share measured around the blocks.
+The framerate display must show the devices on the profiler row, the most expensive first.
+
+Benchmark: the time per step, which is compared with the profiler compiled out (built without DEVICE_PROFILER).
+
+Usage: profiler <log directory> [seconds]
+
+*/
+
+#include "headers/types.h" //Basic types!
+#include "headers/emu/profiler.h" //Profiler support!
+#include "headers/emu/gpu/gpu_text.h" //Text surface support!
+#include "headers/support/highrestimer.h" //High resolution timer support!
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <time.h>
+
+//The tolerance of the device share, in percent of the wall time! Only one out of PROFILER_SAMPLEINTERVAL steps is timed, so host preemptions shorter than PROFILER_MAXLAP are scaled up with it!
+#define TOLERANCE 5.0
+
+char logpath[256] = "logs"; //Log path!
+byte rshift = 0, gshift = 8, bshift = 16, ashift = 24;
+
+//The framerate display!
+int renderedrow = -1; //Row rendered on!
+char rendered[256]; //What's rendered!
+void GPU_textgotoxy(GPU_TEXTSURFACE *surface, int x, int y) { renderedrow = y; rendered[0] = '\0'; }
+void GPU_textclearrow(GPU_TEXTSURFACE *surface, int y) {}
+void GPU_textclearcurrentrownext(GPU_TEXTSURFACE *surface) {}
+void GPU_textprintf(GPU_TEXTSURFACE *surface, uint_32 font, uint_32 border, char *text, ...)
+{
+	va_list args;
+	size_t length;
+	length = strlen(rendered);
+	va_start(args, text);
+	vsnprintf(&rendered[length], sizeof(rendered) - length, text, args);
+	va_end(args);
+}
+
+volatile uint_32 sink; //Keeps the work from being optimized away!
+
+void work(uint_32 amount)
+{
+	uint_32 i, x;
+	x = sink;
+	for (i = 0; i < amount; ++i) x = x * 1103515245u + 12345u;
+	sink = x;
+}
+
+double seconds()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv)
+{
+	double duration, start, blockstart, blockend, inside = 0.0, outside = 0.0;
+	uint_32 r = 1, steps = 0;
+	int step;
+#ifdef DEVICE_PROFILER
+	char filename[300], line[1024], *field;
+	double wall, devices, other, walltotal = 0.0, devicetotal = 0.0, shares[NUMPROFILES], measuredshare, profiledshare;
+	int periods = 0, column, failed = 0;
+	FILE *f;
+	extern DOUBLE profiler_totaltime;
+	extern char profiler_names[NUMPROFILES][16];
+#endif
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s <log directory> [seconds]\n", argv[0]);
+		return 1;
+	}
+	snprintf(logpath, sizeof(logpath), "%s", argv[1]);
+	duration = (argc > 2) ? atof(argv[2]) : 10.0;
+	initHighresTimer();
+	PROFILER_INIT();
+	start = seconds();
+	for (; (seconds() - start) < duration;)
+	{
+		blockstart = seconds();
+		for (step = 0; step < 2000; ++step) //The core handler!
+		{
+			PROFILER_BEGINSTEP();
+			r = r * 1664525u + 1013904223u;
+			work(200 + (r >> 28) * 10); PROFILER_MARK(PROFILE_CPU);
+			work(100); PROFILER_MARK(PROFILE_VGA);
+			if ((step & 3) == 0) work(40); PROFILER_MARK(PROFILE_DMA);
+			work(10); PROFILER_MARK(PROFILE_PIT);
+			if ((r >> 16) & 1) work(60); PROFILER_MARK(PROFILE_ADLIB);
+			PROFILER_MARK(PROFILE_CORE);
+		}
+		blockend = seconds();
+		inside += blockend - blockstart;
+		steps += 2000;
+		work(50000); //The renderer!
+		outside += seconds() - blockend;
+	}
+	printf("%u steps, %.1f ns per step\n", steps, inside * 1e9 / steps);
+#ifdef DEVICE_PROFILER
+	profiler_render(NULL, PROFILER_ROW); //The framerate display!
+	PROFILER_DONE();
+	measuredshare = inside * 100.0 / (inside + outside);
+	memset(&shares, 0, sizeof(shares));
+	snprintf(filename, sizeof(filename), "%s/profiler.csv", logpath);
+	if (!(f = fopen(filename, "rb")))
+	{
+		printf("Can't open %s\n", filename);
+		return 1;
+	}
+	for (; fgets(line, sizeof(line), f);)
+	{
+		if (strncmp(line, "time,wall", 9) == 0) continue; //Header!
+		strtok(line, ","); //Time!
+		wall = atof(strtok(NULL, ","));
+		devices = 0.0;
+		for (column = 0; (column < NUMPROFILES) && (field = strtok(NULL, ",")); ++column)
+		{
+			devices += atof(field);
+			shares[column] += atof(field);
+		}
+		field = strtok(NULL, ",");
+		other = field ? atof(field) : 0.0;
+		if ((column != NUMPROFILES) || (fabs(devices + other - wall) > 1000.0)) //Not adding up to the wall time?
+		{
+			printf("period %d: devices %.0f ns and other %.0f ns don't add up to the wall time of %.0f ns\n", periods, devices, other, wall);
+			failed = 1;
+		}
+		walltotal += wall;
+		devicetotal += devices;
+		++periods;
+	}
+	fclose(f);
+	if (!periods)
+	{
+		printf("no periods logged\n");
+		return 1;
+	}
+	profiledshare = devicetotal * 100.0 / walltotal;
+	printf("%d periods, %.3f s profiled of %.3f s run\n", periods, walltotal / 1e9, seconds() - start);
+	printf("devices: %.2f%% of the wall time profiled, %.2f%% measured around the core handler\n", profiledshare, measuredshare);
+	printf("shares: CPU %.2f%%, VGA %.2f%%, DMA %.2f%%, PIT %.2f%%, Adlib %.2f%%, Core %.2f%%\n", shares[PROFILE_CPU] * 100.0 / walltotal, shares[PROFILE_VGA] * 100.0 / walltotal, shares[PROFILE_DMA] * 100.0 / walltotal, shares[PROFILE_PIT] * 100.0 / walltotal, shares[PROFILE_ADLIB] * 100.0 / walltotal, shares[PROFILE_CORE] * 100.0 / walltotal);
+	printf("display row %d: %s\n", renderedrow, rendered);
+	if (fabs(walltotal / 1e9 - profiler_totaltime / 1e9) > 0.001) //Not all periods logged?
+	{
+		printf("%.3f s logged, but %.3f s profiled\n", walltotal / 1e9, (double)(profiler_totaltime / 1e9));
+		failed = 1;
+	}
+	if (fabs(profiledshare - measuredshare) > TOLERANCE)
+	{
+		printf("the profiled share differs more than %.1f%% from the measured share\n", TOLERANCE);
+		failed = 1;
+	}
+	if ((renderedrow != PROFILER_ROW) || (strncmp(rendered, profiler_names[PROFILE_CPU], strlen(profiler_names[PROFILE_CPU])) != 0) || !strstr(rendered, profiler_names[PROFILE_VGA]))
+	{
+		printf("the display doesn't show the CPU and VGA on the profiler row\n");
+		failed = 1;
+	}
+	return failed;
+#else
+	return 0;
+#endif
+}
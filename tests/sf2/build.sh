@@ -0,0 +1,26 @@
+#!/bin/bash
+# Builds and runs the SoundFont zone lookup equivalence test and benchmark, against the current and the baseline sf2.c.
+# Usage: build.sh [benchmark rounds] [seed]
+. "$(dirname "$0")/../common/prepare.sh"
+prepare_sources SDLPoP/support/sf2.c commonemuframework/support/signedness.c
+prepare_baseline SDLPoP/support/sf2.c SDLPoP/headers/support/sf2.h
+mkdir -p "$BUILD/baseinc/headers/support"
+cp "$BUILD/baseline/SDLPoP/headers/support/sf2.h" "$BUILD/baseinc/headers/support/sf2.h"
+$CC $CFLAGS -c "$COMMON/stubs.c" -o "$BUILD/stubs.o"
+$CC $CFLAGS -c "$BUILD/src/commonemuframework/support/signedness.c" -o "$BUILD/signedness.o"
+$CC $CFLAGS -c "$BUILD/src/SDLPoP/support/sf2.c" -o "$BUILD/sf2.o"
+$CC $CFLAGS -c "$TESTDIR/main.c" -o "$BUILD/main.o"
+$CC -o "$BUILD/sf2" "$BUILD/main.o" "$BUILD/sf2.o" "$BUILD/signedness.o" "$BUILD/stubs.o" $LIBS
+$CC -I"$BUILD/baseinc" $CFLAGS -c "$BUILD/baseline/SDLPoP/support/sf2.c" -o "$BUILD/sf2_baseline.o"
+$CC -I"$BUILD/baseinc" $CFLAGS -c "$TESTDIR/main.c" -o "$BUILD/main_baseline.o"
+$CC -o "$BUILD/sf2_baseline" "$BUILD/main_baseline.o" "$BUILD/sf2_baseline.o" "$BUILD/signedness.o" "$BUILD/stubs.o" $LIBS
+echo -n "baseline: "
+"$BUILD/sf2_baseline" "$BUILD/test.sf2" "$BUILD/baseline.txt" "$@"
+echo -n "current:  "
+"$BUILD/sf2" "$BUILD/test.sf2" "$BUILD/current.txt" "$@"
+if ! cmp -s "$BUILD/baseline.txt" "$BUILD/current.txt"; then
+	diff "$BUILD/baseline.txt" "$BUILD/current.txt" | head -20
+	echo "FAILED: the lookups differ from the baseline"
+	exit 1
+fi
+echo "OK: $(grep -c '^bank' "$BUILD/current.txt") voice setups, identical lookups"
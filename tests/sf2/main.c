@@ -0,0 +1,406 @@
+/*
+
+SoundFont zone lookup harness: equivalence test and benchmark of support/sf2.c.
+
+Writes a generated soundfont, loads it with readSF and performs the lookups that voice setup in the MIDI device does:
+finding the preset of every bank/program, then for each key and velocity the preset and instrument zones, all their generators
+and the modulators of a set of destinations. Everything found is written to the dump file.
+
+The harness is built against the current and the baseline sf2.c: both dumps must be identical.
+The generated soundfont contains global zones, zones without instrument/sample, missing or misplaced key/velocity ranges,
+duplicated generators, linked modulators and duplicate bank/program pairs, to cover the special cases of the lookups.
+
+Usage: sf2 <soundfont to write> <dump file> [benchmark rounds] [seed]
+
+*/
+
+#include "headers/types.h" //Basic types!
+#include "headers/support/sf2.h" //Soundfont support!
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define PRESETS 64
+#define INSTRUMENTS 48
+#define SAMPLES 12
+#define SAMPLEDATA 0x4000
+
+uint_32 seed = 1; //Generator state!
+
+uint_32 rnd(uint_32 range) //Random number in range!
+{
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 8) % range;
+}
+
+//The generated hydra!
+typedef struct
+{
+	byte *data;
+	uint_32 size, allocated;
+} BUFFER;
+
+BUFFER phdr, pbag, pmod, pgen, inst, ibag, imod, igen, shdr;
+
+void put(BUFFER *b, void *data, uint_32 size)
+{
+	if (b->size + size > b->allocated)
+	{
+		b->allocated = (b->size + size) * 2;
+		b->data = realloc(b->data, b->allocated);
+	}
+	memcpy(b->data + b->size, data, size);
+	b->size += size;
+}
+
+void putgen(BUFFER *b, word oper, word amount)
+{
+	sfGenList gen;
+	gen.sfGenOper = oper;
+	gen.genAmount.wAmount = amount;
+	put(b, &gen, sizeof(gen));
+}
+
+word rangeamount() //Random key/velocity range!
+{
+	byte lo, hi;
+	lo = rnd(128);
+	hi = lo + rnd(128 - lo);
+	if (!rnd(16)) hi = rnd(128); //Sometimes an inverted range!
+	return (word)(lo | (hi << 8));
+}
+
+word randomoper(word except) //A random generator other than the special ones!
+{
+	word oper;
+	do
+	{
+		oper = rnd(endOper);
+	} while ((oper == instrument) || (oper == keyRange) || (oper == velRange) || (oper == sampleID) || (oper == except));
+	return oper;
+}
+
+void putmods(BUFFER *b, uint_32 count)
+{
+	static const word destinations[6] = { initialFilterFc, pan, initialAttenuation, coarseTune, 0x8000, 0x8001 };
+	sfModList mod;
+	for (; count; --count)
+	{
+		mod.sfModSrcOper = (word)rnd(0x100);
+		mod.sfModDestOper = destinations[rnd(6)];
+		if (mod.sfModDestOper & 0x8000) mod.sfModDestOper = 0x8000 | rnd(4); //Linked to another modulator!
+		mod.modAmount = (sword)(rnd(0x10000) - 0x8000);
+		mod.sfModAmtSrcOper = rnd(4) ? 0 : (word)rnd(0x100);
+		mod.sfModTransOper = rnd(8) ? 0 : 2;
+		put(b, &mod, sizeof(mod));
+	}
+}
+
+void putzones(BUFFER *bag, BUFFER *gen, BUFFER *mod, uint_32 zones, word terminal, uint_32 terminals) //Generates the zones of a preset/instrument!
+{
+	sfPresetBag thebag; //Same layout as the instrument bag!
+	uint_32 zone, count;
+	for (zone = 0; zone < zones; ++zone)
+	{
+		thebag.wGenNdx = gen->size / sizeof(sfGenList);
+		thebag.wModNdx = mod->size / sizeof(sfModList);
+		put(bag, &thebag, sizeof(thebag));
+		if (rnd(4)) putgen(gen, keyRange, rangeamount()); //Key range first!
+		if (rnd(2)) putgen(gen, velRange, rangeamount()); //Velocity range next!
+		for (count = rnd(6); count; --count) //Normal generators!
+		{
+			putgen(gen, randomoper(terminal), (word)rnd(0x10000));
+		}
+		if (!rnd(12)) putgen(gen, keyRange, rangeamount()); //Misplaced key range!
+		if (!rnd(12)) putgen(gen, pan, (word)rnd(1000)); //Duplicated generator!
+		if (zone || rnd(3)) //Not a global zone?
+		{
+			if (rnd(10)) putgen(gen, terminal, (word)rnd(terminals + 1)); //Instrument/sample, sometimes out of range!
+			else if (!rnd(2)) putgen(gen, terminal, (word)rnd(terminals)), putgen(gen, pan, 0); //Not at the end!
+		}
+		putmods(mod, rnd(5));
+	}
+}
+
+void writechunk(FILE *f, char *id, BUFFER *b)
+{
+	uint_32 size = b->size;
+	fwrite(id, 1, 4, f);
+	fwrite(&size, 1, 4, f);
+	fwrite(b->data, 1, b->size, f);
+}
+
+void writelist(FILE *f, char *type, uint_32 size)
+{
+	size += 4;
+	fwrite("LIST", 1, 4, f);
+	fwrite(&size, 1, 4, f);
+	fwrite(type, 1, 4, f);
+}
+
+int writesoundfont(char *filename)
+{
+	static const word banks[6] = { 0, 0, 0, 1, 8, 128 };
+	sfPresetHeader preset;
+	sfInst instr;
+	sfSample sample;
+	sfPresetBag bag;
+	sfModList mod;
+	sfVersionTag version;
+	BUFFER ifil, smpl;
+	BUFFER *hydra[9] = { &phdr, &pbag, &pmod, &pgen, &inst, &ibag, &imod, &igen, &shdr };
+	static char *hydranames[9] = { "phdr", "pbag", "pmod", "pgen", "inst", "ibag", "imod", "igen", "shdr" };
+	uint_32 i, hydrasize, riffsize;
+	FILE *f;
+	memset(&ifil, 0, sizeof(ifil));
+	memset(&smpl, 0, sizeof(smpl));
+
+	//Presets!
+	for (i = 0; i <= PRESETS; ++i)
+	{
+		memset(&preset, 0, sizeof(preset));
+		snprintf(preset.achPresetName, sizeof(preset.achPresetName), (i < PRESETS) ? "Preset %u" : "EOP", i);
+		preset.wPresetBagNdx = pbag.size / sizeof(sfPresetBag);
+		if (i < PRESETS)
+		{
+			preset.wBank = banks[rnd(6)];
+			preset.wPreset = rnd(8) ? rnd(128) : 0; //Some duplicates!
+		}
+		put(&phdr, &preset, sizeof(preset));
+		if (i < PRESETS) putzones(&pbag, &pgen, &pmod, rnd(7), instrument, INSTRUMENTS);
+	}
+	bag.wGenNdx = pgen.size / sizeof(sfGenList);
+	bag.wModNdx = pmod.size / sizeof(sfModList);
+	put(&pbag, &bag, sizeof(bag)); //Terminal bag!
+
+	//Instruments!
+	for (i = 0; i <= INSTRUMENTS; ++i)
+	{
+		memset(&instr, 0, sizeof(instr));
+		snprintf(instr.achInstName, sizeof(instr.achInstName), (i < INSTRUMENTS) ? "Instrument %u" : "EOI", i);
+		instr.wInstBagNdx = ibag.size / sizeof(sfInstBag);
+		put(&inst, &instr, sizeof(instr));
+		if (i < INSTRUMENTS) putzones(&ibag, &igen, &imod, rnd(9), sampleID, SAMPLES);
+	}
+	bag.wGenNdx = igen.size / sizeof(sfInstGenList);
+	bag.wModNdx = imod.size / sizeof(sfModList);
+	put(&ibag, &bag, sizeof(bag)); //Terminal bag!
+
+	//Terminal modulators and generators!
+	memset(&mod, 0, sizeof(mod));
+	put(&pmod, &mod, sizeof(mod));
+	put(&imod, &mod, sizeof(mod));
+	putgen(&pgen, 0, 0);
+	putgen(&igen, 0, 0);
+
+	//Samples!
+	for (i = 0; i <= SAMPLES; ++i)
+	{
+		memset(&sample, 0, sizeof(sample));
+		snprintf(sample.achSampleName, sizeof(sample.achSampleName), (i < SAMPLES) ? "Sample %u" : "EOS", i);
+		if (i < SAMPLES)
+		{
+			sample.dwStart = i * (SAMPLEDATA / SAMPLES);
+			sample.dwEnd = sample.dwStart + (SAMPLEDATA / SAMPLES) - 46;
+			sample.dwStartloop = sample.dwStart + 8;
+			sample.dwEndloop = sample.dwEnd - 8;
+			sample.dwSampleRate = 22050;
+			sample.byOriginalPitch = 60;
+			sample.sfSampleType = monoSample;
+		}
+		put(&shdr, &sample, sizeof(sample));
+	}
+	for (i = 0; i < SAMPLEDATA; ++i)
+	{
+		word value = (word)rnd(0x10000);
+		put(&smpl, &value, sizeof(value));
+	}
+
+	version.wMajor = 2;
+	version.wMinor = 1;
+	put(&ifil, &version, sizeof(version));
+
+	hydrasize = 0;
+	for (i = 0; i < 9; ++i) hydrasize += 8 + hydra[i]->size;
+	riffsize = 4 + (12 + 8 + ifil.size) + (12 + 8 + smpl.size) + (12 + hydrasize);
+
+	f = fopen(filename, "wb");
+	if (!f) return 0;
+	fwrite("RIFF", 1, 4, f);
+	fwrite(&riffsize, 1, 4, f);
+	fwrite("sfbk", 1, 4, f);
+	writelist(f, "INFO", 8 + ifil.size);
+	writechunk(f, "ifil", &ifil);
+	writelist(f, "sdta", 8 + smpl.size);
+	writechunk(f, "smpl", &smpl);
+	writelist(f, "pdta", hydrasize);
+	for (i = 0; i < 9; ++i) writechunk(f, hydranames[i], hydra[i]);
+	fclose(f);
+	return 1;
+}
+
+FILE *dump = NULL; //Where to dump the lookups, if any!
+uint_64 lookups = 0; //Number of lookups performed!
+
+#define DUMP(...) if (dump) fprintf(dump, __VA_ARGS__)
+
+void dumpmods(RIFFHEADER *sf, uint_32 preset, word bag, byte isInstrument) //Dump the modulators like getSFmodulator looks them up!
+{
+	static const word destinations[6] = { initialFilterFc, pan, initialAttenuation, coarseTune, 0x8000, 0x8002 };
+	uint_32 destination;
+	word index;
+	byte found, isGlobal;
+	sfModList mod;
+	int_32 originMod, foundindex;
+	word linkedentry;
+	for (destination = 0; destination < 6; ++destination)
+	{
+		originMod = INT_MIN;
+		for (index = 0; index < 8; ++index)
+		{
+			foundindex = INT_MIN;
+			isGlobal = 2;
+			linkedentry = 0;
+			memset(&mod, 0, sizeof(mod));
+			if (isInstrument) found = lookupSFInstrumentModGlobal(sf, preset, bag, destinations[destination], index, &isGlobal, &mod, &originMod, &foundindex, &linkedentry);
+			else found = lookupSFPresetModGlobal(sf, preset, bag, destinations[destination], index, &isGlobal, &mod, &originMod, &foundindex, &linkedentry);
+			++lookups;
+			DUMP("  mod %c %04X/%u: %u", isInstrument ? 'i' : 'p', destinations[destination], index, found);
+			if (found)
+			{
+				DUMP(" global %u origin %d found %d linked %04X mod %04X %04X %d %04X %04X", isGlobal, originMod, foundindex, linkedentry, mod.sfModSrcOper, mod.sfModDestOper, mod.modAmount, mod.sfModAmtSrcOper, mod.sfModTransOper);
+			}
+			DUMP("\n");
+			if (!found) break; //No modulators left!
+		}
+	}
+}
+
+void dumpgens(RIFFHEADER *sf, uint_32 preset, word bag, byte isInstrument)
+{
+	word oper;
+	byte found;
+	sfGenList gen;
+	sfInstGenList igen;
+	DUMP("  gens %c:", isInstrument ? 'i' : 'p');
+	for (oper = 0; oper < endOper; ++oper)
+	{
+		if (isInstrument)
+		{
+			found = lookupSFInstrumentGenGlobal(sf, (word)preset, bag, oper, &igen);
+			if (found) DUMP(" %u=%04X/%04X", oper, igen.sfGenOper, igen.genAmount.wAmount);
+			found = lookupSFInstrumentGen(sf, (word)preset, bag, oper, &igen);
+			if (found) DUMP(" %u:%04X", oper, igen.genAmount.wAmount);
+		}
+		else
+		{
+			found = lookupSFPresetGenGlobal(sf, (word)preset, bag, oper, &gen);
+			if (found) DUMP(" %u=%04X/%04X", oper, gen.sfGenOper, gen.genAmount.wAmount);
+			found = lookupSFPresetGen(sf, preset, bag, oper, &gen);
+			if (found) DUMP(" %u:%04X", oper, gen.genAmount.wAmount);
+		}
+		lookups += 2;
+	}
+	DUMP("\n");
+}
+
+void setupvoices(RIFFHEADER *sf, word bank, word program, byte key, byte velocity) //Perform the lookups of the voice setup!
+{
+	uint_32 preset;
+	word pbag, ibag, instrumentnr;
+	int_32 previousPBag, previousIBag;
+	sfGenList instrumentgen;
+	sfInst instrumentinfo;
+	++lookups;
+	if (!lookupPresetByInstrument(sf, program, bank, &preset)) return; //No preset!
+	DUMP("bank %u program %u key %u velocity %u: preset %u\n", bank, program, key, velocity, preset);
+	for (previousPBag = -1;; previousPBag = (int_32)pbag) //All preset zones!
+	{
+		++lookups;
+		if (!lookupPBagByMIDIKey(sf, preset, key, velocity, &pbag, previousPBag)) break;
+		DUMP(" pbag %u global %u valid %u\n", pbag, isGlobalPresetZone(sf, preset, pbag), isValidPresetZone(sf, preset, pbag));
+		dumpgens(sf, preset, pbag, 0);
+		dumpmods(sf, preset, pbag, 0);
+		++lookups;
+		if (!lookupSFPresetGen(sf, preset, pbag, instrument, &instrumentgen)) continue; //No instrument!
+		instrumentnr = instrumentgen.genAmount.wAmount;
+		if (!getSFInstrument(sf, instrumentnr, &instrumentinfo)) continue; //Invalid instrument!
+		for (previousIBag = -1;; previousIBag = (int_32)ibag) //All instrument zones!
+		{
+			++lookups;
+			if (!lookupIBagByMIDIKey(sf, instrumentnr, key, velocity, &ibag, 1, previousIBag)) break;
+			DUMP(" instrument %u ibag %u global %u valid %u\n", instrumentnr, ibag, isGlobalInstrumentZone(sf, instrumentnr, ibag), isValidInstrumentZone(sf, instrumentnr, ibag));
+			dumpgens(sf, instrumentnr, ibag, 1);
+			dumpmods(sf, instrumentnr, ibag, 1);
+		}
+	}
+}
+
+void runall(RIFFHEADER *sf, byte step)
+{
+	static const word banks[4] = { 0, 1, 8, 128 };
+	uint_32 bank, program, key, velocity;
+	for (bank = 0; bank < 4; ++bank)
+	{
+		for (program = 0; program < 128; ++program)
+		{
+			for (key = 0; key < 128; key += step)
+			{
+				for (velocity = 1; velocity < 128; velocity += 42)
+				{
+					setupvoices(sf, banks[bank], program, key, velocity);
+				}
+			}
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	RIFFHEADER *sf;
+	uint_32 rounds, round;
+	struct timespec start, end;
+	double elapsed;
+	if (argc < 3)
+	{
+		fprintf(stderr, "Usage: %s <soundfont to write> <dump file> [benchmark rounds] [seed]\n", argv[0]);
+		return 1;
+	}
+	rounds = (argc > 3) ? atoi(argv[3]) : 1;
+	seed = (argc > 4) ? atoi(argv[4]) : 1;
+	if (!writesoundfont(argv[1]))
+	{
+		fprintf(stderr, "Can't write %s\n", argv[1]);
+		return 1;
+	}
+	sf = readSF(argv[1]);
+	if (!sf)
+	{
+		fprintf(stderr, "Can't load the generated soundfont!\n");
+		return 1;
+	}
+
+	dump = fopen(argv[2], "w");
+	if (!dump)
+	{
+		fprintf(stderr, "Can't write %s\n", argv[2]);
+		return 1;
+	}
+	runall(sf, 1); //Dump every key!
+	fclose(dump);
+	dump = NULL;
+
+	lookups = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (round = 0; round < rounds; ++round)
+	{
+		runall(sf, 1);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	elapsed = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+	printf("%.3fs for %llu lookups (%.1f ns/lookup)\n", elapsed, (unsigned long long)lookups, lookups ? (elapsed * 1e9 / (double)lookups) : 0.0);
+	closeSF(&sf);
+	return 0;
+}
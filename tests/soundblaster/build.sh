@@ -0,0 +1,32 @@
+#!/bin/bash
+# Builds and runs the Sound Blaster DSP equivalence test and benchmark, against the baseline soundblaster.c.
+# Usage: build.sh [seeds...]
+. "$(dirname "$0")/../common/prepare.sh"
+prepare_sources SDLPoP/hardware/soundblaster.c commonemuframework/support/fifobuffer.c commonemuframework/support/signedness.c
+prepare_baseline SDLPoP/hardware/soundblaster.c
+$CC $CFLAGS -c "$BUILD/src/commonemuframework/support/fifobuffer.c" -o "$BUILD/fifobuffer.o"
+$CC $CFLAGS -c "$BUILD/src/commonemuframework/support/signedness.c" -o "$BUILD/signedness.o"
+$CC $CFLAGS -c "$COMMON/stubs.c" -o "$BUILD/stubs.o"
+$CC $CFLAGS -c "$TESTDIR/main.c" -o "$BUILD/main.o"
+$CC $CFLAGS -c "$BUILD/src/SDLPoP/hardware/soundblaster.c" -o "$BUILD/soundblaster.o"
+$CC $CFLAGS -c "$BUILD/baseline/SDLPoP/hardware/soundblaster.c" -o "$BUILD/soundblaster_baseline.o"
+for v in soundblaster soundblaster_baseline; do
+	$CC -o "$BUILD/$v" "$BUILD/main.o" "$BUILD/$v.o" "$BUILD/fifobuffer.o" "$BUILD/signedness.o" "$BUILD/stubs.o" $LIBS
+done
+failed=0
+for seed in ${@:-12345 99999 4242}; do
+	current=$("$BUILD/soundblaster" $seed)
+	baseline=$("$BUILD/soundblaster_baseline" $seed)
+	echo "seed $seed: $current"
+	if [ "$current" != "$baseline" ]; then
+		echo "  baseline: $baseline"
+		failed=1
+	fi
+done
+echo -n "baseline: "; "$BUILD/soundblaster_baseline" -b
+echo -n "current:  "; "$BUILD/soundblaster" -b
+if [ $failed != 0 ]; then
+	echo "FAILED: the output differs from the baseline"
+	exit 1
+fi
+echo "OK"
@@ -0,0 +1,239 @@
+/*
+
+Sound Blaster harness: equivalence test and benchmark of the DSP of hardware/soundblaster.c.
+
+Drives the DSP through its I/O ports with a simulated DMA controller and interrupt controller, with randomly sized time steps:
+reset, single cycle and auto-init 8-bit PCM, 4-bit, 2.6-bit and 2-bit ADPCM with and without reference byte,
+pause/continue, exit auto-init, silence and time constant changes in the middle of a transfer.
+All output samples, interrupts and DMA transfers are hashed together with the step they happen at,
+so builds against the current and the baseline soundblaster.c must print the same hashes.
+
+Benchmark: one emulated second of auto-init 8-bit PCM and of 4-bit ADPCM, in fixed time steps.
+
+Usage: soundblaster [seed] | soundblaster -b [step in ns]
+
+*/
+
+#include "headers/types.h" //Basic types!
+#include "headers/support/sounddoublebuffer.h" //Double buffered sound support!
+#include "headers/emu/sound.h" //Sound output support!
+#include "headers/hardware/ports.h" //I/O support!
+#include "headers/hardware/pic.h" //Interrupt support!
+#include "headers/hardware/8237A.h" //DMA support!
+#include "headers/support/highrestimer.h" //Ticks holder support!
+#include "headers/hardware/soundblaster.h" //Sound Blaster support!
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+byte haswindowactive = 0, backgroundpolicy = 0; //Not running in the background!
+
+//The simulated hardware!
+PORTIN portin = NULL;
+PORTOUT portout = NULL;
+IRQHandler irqaccept = NULL;
+DMAWriteBHandler dmawrite = NULL;
+DMATickHandler dmadreq = NULL, dmadack = NULL, dmatc = NULL;
+byte irqline = 0, dreqline = 0;
+uint_64 stepnr = 0; //Current time step!
+uint_64 irqcount = 0, irqhash = 0, outputcount = 0, outputhash = 0, dmacount = 0, dmahash = 0; //What has happened!
+
+void register_PORTIN(PORTIN handler) { portin = handler; }
+void register_PORTOUT(PORTOUT handler) { portout = handler; }
+void registerIRQ(byte IRQ, IRQHandler acceptIRQ, IRQHandler finishIRQ) { irqaccept = acceptIRQ; }
+void raiseirq(word irqnum) { irqline = 1; ++irqcount; irqhash = irqhash * 31 + stepnr; }
+void lowerirq(word irqnum) { irqline = 0; }
+void acnowledgeIRQrequest(byte irqnum) {}
+void registerDMA8(byte channel, DMAReadBHandler readhandler, DMAWriteBHandler writehandler) { dmawrite = writehandler; }
+void registerDMATick(byte channel, DMATickHandler DREQHandler, DMATickHandler DACKHandler, DMATickHandler TCHandler, DMAEOPHandler EOPHandler) { dmadreq = DREQHandler; dmadack = DACKHandler; dmatc = TCHandler; }
+void DMA_SetDREQ(byte channel, byte DREQ) { dreqline = DREQ; }
+byte allocDoubleBufferedSound16(uint_32 samplebuffersize, SOUNDDOUBLEBUFFER *buffer, byte locked, DOUBLE samplerate) { return 1; }
+void freeDoubleBufferedSound(SOUNDDOUBLEBUFFER *buffer) {}
+void writeDoubleBufferedSound16(SOUNDDOUBLEBUFFER *buffer, word sample) { ++outputcount; outputhash = outputhash * 1000003u + sample + (stepnr << 20); }
+byte readDoubleBufferedSound16(SOUNDDOUBLEBUFFER *buffer, word *sample) { return 0; }
+byte addchannel(SOUNDHANDLER handler, void *extradata, char *name, float samplerate, uint_32 samples, byte stereo, byte method, byte highpassfilterenabled) { return 1; }
+byte setVolume(SOUNDHANDLER handler, void *extradata, float p_volume) { return 1; }
+void removechannel(SOUNDHANDLER handler, void *extradata, byte is_hw) {}
+byte getRecordedSampleL8u() { return 0x80; }
+byte getRecordedSampleR8u() { return 0x80; }
+byte readadlibstatus() { return 0; }
+void writeadlibaddr(byte value) {}
+void writeadlibdata(byte value) {}
+void initTicksHolder(TicksHolder *ticksholder) {}
+float getnspassed(TicksHolder *ticksholder) { return 0.0f; }
+
+uint_32 seed = 12345; //Generator state!
+
+uint_32 rnd()
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+byte memory[0x10000]; //What the DMA transfers!
+uint_32 dmaaddress, dmaremaining, dmabase, dmalength; //The DMA channel!
+byte dmaautoinit;
+DOUBLE MHZ14fraction = 0.0;
+
+void dsp(byte value) { portout(0x22C, value); }
+
+void acknowledge()
+{
+	byte result;
+	if (irqline) //Raised?
+	{
+		irqaccept(0x17);
+		portin(0x22E, &result); //Acknowledge the 8-bit interrupt!
+	}
+}
+
+void step(DOUBLE ns) //Tick the hardware!
+{
+	uint_32 MHZ14passed;
+	byte transfers;
+	++stepnr;
+	MHZ14fraction += ns * 14.31818 / 1000.0;
+	MHZ14passed = (uint_32)MHZ14fraction;
+	MHZ14fraction -= MHZ14passed;
+	updateSoundBlaster(ns, MHZ14passed);
+	for (transfers = 0; transfers < 4; ++transfers) //Up to 4 transfers per step!
+	{
+		dmadreq();
+		if (!dreqline) break; //No request?
+		dmadack();
+		dmawrite(memory[dmaaddress & 0xFFFF]);
+		dmahash = dmahash * 131 + stepnr;
+		++dmacount;
+		++dmaaddress;
+		if (dmaremaining-- == 0) //Terminal count?
+		{
+			dmatc();
+			if (dmaautoinit) //Reload?
+			{
+				dmaaddress = dmabase;
+				dmaremaining = dmalength;
+			}
+			else dmaremaining = 0xFFFF;
+		}
+	}
+}
+
+void run(DOUBLE us) //Run for some time with random steps and interrupt acknowledges!
+{
+	DOUBLE ns, time = 0.0;
+	for (; time < (us * 1000.0); time += ns)
+	{
+		ns = (DOUBLE)(50 + (rnd() % 3000));
+		step(ns);
+		if (irqline && ((rnd() % 8) == 0)) acknowledge();
+	}
+}
+
+void setdma(uint_32 base, uint_32 length, byte autoinit)
+{
+	dmabase = dmaaddress = base;
+	dmalength = dmaremaining = length - 1;
+	dmaautoinit = autoinit;
+}
+
+void transfer(byte command, word length) //Start a single cycle transfer!
+{
+	dsp(command);
+	dsp((length - 1) & 0xFF);
+	dsp((length - 1) >> 8);
+}
+
+double benchmark(DOUBLE stepns) //Run an emulated second, in ms!
+{
+	clock_t start;
+	uint_64 i;
+	start = clock();
+	for (i = 0; i < (uint_64)(1000000000.0 / stepns); ++i)
+	{
+		step(stepns);
+		if (irqline) acknowledge();
+	}
+	return 1000.0 * (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char **argv)
+{
+	static const byte adpcm[3][2] = { { 0x75, 0x74 }, { 0x77, 0x76 }, { 0x17, 0x16 } }; //With and without reference byte!
+	static const byte autoinit[4] = { 0x1C, 0x7D, 0x7F, 0x1F }; //8-bit, 4-bit, 2.6-bit and 2-bit!
+	static const byte timeconstants[4] = { 0xD3, 0xA6, 0x83, 0x9C };
+	byte result;
+	int i, format, block;
+	DOUBLE stepns;
+	uint_64 dmastart;
+	double pcmtime, adpcmtime;
+	for (i = 0; i < 0x10000; ++i) memory[i] = (byte)((i * i * 7 + i * 3) ^ (i >> 5));
+	if ((argc > 1) && !strcmp(argv[1], "-b")) //Benchmark?
+	{
+		stepns = (argc > 2) ? atof(argv[2]) : 1000.0;
+		initSoundBlaster(0x220, 1);
+		portout(0x226, 1); portout(0x226, 0); //Reset!
+		for (i = 0; i < 200; ++i) step(1000.0);
+		portin(0x22A, &result);
+		dsp(0xD1); //Speaker on!
+		dsp(0x40); dsp(0xD3); //22kHz!
+		setdma(0, 8192, 1);
+		dsp(0x48); dsp(0xFF); dsp(0x0F); dsp(0x1C); //Auto-init 8-bit PCM!
+		pcmtime = benchmark(stepns);
+		dsp(0xDA); //Exit auto-init!
+		for (i = 0; i < 2000; ++i) step(1000.0);
+		setdma(0, 8192, 1);
+		dsp(0x48); dsp(0xFF); dsp(0x0F); dsp(0x7D); //Auto-init 4-bit ADPCM!
+		dmastart = dmacount;
+		adpcmtime = benchmark(stepns);
+		printf("1 emulated second in %.0fns steps: 8-bit PCM %.1f ms, 4-bit ADPCM %.1f ms (%llu bytes)\n", stepns, pcmtime, adpcmtime, (unsigned long long)(dmacount - dmastart));
+		return 0;
+	}
+	seed = (argc > 1) ? atoi(argv[1]) : 12345;
+
+	initSoundBlaster(0x220, 1);
+	portout(0x226, 1); portout(0x226, 0); //Reset!
+	run(200);
+	portin(0x22A, &result);
+	dsp(0xD1); //Speaker on!
+	dsp(0x40); dsp(0xD3); //22kHz!
+	for (block = 0; block < 4; ++block) //Single cycle 8-bit PCM!
+	{
+		setdma(block * 1000, 700, 0);
+		transfer(0x14, 700);
+		run(40000);
+		acknowledge();
+	}
+	for (format = 0; format < 3; ++format) //Single cycle ADPCM, the first block with reference byte!
+	{
+		for (block = 0; block < 3; ++block)
+		{
+			setdma(5000 + block * 333 + format * 40, 300, 0);
+			transfer(adpcm[format][block ? 1 : 0], 300);
+			run(60000);
+			acknowledge();
+		}
+	}
+	for (format = 0; format < 4; ++format) //Auto-init, with pause, continue and exit!
+	{
+		dsp(0x40); dsp(timeconstants[format]);
+		setdma(20000 + format * 500, 1024, 1);
+		dsp(0x48); dsp(0xFF); dsp(0x01); dsp(autoinit[format]);
+		run(150000);
+		dsp(0xD0); run(5000); //Pause!
+		dsp(0xD4); run(30000); //Continue!
+		dsp(0xDA); run(80000); //Exit auto-init!
+		acknowledge();
+	}
+	transfer(0x80, 101); //Silence!
+	run(20000);
+	acknowledge();
+	setdma(30000, 2000, 0); //Time constant change in the middle of a transfer!
+	transfer(0x14, 2000);
+	run(20000);
+	dsp(0x40); dsp(0x60);
+	run(120000);
+	acknowledge();
+	printf("steps %llu output %llu hash %016llx irqs %llu hash %016llx dma %llu hash %016llx\n", (unsigned long long)stepnr, (unsigned long long)outputcount, (unsigned long long)outputhash, (unsigned long long)irqcount, (unsigned long long)irqhash, (unsigned long long)dmacount, (unsigned long long)dmahash);
+	return 0;
+}
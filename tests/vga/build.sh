@@ -0,0 +1,43 @@
+#!/bin/bash
+# Builds and runs the VGA renderer equivalence test and benchmark, against the baseline VGA sources.
+# Usage: build.sh [frames]
+. "$(dirname "$0")/../common/prepare.sh"
+VGASOURCES="vga.c vga_attributecontroller.c vga_cga_mda.c vga_cga_ntsc.c vga_crtcontroller.c vga_dac.c vga_dacrenderer.c vga_io.c vga_mmu.c vga_precalcs.c vga_renderer.c vga_sequencer_graphicsmode.c vga_sequencer_textmode.c vga_vram.c vga_vramtext.c svga/tseng.c"
+VGAHEADERS="SDLPoP/headers/hardware/vga/vga.h SDLPoP/headers/hardware/vga/vga_precalcs.h SDLPoP/headers/hardware/vga/vga_cga_ntsc.h commonemuframework/headers/emu/gpu/gpu.h"
+prepare_sources $(for f in $VGASOURCES; do echo SDLPoP/hardware/vga/$f; done) commonemuframework/support/fifobuffer.c commonemuframework/support/signedness.c
+prepare_baseline $(for f in $VGASOURCES; do echo SDLPoP/hardware/vga/$f; done) $VGAHEADERS
+for f in $VGAHEADERS; do #The baseline headers, in front of the current ones!
+	mkdir -p "$BUILD/baseinc/headers/$(dirname "${f#*/headers/}")"
+	cp "$BUILD/baseline/$f" "$BUILD/baseinc/headers/${f#*/headers/}"
+done
+$CC $CFLAGS -c "$BUILD/src/commonemuframework/support/fifobuffer.c" -o "$BUILD/fifobuffer.o"
+$CC $CFLAGS -c "$BUILD/src/commonemuframework/support/signedness.c" -o "$BUILD/signedness.o"
+$CC $CFLAGS -c "$COMMON/stubs.c" -o "$BUILD/stubs.o"
+for v in vga vga_baseline; do
+	if [ $v = vga ]; then src="$BUILD/src/SDLPoP/hardware/vga"; inc=""; else src="$BUILD/baseline/SDLPoP/hardware/vga"; inc="-I$BUILD/baseinc"; fi
+	objs=""
+	for f in $VGASOURCES; do
+		o="$BUILD/$v.$(basename $f .c).o"
+		$CC $inc $CFLAGS -c "$src/$f" -o "$o"
+		objs="$objs $o"
+	done
+	$CC $inc $CFLAGS -c "$TESTDIR/main.c" -o "$BUILD/$v.main.o"
+	$CC -o "$BUILD/$v" "$BUILD/$v.main.o" $objs "$BUILD/fifobuffer.o" "$BUILD/signedness.o" "$BUILD/stubs.o" $LIBS
+done
+failed=0
+for mode in text text132 decoder mode13h palette hicolor16 hicolor16lut hicolor15ext hicolor15extlut; do
+	current=$("$BUILD/vga" $mode "$@")
+	baseline=$("$BUILD/vga_baseline" $mode "$@")
+	echo "$(head -1 <<< "$current")"
+	echo "  baseline: $(tail -1 <<< "$baseline")"
+	echo "  current:  $(tail -1 <<< "$current")"
+	if [ "$(head -1 <<< "$current")" != "$(head -1 <<< "$baseline")" ]; then
+		echo "  baseline: $(head -1 <<< "$baseline")"
+		failed=1
+	fi
+done
+if [ $failed != 0 ]; then
+	echo "FAILED: the rendered frames differ from the baseline"
+	exit 1
+fi
+echo "OK"
@@ -0,0 +1,250 @@
+/*
+
+VGA harness: equivalence test and benchmark of the VGA renderer of hardware/vga.
+
+Sets up a VGA with its registers directly (no BIOS), fills the font and the screen with pseudo random data,
+then renders frames in 100us steps. The frame buffer of every rendered frame is hashed, so builds against
+the current and the baseline VGA sources must print the same hashes.
+
+Modes:
+text    - 80x25 text mode, 9-dot characters, 16 scanlines per character.
+text132 - 132x60 text mode, 8-dot characters, 8 scanlines per character.
+decoder - The text mode decoder only: decodes full 80x25 screens of character cells.
+mode13h - 320x200 256 colors, random palette and pixels.
+palette - Mode 13h, changing 16 DAC entries each frame, and toggling the color pedestal.
+hicolor16, hicolor16lut - Mode 13h timing with a 16-bit Sierra DAC, directly and through the palette (animated).
+hicolor15ext, hicolor15extlut - The same with the extended 15-bit Sierra DAC modes.
+
+The first line of the output is compared, the second line is the time taken.
+
+Usage: vga <mode> [frames]
+
+*/
+
+#include "headers/types.h" //Basic types!
+#include "headers/emu/gpu/gpu.h" //GPU support!
+#include "headers/bios/bios.h" //BIOS Settings support!
+#include "headers/cpu/cpu.h" //CPU support!
+#include "headers/hardware/vga/vga.h" //VGA support!
+#include "headers/hardware/vga/vga_precalcs.h" //Precalculation support!
+#include "headers/hardware/vga/vga_vram.h" //VRAM support!
+#include "headers/hardware/vga/vga_vramtext.h" //Font support!
+#include "headers/hardware/vga/vga_renderer.h" //Renderer support!
+#include "headers/hardware/vga/vga_dacrenderer.h" //Color level support!
+#include "headers/hardware/vga/vga_sequencer_textmode.h" //Text decoder support!
+#include "headers/emu/emu_vga.h" //VGA timing support!
+#include "headers/support/zalloc.h" //Memory allocation support!
+#include "headers/support/highrestimer.h" //Ticks holder support!
+#include "headers/hardware/ports.h" //I/O support!
+#include "headers/hardware/pic.h" //Interrupt support!
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//What the VGA uses from the rest of the emulator!
+GPU_type GPU;
+BIOS_Settings_TYPE BIOS_Settings;
+CPU_type CPU[MAXCPUS];
+byte activeCPU = 0;
+char capturepath[256] = "captures";
+byte is_XT = 0;
+byte EMU_VGAROM[0x10000];
+byte VGAROM_mapping = 0xFF;
+byte lightpen_pressed = 0;
+int_32 lightpen_x = -1, lightpen_y = -1;
+uint_64 memory_dataread[2];
+byte memory_datasize[2];
+byte memory_datawrittensize;
+byte useIPSclock = 0;
+byte MMU_waitstateactive = 0;
+uint_32 rmask = 0xFF, gmask = 0xFF00, bmask = 0xFF0000, amask = 0xFF000000; //RGBA byte order!
+byte rshift = 0, gshift = 8, bshift = 16, ashift = 24;
+uint_32 convertrel(uint_32 src, uint_32 fromres, uint_32 tores) { return fromres ? (uint_32)(((uint_64)src * tores) / fromres) : 0; }
+void debugrow(char *text) {}
+byte changedealloc(void *ptr, uint_32 size, DEALLOCFUNC dealloc) { return 1; }
+DEALLOCFUNC getdefaultdealloc() { return NULL; }
+void initTicksHolder(TicksHolder *ticksholder) {}
+float getnspassed(TicksHolder *ticksholder) { return 0.0f; }
+void MMU_mappingupdated() {}
+void acnowledgeIRQrequest(byte irqnum) {}
+byte execNMI(byte causeisMemory) { return 0; }
+void raiseirq(word irqnum) {}
+void lowerirq(word irqnum) {}
+void register_PORTIN(PORTIN handler) {}
+void register_PORTOUT(PORTOUT handler) {}
+void forceBIOSSave() {}
+byte writeBMP(char *thefilename, uint_32 *image, int w, int h, byte doublexres, byte doubleyres, int virtualwidth) { return 0; }
+
+extern byte characterpixels[16]; //The decoded character pixels!
+extern LOADEDPLANESCONTAINER loadedplanes; //The loaded planes!
+
+uint_64 framehash = 0; //Hash of all rendered frames!
+int frames = 0; //Rendered frames!
+byte animate = 0; //Change the palette each frame?
+
+void animatepalette() //Change 16 DAC entries, and the color pedestal!
+{
+	VGA_Type *VGA = getActiveVGA();
+	int k, entry;
+	for (k = 0; k < 16; ++k)
+	{
+		entry = (frames * 16 + k * 17) & 0xFF;
+		VGA->registers->DAC[entry << 2] = (byte)(rand() & 0x3F);
+		VGA->registers->DAC[(entry << 2) | 1] = (byte)(rand() & 0x3F);
+		VGA->registers->DAC[(entry << 2) | 2] = (byte)(rand() & 0x3F);
+		VGA_calcprecalcs(VGA, WHEREUPDATED_DAC | entry); //The entry has been written!
+	}
+	if (frames == 5) VGA_initColorLevels(VGA, 1); //Pedestal on!
+	if (frames == 9) VGA_initColorLevels(VGA, 0); //Pedestal off!
+}
+
+void renderHWFrame() //A frame has been rendered!
+{
+	uint_64 hash = 1469598103934665603ULL;
+	uint_32 i;
+	if (animate) animatepalette(); //Change the palette for the next frame!
+	for (i = 0; i < (1024 * 1024); ++i) //The used part of the screen buffer!
+	{
+		hash ^= GPU.emu_screenbuffer[i];
+		hash *= 1099511628211ULL;
+	}
+	framehash = framehash * 31 + hash;
+	++frames;
+}
+
+double seconds(clockid_t clock)
+{
+	struct timespec time;
+	clock_gettime(clock, &time);
+	return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+void setuptext(VGA_Type *VGA, byte big) //Text mode 3, or 132x60!
+{
+	static const byte sequencer[5] = { 0x03, 0x00, 0x03, 0x00, 0x02 };
+	static const byte crtc[25] = { 0x5F, 0x4F, 0x50, 0x82, 0x55, 0x81, 0xBF, 0x1F, 0x00, 0x4F, 0x0D, 0x0E, 0x00, 0x00, 0x00, 0x00, 0x9C, 0x8E, 0x8F, 0x28, 0x1F, 0x96, 0xB9, 0xA3, 0xFF };
+	static const byte graphics[9] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x0E, 0x00, 0xFF };
+	static const byte attribute[21] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x14, 0x07, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F, 0x0C, 0x00, 0x0F, 0x08, 0x00 };
+	byte *CRTC = VGA->registers->CRTControllerRegisters.DATA;
+	VGA->registers->ExternalRegisters.MISCOUTPUTREGISTER = 0x67;
+	memcpy(VGA->registers->SequencerRegisters.DATA, sequencer, sizeof(sequencer));
+	memcpy(CRTC, crtc, sizeof(crtc));
+	memcpy(VGA->registers->GraphicsRegisters.DATA, graphics, sizeof(graphics));
+	memcpy(VGA->registers->AttributeControllerRegisters.DATA, attribute, sizeof(attribute));
+	if (big) //132x60 with an 8x8 font, 8-dot characters, 480 lines!
+	{
+		VGA->registers->SequencerRegisters.DATA[1] = 0x01; //8-dot characters!
+		CRTC[0] = 0x9F; CRTC[1] = 131; CRTC[2] = 132; CRTC[3] = 0x82; CRTC[4] = 0x88; CRTC[5] = 0x81; //Horizontal timing!
+		CRTC[6] = 0x0B; CRTC[7] = 0x3E; CRTC[0x10] = 0xEA; CRTC[0x11] = 0x8C; CRTC[0x12] = 0xDF; CRTC[0x15] = 0xE7; CRTC[0x16] = 0x04; //Vertical timing!
+		CRTC[9] = 0x47; CRTC[0xA] = 0x06; CRTC[0xB] = 0x07; //8 scanlines per character, with the cursor!
+		CRTC[0x13] = 66; //Offset!
+		VGA->registers->ExternalRegisters.MISCOUTPUTREGISTER = 0xE7;
+	}
+}
+
+void setupmode13h(VGA_Type *VGA) //Mode 13h, with random contents!
+{
+	static const byte sequencer[5] = { 0x03, 0x01, 0x0F, 0x00, 0x0E };
+	static const byte crtc[25] = { 0x5F, 0x4F, 0x50, 0x82, 0x54, 0x80, 0xBF, 0x1F, 0x00, 0x41, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x9C, 0x8E, 0x8F, 0x28, 0x40, 0x96, 0xB9, 0xA3, 0xFF };
+	static const byte graphics[9] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x05, 0x0F, 0xFF };
+	static const byte attribute[21] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x41, 0x00, 0x0F, 0x00, 0x00 };
+	int i, plane;
+	VGA->registers->ExternalRegisters.MISCOUTPUTREGISTER = 0x63;
+	memcpy(VGA->registers->SequencerRegisters.DATA, sequencer, sizeof(sequencer));
+	memcpy(VGA->registers->CRTControllerRegisters.DATA, crtc, sizeof(crtc));
+	memcpy(VGA->registers->GraphicsRegisters.DATA, graphics, sizeof(graphics));
+	memcpy(VGA->registers->AttributeControllerRegisters.DATA, attribute, sizeof(attribute));
+	for (i = 0; i < 1024; ++i) VGA->registers->DAC[i] = (byte)(rand() & 0x3F); //Random palette!
+	for (i = 0; i < 0x4000; ++i) for (plane = 0; plane < 4; ++plane) writeVRAMplane(VGA, plane, i, 0, (byte)rand(), 0); //Random pixels!
+}
+
+int main(int argc, char **argv)
+{
+	VGA_Type *VGA;
+	char *mode;
+	byte entry;
+	int nframes, i, c, r, cells, f, x, y;
+	uint_64 hash;
+	double start, cpustart;
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s <text|text132|decoder|mode13h|palette|hicolor16|hicolor16lut|hicolor15ext|hicolor15extlut> [frames]\n", argv[0]);
+		return 1;
+	}
+	mode = argv[1];
+	nframes = (argc > 2) ? atoi(argv[2]) : 60;
+	GPU.emu_screenbuffer = (uint_32 *)calloc(EMU_SCREENBUFFERSIZE, sizeof(uint_32));
+	GPU.emu_screenbufferend = GPU.emu_screenbuffer + EMU_SCREENBUFFERSIZE;
+	VGA = VGAalloc(0, 0, 0, 0);
+	if (!(GPU.emu_screenbuffer && VGA))
+	{
+		fprintf(stderr, "Can't allocate the VGA\n");
+		return 1;
+	}
+	setActiveVGA(VGA);
+	setuptext(VGA, !strcmp(mode, "text132"));
+	cells = strcmp(mode, "text132") ? (80 * 25) : (132 * 60);
+	for (i = 0; i < 256; ++i) //The EGA palette, repeated!
+	{
+		entry = i & 0x3F;
+		VGA->registers->DAC[i << 2] = ((entry >> 2) & 1) * 0x2A + ((entry >> 5) & 1) * 0x15;
+		VGA->registers->DAC[(i << 2) | 1] = ((entry >> 1) & 1) * 0x2A + ((entry >> 4) & 1) * 0x15;
+		VGA->registers->DAC[(i << 2) | 2] = (entry & 1) * 0x2A + ((entry >> 3) & 1) * 0x15;
+	}
+	VGA->registers->DACMaskRegister = 0xFF;
+	srand(1234);
+	for (c = 0; c < 256; ++c) for (r = 0; r < 32; ++r) writeVRAMplane(VGA, 2, (c << 5) | r, 0, (byte)((c * 37) ^ (r * 91) ^ (c >> 3)), 0); //The font!
+	for (i = 0; i < cells; ++i) //Random characters and attributes!
+	{
+		writeVRAMplane(VGA, 0, i, 0, (byte)rand(), 0);
+		writeVRAMplane(VGA, 1, i, 0, (byte)rand(), 0);
+	}
+	if (strncmp(mode, "text", 4) && strcmp(mode, "decoder")) //Mode 13h based?
+	{
+		setupmode13h(VGA);
+		animate = (!strcmp(mode, "palette") || !strcmp(mode, "hicolor16lut") || !strcmp(mode, "hicolor15extlut"));
+	}
+	VGA_calcprecalcs(VGA, WHEREUPDATED_ALL);
+	VGA_charsetupdated(VGA);
+	if (!strncmp(mode, "hicolor", 7)) //Sierra DAC high color modes?
+	{
+		VGA->precalcs.SC15025_pixelmaskregister = ~0;
+		if (!strcmp(mode, "hicolor16")) VGA->precalcs.DACmode = 7; //16-bit!
+		else if (!strcmp(mode, "hicolor16lut")) VGA->precalcs.DACmode = 7 | 0x40 | 0x100; //16-bit through the palette!
+		else if (!strcmp(mode, "hicolor15extlut")) VGA->precalcs.DACmode = 6 | 0x40 | 0x20 | 0x80; //Extended 15-bit through the palette!
+		else VGA->precalcs.DACmode = 6 | 0x20; //Extended 15-bit!
+		updateVGASequencer_Mode(VGA);
+	}
+	VGA_initTimer();
+
+	if (!strcmp(mode, "decoder")) //Decode character cells only!
+	{
+		hash = 0;
+		cpustart = seconds(CLOCK_PROCESS_CPUTIME_ID);
+		for (f = 0; f < nframes; ++f)
+		{
+			for (y = 0; y < 400; ++y)
+			{
+				((SEQ_DATA *)VGA->Sequencer)->charinner_y = y & 15;
+				for (x = 0; x < 80; ++x)
+				{
+					loadedplanes.splitplanes[0] = (byte)(x * 7 + y * 13 + f); //Character!
+					loadedplanes.splitplanes[1] = (byte)(x * 3 + f); //Attribute!
+					VGA_TextDecoder(VGA, x);
+					hash = hash * 31 + characterpixels[x & 15] + characterpixels[8];
+				}
+			}
+		}
+		printf("decoder: %d screens, hash %016llx\n", nframes, (unsigned long long)hash);
+		printf("%.1f ns per character cell\n", (seconds(CLOCK_PROCESS_CPUTIME_ID) - cpustart) * 1e9 / (nframes * 400.0 * 80.0));
+		return 0;
+	}
+
+	start = seconds(CLOCK_MONOTONIC);
+	cpustart = seconds(CLOCK_PROCESS_CPUTIME_ID);
+	while (frames < nframes) updateVGA(100000.0, 0); //Render in 100us steps!
+	printf("%s: %d frames, hash %016llx\n", mode, frames, (unsigned long long)framehash);
+	printf("%.1f fps, %.0f%% CPU\n", frames / (seconds(CLOCK_MONOTONIC) - start), 100.0 * (seconds(CLOCK_PROCESS_CPUTIME_ID) - cpustart) / (seconds(CLOCK_MONOTONIC) - start));
+	return 0;
+}
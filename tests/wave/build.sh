@@ -0,0 +1,55 @@
+#!/bin/bash
+# Builds and runs the WAV recording equivalence test and benchmark, against the baseline wave.c.
+# Usage: build.sh [seconds]
+. "$(dirname "$0")/../common/prepare.sh"
+SECONDS_RECORDED=${1:-60}
+prepare_sources commonemuframework/support/wave.c commonemuframework/support/zalloc.c
+prepare_baseline commonemuframework/support/wave.c commonemuframework/headers/support/wave.h
+mkdir -p "$BUILD/baseinc/headers/support"
+cp "$BUILD/baseline/commonemuframework/headers/support/wave.h" "$BUILD/baseinc/headers/support/wave.h"
+$CC $CFLAGS -c "$COMMON/stubs.c" -o "$BUILD/stubs.o"
+$CC $CFLAGS -c "$BUILD/src/commonemuframework/support/zalloc.c" -o "$BUILD/zalloc.o"
+$CC $CFLAGS -c "$BUILD/src/commonemuframework/support/wave.c" -o "$BUILD/wave.o"
+$CC $CFLAGS -c "$TESTDIR/main.c" -o "$BUILD/main.o"
+$CC -o "$BUILD/wave" "$BUILD/main.o" "$BUILD/wave.o" "$BUILD/zalloc.o" "$BUILD/stubs.o" $LIBS
+$CC -I"$BUILD/baseinc" $CFLAGS -c "$BUILD/baseline/commonemuframework/support/wave.c" -o "$BUILD/wave_baseline.o"
+$CC -I"$BUILD/baseinc" $CFLAGS -DWAVE_BASELINE -c "$TESTDIR/main.c" -o "$BUILD/main_baseline.o"
+$CC -o "$BUILD/wave_baseline" "$BUILD/main_baseline.o" "$BUILD/wave_baseline.o" "$BUILD/zalloc.o" "$BUILD/stubs.o" $LIBS
+failed=0
+check() #Compare a recording with the baseline one!
+{
+	if ! cmp -s "$BUILD/$1" "$BUILD/$2"; then
+		echo "  $1 differs from $2"
+		failed=1
+	fi
+}
+for mode in stereo mono; do
+	for length in 0 1 $SECONDS_RECORDED; do
+		"$BUILD/wave_baseline" "$BUILD/baseline_${mode}_$length.wav" $mode $length > "$BUILD/baseline.txt"
+		"$BUILD/wave" "$BUILD/${mode}_$length.wav" $mode $length > "$BUILD/current.txt"
+		TEST_NOTHREAD=1 "$BUILD/wave" "$BUILD/direct_${mode}_$length.wav" $mode $length > "$BUILD/direct.txt"
+		if [ $length = $SECONDS_RECORDED ]; then
+			echo "$mode, $length seconds:"
+			echo "  baseline: $(tail -1 "$BUILD/baseline.txt")"
+			echo "  current:  $(tail -1 "$BUILD/current.txt")"
+			echo "  direct:   $(tail -1 "$BUILD/direct.txt")"
+			echo "  current $(head -1 "$BUILD/current.txt")"
+		fi
+		check "${mode}_$length.wav" "baseline_${mode}_$length.wav"
+		check "direct_${mode}_$length.wav" "baseline_${mode}_$length.wav"
+	done
+done
+for length in 1 $SECONDS_RECORDED; do
+	output=$("$BUILD/wave" "$BUILD/block_$length.wav" block $length)
+	[ $length = $SECONDS_RECORDED ] && echo "  block:    $(tail -1 <<< "$output")"
+	check "block_$length.wav" "baseline_stereo_$length.wav"
+done
+if [ -w /dev/full ]; then
+	echo -n "writer thread "; "$BUILD/wave" /dev/full error || failed=1
+	echo -n "direct "; TEST_NOTHREAD=1 "$BUILD/wave" /dev/full error || failed=1
+fi
+if [ $failed != 0 ]; then
+	echo "FAILED"
+	exit 1
+fi
+echo "OK"
@@ -0,0 +1,119 @@
+/*
+
+WAVE harness: equivalence test and benchmark of the WAV recording of support/wave.c.
+
+Records a generated stereo or mono signal, sample by sample or (current version only) in blocks of 512 samples,
+like the sound mixer does. The recorded files must be identical for the baseline and the current version,
+with and without the writer thread (TEST_NOTHREAD=1). Halfway through, the RIFF sizes in the header of the file
+being recorded are printed, to show that the file stays playable while recording.
+
+Error mode: records to a file that fails all writes (/dev/full), which must be reported by the write functions.
+
+Benchmark: the CPU time the mixer thread spends writing samples, and the time to close the file.
+
+Build with WAVE_BASELINE defined for the baseline version.
+
+Usage: wave <file> <stereo|block|mono> <seconds> | wave <file> error
+
+*/
+
+#include "headers/types.h" //Basic types!
+#include "headers/support/wave.h" //WAVE file support!
+#include "headers/support/zalloc.h" //Memory allocation support!
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BLOCKSIZE 512
+
+double seconds(clockid_t clock)
+{
+	struct timespec time;
+	clock_gettime(clock, &time);
+	return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+word leftsample(uint_32 sample) { return (word)((sample * 37) ^ (sample >> 3)); }
+word rightsample(uint_32 sample) { return (word)((sample * 11) ^ (sample >> 5) ^ 0x5A5A); }
+
+int recorderror(char *filename) //Record until a write error is reported!
+{
+	WAVEFILE *f;
+	uint_32 sample;
+	f = createWAV(filename, 2, 44100);
+	if (!f) //Already failed at the header?
+	{
+		printf("error: reported when creating the file\n");
+		return 0;
+	}
+	for (sample = 0; sample < (44100 * 60); ++sample) //Up to a minute!
+	{
+		if (!writeWAVStereoSample(f, leftsample(sample), rightsample(sample))) //Reported?
+		{
+			printf("error: reported after %u samples\n", sample);
+			closeWAV(&f);
+			return 0;
+		}
+	}
+	closeWAV(&f);
+	printf("error: not reported after %u samples\n", sample);
+	return 1;
+}
+
+int main(int argc, char **argv)
+{
+	static word block[BLOCKSIZE * 2];
+	void *allocations[400];
+	WAVEFILE *f;
+	FILE *check;
+	uint_32 total, sample, count, i, header[11];
+	byte stereo, blocks;
+	int k;
+	double mixertime = 0.0, start, cpustart, closetime;
+	if ((argc == 3) && !strcmp(argv[2], "error")) return recorderror(argv[1]);
+	if (argc < 4)
+	{
+		fprintf(stderr, "Usage: %s <file> <stereo|block|mono> <seconds> | %s <file> error\n", argv[0], argv[0]);
+		return 1;
+	}
+	stereo = (strcmp(argv[2], "mono") != 0);
+	blocks = (strcmp(argv[2], "block") == 0);
+	total = 44100 * atoi(argv[3]);
+	for (k = 0; k < 400; ++k) allocations[k] = zalloc(64 + k, "DUMMY", NULL); //A typical amount of live allocations!
+	start = seconds(CLOCK_MONOTONIC);
+	f = createWAV(argv[1], stereo ? 2 : 1, 44100);
+	if (!f)
+	{
+		fprintf(stderr, "Can't create %s\n", argv[1]);
+		return 1;
+	}
+	for (sample = 0; sample < total; sample += count)
+	{
+		count = MIN(total - sample, BLOCKSIZE);
+		for (i = 0; i < count; ++i) //Generate the block!
+		{
+			block[i * 2] = leftsample(sample + i);
+			block[i * 2 + 1] = rightsample(sample + i);
+		}
+		cpustart = seconds(CLOCK_THREAD_CPUTIME_ID);
+#ifndef WAVE_BASELINE
+		if (blocks) writeWAVSamples(f, block, count);
+		else
+#endif
+		if (stereo) for (i = 0; i < count; ++i) writeWAVStereoSample(f, block[i * 2], block[i * 2 + 1]);
+		else for (i = 0; i < count; ++i) writeWAVMonoSample(f, block[i * 2]);
+		mixertime += seconds(CLOCK_THREAD_CPUTIME_ID) - cpustart;
+		if ((sample < (total / 2)) && ((sample + count) >= (total / 2)) && (check = fopen(argv[1], "rb"))) //Halfway?
+		{
+			if (fread(header, sizeof(uint_32), 11, check) == 11) printf("halfway header: RIFF size %u, data size %u\n", header[1], header[10]);
+			fclose(check);
+		}
+	}
+	cpustart = seconds(CLOCK_THREAD_CPUTIME_ID);
+	closeWAV(&f);
+	closetime = seconds(CLOCK_THREAD_CPUTIME_ID) - cpustart;
+	printf("%s: mixer %.2f ms CPU (%.1f ns per sample), close %.2f ms CPU, %.1f ms total\n", argv[2], mixertime * 1e3, total ? (mixertime * 1e9 / total) : 0.0, closetime * 1e3, (seconds(CLOCK_MONOTONIC) - start) * 1e3);
+	for (k = 0; k < 400; ++k) freez(&allocations[k], 64 + k, "DUMMY");
+	return 0;
+}